@@ -0,0 +1,762 @@
+/*
+dmtxbatch - Batch decoder for stored PGM/PPM images
+
+Copyright (C) 2026 The libdmtx-wrappers project
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+Contact: mike@dragonflylogic.com
+*/
+
+/* $Id$ */
+
+/**
+ * @file dmtxbatch.c
+ * @brief Decode many stored PGM/PPM files on every core, writing JSON lines
+ *
+ * Archive re-scans decode millions of page images. Going through a wrapper
+ * means building an image object in the host language for each of them;
+ * dmtxbatch maps each file instead (dmtxwPnmMap()) and hands the mapped
+ * rows to libdmtx untouched. Worker threads each own a DmtxwSession and
+ * take the next file name from the command line or a list file, so the
+ * list is never held in memory.
+ *
+ * Every file produces one JSON line, written whole. With -r the output
+ * file is read back first: files already decoded there are skipped, files
+ * that failed are tried again and a line cut short by a crash is removed,
+ * so an interrupted run can simply be started again. SIGINT and SIGTERM let the running decodes finish.
+ *
+ *   $ dmtxbatch [-j jobs] [-o output [-r]] [-l list] [-p seconds]
+ *               [-P name=value]... [file...]
+ */
+
+#define _XOPEN_SOURCE 700
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include "dmtxw.h"
+
+#define DMTXBATCH_MAX_PROPS   32
+#define DMTXBATCH_PROGRESS    10
+
+/* Status names in DmtxwStatus order, as used by dmtxd */
+#define DMTXBATCH_STATUS_NAMES { "complete", "max_count", "timeout", "cancelled", \
+                                 "error", "blurred", "empty" }
+
+/* File names already in the output file (open addressing) */
+typedef struct {
+   char          **name;
+   long            capacity;       /* Power of two */
+   long            count;
+} NameSet;
+
+/* Growable output line */
+typedef struct {
+   char           *text;
+   size_t          length;
+   size_t          capacity;
+} Line;
+
+typedef struct {
+   pthread_mutex_t lock;
+   char          **path;           /* From the command line ... */
+   int             pathCount;
+   int             next;
+   FILE           *list;           /* ... or one name per line */
+   char           *listLine;
+   size_t          listCapacity;
+   FILE           *out;
+   NameSet         done;
+   int             prop[DMTXBATCH_MAX_PROPS];
+   int             value[DMTXBATCH_MAX_PROPS];
+   int             propCount;
+   long            files;
+   long            skipped;
+   long            failed;
+   long            symbols;
+   double          bytes;
+   int             running;        /* Workers not finished yet */
+} Batch;
+
+typedef struct {
+   Batch          *batch;
+   pthread_t       thread;
+   DmtxwSession   *session;
+   char           *path;
+   size_t          pathCapacity;
+   Line            line;
+} Worker;
+
+static const char *statusNames[] = DMTXBATCH_STATUS_NAMES;
+static volatile sig_atomic_t stopping = 0;
+
+static void OnSignal(int sig);
+static void *WorkerMain(void *arg);
+static DmtxBoolean NextPath(Batch *batch, Worker *worker);
+static void DecodeOne(Worker *worker, double *bytes, int *symbols, DmtxBoolean *failed);
+static DmtxPassFail LoadDone(Batch *batch, const char *path);
+static DmtxPassFail ParseDoneName(const char *line, size_t length, char **name);
+static DmtxPassFail NameSetAdd(NameSet *set, char *name);
+static DmtxBoolean NameSetHas(const NameSet *set, const char *name);
+static unsigned long HashName(const char *name);
+static DmtxPassFail LineAppend(Line *line, const char *text, size_t length);
+static DmtxPassFail LineAppendString(Line *line, const unsigned char *text, size_t length);
+static void Report(Batch *batch, DmtxTime start, const char *prefix);
+static double ElapsedSec(DmtxTime start);
+
+/**
+ * @brief  Parse the options, run the workers and report throughput
+ * @param  argc Argument count
+ * @param  argv Options and files (see the file comment)
+ * @return 0 if every file was decoded or skipped, 1 otherwise
+ */
+int
+main(int argc, char *argv[])
+{
+   Batch batch;
+   Worker *worker;
+   DmtxwSession *check;
+   DmtxTime start, lastReport;
+   struct sigaction sa;
+   struct timespec nap;
+   const char *outPath = NULL, *listPath = NULL;
+   char *value;
+   int opt, i, jobs, started = 0, resume = 0, progress = DMTXBATCH_PROGRESS;
+   int running;
+   DmtxPassFail err = DmtxPass;
+
+   memset(&batch, 0x00, sizeof(Batch));
+   jobs = (int)sysconf(_SC_NPROCESSORS_ONLN);
+   if(jobs < 1)
+      jobs = 1;
+
+   check = dmtxwSessionCreate();
+   if(check == NULL) {
+      fprintf(stderr, "%s: out of memory\n", argv[0]);
+      return 1;
+   }
+
+   while((opt = getopt(argc, argv, "j:o:rl:p:P:h")) != -1) {
+      switch(opt) {
+         case 'j':
+            jobs = atoi(optarg);
+            break;
+         case 'o':
+            outPath = optarg;
+            break;
+         case 'r':
+            resume = 1;
+            break;
+         case 'l':
+            listPath = optarg;
+            break;
+         case 'p':
+            progress = atoi(optarg);
+            break;
+         case 'P':
+            /* Checked on a scratch session, applied to every worker's */
+            value = strchr(optarg, '=');
+            if(value != NULL)
+               *(value++) = '\0';
+            if(value == NULL || batch.propCount == DMTXBATCH_MAX_PROPS ||
+                  (batch.prop[batch.propCount] = dmtxwPropByName(optarg)) == DmtxUndefined ||
+                  dmtxwSessionSetProp(check, batch.prop[batch.propCount], atoi(value)) == DmtxFail) {
+               fprintf(stderr, "%s: bad option %s\n", argv[0], optarg);
+               return 1;
+            }
+            batch.value[batch.propCount++] = atoi(value);
+            break;
+         default:
+            fprintf(stderr, "usage: %s [-j jobs] [-o output [-r]] [-l list] "
+                  "[-p seconds] [-P name=value]... [file...]\n", argv[0]);
+            return 1;
+      }
+   }
+   dmtxwSessionDestroy(&check);
+
+   if(jobs < 1 || progress < 0 || (resume && outPath == NULL) ||
+         (listPath == NULL) == (optind == argc)) {
+      fprintf(stderr, "%s: need files or -l (not both), -r needs -o, "
+            "-j must be positive\n", argv[0]);
+      return 1;
+   }
+
+   batch.path = argv + optind;
+   batch.pathCount = argc - optind;
+   if(listPath != NULL) {
+      batch.list = (strcmp(listPath, "-") == 0) ? stdin : fopen(listPath, "r");
+      if(batch.list == NULL) {
+         perror(listPath);
+         return 1;
+      }
+   }
+
+   if(resume && LoadDone(&batch, outPath) == DmtxFail) {
+      perror(outPath);
+      return 1;
+   }
+
+   batch.out = (outPath == NULL) ? stdout : fopen(outPath, resume ? "a" : "w");
+   if(batch.out == NULL) {
+      perror(outPath);
+      return 1;
+   }
+
+   worker = (Worker *)calloc(jobs, sizeof(Worker));
+   if(worker == NULL) {
+      fprintf(stderr, "%s: out of memory\n", argv[0]);
+      return 1;
+   }
+
+   memset(&sa, 0x00, sizeof(sa));
+   sa.sa_handler = OnSignal;
+   sigemptyset(&sa.sa_mask);
+   sigaction(SIGINT, &sa, NULL);
+   sigaction(SIGTERM, &sa, NULL);
+
+   pthread_mutex_init(&batch.lock, NULL);
+   start = lastReport = dmtxTimeNow();
+
+   for(i = 0; i < jobs; i++) {
+      worker[i].batch = &batch;
+      worker[i].session = dmtxwSessionCreate();
+      if(worker[i].session == NULL) {
+         err = DmtxFail;
+         break;
+      }
+      for(opt = 0; opt < batch.propCount; opt++)
+         dmtxwSessionSetProp(worker[i].session, batch.prop[opt], batch.value[opt]);
+
+      pthread_mutex_lock(&batch.lock);
+      batch.running++;
+      pthread_mutex_unlock(&batch.lock);
+      if(pthread_create(&(worker[i].thread), NULL, WorkerMain, &(worker[i])) != 0) {
+         pthread_mutex_lock(&batch.lock);
+         batch.running--;
+         pthread_mutex_unlock(&batch.lock);
+         err = DmtxFail;
+         break;
+      }
+      started++;
+   }
+   if(err == DmtxFail) {
+      fprintf(stderr, "%s: unable to start %d workers\n", argv[0], jobs);
+      stopping = 1;
+   }
+
+   /* The main thread only reports progress */
+   nap.tv_sec = 0;
+   nap.tv_nsec = 100000000L;
+   do {
+      nanosleep(&nap, NULL);
+      pthread_mutex_lock(&batch.lock);
+      running = batch.running;
+      if(progress > 0 && ElapsedSec(lastReport) >= progress) {
+         Report(&batch, start, "progress");
+         lastReport = dmtxTimeNow();
+      }
+      pthread_mutex_unlock(&batch.lock);
+   } while(running > 0);
+
+   for(i = 0; i < started; i++)
+      pthread_join(worker[i].thread, NULL);
+
+   fflush(batch.out);
+   Report(&batch, start, stopping ? "interrupted" : "done");
+
+   for(i = 0; i < jobs; i++) {
+      if(worker[i].session != NULL)
+         dmtxwSessionDestroy(&(worker[i].session));
+      free(worker[i].path);
+      free(worker[i].line.text);
+   }
+   free(worker);
+
+   for(i = 0; i < batch.done.capacity; i++)
+      free(batch.done.name[i]);
+   free(batch.done.name);
+   free(batch.listLine);
+
+   if(batch.list != NULL && batch.list != stdin)
+      fclose(batch.list);
+   if(batch.out != stdout)
+      fclose(batch.out);
+   pthread_mutex_destroy(&batch.lock);
+
+   return (err == DmtxPass && batch.failed == 0 && !stopping) ? 0 : 1;
+}
+
+/**
+ * @brief  Stop handing out files; running decodes finish
+ * @param  sig Signal number (unused)
+ * @return void
+ */
+static void
+OnSignal(int sig)
+{
+   stopping = 1;
+}
+
+/**
+ * @brief  Worker thread: decode files until none is left
+ * @param  arg Worker
+ * @return NULL
+ */
+static void *
+WorkerMain(void *arg)
+{
+   Worker *worker = (Worker *)arg;
+   Batch *batch = worker->batch;
+   DmtxBoolean failed;
+   double bytes;
+   int symbols;
+
+   while(NextPath(batch, worker) == DmtxTrue) {
+      worker->line.length = 0;
+      DecodeOne(worker, &bytes, &symbols, &failed);
+
+      /* Whole lines only, so that -r never sees two results mixed */
+      pthread_mutex_lock(&batch->lock);
+      fwrite(worker->line.text, 1, worker->line.length, batch->out);
+      batch->files++;
+      batch->bytes += bytes;
+      batch->symbols += symbols;
+      if(failed == DmtxTrue)
+         batch->failed++;
+      pthread_mutex_unlock(&batch->lock);
+   }
+
+   pthread_mutex_lock(&batch->lock);
+   batch->running--;
+   pthread_mutex_unlock(&batch->lock);
+
+   return NULL;
+}
+
+/**
+ * @brief  Take the next file name not decoded by an earlier run
+ * @param  batch Batch
+ * @param  worker Receives the name in worker->path
+ * @return DmtxTrue if there is one
+ */
+static DmtxBoolean
+NextPath(Batch *batch, Worker *worker)
+{
+   const char *name;
+   ssize_t got;
+   size_t length;
+   DmtxBoolean found = DmtxFalse;
+
+   pthread_mutex_lock(&batch->lock);
+
+   while(!stopping) {
+      if(batch->list == NULL) {
+         if(batch->next == batch->pathCount)
+            break;
+         name = batch->path[batch->next++];
+      }
+      else {
+         got = getline(&batch->listLine, &batch->listCapacity, batch->list);
+         if(got <= 0)
+            break;
+         while(got > 0 && (batch->listLine[got - 1] == '\n' || batch->listLine[got - 1] == '\r'))
+            batch->listLine[--got] = '\0';
+         if(got == 0)
+            continue;
+         name = batch->listLine;
+      }
+
+      if(NameSetHas(&batch->done, name) == DmtxTrue) {
+         batch->skipped++;
+         continue;
+      }
+
+      length = strlen(name) + 1;
+      if(length > worker->pathCapacity) {
+         free(worker->path);
+         worker->path = (char *)malloc(length);
+         worker->pathCapacity = (worker->path == NULL) ? 0 : length;
+         if(worker->path == NULL)
+            break;
+      }
+      memcpy(worker->path, name, length);
+      found = DmtxTrue;
+      break;
+   }
+
+   pthread_mutex_unlock(&batch->lock);
+
+   return found;
+}
+
+/**
+ * @brief  Decode worker->path and format its JSON line into worker->line
+ * @param  worker Worker
+ * @param  bytes Receives the file size
+ * @param  symbols Receives the number of symbols decoded
+ * @param  failed Receives DmtxTrue if the file could not be decoded
+ * @return void
+ */
+static void
+DecodeOne(Worker *worker, double *bytes, int *symbols, DmtxBoolean *failed)
+{
+   Line *line = &(worker->line);
+   DmtxwPnm pnm;
+   DmtxTime start;
+   const DmtxwResult *result;
+   const unsigned char *payload;
+   size_t length;
+   char text[256];
+   int i, j, status;
+   DmtxPassFail err;
+
+   *bytes = 0.0;
+   *symbols = 0;
+   *failed = DmtxFalse;
+
+   LineAppend(line, "{\"file\":", 8);
+   LineAppendString(line, (unsigned char *)worker->path, strlen(worker->path));
+
+   start = dmtxTimeNow();
+   if(dmtxwPnmMap(worker->path, &pnm) == DmtxFail) {
+      sprintf(text, ",\"error\":\"%.128s\"}\n", (errno == EINVAL) ?
+            "not a binary PGM/PPM file with maxval up to 255" : strerror(errno));
+      LineAppend(line, text, strlen(text));
+      *failed = DmtxTrue;
+      return;
+   }
+
+   err = dmtxwSessionDecode(worker->session, pnm.pxl, pnm.width, pnm.height,
+         pnm.rowSizeBytes, pnm.format);
+   *bytes = (double)pnm.mapSize;
+   dmtxwPnmUnmap(&pnm);
+
+   status = (int)worker->session->status;
+   if(err == DmtxFail || status < 0 || status > DmtxwStatusEmpty) {
+      LineAppend(line, ",\"error\":\"decode failed\"}\n", 26);
+      *failed = DmtxTrue;
+      return;
+   }
+
+   sprintf(text, ",\"width\":%d,\"height\":%d,\"status\":\"%s\",\"msec\":%.2f,\"symbols\":[",
+         pnm.width, pnm.height, statusNames[status], ElapsedSec(start) * 1000.0);
+   LineAppend(line, text, strlen(text));
+
+   *symbols = dmtxwSessionGetResultCount(worker->session);
+   for(i = 0; i < *symbols; i++) {
+      result = dmtxwSessionGetResult(worker->session, i);
+      payload = dmtxwSessionGetPayload(worker->session, i, &length);
+
+      LineAppend(line, (i == 0) ? "{\"data\":" : ",{\"data\":", (i == 0) ? 8 : 9);
+      LineAppendString(line, payload, length);
+      LineAppend(line, ",\"corners\":[", 12);
+      for(j = 0; j < 4; j++) {
+         sprintf(text, "%s[%d,%d]", (j == 0) ? "" : ",", result->corner[j].X,
+               result->corner[j].Y);
+         LineAppend(line, text, strlen(text));
+      }
+      sprintf(text, "],\"angle\":%d,\"size_idx\":%d}", result->angle, result->sizeIdx);
+      LineAppend(line, text, strlen(text));
+   }
+
+   LineAppend(line, "]}\n", 3);
+}
+
+/**
+ * @brief  Collect the files listed in an earlier output file and cut off
+ *         a trailing partial line
+ * @param  batch Batch
+ * @param  path Output file (a missing file is an empty one)
+ * @return DmtxPass | DmtxFail (errno set)
+ */
+static DmtxPassFail
+LoadDone(Batch *batch, const char *path)
+{
+   FILE *fp;
+   char *text = NULL, *name;
+   size_t capacity = 0;
+   ssize_t got;
+   off_t good = 0;
+
+   fp = fopen(path, "r");
+   if(fp == NULL)
+      return (errno == ENOENT) ? DmtxPass : DmtxFail;
+
+   while((got = getline(&text, &capacity, fp)) > 0) {
+      if(text[got - 1] != '\n')
+         break;
+      good += got;
+      if(ParseDoneName(text, (size_t)got, &name) == DmtxPass &&
+            NameSetAdd(&batch->done, name) == DmtxFail) {
+         free(text);
+         fclose(fp);
+         errno = ENOMEM;
+         return DmtxFail;
+      }
+   }
+   free(text);
+   fclose(fp);
+
+   return (truncate(path, good) == 0) ? DmtxPass : DmtxFail;
+}
+
+/**
+ * @brief  Undo the escaping of the "file" member at the start of a line
+ *         that records a decoded file
+ * @param  line Output line
+ * @param  length Line length
+ * @param  name Receives the file name (malloc'ed)
+ * @return DmtxPass | DmtxFail (an error record, or not a line written by
+ *         dmtxbatch)
+ */
+static DmtxPassFail
+ParseDoneName(const char *line, size_t length, char **name)
+{
+   size_t i;
+   int n = 0;
+   unsigned int code;
+   char *dst;
+
+   if(length < 10 || strncmp(line, "{\"file\":\"", 9) != 0)
+      return DmtxFail;
+
+   dst = (char *)malloc(length);
+   if(dst == NULL)
+      return DmtxFail;
+
+   for(i = 9; i < length && line[i] != '"'; i++) {
+      if(line[i] != '\\') {
+         dst[n++] = line[i];
+      }
+      else if(i + 1 < length && line[i + 1] == 'u' && i + 5 < length &&
+            sscanf(line + i + 2, "%4x", &code) == 1) {
+         dst[n++] = (char)code;
+         i += 5;
+      }
+      else if(i + 1 < length) {
+         i++;
+         dst[n++] = (line[i] == 'n') ? '\n' : (line[i] == 't') ? '\t' : line[i];
+      }
+   }
+
+   /* Error records go straight on to "error"; those files are retried */
+   if(i == length || length - i < 10 || strncmp(line + i + 1, ",\"width\":", 9) != 0) {
+      free(dst);
+      return DmtxFail;
+   }
+
+   dst[n] = '\0';
+   *name = dst;
+
+   return DmtxPass;
+}
+
+/**
+ * @brief  Add a name to the set, taking ownership of it
+ * @param  set Name set
+ * @param  name malloc'ed name
+ * @return DmtxPass | DmtxFail (out of memory)
+ */
+static DmtxPassFail
+NameSetAdd(NameSet *set, char *name)
+{
+   char **old;
+   long i, oldCapacity;
+   unsigned long slot;
+
+   if(NameSetHas(set, name) == DmtxTrue) {
+      free(name);
+      return DmtxPass;
+   }
+
+   /* Keep the table at most half full */
+   if((set->count + 1) * 2 > set->capacity) {
+      old = set->name;
+      oldCapacity = set->capacity;
+      set->capacity = (oldCapacity == 0) ? 1024 : oldCapacity * 2;
+      set->name = (char **)calloc(set->capacity, sizeof(char *));
+      if(set->name == NULL) {
+         set->name = old;
+         set->capacity = oldCapacity;
+         free(name);
+         return DmtxFail;
+      }
+      for(i = 0; i < oldCapacity; i++) {
+         if(old[i] == NULL)
+            continue;
+         slot = HashName(old[i]) & (set->capacity - 1);
+         while(set->name[slot] != NULL)
+            slot = (slot + 1) & (set->capacity - 1);
+         set->name[slot] = old[i];
+      }
+      free(old);
+   }
+
+   slot = HashName(name) & (set->capacity - 1);
+   while(set->name[slot] != NULL)
+      slot = (slot + 1) & (set->capacity - 1);
+   set->name[slot] = name;
+   set->count++;
+
+   return DmtxPass;
+}
+
+/**
+ * @brief  Look a name up in the set
+ * @param  set Name set
+ * @param  name Name
+ * @return DmtxTrue if present
+ */
+static DmtxBoolean
+NameSetHas(const NameSet *set, const char *name)
+{
+   unsigned long slot;
+
+   if(set->count == 0)
+      return DmtxFalse;
+
+   slot = HashName(name) & (set->capacity - 1);
+   while(set->name[slot] != NULL) {
+      if(strcmp(set->name[slot], name) == 0)
+         return DmtxTrue;
+      slot = (slot + 1) & (set->capacity - 1);
+   }
+
+   return DmtxFalse;
+}
+
+/**
+ * @brief  FNV-1a hash of a name
+ * @param  name Name
+ * @return Hash
+ */
+static unsigned long
+HashName(const char *name)
+{
+   unsigned long hash = 2166136261UL;
+
+   while(*name != '\0') {
+      hash ^= (unsigned char)*(name++);
+      hash *= 16777619UL;
+   }
+
+   return hash;
+}
+
+/**
+ * @brief  Append raw text to a line
+ * @param  line Line
+ * @param  text Text
+ * @param  length Bytes of text
+ * @return DmtxPass | DmtxFail (out of memory, text dropped)
+ */
+static DmtxPassFail
+LineAppend(Line *line, const char *text, size_t length)
+{
+   char *grown;
+   size_t capacity;
+
+   if(line->length + length > line->capacity) {
+      capacity = (line->capacity == 0) ? 1024 : line->capacity;
+      while(capacity < line->length + length)
+         capacity *= 2;
+      grown = (char *)realloc(line->text, capacity);
+      if(grown == NULL)
+         return DmtxFail;
+      line->text = grown;
+      line->capacity = capacity;
+   }
+
+   memcpy(line->text + line->length, text, length);
+   line->length += length;
+
+   return DmtxPass;
+}
+
+/**
+ * @brief  Append bytes as a JSON string. Bytes outside printable ASCII
+ *         become \\u00XX, i.e. the payload is read as Latin-1.
+ * @param  line Line
+ * @param  text Bytes
+ * @param  length Number of bytes
+ * @return DmtxPass | DmtxFail (out of memory)
+ */
+static DmtxPassFail
+LineAppendString(Line *line, const unsigned char *text, size_t length)
+{
+   char escape[8];
+   size_t i;
+   DmtxPassFail err;
+
+   err = LineAppend(line, "\"", 1);
+   for(i = 0; i < length && err == DmtxPass; i++) {
+      if(text[i] == '"' || text[i] == '\\') {
+         escape[0] = '\\';
+         escape[1] = (char)text[i];
+         err = LineAppend(line, escape, 2);
+      }
+      else if(text[i] < 0x20 || text[i] > 0x7e) {
+         sprintf(escape, "\\u%04x", text[i]);
+         err = LineAppend(line, escape, 6);
+      }
+      else {
+         err = LineAppend(line, (const char *)text + i, 1);
+      }
+   }
+
+   return (err == DmtxPass) ? LineAppend(line, "\"", 1) : err;
+}
+
+/**
+ * @brief  Print counts and throughput to stderr (caller holds the lock)
+ * @param  batch Batch
+ * @param  start Start of the run
+ * @param  prefix First word of the line
+ * @return void
+ */
+static void
+Report(Batch *batch, DmtxTime start, const char *prefix)
+{
+   double sec = ElapsedSec(start);
+
+   if(sec <= 0.0)
+      sec = 1.0e-6;
+
+   fprintf(stderr, "dmtxbatch: %s: %ld files (%ld failed, %ld skipped), %ld symbols, "
+         "%.1f s, %.1f files/s, %.1f MB/s\n", prefix, batch->files, batch->failed,
+         batch->skipped, batch->symbols, sec, batch->files / sec,
+         batch->bytes / sec / 1048576.0);
+}
+
+/**
+ * @brief  Seconds since a point in time
+ * @param  start Start time
+ * @return Elapsed seconds
+ */
+static double
+ElapsedSec(DmtxTime start)
+{
+   DmtxTime now = dmtxTimeNow();
+
+   return (double)(now.sec - start.sec) + ((double)now.usec - (double)start.usec) / 1.0e6;
+}
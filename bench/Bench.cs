@@ -0,0 +1,125 @@
+/*
+ * .NET decode benchmark driver; see bench/benchc.c for the protocol
+ *
+ *   $ mcs -r:Libdmtx.Net.dll -r:System.Drawing.dll -out:Bench.exe bench/Bench.cs
+ *   $ mono Bench.exe corpus.txt [repeat]
+ */
+
+using System;
+using System.Diagnostics;
+using System.Drawing;
+using System.Drawing.Imaging;
+using System.Globalization;
+using System.IO;
+using System.Runtime.InteropServices;
+using System.Text;
+using Libdmtx;
+
+public static class Bench {
+    // Binary PPM into a 24 bpp Bitmap (BGR in memory)
+    private static Bitmap ReadPpm(string path) {
+        byte[] data = File.ReadAllBytes(path);
+        int[] header = new int[4];
+        int pos = 0;
+        for (int field = 0; field < 4; field++) {
+            while (char.IsWhiteSpace((char)data[pos]))
+                pos++;
+            int start = pos;
+            while (!char.IsWhiteSpace((char)data[pos]))
+                pos++;
+            string word = Encoding.ASCII.GetString(data, start, pos - start);
+            header[field] = (field == 0) ? 0 : int.Parse(word, CultureInfo.InvariantCulture);
+        }
+        pos++;
+
+        int width = header[1], height = header[2];
+        Bitmap bitmap = new Bitmap(width, height, PixelFormat.Format24bppRgb);
+        BitmapData locked = bitmap.LockBits(new Rectangle(0, 0, width, height),
+            ImageLockMode.WriteOnly, PixelFormat.Format24bppRgb);
+        byte[] row = new byte[locked.Stride];
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                int src = pos + (y * width + x) * 3;
+                row[3 * x] = data[src + 2];
+                row[3 * x + 1] = data[src + 1];
+                row[3 * x + 2] = data[src];
+            }
+            Marshal.Copy(row, 0, new IntPtr(locked.Scan0.ToInt64() + (long)y * locked.Stride),
+                locked.Stride);
+        }
+        bitmap.UnlockBits(locked);
+
+        return bitmap;
+    }
+
+    private static long PeakRssKb() {
+        foreach (string line in File.ReadAllLines("/proc/self/status")) {
+            if (line.StartsWith("VmHWM:"))
+                return long.Parse(line.Substring(6).Trim().Split(' ')[0]);
+        }
+        return -1;
+    }
+
+    // Preset options (see bench/benchc.c) onto DecodeOptions fields
+    private static DecodeOptions ReadOptions() {
+        DecodeOptions options = new DecodeOptions();
+        string env = Environment.GetEnvironmentVariable("DMTX_BENCH_OPTIONS");
+        if (env == null)
+            return options;
+
+        foreach (string word in env.Split(new char[] { ' ', '\t' }, StringSplitOptions.RemoveEmptyEntries)) {
+            string name = word.Substring(0, word.IndexOf('='));
+            int value = int.Parse(word.Substring(word.IndexOf('=') + 1), CultureInfo.InvariantCulture);
+            switch (name) {
+                case "min_edge": options.EdgeMin = (short)value; break;
+                case "max_edge": options.EdgeMax = (short)value; break;
+                case "gap_size": options.ScanGap = (short)value; break;
+                case "deviation": options.SquareDevn = (short)value; break;
+                case "threshold": options.EdgeThresh = (short)value; break;
+                case "timeout": options.TimeoutMS = value; break;
+                case "max_count": options.MaxCodes = (short)value; break;
+                case "corrections": options.CorrectionsMax = (short)value; break;
+                case "shrink": options.Shrink = (short)value; break;
+                case "luma": options.LumaScale = (short)value; break;
+                case "min_sharpness": options.MinSharpness = value; break;
+                case "min_edge_density": options.MinEdgeDensity = (short)value; break;
+                case "search_share": options.SearchShare = (short)value; break;
+                default:
+                    Console.Error.WriteLine("unsupported option " + name);
+                    Environment.Exit(3);
+                    break;
+            }
+        }
+
+        return options;
+    }
+
+    public static void Main(string[] args) {
+        string manifest = args[0];
+        int repeat = (args.Length > 1) ? int.Parse(args[1]) : 1;
+        string dir = Path.GetDirectoryName(Path.GetFullPath(manifest));
+        DecodeOptions options = ReadOptions();
+
+        foreach (string line in File.ReadAllLines(manifest)) {
+            if (line.StartsWith("#") || line.IndexOf('\t') < 0)
+                continue;
+            string name = line.Substring(0, line.IndexOf('\t'));
+            Bitmap bitmap = ReadPpm(Path.Combine(dir, name));
+
+            for (int r = 0; r < repeat; r++) {
+                Stopwatch watch = Stopwatch.StartNew();
+                DmtxDecoded[] found = Dmtx.Decode(bitmap, options);
+                double ms = watch.Elapsed.TotalMilliseconds;
+
+                StringBuilder output = new StringBuilder(name);
+                output.Append('\t').Append(ms.ToString("F3", CultureInfo.InvariantCulture));
+                foreach (DmtxDecoded d in found)
+                    output.Append('\t').Append(Encoding.ASCII.GetString(d.Data).TrimEnd('\0'));
+                Console.WriteLine(output);
+            }
+            bitmap.Dispose();
+        }
+
+        Console.WriteLine("#rss_kb\t" + PeakRssKb());
+    }
+}
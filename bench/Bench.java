@@ -0,0 +1,116 @@
+/*
+ * Java decode benchmark driver; see bench/benchc.c for the protocol
+ *
+ *   $ javac -cp java/dmtx.jar -d . bench/Bench.java
+ *   $ java -cp java/dmtx.jar:. -Djava.library.path=java/native Bench corpus.txt [repeat]
+ */
+
+import java.io.BufferedReader;
+import java.io.DataInputStream;
+import java.io.File;
+import java.io.FileInputStream;
+import java.io.FileReader;
+import java.io.IOException;
+
+import org.libdmtx.DMTXImage;
+import org.libdmtx.DMTXTag;
+
+public class Bench {
+  /**
+   * Read a binary PPM into 0x00RRGGBB ints, as DMTXImage holds them
+   */
+  private static DMTXImage readPpm(File aFile) throws IOException {
+    DataInputStream lIn = new DataInputStream(new FileInputStream(aFile));
+    int[] lHeader = new int[4];
+    int lField = 0, lC = lIn.read();
+
+    try {
+      while (lField < 4) {
+        while (Character.isWhitespace(lC))
+          lC = lIn.read();
+        StringBuilder lWord = new StringBuilder();
+        while (lC != -1 && !Character.isWhitespace(lC)) {
+          lWord.append((char)lC);
+          lC = lIn.read();
+        }
+        lHeader[lField] = (lField == 0) ? 0 : Integer.parseInt(lWord.toString());
+        lField++;
+      }
+
+      byte[] lRgb = new byte[lHeader[1] * lHeader[2] * 3];
+      lIn.readFully(lRgb);
+
+      int[] lData = new int[lHeader[1] * lHeader[2]];
+      for (int i = 0; i < lData.length; i++)
+        lData[i] = ((lRgb[3 * i] & 0xff) << 16) | ((lRgb[3 * i + 1] & 0xff) << 8) |
+            (lRgb[3 * i + 2] & 0xff);
+
+      return new DMTXImage(lHeader[1], lHeader[2], lData);
+    }
+    finally {
+      lIn.close();
+    }
+  }
+
+  private static long peakRssKb() throws IOException {
+    BufferedReader lIn = new BufferedReader(new FileReader("/proc/self/status"));
+    try {
+      for (String lLine = lIn.readLine(); lLine != null; lLine = lIn.readLine()) {
+        if (lLine.startsWith("VmHWM:"))
+          return Long.parseLong(lLine.substring(6).trim().split("\\s+")[0]);
+      }
+    }
+    finally {
+      lIn.close();
+    }
+    return -1;
+  }
+
+  public static void main(String[] aArgs) throws IOException {
+    // Preset options (see bench/benchc.c); getTags() takes these three
+    int lMaxCount = -1, lTimeout = -1, lLuma = 0;
+    String lOptions = System.getenv("DMTX_BENCH_OPTIONS");
+    for (String lWord : (lOptions == null) ? new String[0] : lOptions.trim().split("\\s+")) {
+      if (lWord.length() == 0)
+        continue;
+      String lName = lWord.substring(0, lWord.indexOf('='));
+      int lValue = Integer.parseInt(lWord.substring(lWord.indexOf('=') + 1));
+      if (lName.equals("max_count"))
+        lMaxCount = lValue;
+      else if (lName.equals("timeout"))
+        lTimeout = lValue;
+      else if (lName.equals("luma"))
+        lLuma = lValue;
+      else {
+        System.err.println("unsupported option " + lName);
+        System.exit(3);
+      }
+    }
+
+    File lManifest = new File(aArgs[0]);
+    int lRepeat = (aArgs.length > 1) ? Integer.parseInt(aArgs[1]) : 1;
+    BufferedReader lIn = new BufferedReader(new FileReader(lManifest));
+
+    for (String lLine = lIn.readLine(); lLine != null; lLine = lIn.readLine()) {
+      if (lLine.startsWith("#") || lLine.indexOf('\t') < 0)
+        continue;
+      String lName = lLine.substring(0, lLine.indexOf('\t'));
+      DMTXImage lImage = readPpm(new File(lManifest.getParentFile(), lName));
+
+      for (int r = 0; r < lRepeat; r++) {
+        long lT0 = System.nanoTime();
+        DMTXTag[] lTags = lImage.getTags(lMaxCount, lTimeout, lLuma);
+        double lMs = (System.nanoTime() - lT0) / 1.0e6;
+
+        StringBuilder lOut = new StringBuilder(lName);
+        lOut.append('\t').append(String.format("%.3f", lMs));
+        for (int i = 0; lTags != null && i < lTags.length; i++)
+          lOut.append('\t').append(lTags[i].id);
+        System.out.println(lOut);
+      }
+    }
+    lIn.close();
+
+    System.out.println("#rss_kb\t" + peakRssKb());
+  }
+}
@@ -0,0 +1,65 @@
+<?php
+/*
+ * PHP decode benchmark driver; see bench/benchc.c for the protocol. The
+ * PHP extension only encodes, so PHP decodes through dmtxd; the times
+ * include the socket round trip.
+ *
+ *   $ DMTXD_SOCKET=/tmp/dmtxd.sock php bench/bench.php corpus.txt [repeat]
+ */
+
+require_once dirname(__FILE__) . '/../php/dmtxd_client.php';
+
+function readPpm($path, &$width, &$height)
+{
+	$data = file_get_contents($path);
+	if (!preg_match('/^P6\s+(\d+)\s+(\d+)\s+255\s/', $data, $m))
+		return false;
+	$width = (int)$m[1];
+	$height = (int)$m[2];
+	return substr($data, strlen($m[0]), $width * $height * 3);
+}
+
+function peakRssKb()
+{
+	foreach (file('/proc/self/status') as $line) {
+		if (strncmp($line, 'VmHWM:', 6) == 0)
+			return (int)substr($line, 6);
+	}
+	return -1;
+}
+
+/* Preset options (see bench/benchc.c) go to dmtxd as they are */
+$options = array();
+foreach (preg_split('/\s+/', trim((string)getenv('DMTX_BENCH_OPTIONS'))) as $word) {
+	if ($word != '') {
+		list($name, $value) = explode('=', $word);
+		$options[$name] = (int)$value;
+	}
+}
+
+$manifest = $argv[1];
+$repeat = isset($argv[2]) ? (int)$argv[2] : 1;
+$socket = getenv('DMTXD_SOCKET');
+$client = new DmtxdClient($socket ? $socket : '/tmp/dmtxd.sock');
+
+foreach (file($manifest) as $line) {
+	if ($line[0] == '#' || strpos($line, "\t") === false)
+		continue;
+	$fields = explode("\t", $line);
+	$pixels = readPpm(dirname($manifest) . '/' . $fields[0], $width, $height);
+	if ($pixels === false) {
+		fwrite(STDERR, "unable to read {$fields[0]}\n");
+		exit(1);
+	}
+	for ($r = 0; $r < $repeat; $r++) {
+		$t0 = microtime(true);
+		$result = $client->decode($pixels, $width, $height, 'rgb24', $options);
+		$ms = (microtime(true) - $t0) * 1000.0;
+		$out = array($fields[0], sprintf('%.3f', $ms));
+		foreach ($result['symbols'] as $symbol)
+			$out[] = $symbol['data'];
+		echo implode("\t", $out), "\n";
+	}
+}
+
+echo "#rss_kb\t", peakRssKb(), "\n";
@@ -0,0 +1,58 @@
+#!/usr/bin/env python
+#
+# pydmtx decode benchmark driver; see bench/benchc.c for the protocol
+#
+#   $ PYTHONPATH=python/build/lib... python bench/bench.py corpus.txt [repeat]
+
+import os
+import sys
+import time
+from pydmtx import DataMatrix
+
+def read_ppm( path ):
+	data = open( path, 'rb' ).read()
+	fields = []
+	pos = 0
+	while len(fields) < 4:
+		while data[pos].isspace():
+			pos += 1
+		start = pos
+		while not data[pos].isspace():
+			pos += 1
+		fields.append( data[start:pos] )
+	width, height = int(fields[1]), int(fields[2])
+	return width, height, data[pos + 1:pos + 1 + width * height * 3]
+
+# Preset options (see bench/benchc.c) are passed on as keywords
+def options():
+	opts = {}
+	for word in os.environ.get( 'DMTX_BENCH_OPTIONS', '' ).split():
+		name, value = word.split( '=' )
+		opts[name] = int( value )
+	return opts
+
+def peak_rss_kb():
+	for line in open( '/proc/self/status' ):
+		if line.startswith( 'VmHWM:' ):
+			return int( line.split()[1] )
+	return -1
+
+manifest = sys.argv[1]
+repeat = int( sys.argv[2] ) if len(sys.argv) > 2 else 1
+base = os.path.dirname( manifest )
+
+opts = options()
+dm = DataMatrix()
+for line in open( manifest ):
+	if line.startswith( '#' ) or '\t' not in line:
+		continue
+	name = line.split( '\t' )[0]
+	width, height, pixels = read_ppm( os.path.join( base, name ) )
+	for r in range( repeat ):
+		t0 = time.time()
+		dm.decode( width, height, buffer(pixels), **opts )
+		ms = (time.time() - t0) * 1000.0
+		messages = [ dm.message( i + 1 ) for i in range( dm.count() ) ]
+		print '\t'.join( [ name, '%.3f' % ms ] + messages )
+
+print '#rss_kb\t%d' % peak_rss_kb()
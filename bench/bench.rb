@@ -0,0 +1,46 @@
+#!/usr/bin/env ruby
+#
+# Rdmtx decode benchmark driver; see bench/benchc.c for the protocol
+#
+#   $ ruby -I ruby bench/bench.rb corpus.txt [repeat]
+
+require 'rubygems'
+require 'RMagick'
+require 'Rdmtx'
+
+def peak_rss_kb
+    File.foreach('/proc/self/status') do |line|
+        return line.split[1].to_i if line.start_with?('VmHWM:')
+    end
+    -1
+end
+
+# Preset options (see bench/benchc.c); Rdmtx#decode takes timeout and luma
+options = { 'timeout' => 0, 'luma' => 0 }
+ENV.fetch('DMTX_BENCH_OPTIONS', '').split.each do |word|
+    name, value = word.split('=')
+    unless options.key?(name)
+        $stderr.puts "unsupported option #{name}"
+        exit 3
+    end
+    options[name] = value.to_i
+end
+
+manifest = ARGV[0]
+repeat = (ARGV[1] || 1).to_i
+base = File.dirname(manifest)
+
+rdmtx = Rdmtx.new
+File.foreach(manifest) do |line|
+    next if line.start_with?('#') || !line.include?("\t")
+    name = line.split("\t")[0]
+    image = Magick::Image.read(File.join(base, name)).first
+    repeat.times do
+        t0 = Process.clock_gettime(Process::CLOCK_MONOTONIC)
+        messages = rdmtx.decode(image, options['timeout'], options['luma'])
+        ms = (Process.clock_gettime(Process::CLOCK_MONOTONIC) - t0) * 1000.0
+        puts ([name, format('%.3f', ms)] + messages).join("\t")
+    end
+end
+
+puts "#rss_kb\t#{peak_rss_kb}"
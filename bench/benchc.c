@@ -0,0 +1,259 @@
+/*
+benchc - Decode benchmark driver for the plain libdmtx C API
+
+Copyright (C) 2026 The libdmtx-wrappers project
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+Contact: mike@dragonflylogic.com
+*/
+
+/* $Id$ */
+
+/**
+ * @file benchc.c
+ * @brief Baseline for the wrapper benchmarks: the libdmtx decode loop
+ *        with nothing in between
+ *
+ * Every driver in bench/ reads the same manifest, decodes each scene's
+ * RGB pixels the given number of times with its wrapper's defaults (all
+ * symbols, no timeout) and prints one line per decode:
+ *
+ *   file <TAB> milliseconds <TAB> message <TAB> message ...
+ *
+ * followed by "#rss_kb <TAB> peak resident set" from /proc/self/status.
+ * Only the decode call is timed, not reading the file. Options of a
+ * preset come in DMTX_BENCH_OPTIONS as "name=value ..." with libdmtxw
+ * property names; a driver that cannot apply one prints "unsupported
+ * option" and exits with 3. This one calls dmtxRegionFindNext() and
+ * dmtxDecodeMatrixRegion() directly, as a C program without libdmtxw
+ * would; run.sh compares the others with it.
+ *
+ *   $ benchc corpus.txt [repeat]
+ */
+
+#define _XOPEN_SOURCE 700
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "dmtxw.h"
+
+#define BENCH_MAX_LINE        4096
+#define BENCH_MAX_OPTIONS     16
+
+/* Decode settings from DMTX_BENCH_OPTIONS */
+typedef struct {
+   int scale;
+   int maxCount;
+   int timeout;
+   int corrections;
+   int propCount;
+   int prop[BENCH_MAX_OPTIONS];
+   int value[BENCH_MAX_OPTIONS];
+} Options;
+
+static int ParseOptions(Options *opt);
+static double Now(void);
+static void PrintPeakRss(void);
+
+/**
+ * @brief  Decode every scene in the manifest and print the timings
+ * @param  argc Argument count
+ * @param  argv Manifest and optional repeat count
+ * @return 0 on success, 1 if a scene could not be read
+ */
+int
+main(int argc, char *argv[])
+{
+   FILE *manifest;
+   char line[BENCH_MAX_LINE], *name, *path, *slash;
+   int repeat, r;
+   double t0, ms;
+   DmtxwPnm pnm;
+   DmtxImage *img;
+   DmtxDecode *dec;
+   DmtxRegion *reg;
+   DmtxMessage *msg;
+   DmtxTime timeout;
+   Options opt;
+   char *messages;
+   size_t used, capacity = BENCH_MAX_LINE;
+   int i, found;
+
+   if(argc < 2 || argc > 3) {
+      fprintf(stderr, "usage: %s corpus.txt [repeat]\n", argv[0]);
+      return 1;
+   }
+   repeat = (argc > 2) ? atoi(argv[2]) : 1;
+   if(ParseOptions(&opt) != 0)
+      return 3;
+
+   manifest = fopen(argv[1], "r");
+   path = (char *)malloc(strlen(argv[1]) + BENCH_MAX_LINE);
+   messages = (char *)malloc(capacity);
+   if(manifest == NULL || path == NULL || messages == NULL || repeat < 1) {
+      perror(argv[1]);
+      return 1;
+   }
+
+   /* Scene files live next to the manifest */
+   strcpy(path, argv[1]);
+   slash = strrchr(path, '/');
+   name = (slash == NULL) ? path : slash + 1;
+
+   while(fgets(line, sizeof(line), manifest) != NULL) {
+      if(line[0] == '#' || strchr(line, '\t') == NULL)
+         continue;
+      *strchr(line, '\t') = '\0';
+      strcpy(name, line);
+
+      if(dmtxwPnmMap(path, &pnm) == DmtxFail || pnm.format != DmtxwFormatRGB24) {
+         fprintf(stderr, "%s: unable to read %s\n", argv[0], path);
+         return 1;
+      }
+
+      for(r = 0; r < repeat; r++) {
+         used = 0;
+         messages[0] = '\0';
+
+         found = 0;
+
+         t0 = Now();
+         if(opt.timeout != DmtxUndefined)
+            timeout = dmtxTimeAdd(dmtxTimeNow(), opt.timeout);
+         img = dmtxImageCreate((unsigned char *)pnm.pxl, pnm.width, pnm.height,
+               DmtxPack24bppRGB);
+         dec = (img == NULL) ? NULL : dmtxDecodeCreate(img, opt.scale);
+         for(i = 0; dec != NULL && i < opt.propCount; i++)
+            dmtxDecodeSetProp(dec, opt.prop[i], opt.value[i]);
+         while(dec != NULL && (opt.maxCount == DmtxUndefined || found < opt.maxCount) &&
+               (reg = dmtxRegionFindNext(dec, (opt.timeout == DmtxUndefined) ?
+               NULL : &timeout)) != NULL) {
+            msg = dmtxDecodeMatrixRegion(dec, reg, opt.corrections);
+            if(msg != NULL) {
+               found++;
+               if(used + msg->outputIdx + 2 < capacity) {
+                  messages[used++] = '\t';
+                  memcpy(messages + used, msg->output, msg->outputIdx);
+                  used += msg->outputIdx;
+                  messages[used] = '\0';
+               }
+               dmtxMessageDestroy(&msg);
+            }
+            dmtxRegionDestroy(&reg);
+         }
+         if(dec != NULL)
+            dmtxDecodeDestroy(&dec);
+         if(img != NULL)
+            dmtxImageDestroy(&img);
+         ms = Now() - t0;
+
+         printf("%s\t%.3f%s\n", line, ms, messages);
+      }
+
+      dmtxwPnmUnmap(&pnm);
+   }
+
+   PrintPeakRss();
+
+   fclose(manifest);
+   free(path);
+   free(messages);
+
+   return 0;
+}
+
+/**
+ * @brief  Read the preset options from DMTX_BENCH_OPTIONS. libdmtx decode
+ *         properties, shrink, max_count, timeout and corrections can be
+ *         applied without libdmtxw.
+ * @param  opt Receives the settings
+ * @return 0, or 3 after printing why an option cannot be applied
+ */
+static int
+ParseOptions(Options *opt)
+{
+   const char *env = getenv("DMTX_BENCH_OPTIONS");
+   char name[64];
+   int prop, value, used;
+
+   opt->scale = 1;
+   opt->maxCount = DmtxUndefined;
+   opt->timeout = DmtxUndefined;
+   opt->corrections = DmtxUndefined;
+   opt->propCount = 0;
+
+   while(env != NULL && sscanf(env, " %63[^=]=%d%n", name, &value, &used) == 2) {
+      env += used;
+      prop = dmtxwPropByName(name);
+      if(prop == DmtxwPropShrink)
+         opt->scale = value;
+      else if(prop == DmtxwPropMaxCount)
+         opt->maxCount = value;
+      else if(prop == DmtxwPropTimeout)
+         opt->timeout = value;
+      else if(prop == DmtxwPropCorrections)
+         opt->corrections = value;
+      else if(prop != DmtxUndefined && prop < DmtxwPropMaxCount &&
+            opt->propCount < BENCH_MAX_OPTIONS) {
+         opt->prop[opt->propCount] = prop;
+         opt->value[opt->propCount++] = value;
+      }
+      else {
+         fprintf(stderr, "unsupported option %s\n", name);
+         return 3;
+      }
+   }
+
+   return 0;
+}
+
+/**
+ * @brief  Monotonic wall clock
+ * @return Milliseconds
+ */
+static double
+Now(void)
+{
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+
+   return ts.tv_sec * 1000.0 + ts.tv_nsec / 1.0e6;
+}
+
+/**
+ * @brief  Print the peak resident set size line of the driver protocol
+ * @return void
+ */
+static void
+PrintPeakRss(void)
+{
+   FILE *fp;
+   char line[256];
+   long kb = -1;
+
+   fp = fopen("/proc/self/status", "r");
+   while(fp != NULL && fgets(line, sizeof(line), fp) != NULL) {
+      if(strncmp(line, "VmHWM:", 6) == 0)
+         kb = atol(line + 6);
+   }
+   if(fp != NULL)
+      fclose(fp);
+
+   printf("#rss_kb\t%ld\n", kb);
+}
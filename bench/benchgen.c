@@ -0,0 +1,576 @@
+/*
+benchgen - Synthetic decode benchmark corpus
+
+Copyright (C) 2026 The libdmtx-wrappers project
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+Contact: mike@dragonflylogic.com
+*/
+
+/* $Id$ */
+
+/**
+ * @file benchgen.c
+ * @brief Write the benchmark corpus: PPM scenes and a manifest of the
+ *        messages in each
+ *
+ * Every ECC200 symbol size appears in four single-symbol scenes: upright
+ * and clean, rotated by any angle, small modules near a right angle, and
+ * large modules with low contrast and heavy noise. Multi-symbol scenes
+ * follow, with two to four rotated symbols each. Symbols are encoded by
+ * libdmtx at module size 1 (dmtxwEncodeDataMatrix()) and drawn with 3x3
+ * supersampling through the inverse rotation, so module edges are soft
+ * as in a camera image. Everything comes from one LCG, so a seed always
+ * gives the same files on every platform.
+ *
+ * Files are named after their look and number (upright-0000.ppm, ...,
+ * multi-0120.ppm), which perfcheck.sh uses to group its cases. The
+ * manifest (corpus.txt) has one line per scene: the file name, the
+ * number of symbols and their messages, separated by tabs. Messages are
+ * upper case letters and digits only.
+ *
+ * With -p the same scenes are written as 8 bit grayscale PNG files for
+ * the golden corpus instead, with no manifest: each file carries one
+ * "Message" tEXt chunk per symbol, which goldprep.py reads back.
+ *
+ *   $ benchgen [-p] directory [seed [multi-symbol scenes]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "dmtxw.h"
+
+#define BENCH_SIZES           30
+#define BENCH_MULTI           20
+#define BENCH_MAX_SYMBOLS     4
+#define BENCH_MAX_MESSAGE     64
+#define BENCH_MULTI_WIDTH     1024
+#define BENCH_MULTI_HEIGHT    768
+
+#ifndef M_PI
+#define M_PI      3.14159265358979323846
+#endif
+
+/* One symbol to draw into a scene */
+typedef struct {
+   int sizeIdx;
+   int moduleSize;                 /* Pixels per module */
+   double angle;                   /* Degrees, counterclockwise */
+   int cx, cy;                     /* Centre in the scene */
+   char message[BENCH_MAX_MESSAGE + 1];
+} Placement;
+
+/* Scene pixels and look */
+typedef struct {
+   const char *kind;               /* Look, used as the file name prefix */
+   unsigned char *pxl;             /* 8 bpp, written out as gray RGB */
+   int width;
+   int height;
+   int light;
+   int dark;
+   int noise;                      /* Peak noise amplitude */
+} Scene;
+
+/* Small LCG so the corpus is the same on every platform */
+static unsigned long seed = 1;
+
+/* Write PNG files with tEXt chunks instead of PPM files and a manifest */
+static int png = 0;
+
+static int Random(int n);
+static void MakeMessage(Placement *p);
+static int SymbolExtent(const Placement *p);
+static DmtxPassFail DrawSymbol(Scene *scene, const Placement *p);
+static DmtxPassFail WriteScene(const char *dir, int index, Scene *scene,
+      const Placement *p, int count, FILE *manifest);
+static DmtxPassFail WritePng(FILE *fp, const Scene *scene, const Placement *p, int count);
+static DmtxPassFail WritePngChunk(FILE *fp, const char *type, const unsigned char *data,
+      size_t length);
+static void PutBigEndian32(unsigned char *buf, unsigned long value);
+
+/**
+ * @brief  Write every scene and the manifest
+ * @param  argc Argument count
+ * @param  argv -p, output directory, optional seed and multi-symbol scene count
+ * @return 0 on success, 1 otherwise
+ */
+int
+main(int argc, char *argv[])
+{
+   static const struct {
+      const char *kind;
+      int light, dark, noise, minModule, spanModule;
+   } look[4] = {
+      { "upright", 235, 20,  0, 4, 1 },  /* Upright and clean */
+      { "rotated", 225, 35, 12, 3, 4 },  /* Any angle */
+      { "small",   220, 40, 24, 2, 2 },  /* Small modules, near 90 degrees */
+      { "noisy",   180, 80, 40, 6, 3 }   /* Large modules, low contrast, noisy */
+   };
+   Scene scene;
+   Placement p[BENCH_MAX_SYMBOLS];
+   FILE *manifest = NULL;
+   char *path, *dir;
+   int i, j, v, multi, index = 0, extent, count;
+   DmtxPassFail err = DmtxPass;
+
+   if(argc > 1 && strcmp(argv[1], "-p") == 0) {
+      png = 1;
+      argv[1] = argv[0];
+      argc--;
+      argv++;
+   }
+   if(argc < 2 || argc > 4) {
+      fprintf(stderr, "usage: %s [-p] directory [seed [multi-symbol scenes]]\n", argv[0]);
+      return 1;
+   }
+   dir = argv[1];
+   seed = (argc > 2) ? strtoul(argv[2], NULL, 10) : 1;
+   multi = (argc > 3) ? atoi(argv[3]) : BENCH_MULTI;
+
+   if(!png) {
+      path = (char *)malloc(strlen(dir) + 32);
+      if(path == NULL)
+         return 1;
+      sprintf(path, "%s/corpus.txt", dir);
+      manifest = fopen(path, "w");
+      if(manifest == NULL) {
+         perror(path);
+         return 1;
+      }
+      free(path);
+      fprintf(manifest, "# benchgen corpus, seed %lu: file, symbols, messages\n", seed);
+   }
+
+   memset(&scene, 0x00, sizeof(Scene));
+
+   /* Every size, in each of the four looks */
+   for(i = 0; i < BENCH_SIZES && err == DmtxPass; i++) {
+      for(v = 0; v < 4 && err == DmtxPass; v++) {
+         p[0].sizeIdx = i;
+         p[0].moduleSize = look[v].minModule + Random(look[v].spanModule);
+         switch(v) {
+            case 0:
+               p[0].angle = 0.0;
+               break;
+            case 2:
+               p[0].angle = 90.0 * Random(4) + Random(21) - 10;
+               break;
+            default:
+               p[0].angle = Random(360);
+               break;
+         }
+         MakeMessage(&p[0]);
+
+         extent = SymbolExtent(&p[0]);
+         scene.width = extent + 40 + Random(40);
+         scene.height = extent + 40 + Random(40);
+         scene.kind = look[v].kind;
+         scene.light = look[v].light;
+         scene.dark = look[v].dark;
+         scene.noise = look[v].noise;
+         p[0].cx = scene.width / 2;
+         p[0].cy = scene.height / 2;
+
+         err = WriteScene(dir, index++, &scene, p, 1, manifest);
+      }
+   }
+
+   /* Two to four symbols, one per quarter of the scene */
+   for(i = 0; i < multi && err == DmtxPass; i++) {
+      count = 2 + Random(BENCH_MAX_SYMBOLS - 1);
+      for(j = 0; j < count; j++) {
+         p[j].sizeIdx = Random(14);
+         p[j].angle = Random(360);
+         MakeMessage(&p[j]);
+
+         /* Largest module that keeps the rotated symbol inside its quarter */
+         for(p[j].moduleSize = 2 + Random(4); p[j].moduleSize > 1; p[j].moduleSize--) {
+            if(SymbolExtent(&p[j]) <= BENCH_MULTI_HEIGHT / 2 - 24)
+               break;
+         }
+         p[j].cx = (j % 2) * (BENCH_MULTI_WIDTH / 2) + BENCH_MULTI_WIDTH / 4 + Random(41) - 20;
+         p[j].cy = (j / 2) * (BENCH_MULTI_HEIGHT / 2) + BENCH_MULTI_HEIGHT / 4 + Random(21) - 10;
+      }
+      scene.kind = "multi";
+      scene.width = BENCH_MULTI_WIDTH;
+      scene.height = BENCH_MULTI_HEIGHT;
+      scene.light = 215 + Random(20);
+      scene.dark = 25 + Random(30);
+      scene.noise = 8 * Random(4);
+
+      err = WriteScene(dir, index++, &scene, p, count, manifest);
+   }
+
+   free(scene.pxl);
+   if(manifest != NULL && fclose(manifest) != 0)
+      err = DmtxFail;
+
+   if(err == DmtxFail) {
+      fprintf(stderr, "%s: unable to write scene %d\n", argv[0], index - 1);
+      return 1;
+   }
+
+   printf("%d scenes in %s\n", index, dir);
+
+   return 0;
+}
+
+/**
+ * @brief  Next pseudo-random number
+ * @param  n Upper bound
+ * @return Number in 0 .. n-1
+ */
+static int
+Random(int n)
+{
+   seed = seed * 1103515245UL + 12345UL;
+   return (int)((seed >> 16) & 0x7fff) % n;
+}
+
+/**
+ * @brief  Pick a message that fills about half of the symbol's data words,
+ *         so that it fits the requested size in any scheme
+ * @param  p Placement with sizeIdx set; receives the message
+ * @return void
+ */
+static void
+MakeMessage(Placement *p)
+{
+   static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+   const DmtxwSymbolInfo *info = dmtxwSymbolInfo(p->sizeIdx);
+   int i, length;
+
+   length = info->dataWords / 2;
+   if(length < 1)
+      length = 1;
+   if(length > BENCH_MAX_MESSAGE)
+      length = BENCH_MAX_MESSAGE;
+
+   for(i = 0; i < length; i++)
+      p->message[i] = alphabet[Random(36)];
+   p->message[length] = '\0';
+}
+
+/**
+ * @brief  Side of the square that holds the rotated symbol and its quiet
+ *         zone
+ * @param  p Placement
+ * @return Pixels
+ */
+static int
+SymbolExtent(const Placement *p)
+{
+   const DmtxwSymbolInfo *info = dmtxwSymbolInfo(p->sizeIdx);
+   double w = (info->cols + 2) * p->moduleSize;
+   double h = (info->rows + 2) * p->moduleSize;
+
+   return (int)ceil(sqrt(w * w + h * h));
+}
+
+/**
+ * @brief  Encode a placement and draw it into the scene
+ * @param  scene Scene
+ * @param  p Placement
+ * @return DmtxPass | DmtxFail
+ */
+static DmtxPassFail
+DrawSymbol(Scene *scene, const Placement *p)
+{
+   DmtxEncode *enc;
+   unsigned char *module;
+   double c, s, u, v, dx, dy;
+   int x, y, x0, y0, x1, y1, sx, sy, sum, cols, rows, half;
+   int width, height, mx, my;
+
+   enc = dmtxEncodeCreate();
+   if(enc == NULL)
+      return DmtxFail;
+   dmtxEncodeSetProp(enc, DmtxPropSizeRequest, p->sizeIdx);
+   dmtxEncodeSetProp(enc, DmtxPropModuleSize, 1);
+   dmtxEncodeSetProp(enc, DmtxPropMarginSize, 0);
+
+   /* One byte per module, 0x00 dark */
+   if(dmtxwEncodeDataMatrix(enc, (int)strlen(p->message),
+         (const unsigned char *)p->message) == DmtxFail ||
+         dmtxwEncodeGetSize(enc, &cols, &rows) == DmtxFail ||
+         (module = (unsigned char *)malloc((size_t)cols * rows)) == NULL) {
+      dmtxEncodeDestroy(&enc);
+      return DmtxFail;
+   }
+   dmtxwEncodeExpand(enc, module, cols, DmtxwFormatGray8);
+   dmtxEncodeDestroy(&enc);
+
+   c = cos(p->angle * M_PI / 180.0);
+   s = sin(p->angle * M_PI / 180.0);
+   width = cols * p->moduleSize;
+   height = rows * p->moduleSize;
+   half = SymbolExtent(p) / 2 + 1;
+
+   x0 = (p->cx - half < 0) ? 0 : p->cx - half;
+   y0 = (p->cy - half < 0) ? 0 : p->cy - half;
+   x1 = (p->cx + half > scene->width) ? scene->width : p->cx + half;
+   y1 = (p->cy + half > scene->height) ? scene->height : p->cy + half;
+
+   /* Inverse rotation of 3x3 subpixels into module coordinates */
+   for(y = y0; y < y1; y++) {
+      for(x = x0; x < x1; x++) {
+         sum = 0;
+         for(sy = 0; sy < 3; sy++) {
+            for(sx = 0; sx < 3; sx++) {
+               dx = x + (sx + 0.5) / 3.0 - p->cx;
+               dy = y + (sy + 0.5) / 3.0 - p->cy;
+               u = c * dx - s * dy + width / 2.0;
+               v = s * dx + c * dy + height / 2.0;
+               mx = (int)floor(u / p->moduleSize);
+               my = (int)floor(v / p->moduleSize);
+               if(mx >= 0 && my >= 0 && mx < cols && my < rows && module[my * cols + mx] == 0)
+                  sum++;
+            }
+         }
+         if(sum > 0)
+            scene->pxl[y * scene->width + x] = (unsigned char)(scene->light -
+                  (scene->light - scene->dark) * sum / 9);
+      }
+   }
+
+   free(module);
+
+   return DmtxPass;
+}
+
+/**
+ * @brief  Draw a scene and write it as a binary PPM added to the manifest, or
+ *         as a PNG with its messages
+ * @param  dir Output directory
+ * @param  index Scene number
+ * @param  scene Scene with its size and look set
+ * @param  p Symbols
+ * @param  count Number of symbols
+ * @param  manifest Manifest file (NULL for PNG)
+ * @return DmtxPass | DmtxFail
+ */
+static DmtxPassFail
+WriteScene(const char *dir, int index, Scene *scene, const Placement *p, int count,
+      FILE *manifest)
+{
+   static unsigned char *row = NULL;
+   static int rowWidth = 0;
+   unsigned char *pxl;
+   char name[32], *path;
+   FILE *fp;
+   int i, x, y, value;
+   DmtxPassFail err = DmtxPass;
+
+   pxl = (unsigned char *)realloc(scene->pxl, (size_t)scene->width * scene->height);
+   if(pxl == NULL)
+      return DmtxFail;
+   scene->pxl = pxl;
+   memset(pxl, scene->light, (size_t)scene->width * scene->height);
+
+   for(i = 0; i < count && err == DmtxPass; i++)
+      err = DrawSymbol(scene, &p[i]);
+   if(err == DmtxFail)
+      return DmtxFail;
+
+   if(scene->noise > 0) {
+      for(i = 0; i < scene->width * scene->height; i++) {
+         value = pxl[i] + Random(2 * scene->noise + 1) - scene->noise;
+         pxl[i] = (unsigned char)((value < 0) ? 0 : (value > 255) ? 255 : value);
+      }
+   }
+
+   sprintf(name, "%.8s-%04d.%s", scene->kind, index, png ? "png" : "ppm");
+   path = (char *)malloc(strlen(dir) + strlen(name) + 2);
+   if(path == NULL)
+      return DmtxFail;
+   sprintf(path, "%s/%s", dir, name);
+   fp = fopen(path, "wb");
+   free(path);
+   if(fp == NULL)
+      return DmtxFail;
+
+   if(png) {
+      err = WritePng(fp, scene, p, count);
+      if(fclose(fp) != 0)
+         err = DmtxFail;
+      return err;
+   }
+
+   if(scene->width > rowWidth) {
+      free(row);
+      row = (unsigned char *)malloc((size_t)scene->width * 3);
+      rowWidth = (row == NULL) ? 0 : scene->width;
+      if(row == NULL) {
+         fclose(fp);
+         return DmtxFail;
+      }
+   }
+
+   fprintf(fp, "P6\n%d %d\n255\n", scene->width, scene->height);
+   for(y = 0; y < scene->height; y++) {
+      for(x = 0; x < scene->width; x++)
+         row[3 * x] = row[3 * x + 1] = row[3 * x + 2] = pxl[y * scene->width + x];
+      if(fwrite(row, 3, scene->width, fp) != (size_t)scene->width)
+         err = DmtxFail;
+   }
+   if(fclose(fp) != 0)
+      err = DmtxFail;
+
+   fprintf(manifest, "%s\t%d", name, count);
+   for(i = 0; i < count; i++)
+      fprintf(manifest, "\t%s", p[i].message);
+   fprintf(manifest, "\n");
+
+   return err;
+}
+
+/**
+ * @brief  Write the scene as an 8 bit grayscale PNG with one "Message" tEXt
+ *         chunk per symbol. The image data is deflated in stored blocks,
+ *         so no zlib is needed.
+ * @param  fp Output file
+ * @param  scene Drawn scene
+ * @param  p Symbols
+ * @param  count Number of symbols
+ * @return DmtxPass | DmtxFail
+ */
+static DmtxPassFail
+WritePng(FILE *fp, const Scene *scene, const Placement *p, int count)
+{
+   static const unsigned char signature[8] = { 137, 'P', 'N', 'G', '\r', '\n', 26, '\n' };
+   unsigned char header[13], text[BENCH_MAX_MESSAGE + 16], *idat, *out;
+   size_t rawSize, idatSize, left, block, length;
+   unsigned long a = 1, b = 0;
+   int i, y, x;
+   DmtxPassFail err;
+
+   /* Filter byte 0 before every row */
+   rawSize = (size_t)(scene->width + 1) * scene->height;
+   idatSize = 2 + rawSize + 5 * (rawSize / 65535 + 1) + 4;
+   idat = (unsigned char *)malloc(idatSize);
+   if(idat == NULL)
+      return DmtxFail;
+
+   out = idat;
+   *out++ = 0x78;
+   *out++ = 0x01;
+   left = rawSize;
+   x = -1;
+   y = 0;
+   while(left > 0) {
+      block = (left > 65535) ? 65535 : left;
+      left -= block;
+      *out++ = (left == 0) ? 1 : 0;
+      *out++ = (unsigned char)(block & 0xff);
+      *out++ = (unsigned char)(block >> 8);
+      *out++ = (unsigned char)(~block & 0xff);
+      *out++ = (unsigned char)((~block >> 8) & 0xff);
+      while(block-- > 0) {
+         *out = (x < 0) ? 0 : scene->pxl[y * scene->width + x];
+         a = (a + *out++) % 65521;
+         b = (b + a) % 65521;
+         if(++x == scene->width) {
+            x = -1;
+            y++;
+         }
+      }
+   }
+   PutBigEndian32(out, (b << 16) | a);
+   out += 4;
+
+   PutBigEndian32(header, (unsigned long)scene->width);
+   PutBigEndian32(header + 4, (unsigned long)scene->height);
+   header[8] = 8;                  /* Bit depth */
+   header[9] = 0;                  /* Grayscale */
+   header[10] = header[11] = header[12] = 0;
+
+   err = (fwrite(signature, 1, 8, fp) == 8) ? DmtxPass : DmtxFail;
+   if(err == DmtxPass)
+      err = WritePngChunk(fp, "IHDR", header, 13);
+   for(i = 0; i < count && err == DmtxPass; i++) {
+      length = strlen(p[i].message);
+      memcpy(text, "Message", 8);
+      memcpy(text + 8, p[i].message, length);
+      err = WritePngChunk(fp, "tEXt", text, 8 + length);
+   }
+   if(err == DmtxPass)
+      err = WritePngChunk(fp, "IDAT", idat, (size_t)(out - idat));
+   if(err == DmtxPass)
+      err = WritePngChunk(fp, "IEND", NULL, 0);
+
+   free(idat);
+
+   return err;
+}
+
+/**
+ * @brief  Write one PNG chunk with its length and CRC
+ * @param  fp Output file
+ * @param  type Four letter chunk type
+ * @param  data Chunk data
+ * @param  length Bytes of data
+ * @return DmtxPass | DmtxFail
+ */
+static DmtxPassFail
+WritePngChunk(FILE *fp, const char *type, const unsigned char *data, size_t length)
+{
+   static unsigned long table[256];
+   static int tableReady = 0;
+   unsigned char buf[4];
+   unsigned long crc = 0xffffffffUL, c;
+   size_t i;
+   int n, k;
+
+   if(!tableReady) {
+      for(n = 0; n < 256; n++) {
+         c = (unsigned long)n;
+         for(k = 0; k < 8; k++)
+            c = (c & 1) ? 0xedb88320UL ^ (c >> 1) : c >> 1;
+         table[n] = c;
+      }
+      tableReady = 1;
+   }
+
+   for(i = 0; i < 4; i++)
+      crc = table[(crc ^ (unsigned char)type[i]) & 0xff] ^ (crc >> 8);
+   for(i = 0; i < length; i++)
+      crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+
+   PutBigEndian32(buf, (unsigned long)length);
+   if(fwrite(buf, 1, 4, fp) != 4 || fwrite(type, 1, 4, fp) != 4 ||
+         (length > 0 && fwrite(data, 1, length, fp) != length))
+      return DmtxFail;
+   PutBigEndian32(buf, crc ^ 0xffffffffUL);
+
+   return (fwrite(buf, 1, 4, fp) == 4) ? DmtxPass : DmtxFail;
+}
+
+/**
+ * @brief  Store a 32-bit value most significant byte first
+ * @param  buf Destination (4 bytes)
+ * @param  value Value
+ * @return void
+ */
+static void
+PutBigEndian32(unsigned char *buf, unsigned long value)
+{
+   buf[0] = (unsigned char)((value >> 24) & 0xff);
+   buf[1] = (unsigned char)((value >> 16) & 0xff);
+   buf[2] = (unsigned char)((value >> 8) & 0xff);
+   buf[3] = (unsigned char)(value & 0xff);
+}
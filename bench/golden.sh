@@ -0,0 +1,163 @@
+#!/bin/sh
+#
+# Golden corpus accuracy and speed report (see bench/README, section 6)
+#
+#   $ bench/golden.sh [-b builddir] [-s srcdir] [-g pngdir] [-p presets]
+#                     [-r repeat] [-w wrappers] [-o golden.json]
+#                     [-i images.csv] [-m min_read_rate]
+#
+# Decodes a directory of PNG images whose expected messages are stored
+# in "Message" tEXt chunks through benchc and each wrapper driver, once
+# per option preset, and writes one report of read rate and speed per
+# preset and driver, plus the time and result of every image. With -m
+# the exit status is 1 if any preset and driver read less than the given
+# share (0 to 1) of the expected symbols.
+
+BUILD=.
+SRC=$(dirname "$0")/..
+GOLD=
+PRESETS=
+REPEAT=1
+WRAPPERS=python,ruby,php,java,net
+OUTPUT=golden.json
+IMAGES=golden-images.csv
+MIN_RATE=
+
+while getopts "b:s:g:p:r:w:o:i:m:" opt; do
+   case $opt in
+      b) BUILD="$OPTARG" ;;
+      s) SRC="$OPTARG" ;;
+      g) GOLD="$OPTARG" ;;
+      p) PRESETS="$OPTARG" ;;
+      r) REPEAT="$OPTARG" ;;
+      w) WRAPPERS="$OPTARG" ;;
+      o) OUTPUT="$OPTARG" ;;
+      i) IMAGES="$OPTARG" ;;
+      m) MIN_RATE="$OPTARG" ;;
+      *) echo "usage: $0 [-b builddir] [-s srcdir] [-g pngdir] [-p presets] [-r repeat] [-w wrappers] [-o golden.json] [-i images.csv] [-m min_read_rate]" >&2
+         exit 2 ;;
+   esac
+done
+
+BUILD=$(cd "$BUILD" && pwd)
+SRC=$(cd "$SRC" && pwd)
+test -n "$GOLD" || GOLD="$BUILD/golden-corpus"
+test -n "$PRESETS" || PRESETS="$SRC/bench/presets"
+PREP="$BUILD/golden-prep"
+WORK=$(mktemp -d "${TMPDIR:-/tmp}/dmtxgold.XXXXXX") || exit 2
+trap 'rm -rf "$WORK"' 0
+trap 'exit 2' 1 2 15
+
+# The generated corpus stands in when no images are given
+if ! ls "$GOLD"/*.png > /dev/null 2>&1; then
+   mkdir -p "$GOLD" && "$BUILD/benchgen" -p "$GOLD" || exit 2
+fi
+
+# PNG to PPM and manifest, again only when an image changed
+if test ! -f "$PREP/corpus.txt" || test -n "$(find "$GOLD" -name '*.png' -newer "$PREP/corpus.txt")"; then
+   rm -rf "$PREP"
+   "${PYTHON:-python}" "$SRC/bench/goldprep.py" "$GOLD" "$PREP" || exit 2
+fi
+
+: > "$WORK/presets"
+grep -v '^#' "$PRESETS" | while read -r name options; do
+   test -n "$name" || continue
+   echo "Preset $name${options:+ ($options)}" >&2
+   mkdir "$WORK/$name" || exit 2
+   DMTX_BENCH_OPTIONS="$options" sh "$SRC/bench/run.sh" -b "$BUILD" -s "$SRC" -c "$PREP" \
+         -r "$REPEAT" -w "$WRAPPERS" -o "$WORK/$name/results.json" -k "$WORK/$name" || exit 2
+   printf '%s\t%s\n' "$name" "$options" >> "$WORK/presets"
+done || exit 2
+
+# A JSON string, escaped like q() in run.sh. The value goes through the
+# environment, so awk does not interpret backslashes in it, and out
+# through printf rather than echo for the same reason.
+Quote()
+{
+   GOLDEN_STRING="$1" awk 'BEGIN {
+      s = ENVIRON["GOLDEN_STRING"]
+      gsub(/\\/, "&&", s)
+      gsub(/"/, "\\\"", s)
+      printf "\"%s\"", s
+   }'
+}
+
+# One report: the corpus line of run.sh, then its drivers for each preset
+{
+   echo "{"
+   printf '  "images": %s,\n' "$(Quote "$GOLD")"
+   sed -n 2p "$WORK/$(head -n 1 "$WORK/presets" | cut -f 1)/results.json"
+   echo "  \"presets\": ["
+   sep=
+   while IFS="$(printf '\t')" read -r name options; do
+      test -z "$sep" || echo "$sep"
+      printf '    { "name": %s, "options": %s,\n' "$(Quote "$name")" "$(Quote "$options")"
+      echo "      \"drivers\": {"
+      sed -e '1,3d' -e '$d' "$WORK/$name/results.json" | sed '$d'
+      printf "      } }"
+      sep=","
+   done < "$WORK/presets"
+   printf "\n  ]\n}\n"
+} > "$OUTPUT" || exit 2
+
+# Every decode: preset, driver, image, time, symbols read and expected
+echo "preset,driver,image,ms,found,expected,ms_per_symbol" > "$IMAGES"
+while IFS="$(printf '\t')" read name options; do
+   for out in "$WORK/$name"/*.out; do
+      test -f "$out" || continue
+      awk -F '\t' -v preset="$name" -v driver="$(basename "$out" .out)" \
+            -v manifest="$PREP/corpus.txt" '
+      BEGIN {
+         while((getline line < manifest) > 0) {
+            if(line ~ /^#/)
+               continue
+            nf = split(line, f, "\t")
+            for(i = 3; i <= nf; i++)
+               want[f[1], f[i]] = 1
+            expect[f[1]] = f[2]
+         }
+      }
+      /^#/ { next }
+      {
+         found = 0
+         delete seen
+         for(i = 3; i <= NF; i++) {
+            if(($1, $i) in want && !($i in seen)) {
+               seen[$i] = 1
+               found++
+            }
+         }
+         printf "%s,%s,%s,%s,%d,%d,%s\n", preset, driver, $1, $2, found, expect[$1],
+               (found > 0) ? sprintf("%.3f", $2 / found) : ""
+      }' "$out"
+   done
+done < "$WORK/presets" >> "$IMAGES"
+
+echo "Results in $OUTPUT, every image in $IMAGES" >&2
+
+# Read rate per preset and driver, and the gate
+awk -F, -v minRate="$MIN_RATE" '
+NR > 1 {
+   key = $1 " " $2
+   if(!(key in found))
+      order[++n] = key
+   images[key]++
+   found[key] += $5
+   expected[key] += $6
+   ms[key] += $4
+}
+END {
+   printf "%-12s %-8s %10s %12s\n", "preset", "driver", "read", "ms/image"
+   for(i = 1; i <= n; i++) {
+      key = order[i]
+      split(key, f, " ")
+      rate = (expected[key] > 0) ? found[key] / expected[key] : 1
+      printf "%-12s %-8s %9.1f%% %12.3f\n", f[1], f[2], rate * 100, ms[key] / images[key]
+      if(minRate != "" && rate < minRate + 0)
+         low++
+   }
+   if(low > 0) {
+      printf "%d preset and driver pair(s) read less than %.1f%%\n", low, minRate * 100
+      exit 1
+   }
+}' "$IMAGES"
@@ -0,0 +1,135 @@
+#!/usr/bin/env python
+#
+# Turn a directory of golden PNG images into a benchmark corpus
+#
+#   $ python bench/goldprep.py pngdir corpusdir
+#
+# Every PNG lists the messages it holds in "Message" tEXt (or zTXt)
+# chunks, one per symbol (benchgen -p writes them; scanned images can be
+# tagged with any PNG tool). A PNG without them is expected to hold no
+# symbol. Each image
+# is written to corpusdir as a binary PPM, and corpusdir/corpus.txt lists
+# the expected messages in the manifest format of bench/benchgen.c, so the
+# drivers of bench/run.sh can decode them. Works with Python 2 and 3 and
+# needs nothing beyond zlib.
+
+import os
+import struct
+import sys
+import zlib
+
+def unfilter( raw, width, height, bpp, stride ):
+	rows = []
+	prev = bytearray( stride )
+	pos = 0
+	for y in range( height ):
+		ftype = raw[pos]
+		line = bytearray( raw[pos + 1:pos + 1 + stride] )
+		pos += 1 + stride
+		for i in range( stride ):
+			a = line[i - bpp] if i >= bpp else 0
+			b = prev[i]
+			c = prev[i - bpp] if i >= bpp else 0
+			if ftype == 1:
+				line[i] = (line[i] + a) & 0xff
+			elif ftype == 2:
+				line[i] = (line[i] + b) & 0xff
+			elif ftype == 3:
+				line[i] = (line[i] + ((a + b) >> 1)) & 0xff
+			elif ftype == 4:
+				p = a + b - c
+				pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+				pred = a if (pa <= pb and pa <= pc) else (b if pb <= pc else c)
+				line[i] = (line[i] + pred) & 0xff
+		rows.append( line )
+		prev = line
+	return rows
+
+def read_png( path ):
+	data = open( path, 'rb' ).read()
+	if data[:8] != b'\x89PNG\r\n\x1a\n':
+		raise ValueError( 'not a PNG file' )
+	pos = 8
+	idat = []
+	messages = []
+	palette = None
+	while pos < len(data):
+		length, ctype = struct.unpack( '>I4s', data[pos:pos + 8] )
+		body = data[pos + 8:pos + 8 + length]
+		pos += 12 + length
+		if ctype == b'IHDR':
+			width, height, depth, color, _, _, interlace = struct.unpack( '>IIBBBBB', body )
+		elif ctype == b'PLTE':
+			palette = bytearray( body )
+		elif ctype == b'tEXt':
+			key, _, text = body.partition( b'\0' )
+			if key == b'Message':
+				messages.append( text.decode( 'latin-1' ) )
+		elif ctype == b'zTXt':
+			# Some tools compress longer text
+			key, _, text = body.partition( b'\0' )
+			if key == b'Message':
+				messages.append( zlib.decompress( text[1:] ).decode( 'latin-1' ) )
+		elif ctype == b'IDAT':
+			idat.append( body )
+		elif ctype == b'IEND':
+			break
+
+	channels = { 0: 1, 2: 3, 3: 1, 4: 2, 6: 4 }[color]
+	if interlace != 0 or depth == 16 or (depth < 8 and channels != 1):
+		raise ValueError( 'interlaced, 16 bit and packed color PNGs are not supported' )
+
+	bits = depth * channels
+	stride = (width * bits + 7) // 8
+	rows = unfilter( bytearray( zlib.decompress( b''.join( idat ) ) ), width, height,
+			max( 1, bits // 8 ), stride )
+
+	rgb = bytearray( width * height * 3 )
+	out = 0
+	for line in rows:
+		for x in range( width ):
+			if depth < 8:
+				shift = 8 - depth - (x * depth) % 8
+				v = (line[x * depth // 8] >> shift) & ((1 << depth) - 1)
+				px = (v,) if color == 3 else (v * 255 // ((1 << depth) - 1),)
+			else:
+				px = line[x * channels:(x + 1) * channels]
+			if color == 3:
+				r, g, b = palette[3 * px[0]:3 * px[0] + 3]
+			elif channels <= 2:
+				r = g = b = px[0]
+			else:
+				r, g, b = px[0], px[1], px[2]
+			rgb[out:out + 3] = bytearray( (r, g, b) )
+			out += 3
+	return width, height, rgb, messages
+
+if len(sys.argv) != 3:
+	sys.stderr.write( 'usage: %s pngdir corpusdir\n' % sys.argv[0] )
+	sys.exit( 1 )
+
+src, dst = sys.argv[1], sys.argv[2]
+if not os.path.isdir( dst ):
+	os.makedirs( dst )
+
+manifest = open( os.path.join( dst, 'corpus.txt' ), 'w' )
+manifest.write( '# golden corpus from %s: file, symbols, messages\n' % src )
+count = 0
+for name in sorted( os.listdir( src ) ):
+	if not name.lower().endswith( '.png' ):
+		continue
+	try:
+		width, height, rgb, messages = read_png( os.path.join( src, name ) )
+	except (ValueError, KeyError, struct.error, zlib.error) as e:
+		sys.stderr.write( '%s: skipped (%s)\n' % (name, e) )
+		continue
+	ppm = name[:-4] + '.ppm'
+	out = open( os.path.join( dst, ppm ), 'wb' )
+	out.write( ('P6\n%d %d\n255\n' % (width, height)).encode( 'ascii' ) )
+	out.write( rgb )
+	out.close()
+	manifest.write( '\t'.join( [ ppm, str( len(messages) ) ] + messages ) + '\n' )
+	count += 1
+manifest.close()
+
+sys.stderr.write( '%d images in %s\n' % (count, dst) )
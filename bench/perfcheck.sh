@@ -0,0 +1,277 @@
+#!/bin/sh
+#
+# Performance regression gate (see bench/README, section 5)
+#
+#   $ bench/perfcheck.sh [-b builddir] [-s srcdir] [-c corpusdir] [-r repeat]
+#                        [-w wrappers] [-o metrics.json] [-B baseline.json]
+#                        [-H history.csv] [-t pct] [-T pct] [-a ms]
+#                        [-C compiler] [-F flags] [-m warn|fail] [-u]
+#
+# Runs the benchmark drivers through run.sh, writes a metrics file with
+# the median and p99 decode time and the read rate of every driver and
+# scene look, appends the same rows to a CSV history and compares them
+# with a baseline metrics file. Exits 1 if any case got slower than the
+# tolerance allows or reads fewer symbols, and 2 if it could not run.
+# A baseline recorded with another CPU, compiler or flags gives a
+# warning, or exit status 2 with -m fail. With -u the metrics are stored
+# as the new baseline instead.
+
+BUILD=.
+SRC=$(dirname "$0")/..
+CORPUS=
+REPEAT=5
+WRAPPERS=python,ruby,php,java,net
+METRICS=perf-metrics.json
+BASELINE=perf-baseline.json
+HISTORY=perf-history.csv
+TOLERANCE=10
+P99_TOLERANCE=25
+MIN_MS=0.05
+COMPILER=${CC:-cc}
+FLAGS=${CFLAGS:-}
+MISMATCH=warn
+UPDATE=no
+
+while getopts "b:s:c:r:w:o:B:H:t:T:a:C:F:m:u" opt; do
+   case $opt in
+      b) BUILD="$OPTARG" ;;
+      s) SRC="$OPTARG" ;;
+      c) CORPUS="$OPTARG" ;;
+      r) REPEAT="$OPTARG" ;;
+      w) WRAPPERS="$OPTARG" ;;
+      o) METRICS="$OPTARG" ;;
+      B) BASELINE="$OPTARG" ;;
+      H) HISTORY="$OPTARG" ;;
+      t) TOLERANCE="$OPTARG" ;;
+      T) P99_TOLERANCE="$OPTARG" ;;
+      a) MIN_MS="$OPTARG" ;;
+      C) COMPILER="$OPTARG" ;;
+      F) FLAGS="$OPTARG" ;;
+      m) MISMATCH="$OPTARG" ;;
+      u) UPDATE=yes ;;
+      *) echo "usage: $0 [-b builddir] [-s srcdir] [-c corpusdir] [-r repeat] [-w wrappers] [-o metrics.json] [-B baseline.json] [-H history.csv] [-t pct] [-T pct] [-a ms] [-C compiler] [-F flags] [-m warn|fail] [-u]" >&2
+         exit 2 ;;
+   esac
+done
+
+case $MISMATCH in
+   warn|fail) ;;
+   *) echo "$0: -m takes warn or fail, not \"$MISMATCH\"" >&2
+      exit 2 ;;
+esac
+
+BUILD=$(cd "$BUILD" && pwd)
+SRC=$(cd "$SRC" && pwd)
+test -n "$CORPUS" || CORPUS="$BUILD/bench-corpus"
+WORK=$(mktemp -d "${TMPDIR:-/tmp}/dmtxperf.XXXXXX") || exit 2
+trap 'rm -rf "$WORK"' 0
+trap 'exit 2' 1 2 15
+
+sh "$SRC/bench/run.sh" -b "$BUILD" -s "$SRC" -c "$CORPUS" -r "$REPEAT" \
+      -w "$WRAPPERS" -o "$WORK/results.json" -k "$WORK" || exit 2
+
+# Everything describing the run goes through the environment, so awk
+# does not interpret backslashes in it
+PERF_COMMIT=$(git -C "$SRC" rev-parse --short HEAD 2>/dev/null || echo unknown)
+PERF_DATE=$(date -u +%Y-%m-%dT%H:%M:%SZ)
+PERF_HOST=$(uname -n)
+PERF_CPU=$(sed -n 's/^model name[[:space:]]*: //p' /proc/cpuinfo 2>/dev/null | head -n 1)
+PERF_COMPILER=$($COMPILER --version 2>/dev/null | head -n 1)
+test -n "$PERF_COMPILER" || PERF_COMPILER="$COMPILER"
+PERF_FLAGS="$FLAGS"
+export PERF_COMMIT PERF_DATE PERF_HOST PERF_CPU PERF_COMPILER PERF_FLAGS
+
+# One row per decode and case: driver, case, ms, found, expected. Each
+# decode counts for its look (the file name prefix) and for "all".
+for out in "$WORK"/*.out; do
+   driver=$(basename "$out" .out)
+   awk -F '\t' -v driver="$driver" -v manifest="$CORPUS/corpus.txt" '
+   BEGIN {
+      while((getline line < manifest) > 0) {
+         if(line ~ /^#/)
+            continue
+         nf = split(line, f, "\t")
+         for(i = 3; i <= nf; i++)
+            want[f[1], f[i]] = 1
+         expect[f[1]] = f[2]
+      }
+   }
+   /^#/ { next }
+   {
+      found = 0
+      delete seen
+      for(i = 3; i <= NF; i++) {
+         if(($1, $i) in want && !($i in seen)) {
+            seen[$i] = 1
+            found++
+         }
+      }
+      look = $1
+      sub(/-.*/, "", look)
+      printf "%s\t%s\t%s\t%d\t%d\n", driver, look, $2, found, expect[$1]
+      printf "%s\tall\t%s\t%d\t%d\n", driver, $2, found, expect[$1]
+   }' "$out"
+done | sort -t "$(printf '\t')" -k1,1 -k2,2 -k3,3n > "$WORK/rows"
+
+awk -F '\t' -v repeat="$REPEAT" -v manifest="$CORPUS/corpus.txt" '
+function q(s) {
+   gsub(/\\/, "&&", s)
+   gsub(/"/, "\\\"", s)
+   return "\"" s "\""
+}
+function flush(   k) {
+   if(n == 0)
+      return
+   k = int(99 * n / 100.0 + 0.999999)
+   printf "%s    { \"driver\": %s, \"case\": %s, \"decodes\": %d, \"found\": %d, \"expected\": %d, \"median_ms\": %.3f, \"p99_ms\": %.3f }",
+         sep, q(driver), q(kase), n, found, expected, ms[int((n + 1) / 2)], ms[k]
+   sep = ",\n"
+}
+BEGIN {
+   getline line < manifest
+   seed = line
+   sub(/.*seed /, "", seed)
+   sub(/[^0-9].*/, "", seed)
+   while((getline line < manifest) > 0)
+      scenes++
+
+   printf "{\n  \"format\": 1,\n"
+   printf "  \"commit\": %s,\n  \"date\": %s,\n  \"host\": %s,\n  \"cpu\": %s,\n",
+         q(ENVIRON["PERF_COMMIT"]), q(ENVIRON["PERF_DATE"]), q(ENVIRON["PERF_HOST"]),
+         q(ENVIRON["PERF_CPU"])
+   printf "  \"compiler\": %s,\n  \"flags\": %s,\n",
+         q(ENVIRON["PERF_COMPILER"]), q(ENVIRON["PERF_FLAGS"])
+   printf "  \"corpus\": { \"seed\": %d, \"scenes\": %d, \"repeat\": %d },\n",
+         seed, scenes, repeat
+   printf "  \"cases\": [\n"
+}
+$1 != driver || $2 != kase {
+   flush()
+   driver = $1
+   kase = $2
+   n = found = expected = 0
+}
+{
+   ms[++n] = $3 + 0
+   found += $4
+   expected += $5
+}
+END {
+   flush()
+   printf "\n  ]\n}\n"
+}' "$WORK/rows" > "$METRICS" || exit 2
+
+echo "Metrics in $METRICS" >&2
+
+# Value of a run field ("cpu", "compiler", ...) of a metrics file, still
+# JSON escaped, which is enough to compare two files
+Field()
+{
+   sed -n "s/^  \"$2\": \(.*\),\$/\1/p" "$1"
+}
+
+# Case lines of a metrics file as: driver case median p99 found expected
+Cases()
+{
+   awk '
+   function field(key,   s) {
+      if(!match($0, "\"" key "\": (\"[^\"]*\"|[0-9.]+)"))
+         return ""
+      s = substr($0, RSTART + length(key) + 4, RLENGTH - length(key) - 4)
+      gsub(/"/, "", s)
+      return s
+   }
+   /"driver":/ {
+      print field("driver"), field("case"), field("median_ms"), field("p99_ms"),
+            field("found"), field("expected")
+   }' "$1"
+}
+
+if test ! -f "$HISTORY"; then
+   echo "date,commit,driver,case,median_ms,p99_ms,found,expected" > "$HISTORY"
+fi
+Cases "$METRICS" | while read driver kase median p99 found expected; do
+   echo "$PERF_DATE,$PERF_COMMIT,$driver,$kase,$median,$p99,$found,$expected"
+done >> "$HISTORY"
+
+if test "$UPDATE" = yes; then
+   cp "$METRICS" "$BASELINE" || exit 2
+   echo "Baseline $BASELINE updated" >&2
+   exit 0
+fi
+
+if test ! -f "$BASELINE"; then
+   echo "No baseline at $BASELINE; record one with -u (make perfbaseline)" >&2
+   exit 0
+fi
+
+# Times from another machine or build are not comparable
+differs=0
+for field in cpu compiler flags; do
+   base=$(Field "$BASELINE" $field)
+   cur=$(Field "$METRICS" $field)
+   if test "x$base" != "x$cur"; then
+      echo "$field differs from the baseline: $cur (baseline $base)" >&2
+      differs=1
+   fi
+done
+if test $differs = 1; then
+   if test "$MISMATCH" = fail; then
+      echo "Baseline $BASELINE was recorded with another build; record one for this build with -u (make perfbaseline)" >&2
+      exit 2
+   fi
+   echo "Warning: comparing against a baseline from another build" >&2
+fi
+
+Cases "$BASELINE" > "$WORK/baseline"
+Cases "$METRICS" | awk -v tol="$TOLERANCE" -v tol99="$P99_TOLERANCE" -v minMs="$MIN_MS" \
+      -v baseline="$WORK/baseline" '
+function slower(cur, base, pct) {
+   return cur - base > minMs && cur > base * (1 + pct / 100.0)
+}
+function change(cur, base) {
+   return (base > 0) ? sprintf("%+.1f%%", (cur - base) * 100.0 / base) : "n/a"
+}
+BEGIN {
+   while((getline line < baseline) > 0) {
+      split(line, f, " ")
+      key = f[1] " " f[2]
+      baseMedian[key] = f[3]
+      baseP99[key] = f[4]
+      baseRate[key] = (f[6] > 0) ? f[5] / f[6] : 1
+   }
+   printf "%-8s %-8s %12s %9s %12s %9s  %s\n", "driver", "case", "median ms",
+         "change", "p99 ms", "change", "status"
+}
+{
+   key = $1 " " $2
+   if(!(key in baseMedian)) {
+      printf "%-8s %-8s %12.3f %9s %12.3f %9s  new\n", $1, $2, $3, "", $4, ""
+      next
+   }
+   seen[key] = 1
+   status = "ok"
+   if(slower($3, baseMedian[key], tol))
+      status = "SLOWER (median)"
+   else if(slower($4, baseP99[key], tol99))
+      status = "SLOWER (p99)"
+   if($6 > 0 && $5 / $6 < baseRate[key] - 1e-9)
+      status = sprintf("FEWER READ (%d of %d, was %.1f%%)", $5, $6, baseRate[key] * 100)
+   if(status != "ok")
+      failed++
+   printf "%-8s %-8s %12.3f %9s %12.3f %9s  %s\n", $1, $2, $3,
+         change($3, baseMedian[key]), $4, change($4, baseP99[key]), status
+}
+END {
+   for(key in baseMedian) {
+      if(!(key in seen)) {
+         split(key, f, " ")
+         printf "%-8s %-8s %12s %9s %12s %9s  not run\n", f[1], f[2], "", "", "", ""
+      }
+   }
+   if(failed > 0) {
+      printf "%d case(s) regressed (tolerance %s%% median, %s%% p99)\n", failed, tol, tol99
+      exit 1
+   }
+   printf "No regressions (tolerance %s%% median, %s%% p99)\n", tol, tol99
+}'
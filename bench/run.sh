@@ -0,0 +1,233 @@
+#!/bin/sh
+#
+# Cross-wrapper decode benchmark (see bench/README)
+#
+#   $ bench/run.sh [-b builddir] [-s srcdir] [-c corpusdir] [-o results.json]
+#                  [-r repeat] [-w wrapper,wrapper,...] [-k keepdir]
+#
+# Generates the corpus once, runs benchc and each wrapper driver on it and
+# writes the summary to one JSON file. Wrappers are python, ruby, php,
+# java and net; a wrapper that is not built is recorded as skipped. With
+# -k the raw output of each driver is also kept as keepdir/name.out.
+
+BUILD=.
+SRC=$(dirname "$0")/..
+CORPUS=
+OUTPUT=bench-results.json
+REPEAT=3
+WRAPPERS=python,ruby,php,java,net
+SEED=1
+KEEP=
+
+while getopts "b:s:c:o:r:w:k:" opt; do
+   case $opt in
+      b) BUILD="$OPTARG" ;;
+      s) SRC="$OPTARG" ;;
+      c) CORPUS="$OPTARG" ;;
+      o) OUTPUT="$OPTARG" ;;
+      r) REPEAT="$OPTARG" ;;
+      w) WRAPPERS="$OPTARG" ;;
+      k) KEEP="$OPTARG" ;;
+      *) echo "usage: $0 [-b builddir] [-s srcdir] [-c corpusdir] [-o results.json] [-r repeat] [-w wrappers] [-k keepdir]" >&2
+         exit 1 ;;
+   esac
+done
+
+BUILD=$(cd "$BUILD" && pwd)
+SRC=$(cd "$SRC" && pwd)
+test -n "$CORPUS" || CORPUS="$BUILD/bench-corpus"
+MANIFEST="$CORPUS/corpus.txt"
+WORK=$(mktemp -d "${TMPDIR:-/tmp}/dmtxbench.XXXXXX") || exit 1
+DMTXD_PID=
+trap 'test -n "$DMTXD_PID" && kill $DMTXD_PID 2>/dev/null; rm -rf "$WORK"' 0
+trap 'exit 1' 1 2 15
+
+if test ! -f "$MANIFEST"; then
+   mkdir -p "$CORPUS" && "$BUILD/benchgen" "$CORPUS" $SEED || exit 1
+fi
+
+# Run one driver: Run name command...  (output in $WORK/name.out)
+Run()
+{
+   NAME="$1"
+   shift
+   echo "   $NAME" >&2
+   "$@" "$MANIFEST" "$REPEAT" > "$WORK/$NAME.out" 2> "$WORK/$NAME.err"
+   STATUS=$?
+   case $STATUS in
+   0) echo "$NAME" >> "$WORK/ran"
+      test -z "$KEEP" || cp "$WORK/$NAME.out" "$KEEP/$NAME.out" ;;
+   3) Skip "$NAME" "$(head -n 1 "$WORK/$NAME.err")" ;;
+   *) Skip "$NAME" "driver failed: $(head -n 1 "$WORK/$NAME.err")" ;;
+   esac
+}
+
+# Record a wrapper that was not measured: Skip name reason
+Skip()
+{
+   echo "   $1 skipped ($2)" >&2
+   printf '%s\t%s\n' "$1" "$2" >> "$WORK/skipped"
+}
+
+: > "$WORK/ran"
+: > "$WORK/skipped"
+
+echo "Benchmarking $MANIFEST, $REPEAT decodes per scene" >&2
+Run c "$BUILD/benchc"
+if test $STATUS -ne 0 && test $STATUS -ne 3; then
+   echo "$0: benchc failed, nothing to compare with" >&2
+   exit 1
+fi
+
+for wrapper in $(echo "$WRAPPERS" | tr ',' ' '); do
+   case $wrapper in
+   python)
+      PYLIB=$(ls -d "$BUILD"/python/build/lib* "$SRC"/python/build/lib* 2>/dev/null | head -n 1)
+      if test -z "$PYLIB"; then
+         Skip python "pydmtx not built"
+      else
+         Run python env PYTHONPATH="$PYLIB" "${PYTHON:-python}" "$SRC/bench/bench.py"
+      fi ;;
+   ruby)
+      RBDIR=$(dirname "$(ls "$BUILD"/ruby/Rdmtx.so "$SRC"/ruby/Rdmtx.so 2>/dev/null | head -n 1)")
+      if test "$RBDIR" = .; then
+         Skip ruby "Rdmtx not built"
+      else
+         Run ruby "${RUBY:-ruby}" -I "$RBDIR" "$SRC/bench/bench.rb"
+      fi ;;
+   php)
+      # The PHP extension only encodes; PHP decodes through dmtxd
+      if test ! -x "$BUILD/dmtxd"; then
+         Skip php "dmtxd not built"
+      else
+         "$BUILD/dmtxd" -s "$WORK/dmtxd.sock" 2> "$WORK/dmtxd.err" &
+         DMTXD_PID=$!
+         sleep 1
+         Run php env DMTXD_SOCKET="$WORK/dmtxd.sock" "${PHP:-php}" "$SRC/bench/bench.php"
+         kill $DMTXD_PID 2>/dev/null
+         DMTXD_PID=
+      fi ;;
+   java)
+      if test ! -f "$SRC/java/dmtx.jar" || test ! -f "$SRC/java/native/libdmtx.so"; then
+         Skip java "dmtx.jar or native/libdmtx.so not built"
+      elif ! "${JAVAC:-javac}" -cp "$SRC/java/dmtx.jar" -d "$WORK" "$SRC/bench/Bench.java" 2> "$WORK/javac.err"; then
+         Skip java "javac failed"
+      else
+         Run java "${JAVA:-java}" -cp "$SRC/java/dmtx.jar:$WORK" \
+               -Djava.library.path="$SRC/java/native" Bench
+      fi ;;
+   net)
+      NETDLL=$(ls "$SRC"/net/Libdmtx.Net/bin/Release/Libdmtx.Net.dll \
+            "$SRC"/net/Libdmtx.Net/bin/Debug/Libdmtx.Net.dll 2>/dev/null | head -n 1)
+      if test -z "$NETDLL"; then
+         Skip net "Libdmtx.Net.dll not built"
+      elif ! "${MCS:-mcs}" -r:"$NETDLL" -r:System.Drawing.dll -out:"$WORK/Bench.exe" \
+            "$SRC/bench/Bench.cs" > "$WORK/mcs.err" 2>&1; then
+         Skip net "mcs failed"
+      else
+         cp "$NETDLL" "$WORK"
+         Run net env MONO_PATH="$WORK" "${MONO:-mono}" "$WORK/Bench.exe"
+      fi ;;
+   *)
+      Skip "$wrapper" "unknown wrapper" ;;
+   esac
+done
+
+# Per-driver latencies, sorted for the percentiles
+for name in $(cat "$WORK/ran"); do
+   grep -v '^#' "$WORK/$name.out" | cut -f 2 | sort -n > "$WORK/$name.ms"
+done
+
+# The manifest path goes through the environment, so awk does not
+# interpret backslashes in it
+BENCH_MANIFEST="$MANIFEST" awk -F '\t' -v work="$WORK" -v repeat="$REPEAT" '
+function pct(ms, n, p,   k) {
+   k = int(p * n / 100.0 + 0.999999)
+   return ms[(k < 1) ? 1 : k]
+}
+function q(s) {
+   gsub(/\\/, "&&", s)
+   gsub(/"/, "\\\"", s)
+   return "\"" s "\""
+}
+BEGIN {
+   manifest = ENVIRON["BENCH_MANIFEST"]
+
+   # Expected messages per scene
+   while((getline line < manifest) > 0) {
+      if(line ~ /^#/)
+         continue
+      nf = split(line, f, "\t")
+      scenes++
+      symbols += f[2]
+      for(i = 3; i <= nf; i++)
+         want[f[1], f[i]] = 1
+      expect[f[1]] = f[2]
+   }
+
+   printf "{\n  \"corpus\": { \"manifest\": %s, \"scenes\": %d, \"symbols\": %d, \"repeat\": %d },\n",
+         q(manifest), scenes, symbols, repeat
+   printf "  \"drivers\": {"
+   sep = "\n"
+
+   while((getline name < (work "/ran")) > 0) {
+      n = 0; total = 0; found = 0; expected = 0; falses = 0; rss = -1
+      out = work "/" name ".out"
+      while((getline line < out) > 0) {
+         nf = split(line, f, "\t")
+         if(f[1] == "#rss_kb") {
+            rss = f[2]
+            continue
+         }
+         n++
+         total += f[2]
+         expected += expect[f[1]]
+         delete seen
+         for(i = 3; i <= nf; i++) {
+            if((f[1], f[i]) in want && !(f[i] in seen)) {
+               seen[f[i]] = 1
+               found++
+            }
+            else {
+               falses++
+            }
+         }
+      }
+      close(out)
+
+      delete ms
+      k = 0
+      while((getline v < (work "/" name ".ms")) > 0)
+         ms[++k] = v + 0
+      mean = (n > 0) ? total / n : 0
+      p50 = pct(ms, k, 50)
+      if(name == "c") {
+         cMean = mean
+         cP50 = p50
+      }
+
+      printf "%s    %s: { \"decodes\": %d, \"found\": %d, \"expected\": %d, \"false\": %d,\n",
+            sep, q(name), n, found, expected, falses
+      printf "      \"read_rate\": %.4f, \"ms_per_symbol\": %.3f,\n",
+            (expected > 0) ? found / expected : 1, (found > 0) ? total / found : 0
+      printf "      \"throughput_per_s\": %.2f, \"total_ms\": %.3f,\n",
+            (total > 0) ? n * 1000.0 / total : 0, total
+      printf "      \"mean_ms\": %.3f, \"p50_ms\": %.3f, \"p90_ms\": %.3f, \"p99_ms\": %.3f, \"max_ms\": %.3f,\n",
+            mean, p50, pct(ms, k, 90), pct(ms, k, 99), ms[k]
+      printf "      \"peak_rss_kb\": %d", rss
+      if(name != "c" && cMean > 0)
+         printf ",\n      \"overhead_mean_pct\": %.1f, \"overhead_p50_pct\": %.1f",
+               (mean - cMean) * 100.0 / cMean, (cP50 > 0) ? (p50 - cP50) * 100.0 / cP50 : 0
+      printf " }"
+      sep = ",\n"
+   }
+
+   while((getline line < (work "/skipped")) > 0) {
+      split(line, f, "\t")
+      printf "%s    %s: { \"skipped\": %s }", sep, q(f[1]), q(f[2])
+      sep = ",\n"
+   }
+   printf "\n  }\n}\n"
+}' > "$OUTPUT" || exit 1
+
+echo "Results in $OUTPUT" >&2
@@ -0,0 +1,1093 @@
+/*
+dmtxbulk - Bulk Data Matrix encoder for label runs
+
+Copyright (C) 2026 The libdmtx-wrappers project
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+Contact: mike@dragonflylogic.com
+*/
+
+/* $Id$ */
+
+/**
+ * @file dmtxbulk.c
+ * @brief Encode one label per input line on every core into PNG files, a
+ *        multi-page TIFF or a packed index and blob file
+ *
+ * Nightly label runs encode millions of messages. Through a wrapper each
+ * one costs an encoder, a full-size image and a host-language image
+ * object. dmtxbulk runs one thread per core instead, each reusing a
+ * single encoder: libdmtx renders at module size 1, dmtxwEncodeExpand()
+ * scales that to 1 bit per pixel and the worker turns it into the bytes
+ * of the output container (a PNG file, a PackBits TIFF strip or raw rows).
+ *
+ * Results are written in input order by whichever worker finishes the
+ * oldest one, so the output does not depend on the thread count. A
+ * worker reserves the worst-case size of its label before building it
+ * and waits while the labels built but not yet written would exceed the
+ * memory budget; the oldest label is always let through, so a slow label
+ * never blocks the ones queued behind it for good. SIGINT and SIGTERM
+ * stop reading input; labels already taken are finished and written.
+ *
+ *   $ dmtxbulk -f png|tiff|pack -o output [-l list] [-j jobs] [-m MB]
+ *              [-p seconds] [-P name=value]...
+ */
+
+#define _XOPEN_SOURCE 700
+#define _DEFAULT_SOURCE
+#define _FILE_OFFSET_BITS 64
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include "dmtxw.h"
+
+#define DMTXBULK_PROGRESS     10
+#define DMTXBULK_BUDGET       64
+
+/* Labels taken but not written at most (oldest to newest) */
+#define DMTXBULK_WINDOW       4096
+
+/* Largest stored deflate block */
+#define DMTXBULK_STORED_MAX   65535
+
+/* Entries in every TIFF directory, and its size in bytes */
+#define DMTXBULK_TIFF_TAGS    10
+#define DMTXBULK_TIFF_IFD     (2 + DMTXBULK_TIFF_TAGS * 12 + 4)
+
+/* Index file header and record sizes */
+#define DMTXBULK_PACK_HEADER  16
+#define DMTXBULK_PACK_RECORD  24
+
+typedef enum {
+   BulkFormatPng,
+   BulkFormatTiff,
+   BulkFormatPack
+} BulkFormat;
+
+/* One label in its container encoding, followed by its bytes */
+typedef struct {
+   int             width;
+   int             height;
+   size_t          size;
+   unsigned char  *data;
+} Result;
+
+typedef struct {
+   pthread_mutex_t lock;
+   pthread_cond_t  drained;        /* Signalled whenever a label is written */
+   FILE           *list;
+   char           *listLine;
+   size_t          listCapacity;
+   long            nextSeq;        /* Input line handed out next, from 1 */
+   long            nextWrite;      /* Input line written next */
+   Result         *pending[DMTXBULK_WINDOW];
+   size_t          reserved[DMTXBULK_WINDOW];
+   size_t          inFlight;       /* Bytes reserved by labels not written */
+   size_t          peakInFlight;
+   size_t          budget;
+   int             writing;        /* A worker is writing labels out */
+   int             moduleSize;     /* Encoder properties, DmtxUndefined if unset */
+   int             marginSize;
+   int             scheme;
+   int             sizeRequest;
+   long            labels;
+   long            failed;
+   double          bytes;
+   int             running;        /* Workers not finished yet */
+
+   /* Output, used by the writing worker only */
+   BulkFormat      format;
+   const char     *outPath;
+   char           *pngPath;
+   FILE           *out;            /* TIFF file or pack blob */
+   FILE           *index;          /* Pack index */
+   off_t           offset;         /* Bytes written to out */
+   off_t           lastLink;       /* Next-directory field of the last TIFF page */
+   DmtxPassFail    writeErr;
+} Bulk;
+
+typedef struct {
+   Bulk           *bulk;
+   pthread_t       thread;
+   DmtxEncode     *enc;
+   unsigned char  *payload;
+   size_t          payloadLength;
+   size_t          payloadCapacity;
+   unsigned char  *rows;           /* 1 bpp scratch image (PNG and TIFF) */
+   size_t          rowsCapacity;
+} Worker;
+
+/* Stand in for labels that could not be encoded or stored */
+static Result encodeFailed;
+static Result outOfMemory;
+
+static unsigned long crcTable[256];
+static volatile sig_atomic_t stopping = 0;
+
+static void OnSignal(int sig);
+static void *WorkerMain(void *arg);
+static DmtxBoolean NextPayload(Bulk *bulk, Worker *worker, long *seq);
+static Result *EncodeOne(Worker *worker, long seq, size_t *reserved);
+static void Reserve(Bulk *bulk, long seq, size_t bytes);
+static void Submit(Bulk *bulk, long seq, Result *result, size_t reserved);
+static size_t FormatPng(unsigned char *raw, int width, int height, unsigned char *dst);
+static size_t PackBits(const unsigned char *src, int count, unsigned char *dst);
+static DmtxPassFail OpenOutput(Bulk *bulk);
+static DmtxPassFail CloseOutput(Bulk *bulk);
+static DmtxPassFail WriteResult(Bulk *bulk, long seq, const Result *result);
+static DmtxPassFail WriteTiffPage(Bulk *bulk, const Result *result);
+static DmtxPassFail WritePackRecord(Bulk *bulk, const Result *result);
+static void PutBE32(unsigned char *dst, unsigned long value);
+static void PutLE16(unsigned char *dst, unsigned int value);
+static void PutLE32(unsigned char *dst, unsigned long value);
+static void InitCrcTable(void);
+static unsigned long Crc32(const unsigned char *data, size_t length);
+static unsigned long Adler32(const unsigned char *data, size_t length);
+static void Report(Bulk *bulk, DmtxTime start, const char *prefix);
+static double ElapsedSec(DmtxTime start);
+
+/**
+ * @brief  Parse the options, run the workers and report throughput
+ * @param  argc Argument count
+ * @param  argv Options (see the file comment)
+ * @return 0 if every label was encoded and written, 1 otherwise
+ */
+int
+main(int argc, char *argv[])
+{
+   static const struct { const char *name; int prop; } encodeProps[] = {
+      { "module_size", DmtxPropModuleSize },
+      { "margin_size", DmtxPropMarginSize },
+      { "scheme",      DmtxPropScheme },
+      { "size",        DmtxPropSizeRequest },
+      { NULL,          DmtxUndefined }
+   };
+   Bulk *bulk;
+   Worker *worker;
+   DmtxEncode *check;
+   DmtxTime start, lastReport;
+   struct sigaction sa;
+   struct timespec nap;
+   const char *listPath = "-", *formatName = NULL;
+   char *value;
+   int opt, i, jobs, started = 0, progress = DMTXBULK_PROGRESS, budget = DMTXBULK_BUDGET;
+   int running, format;
+   DmtxPassFail err = DmtxPass;
+
+   /* Too large for the stack with its result window */
+   bulk = (Bulk *)calloc(1, sizeof(Bulk));
+   check = dmtxEncodeCreate();
+   if(bulk == NULL || check == NULL) {
+      fprintf(stderr, "%s: out of memory\n", argv[0]);
+      return 1;
+   }
+   bulk->moduleSize = bulk->marginSize = bulk->scheme = bulk->sizeRequest = DmtxUndefined;
+   bulk->writeErr = DmtxPass;
+
+   jobs = (int)sysconf(_SC_NPROCESSORS_ONLN);
+   if(jobs < 1)
+      jobs = 1;
+
+   while((opt = getopt(argc, argv, "f:o:l:j:m:p:P:h")) != -1) {
+      switch(opt) {
+         case 'f':
+            formatName = optarg;
+            break;
+         case 'o':
+            bulk->outPath = optarg;
+            break;
+         case 'l':
+            listPath = optarg;
+            break;
+         case 'j':
+            jobs = atoi(optarg);
+            break;
+         case 'm':
+            budget = atoi(optarg);
+            break;
+         case 'p':
+            progress = atoi(optarg);
+            break;
+         case 'P':
+            /* Checked on a scratch encoder, applied to every worker's */
+            value = strchr(optarg, '=');
+            if(value != NULL)
+               *(value++) = '\0';
+            for(i = 0; encodeProps[i].name != NULL; i++) {
+               if(strcmp(encodeProps[i].name, optarg) == 0)
+                  break;
+            }
+            if(value == NULL || encodeProps[i].name == NULL ||
+                  dmtxEncodeSetProp(check, encodeProps[i].prop, atoi(value)) == DmtxFail) {
+               fprintf(stderr, "%s: bad option %s\n", argv[0], optarg);
+               return 1;
+            }
+            switch(encodeProps[i].prop) {
+               case DmtxPropModuleSize:
+                  bulk->moduleSize = atoi(value);
+                  break;
+               case DmtxPropMarginSize:
+                  bulk->marginSize = atoi(value);
+                  break;
+               case DmtxPropScheme:
+                  bulk->scheme = atoi(value);
+                  break;
+               default:
+                  bulk->sizeRequest = atoi(value);
+                  break;
+            }
+            break;
+         default:
+            fprintf(stderr, "usage: %s -f png|tiff|pack -o output [-l list] [-j jobs] "
+                  "[-m MB] [-p seconds] [-P name=value]...\n", argv[0]);
+            return 1;
+      }
+   }
+   dmtxEncodeDestroy(&check);
+
+   format = DmtxUndefined;
+   if(formatName != NULL && strcmp(formatName, "png") == 0)
+      format = BulkFormatPng;
+   else if(formatName != NULL && strcmp(formatName, "tiff") == 0)
+      format = BulkFormatTiff;
+   else if(formatName != NULL && strcmp(formatName, "pack") == 0)
+      format = BulkFormatPack;
+
+   if(format == DmtxUndefined || bulk->outPath == NULL || optind != argc || jobs < 1 ||
+         budget < 1 || progress < 0) {
+      fprintf(stderr, "%s: need -f png, tiff or pack and -o; -j and -m must be "
+            "positive\n", argv[0]);
+      return 1;
+   }
+   bulk->format = (BulkFormat)format;
+   bulk->budget = (size_t)budget * 1048576;
+
+   bulk->list = (strcmp(listPath, "-") == 0) ? stdin : fopen(listPath, "r");
+   if(bulk->list == NULL) {
+      perror(listPath);
+      return 1;
+   }
+
+   if(OpenOutput(bulk) == DmtxFail) {
+      perror(bulk->outPath);
+      return 1;
+   }
+
+   worker = (Worker *)calloc(jobs, sizeof(Worker));
+   if(worker == NULL) {
+      fprintf(stderr, "%s: out of memory\n", argv[0]);
+      return 1;
+   }
+
+   memset(&sa, 0x00, sizeof(sa));
+   sa.sa_handler = OnSignal;
+   sigemptyset(&sa.sa_mask);
+   sigaction(SIGINT, &sa, NULL);
+   sigaction(SIGTERM, &sa, NULL);
+
+   InitCrcTable();
+   pthread_mutex_init(&bulk->lock, NULL);
+   pthread_cond_init(&bulk->drained, NULL);
+   bulk->nextSeq = bulk->nextWrite = 1;
+   start = lastReport = dmtxTimeNow();
+
+   for(i = 0; i < jobs; i++) {
+      worker[i].bulk = bulk;
+      worker[i].enc = dmtxEncodeCreate();
+      if(worker[i].enc == NULL) {
+         err = DmtxFail;
+         break;
+      }
+      if(bulk->moduleSize != DmtxUndefined)
+         dmtxEncodeSetProp(worker[i].enc, DmtxPropModuleSize, bulk->moduleSize);
+      if(bulk->marginSize != DmtxUndefined)
+         dmtxEncodeSetProp(worker[i].enc, DmtxPropMarginSize, bulk->marginSize);
+      if(bulk->scheme != DmtxUndefined)
+         dmtxEncodeSetProp(worker[i].enc, DmtxPropScheme, bulk->scheme);
+      if(bulk->sizeRequest != DmtxUndefined)
+         dmtxEncodeSetProp(worker[i].enc, DmtxPropSizeRequest, bulk->sizeRequest);
+
+      pthread_mutex_lock(&bulk->lock);
+      bulk->running++;
+      pthread_mutex_unlock(&bulk->lock);
+      if(pthread_create(&(worker[i].thread), NULL, WorkerMain, &(worker[i])) != 0) {
+         pthread_mutex_lock(&bulk->lock);
+         bulk->running--;
+         pthread_mutex_unlock(&bulk->lock);
+         err = DmtxFail;
+         break;
+      }
+      started++;
+   }
+   if(err == DmtxFail) {
+      fprintf(stderr, "%s: unable to start %d workers\n", argv[0], jobs);
+      stopping = 1;
+   }
+
+   /* The main thread only reports progress */
+   nap.tv_sec = 0;
+   nap.tv_nsec = 100000000L;
+   do {
+      nanosleep(&nap, NULL);
+      pthread_mutex_lock(&bulk->lock);
+      running = bulk->running;
+      if(progress > 0 && ElapsedSec(lastReport) >= progress) {
+         Report(bulk, start, "progress");
+         lastReport = dmtxTimeNow();
+      }
+      pthread_mutex_unlock(&bulk->lock);
+   } while(running > 0);
+
+   for(i = 0; i < started; i++)
+      pthread_join(worker[i].thread, NULL);
+
+   if(CloseOutput(bulk) == DmtxFail && bulk->writeErr == DmtxPass) {
+      perror(bulk->outPath);
+      bulk->writeErr = DmtxFail;
+   }
+   Report(bulk, start, (bulk->writeErr == DmtxFail) ? "write failed" :
+         stopping ? "interrupted" : "done");
+
+   for(i = 0; i < jobs; i++) {
+      if(worker[i].enc != NULL)
+         dmtxEncodeDestroy(&(worker[i].enc));
+      free(worker[i].payload);
+      free(worker[i].rows);
+   }
+   free(worker);
+
+   if(bulk->list != stdin)
+      fclose(bulk->list);
+   free(bulk->listLine);
+   free(bulk->pngPath);
+   pthread_cond_destroy(&bulk->drained);
+   pthread_mutex_destroy(&bulk->lock);
+
+   err = (err == DmtxPass && bulk->writeErr == DmtxPass && bulk->failed == 0 &&
+         !stopping) ? DmtxPass : DmtxFail;
+   free(bulk);
+
+   return (err == DmtxPass) ? 0 : 1;
+}
+
+/**
+ * @brief  Stop reading input; labels already taken are finished
+ * @param  sig Signal number (unused)
+ * @return void
+ */
+static void
+OnSignal(int sig)
+{
+   stopping = 1;
+}
+
+/**
+ * @brief  Worker thread: encode labels until the input is used up
+ * @param  arg Worker
+ * @return NULL
+ */
+static void *
+WorkerMain(void *arg)
+{
+   Worker *worker = (Worker *)arg;
+   Bulk *bulk = worker->bulk;
+   Result *result;
+   size_t reserved;
+   long seq;
+
+   while(NextPayload(bulk, worker, &seq) == DmtxTrue) {
+      result = EncodeOne(worker, seq, &reserved);
+      Submit(bulk, seq, result, reserved);
+   }
+
+   pthread_mutex_lock(&bulk->lock);
+   bulk->running--;
+   pthread_mutex_unlock(&bulk->lock);
+
+   return NULL;
+}
+
+/**
+ * @brief  Take the next input line, waiting while the oldest label not
+ *         yet written is a full window behind
+ * @param  bulk Bulk run
+ * @param  worker Receives the message in worker->payload
+ * @param  seq Receives its line number
+ * @return DmtxTrue if there is one
+ */
+static DmtxBoolean
+NextPayload(Bulk *bulk, Worker *worker, long *seq)
+{
+   ssize_t got;
+   DmtxBoolean found = DmtxFalse;
+
+   pthread_mutex_lock(&bulk->lock);
+
+   while(!stopping && bulk->nextSeq - bulk->nextWrite >= DMTXBULK_WINDOW)
+      pthread_cond_wait(&bulk->drained, &bulk->lock);
+
+   if(!stopping && (got = getline(&bulk->listLine, &bulk->listCapacity, bulk->list)) > 0) {
+      while(got > 0 && (bulk->listLine[got - 1] == '\n' || bulk->listLine[got - 1] == '\r'))
+         got--;
+
+      if((size_t)got > worker->payloadCapacity) {
+         free(worker->payload);
+         worker->payload = (unsigned char *)malloc(got);
+         worker->payloadCapacity = (worker->payload == NULL) ? 0 : got;
+      }
+
+      /* A line that cannot be copied is reported as a failed label */
+      worker->payloadLength = (worker->payload == NULL) ? 0 : got;
+      if(worker->payloadLength > 0)
+         memcpy(worker->payload, bulk->listLine, worker->payloadLength);
+      *seq = bulk->nextSeq++;
+      found = DmtxTrue;
+   }
+
+   pthread_mutex_unlock(&bulk->lock);
+
+   return found;
+}
+
+/**
+ * @brief  Encode worker->payload and build its bytes for the container
+ * @param  worker Worker
+ * @param  seq Line number of the message
+ * @param  reserved Receives the bytes reserved against the budget
+ * @return New result, &encodeFailed or &outOfMemory
+ */
+static Result *
+EncodeOne(Worker *worker, long seq, size_t *reserved)
+{
+   Bulk *bulk = worker->bulk;
+   Result *result;
+   unsigned char *raw;
+   size_t rawSize, worst;
+   int width, height, rowBytes, y;
+
+   *reserved = 0;
+
+   if(worker->payloadLength == 0 ||
+         dmtxwEncodeDataMatrix(worker->enc, (int)worker->payloadLength,
+         worker->payload) == DmtxFail ||
+         dmtxwEncodeGetSize(worker->enc, &width, &height) == DmtxFail)
+      return &encodeFailed;
+
+   /* PNG rows carry a filter byte, which the scratch image leaves room for */
+   rowBytes = (width + 7) / 8;
+   rawSize = (size_t)(rowBytes + 1) * height;
+   if((double)(rowBytes + 1) * height > (double)((size_t)-1 / 4))
+      return &outOfMemory;
+
+   switch(bulk->format) {
+      case BulkFormatPng:
+         worst = 8 + 25 + 12 + 2 + 4 + 12 + rawSize +
+               5 * (rawSize / DMTXBULK_STORED_MAX + 1);
+         break;
+      case BulkFormatTiff:
+         worst = (size_t)(rowBytes + rowBytes / 128 + 1) * height;
+         break;
+      default:
+         worst = (size_t)rowBytes * height;
+         break;
+   }
+
+   Reserve(bulk, seq, worst);
+   *reserved = worst;
+
+   result = (Result *)malloc(sizeof(Result) + worst);
+   if(result == NULL)
+      return &outOfMemory;
+   result->data = (unsigned char *)(result + 1);
+   result->width = width;
+   result->height = height;
+
+   if(bulk->format == BulkFormatPack) {
+      dmtxwEncodeExpand(worker->enc, result->data, rowBytes, DmtxwFormatMono1);
+      result->size = worst;
+      return result;
+   }
+
+   if(rawSize > worker->rowsCapacity) {
+      free(worker->rows);
+      worker->rows = (unsigned char *)malloc(rawSize);
+      worker->rowsCapacity = (worker->rows == NULL) ? 0 : rawSize;
+      if(worker->rows == NULL) {
+         free(result);
+         return &outOfMemory;
+      }
+   }
+   raw = worker->rows;
+
+   if(bulk->format == BulkFormatPng) {
+      dmtxwEncodeExpand(worker->enc, raw + 1, rowBytes + 1, DmtxwFormatMono1);
+      result->size = FormatPng(raw, width, height, result->data);
+   }
+   else {
+      dmtxwEncodeExpand(worker->enc, raw, rowBytes, DmtxwFormatMono1);
+      result->size = 0;
+      for(y = 0; y < height; y++)
+         result->size += PackBits(raw + (size_t)y * rowBytes, rowBytes,
+               result->data + result->size);
+   }
+
+   return result;
+}
+
+/**
+ * @brief  Count a label's bytes against the budget, waiting for older
+ *         labels to be written while it is exhausted. The oldest label
+ *         is never held back, so the run always moves on.
+ * @param  bulk Bulk run
+ * @param  seq Line number of the label
+ * @param  bytes Bytes to reserve
+ * @return void
+ */
+static void
+Reserve(Bulk *bulk, long seq, size_t bytes)
+{
+   pthread_mutex_lock(&bulk->lock);
+
+   while(bulk->inFlight > 0 && bulk->inFlight + bytes > bulk->budget &&
+         seq != bulk->nextWrite)
+      pthread_cond_wait(&bulk->drained, &bulk->lock);
+
+   bulk->inFlight += bytes;
+   if(bulk->inFlight > bulk->peakInFlight)
+      bulk->peakInFlight = bulk->inFlight;
+
+   pthread_mutex_unlock(&bulk->lock);
+}
+
+/**
+ * @brief  Hand a label over for writing. The worker that hands over the
+ *         oldest label writes it and every label queued after it.
+ * @param  bulk Bulk run
+ * @param  seq Line number of the label
+ * @param  result Label, &encodeFailed or &outOfMemory
+ * @param  reserved Bytes it reserved
+ * @return void
+ */
+static void
+Submit(Bulk *bulk, long seq, Result *result, size_t reserved)
+{
+   Result *next;
+   size_t bytes, written;
+   long nextSeq;
+   DmtxBoolean failed;
+   DmtxPassFail err;
+
+   pthread_mutex_lock(&bulk->lock);
+
+   bulk->pending[seq % DMTXBULK_WINDOW] = result;
+   bulk->reserved[seq % DMTXBULK_WINDOW] = reserved;
+   if(bulk->writing || seq != bulk->nextWrite) {
+      pthread_mutex_unlock(&bulk->lock);
+      return;
+   }
+
+   bulk->writing = 1;
+   while((next = bulk->pending[bulk->nextWrite % DMTXBULK_WINDOW]) != NULL) {
+      nextSeq = bulk->nextWrite;
+      bytes = bulk->reserved[nextSeq % DMTXBULK_WINDOW];
+      bulk->pending[nextSeq % DMTXBULK_WINDOW] = NULL;
+      pthread_mutex_unlock(&bulk->lock);
+
+      /* After a write error the rest is dropped, so no worker waits for good */
+      err = (bulk->writeErr == DmtxPass) ? WriteResult(bulk, nextSeq, next) : DmtxFail;
+      if(err == DmtxFail && bulk->writeErr == DmtxPass)
+         perror(bulk->outPath);
+      failed = (next == &encodeFailed || next == &outOfMemory) ? DmtxTrue : DmtxFalse;
+      written = (err == DmtxPass && failed == DmtxFalse) ? next->size : 0;
+      if(failed == DmtxFalse)
+         free(next);
+
+      pthread_mutex_lock(&bulk->lock);
+      if(err == DmtxFail) {
+         bulk->writeErr = DmtxFail;
+         stopping = 1;
+      }
+      if(failed == DmtxTrue)
+         bulk->failed++;
+      else if(written > 0)
+         bulk->labels++;
+      bulk->bytes += (double)written;
+      bulk->inFlight -= bytes;
+      bulk->nextWrite++;
+      pthread_cond_broadcast(&bulk->drained);
+   }
+   bulk->writing = 0;
+
+   pthread_mutex_unlock(&bulk->lock);
+}
+
+/**
+ * @brief  Build a 1-bit grayscale PNG file with stored (uncompressed)
+ *         deflate blocks, which cost nothing to make and little space at
+ *         one bit per pixel
+ * @param  raw 1 bpp rows (1 dark) at raw + 1, one spare byte before each
+ * @param  width Width in pixels
+ * @param  height Height in pixels
+ * @param  dst Receives the file
+ * @return File size in bytes
+ */
+static size_t
+FormatPng(unsigned char *raw, int width, int height, unsigned char *dst)
+{
+   static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+   static const unsigned char iend[12] = { 0, 0, 0, 0, 'I', 'E', 'N', 'D', 0xae, 0x42, 0x60, 0x82 };
+   unsigned char *row;
+   size_t i, rawSize, block, n, idat;
+   int rowBytes = (width + 7) / 8;
+   int x, y;
+
+   /* PNG grayscale is 0 dark; each row starts with filter type 0 */
+   rawSize = (size_t)(rowBytes + 1) * height;
+   for(y = 0; y < height; y++) {
+      row = raw + (size_t)y * (rowBytes + 1);
+      row[0] = 0x00;
+      for(x = 1; x <= rowBytes; x++)
+         row[x] = (unsigned char)~row[x];
+   }
+
+   memcpy(dst, signature, 8);
+   PutBE32(dst + 8, 13);
+   memcpy(dst + 12, "IHDR", 4);
+   PutBE32(dst + 16, (unsigned long)width);
+   PutBE32(dst + 20, (unsigned long)height);
+   dst[24] = 1;                    /* Bit depth */
+   dst[25] = 0;                    /* Grayscale */
+   dst[26] = dst[27] = dst[28] = 0;
+   PutBE32(dst + 29, Crc32(dst + 12, 17));
+
+   idat = 33;
+   memcpy(dst + idat + 4, "IDAT", 4);
+   n = idat + 8;
+   dst[n++] = 0x78;                /* Deflate, 32K window */
+   dst[n++] = 0x01;
+   for(i = 0; i < rawSize; i += block) {
+      block = (rawSize - i > DMTXBULK_STORED_MAX) ? DMTXBULK_STORED_MAX : rawSize - i;
+      dst[n++] = (i + block == rawSize) ? 0x01 : 0x00;
+      PutLE16(dst + n, (unsigned int)block);
+      PutLE16(dst + n + 2, (unsigned int)(~block & 0xffff));
+      memcpy(dst + n + 4, raw + i, block);
+      n += 4 + block;
+   }
+   PutBE32(dst + n, Adler32(raw, rawSize));
+   n += 4;
+   PutBE32(dst + idat, (unsigned long)(n - idat - 8));
+   PutBE32(dst + n, Crc32(dst + idat + 4, n - idat - 4));
+   n += 4;
+
+   memcpy(dst + n, iend, 12);
+
+   return n + 12;
+}
+
+/**
+ * @brief  PackBits-compress one row (TIFF compression 32773)
+ * @param  src Row
+ * @param  count Bytes in the row
+ * @param  dst Receives at most count + count / 128 + 1 bytes
+ * @return Bytes written
+ */
+static size_t
+PackBits(const unsigned char *src, int count, unsigned char *dst)
+{
+   size_t n = 0;
+   int i = 0, run;
+
+   while(i < count) {
+      for(run = 1; i + run < count && run < 128 && src[i + run] == src[i]; run++)
+         ;
+
+      if(run >= 2) {
+         dst[n++] = (unsigned char)(257 - run);
+         dst[n++] = src[i];
+      }
+      else {
+         /* Literal bytes up to where the next run starts */
+         for(run = 1; i + run < count && run < 128 &&
+               !(i + run + 1 < count && src[i + run] == src[i + run + 1]); run++)
+            ;
+         dst[n++] = (unsigned char)(run - 1);
+         memcpy(dst + n, src + i, run);
+         n += run;
+      }
+      i += run;
+   }
+
+   return n;
+}
+
+/**
+ * @brief  Create the output directory or files and write their headers
+ * @param  bulk Bulk run
+ * @return DmtxPass | DmtxFail (errno set)
+ */
+static DmtxPassFail
+OpenOutput(Bulk *bulk)
+{
+   unsigned char header[DMTXBULK_PACK_HEADER];
+   char *indexPath;
+
+   switch(bulk->format) {
+      case BulkFormatPng:
+         if(mkdir(bulk->outPath, 0777) != 0 && errno != EEXIST)
+            return DmtxFail;
+         bulk->pngPath = (char *)malloc(strlen(bulk->outPath) + 32);
+         return (bulk->pngPath == NULL) ? DmtxFail : DmtxPass;
+
+      case BulkFormatTiff:
+         /* Little-endian; the first directory follows the header */
+         bulk->out = fopen(bulk->outPath, "wb");
+         if(bulk->out == NULL)
+            return DmtxFail;
+         memcpy(header, "II*\0", 4);
+         PutLE32(header + 4, 8);
+         bulk->offset = 8;
+         bulk->lastLink = 4;
+         return (fwrite(header, 1, 8, bulk->out) == 8) ? DmtxPass : DmtxFail;
+
+      default:
+         indexPath = (char *)malloc(strlen(bulk->outPath) + 5);
+         if(indexPath == NULL)
+            return DmtxFail;
+         sprintf(indexPath, "%s.bin", bulk->outPath);
+         bulk->out = fopen(indexPath, "wb");
+         sprintf(indexPath, "%s.idx", bulk->outPath);
+         bulk->index = (bulk->out == NULL) ? NULL : fopen(indexPath, "wb");
+         free(indexPath);
+         if(bulk->index == NULL)
+            return DmtxFail;
+         memcpy(header, "DMTXBULK", 8);
+         PutLE32(header + 8, 1);
+         PutLE32(header + 12, DMTXBULK_PACK_RECORD);
+         return (fwrite(header, 1, DMTXBULK_PACK_HEADER, bulk->index) ==
+               DMTXBULK_PACK_HEADER) ? DmtxPass : DmtxFail;
+   }
+}
+
+/**
+ * @brief  End the TIFF page chain and close the output files
+ * @param  bulk Bulk run
+ * @return DmtxPass | DmtxFail (errno set)
+ */
+static DmtxPassFail
+CloseOutput(Bulk *bulk)
+{
+   unsigned char zero[4] = { 0, 0, 0, 0 };
+   DmtxPassFail err = DmtxPass;
+
+   if(bulk->format == BulkFormatTiff && bulk->writeErr == DmtxPass &&
+         (fseeko(bulk->out, bulk->lastLink, SEEK_SET) != 0 ||
+         fwrite(zero, 1, 4, bulk->out) != 4))
+      err = DmtxFail;
+
+   if(bulk->out != NULL && fclose(bulk->out) != 0)
+      err = DmtxFail;
+   if(bulk->index != NULL && fclose(bulk->index) != 0)
+      err = DmtxFail;
+
+   return err;
+}
+
+/**
+ * @brief  Write one label, or report one that failed
+ * @param  bulk Bulk run
+ * @param  seq Line number of the label
+ * @param  result Label, &encodeFailed or &outOfMemory
+ * @return DmtxPass | DmtxFail (write error, errno set)
+ */
+static DmtxPassFail
+WriteResult(Bulk *bulk, long seq, const Result *result)
+{
+   FILE *fp;
+   DmtxPassFail err;
+
+   if(result == &encodeFailed || result == &outOfMemory) {
+      fprintf(stderr, "dmtxbulk: line %ld: %s\n", seq, (result == &encodeFailed) ?
+            "message does not fit" : "out of memory");
+      return (bulk->format == BulkFormatPack) ? WritePackRecord(bulk, result) : DmtxPass;
+   }
+
+   switch(bulk->format) {
+      case BulkFormatPng:
+         sprintf(bulk->pngPath, "%s/%08ld.png", bulk->outPath, seq);
+         fp = fopen(bulk->pngPath, "wb");
+         if(fp == NULL)
+            return DmtxFail;
+         err = (fwrite(result->data, 1, result->size, fp) == result->size) ? DmtxPass : DmtxFail;
+         if(fclose(fp) != 0)
+            err = DmtxFail;
+         break;
+      case BulkFormatTiff:
+         err = WriteTiffPage(bulk, result);
+         break;
+      default:
+         err = (fwrite(result->data, 1, result->size, bulk->out) == result->size) ?
+               WritePackRecord(bulk, result) : DmtxFail;
+         break;
+   }
+
+   return err;
+}
+
+/**
+ * @brief  Append a TIFF page: its directory, then its one PackBits strip.
+ *         Every directory points past its own strip, where the next page
+ *         goes; CloseOutput() ends the chain at the last one.
+ * @param  bulk Bulk run
+ * @param  result Label with a PackBits strip
+ * @return DmtxPass | DmtxFail (errno set)
+ */
+static DmtxPassFail
+WriteTiffPage(Bulk *bulk, const Result *result)
+{
+   /* Tag, type (3 SHORT, 4 LONG), value; ascending as TIFF requires */
+   static const unsigned int tags[DMTXBULK_TIFF_TAGS][2] = {
+      { 254, 4 }, { 256, 4 }, { 257, 4 }, { 258, 3 }, { 259, 3 },
+      { 262, 3 }, { 273, 4 }, { 277, 3 }, { 278, 4 }, { 279, 4 }
+   };
+   unsigned char ifd[DMTXBULK_TIFF_IFD], pad = 0;
+   unsigned long value[DMTXBULK_TIFF_TAGS];
+   off_t strip, next;
+   int i;
+
+   strip = bulk->offset + DMTXBULK_TIFF_IFD;
+   next = strip + (off_t)result->size + (off_t)(result->size & 1);
+   if(next > (off_t)0xffffffffUL) {
+      errno = EFBIG;
+      return DmtxFail;
+   }
+
+   value[0] = 2;                   /* NewSubfileType: one page of many */
+   value[1] = (unsigned long)result->width;
+   value[2] = (unsigned long)result->height;
+   value[3] = 1;                   /* BitsPerSample */
+   value[4] = 32773;               /* Compression: PackBits */
+   value[5] = 0;                   /* Photometric: WhiteIsZero */
+   value[6] = (unsigned long)strip;
+   value[7] = 1;                   /* SamplesPerPixel */
+   value[8] = (unsigned long)result->height;
+   value[9] = (unsigned long)result->size;
+
+   PutLE16(ifd, DMTXBULK_TIFF_TAGS);
+   for(i = 0; i < DMTXBULK_TIFF_TAGS; i++) {
+      PutLE16(ifd + 2 + i * 12, tags[i][0]);
+      PutLE16(ifd + 4 + i * 12, tags[i][1]);
+      PutLE32(ifd + 6 + i * 12, 1);
+      PutLE32(ifd + 10 + i * 12, 0);
+      if(tags[i][1] == 3)
+         PutLE16(ifd + 10 + i * 12, (unsigned int)value[i]);
+      else
+         PutLE32(ifd + 10 + i * 12, value[i]);
+   }
+   PutLE32(ifd + DMTXBULK_TIFF_IFD - 4, (unsigned long)next);
+
+   if(fwrite(ifd, 1, DMTXBULK_TIFF_IFD, bulk->out) != DMTXBULK_TIFF_IFD ||
+         fwrite(result->data, 1, result->size, bulk->out) != result->size ||
+         ((result->size & 1) && fwrite(&pad, 1, 1, bulk->out) != 1))
+      return DmtxFail;
+
+   bulk->lastLink = bulk->offset + DMTXBULK_TIFF_IFD - 4;
+   bulk->offset = next;
+
+   return DmtxPass;
+}
+
+/**
+ * @brief  Append a label's index record; its rows are already in the blob
+ *         (none for a failed label, whose record is flagged)
+ * @param  bulk Bulk run
+ * @param  result Label, &encodeFailed or &outOfMemory
+ * @return DmtxPass | DmtxFail (errno set)
+ */
+static DmtxPassFail
+WritePackRecord(Bulk *bulk, const Result *result)
+{
+   unsigned char record[DMTXBULK_PACK_RECORD];
+   DmtxBoolean failed = (result == &encodeFailed || result == &outOfMemory);
+   off_t offset = bulk->offset;
+   int i;
+
+   /* Offset (64-bit), bytes, width, height, flags (1 failed) */
+   for(i = 0; i < 8; i++) {
+      record[i] = (unsigned char)(offset & 0xff);
+      offset >>= 8;
+   }
+   PutLE32(record + 8, failed ? 0 : (unsigned long)result->size);
+   PutLE32(record + 12, failed ? 0 : (unsigned long)result->width);
+   PutLE32(record + 16, failed ? 0 : (unsigned long)result->height);
+   PutLE32(record + 20, failed ? 1 : 0);
+
+   if(fwrite(record, 1, DMTXBULK_PACK_RECORD, bulk->index) != DMTXBULK_PACK_RECORD)
+      return DmtxFail;
+
+   if(!failed)
+      bulk->offset += (off_t)result->size;
+
+   return DmtxPass;
+}
+
+/**
+ * @brief  Store a 32-bit value big-endian (PNG)
+ * @param  dst Destination
+ * @param  value Value
+ * @return void
+ */
+static void
+PutBE32(unsigned char *dst, unsigned long value)
+{
+   dst[0] = (unsigned char)((value >> 24) & 0xff);
+   dst[1] = (unsigned char)((value >> 16) & 0xff);
+   dst[2] = (unsigned char)((value >> 8) & 0xff);
+   dst[3] = (unsigned char)(value & 0xff);
+}
+
+/**
+ * @brief  Store a 16-bit value little-endian (deflate, TIFF, index)
+ * @param  dst Destination
+ * @param  value Value
+ * @return void
+ */
+static void
+PutLE16(unsigned char *dst, unsigned int value)
+{
+   dst[0] = (unsigned char)(value & 0xff);
+   dst[1] = (unsigned char)((value >> 8) & 0xff);
+}
+
+/**
+ * @brief  Store a 32-bit value little-endian (TIFF, index)
+ * @param  dst Destination
+ * @param  value Value
+ * @return void
+ */
+static void
+PutLE32(unsigned char *dst, unsigned long value)
+{
+   PutLE16(dst, (unsigned int)(value & 0xffff));
+   PutLE16(dst + 2, (unsigned int)((value >> 16) & 0xffff));
+}
+
+/**
+ * @brief  Fill the CRC-32 table (before the workers start)
+ * @return void
+ */
+static void
+InitCrcTable(void)
+{
+   unsigned long c;
+   int n, k;
+
+   for(n = 0; n < 256; n++) {
+      c = (unsigned long)n;
+      for(k = 0; k < 8; k++)
+         c = (c & 1) ? 0xedb88320UL ^ (c >> 1) : c >> 1;
+      crcTable[n] = c;
+   }
+}
+
+/**
+ * @brief  CRC-32 of a PNG chunk's type and data
+ * @param  data Bytes
+ * @param  length Number of bytes
+ * @return CRC
+ */
+static unsigned long
+Crc32(const unsigned char *data, size_t length)
+{
+   unsigned long c = 0xffffffffUL;
+   size_t i;
+
+   for(i = 0; i < length; i++)
+      c = crcTable[(c ^ data[i]) & 0xff] ^ (c >> 8);
+
+   return (c ^ 0xffffffffUL) & 0xffffffffUL;
+}
+
+/**
+ * @brief  Adler-32 of the uncompressed zlib stream
+ * @param  data Bytes
+ * @param  length Number of bytes
+ * @return Checksum
+ */
+static unsigned long
+Adler32(const unsigned char *data, size_t length)
+{
+   unsigned long a = 1, b = 0;
+   size_t i, chunk;
+
+   /* 5552 bytes at most between reductions keep b below 2^32 */
+   while(length > 0) {
+      chunk = (length > 5552) ? 5552 : length;
+      for(i = 0; i < chunk; i++) {
+         a += data[i];
+         b += a;
+      }
+      a %= 65521;
+      b %= 65521;
+      data += chunk;
+      length -= chunk;
+   }
+
+   return (b << 16) | a;
+}
+
+/**
+ * @brief  Print counts, throughput and memory to stderr (caller holds the
+ *         lock, or the workers are done)
+ * @param  bulk Bulk run
+ * @param  start Start of the run
+ * @param  prefix First word of the line
+ * @return void
+ */
+static void
+Report(Bulk *bulk, DmtxTime start, const char *prefix)
+{
+   double sec = ElapsedSec(start);
+
+   if(sec <= 0.0)
+      sec = 1.0e-6;
+
+   fprintf(stderr, "dmtxbulk: %s: %ld labels (%ld failed), %.1f s, %.1f labels/s, "
+         "%.1f MB written, %.1f MB in flight (peak %.1f)\n", prefix,
+         bulk->labels, bulk->failed, sec, (bulk->labels + bulk->failed) / sec,
+         bulk->bytes / 1048576.0, bulk->inFlight / 1048576.0,
+         bulk->peakInFlight / 1048576.0);
+}
+
+/**
+ * @brief  Seconds since a point in time
+ * @param  start Start time
+ * @return Elapsed seconds
+ */
+static double
+ElapsedSec(DmtxTime start)
+{
+   DmtxTime now = dmtxTimeNow();
+
+   return (double)(now.sec - start.sec) + ((double)now.usec - (double)start.usec) / 1.0e6;
+}
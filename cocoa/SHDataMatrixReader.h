@@ -25,15 +25,34 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #import <Cocoa/Cocoa.h>
 #endif
 
+#import "dmtxw.h"
+
 @interface SHDataMatrixReader : NSObject {
-    
+	DmtxwSession *session;
+	DmtxwCache *cache;
+	NSInteger lumaScale;
 }
+// Convert to luminance natively before decoding, downscaled by 1, 2 or 4
+// (0, the default, decodes the ARGB bitmap as is).
+@property (nonatomic, assign) NSInteger lumaScale;
+// Hits and misses of the result cache since it was enabled.
+@property (nonatomic, readonly) long cacheHits;
+@property (nonatomic, readonly) long cacheMisses;
+// Why the last decode stopped: DmtxwStatusComplete, DmtxwStatusTimeout, ...
+@property (nonatomic, readonly) DmtxwStatus lastStatus;
 #pragma mark Allocation
 + (id)sharedDataMatrixReader;
 #pragma mark Instance
+// Answer images matching one of the last `entries` decoded ones from memory
+// for `ttl` milliseconds (at least 1); 0 entries switches the cache off.
+- (BOOL)enableCacheWithEntries:(NSInteger)entries ttl:(NSInteger)ttl;
 #if TARGET_OS_IPHONE
 - (NSString *)decodeBarcodeFromImage:(UIImage *)image;
+// Give up searching at `deadline` (nil: never); lastStatus tells whether
+// a nil result means no symbol or no time.
+- (NSString *)decodeBarcodeFromImage:(UIImage *)image beforeDate:(NSDate *)deadline;
 #else
 - (NSString *)decodeBarcodeFromImage:(NSImage *)image;
+- (NSString *)decodeBarcodeFromImage:(NSImage *)image beforeDate:(NSDate *)deadline;
 #endif
 @end
@@ -29,14 +29,16 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 
 @interface SHDataMatrixReader ()
 #if TARGET_OS_IPHONE
-- (NSData *)_ARGB8DataForImage:(UIImage *)image;
+- (NSData *)_ARGB8DataForImage:(UIImage *)image width:(NSUInteger *)width height:(NSUInteger *)height;
 #else
-- (NSData *)_ARGB8DataForImage:(NSImage *)image;
+- (NSData *)_ARGB8DataForImage:(NSImage *)image width:(NSUInteger *)width height:(NSUInteger *)height;
 #endif
 @end
 
 @implementation SHDataMatrixReader
 
+@synthesize lumaScale;
+
 #pragma mark Allocation
 
 + (id)sharedDataMatrixReader {
@@ -49,79 +51,107 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 - (id)init {
 	self = [super init];
 	if(self != nil) {
-
+		session = dmtxwSessionCreate();
+		if(session == NULL) {
+#if ! __has_feature(objc_arc)
+			[self release];
+#endif
+			return nil;
+		}
+		dmtxwSessionSetProp(session, DmtxwPropMaxCount, 1);
 	}
 	return self;
 }
 
 #pragma mark Instance
-#if TARGET_OS_IPHONE
-- (NSString *)decodeBarcodeFromImage:(UIImage *)image {
-#else
-- (NSString *)decodeBarcodeFromImage:(NSImage *)image {
-#endif
+- (BOOL)enableCacheWithEntries:(NSInteger)entries ttl:(NSInteger)ttl {
+	DmtxwCache *newCache = NULL;
 
-	NSMutableArray *messages = [NSMutableArray array];
+	if(entries > 0) {
+		newCache = dmtxwCacheCreate((int)entries, (int)ttl, DmtxUndefined);
+		if(newCache == NULL)
+			return NO;
+	}
 
-    NSData * imageData = [self _ARGB8DataForImage:image];
-	// Create dmtx image.
-	DmtxImage *dmtxImage = dmtxImageCreate((unsigned char*)[imageData bytes], 500, 500, DmtxPack32bppXRGB);
-	if(dmtxImage == NULL)
-    {
-#if ! __has_feature(objc_arc)
-        [imageData release];
-#endif
-		return nil;
-    }
+	dmtxwSessionSetCache(session, newCache);
+	if(cache != NULL)
+		dmtxwCacheDestroy(&cache);
+	cache = newCache;
 
-	// Initialize dmtx decode struct for image.
-	DmtxDecode *dmtxDecode = dmtxDecodeCreate(dmtxImage, 1);
+	return YES;
+}
 
-	DmtxRegion *dmtxRegion;
-	DmtxMessage *dmtxMessage;
+- (long)cacheHits {
+	long hits = 0;
 
-	// Loop once for each detected barcode region.
-	NSUInteger count;
-	for(count = 0; count < 1; count++) {
+	dmtxwCacheGetStats(cache, &hits, NULL);
+	return hits;
+}
 
-		// Find next barcode region within image.
-		dmtxRegion = dmtxRegionFindNext(dmtxDecode, NULL);
-		if(dmtxRegion == NULL)
-			break;
+- (long)cacheMisses {
+	long misses = 0;
 
-		// Decode region based on requested scan mode.
-		dmtxMessage = dmtxDecodeMatrixRegion(dmtxDecode, dmtxRegion, DmtxUndefined);
+	dmtxwCacheGetStats(cache, NULL, &misses);
+	return misses;
+}
 
-		if(dmtxMessage != NULL) {
-			// Convert C string to NSString.
-            NSString *message = [[NSString alloc] initWithBytes:dmtxMessage->output length:(NSUInteger)dmtxMessage->outputIdx encoding:NSASCIIStringEncoding];
-			[messages addObject:message];
+- (DmtxwStatus)lastStatus {
+	return session->status;
+}
 
-			// Free dmtx message memory.
-			dmtxMessageDestroy(&dmtxMessage);
-		}
+#if TARGET_OS_IPHONE
+- (NSString *)decodeBarcodeFromImage:(UIImage *)image {
+#else
+- (NSString *)decodeBarcodeFromImage:(NSImage *)image {
+#endif
+	return [self decodeBarcodeFromImage:image beforeDate:nil];
+}
 
-		dmtxRegionDestroy(&dmtxRegion);
+#if TARGET_OS_IPHONE
+- (NSString *)decodeBarcodeFromImage:(UIImage *)image beforeDate:(NSDate *)deadline {
+#else
+- (NSString *)decodeBarcodeFromImage:(NSImage *)image beforeDate:(NSDate *)deadline {
+#endif
+
+	NSUInteger width, height;
+	size_t length;
+	DmtxTime end;
 
-		break;
+	// The budget also covers rendering the image into a bitmap.
+	if(deadline != nil) {
+		NSTimeInterval left = [deadline timeIntervalSinceNow];
+		end = dmtxTimeAdd(dmtxTimeNow(), (left > 0.0) ? (long)(left * 1000.0) : 0);
 	}
 
-	// Free dmtx decode memory.
-	dmtxDecodeDestroy(&dmtxDecode);
+	NSData *imageData = [self _ARGB8DataForImage:image width:&width height:&height];
+	if(imageData == nil)
+		return nil;
 
-	// Free dmtx image memory.
-	dmtxImageDestroy(&dmtxImage);
+	if(dmtxwSessionSetProp(session, DmtxwPropLuma, (int)lumaScale) == DmtxFail)
+		return nil;
 
-	if([messages count] > 0)
-		return [messages objectAtIndex:0];
-	else
+	// Decode the premultiplied ARGB buffer in place.
+	if(dmtxwSessionDecodeBefore(session, (unsigned char *)[imageData bytes], (int)width,
+			(int)height, (int)(width * 4), DmtxwFormatXRGB32,
+			(deadline != nil) ? &end : NULL) == DmtxFail)
 		return nil;
+
+	if(dmtxwSessionGetResultCount(session) == 0)
+		return nil;
+
+	// Convert payload to NSString.
+	const unsigned char *payload = dmtxwSessionGetPayload(session, 0, &length);
+	NSString *message = [[NSString alloc] initWithBytes:payload length:(NSUInteger)length encoding:NSASCIIStringEncoding];
+#if ! __has_feature(objc_arc)
+	[message autorelease];
+#endif
+	return message;
 }
 
 #if TARGET_OS_IPHONE
-- (NSData *)_ARGB8DataForImage:(UIImage *)image {
+- (NSData *)_ARGB8DataForImage:(UIImage *)image width:(NSUInteger *)outWidth height:(NSUInteger *)outHeight {
 #else
-- (NSData *)_ARGB8DataForImage:(NSImage *)image {
+- (NSData *)_ARGB8DataForImage:(NSImage *)image width:(NSUInteger *)outWidth height:(NSUInteger *)outHeight {
 #endif
 
 #if TARGET_OS_IPHONE
@@ -132,9 +162,12 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #endif
 
 	// Calculate image dimensions (500 pixel should be enough for decoding).
-	NSUInteger aspectRatio = CGImageGetWidth(imageRef) / CGImageGetHeight(imageRef);
+	if(CGImageGetWidth(imageRef) == 0 || CGImageGetHeight(imageRef) == 0)
+		return NULL;
 	NSUInteger width = 500;
-	NSUInteger height = 500 / aspectRatio;
+	NSUInteger height = (NSUInteger)(500.0 * CGImageGetHeight(imageRef) / CGImageGetWidth(imageRef) + 0.5);
+	if(height == 0)
+		height = 1;
 	NSUInteger bytesPerRow = width * 4;
 
 	// Create color space object.
@@ -181,13 +214,19 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 	// Free context memory.
 	free(memory);
 
+	*outWidth = width;
+	*outHeight = height;
+
 	return imageData;
 }
 
-#if ! __has_feature(objc_arc)
 - (void)dealloc {
+	dmtxwSessionDestroy(&session);
+	if(cache != NULL)
+		dmtxwCacheDestroy(&cache);
+#if ! __has_feature(objc_arc)
     [super dealloc];
-}
 #endif
+}
 
 @end
@@ -0,0 +1,1291 @@
+/*
+dmtxd - Decode daemon for the libdmtx wrappers
+
+Copyright (C) 2026 The libdmtx-wrappers project
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+Contact: mike@dragonflylogic.com
+*/
+
+/* $Id$ */
+
+/**
+ * @file dmtxd.c
+ * @brief Decode daemon serving the libdmtx wrappers over a Unix socket
+ *
+ * Short-lived callers (PHP-FPM requests, scripts) pay for loading libdmtx
+ * and setting up a decoder on every request, and cannot share cores among
+ * each other. dmtxd keeps a fixed pool of workers, each owning one
+ * DmtxwSession, and serves decode and encode jobs sent over a Unix socket
+ * (see dmtxd.h for the protocol). Pixels can be handed over as a file
+ * descriptor; a memfd sealed against shrinking and writing is mapped, not
+ * copied. Any other descriptor is read into the worker's buffer, since a
+ * client truncating a mapped file would kill the daemon with SIGBUS.
+ *
+ * The main thread only accepts connections and waits for requests; a
+ * connection with a request pending is queued for the workers. When the
+ * queue is full the main thread stops accepting and reading, so clients
+ * block in the kernel instead of piling up work (backpressure).
+ *
+ *   $ dmtxd [-s socket] [-w workers] [-q queue] [-c connections]
+ *           [-m mode] [-C cache entries] [-t trace prefix [-T min ms]]
+ *
+ * With -t, every worker writes the spans of its decodes to its own Chrome
+ * trace file, prefix.N.json; with -T, only decodes taking at least that
+ * many milliseconds are kept.
+ */
+
+#define _XOPEN_SOURCE 700
+#define _DEFAULT_SOURCE
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include "dmtxw.h"
+#include "dmtxd.h"
+
+#define DMTXD_WORKERS         4
+#define DMTXD_QUEUE           16
+#define DMTXD_CONNECTIONS     64
+#define DMTXD_BACKLOG         64
+
+/* Seconds a client may stall while sending a request or reading a reply */
+#define DMTXD_IO_TIMEOUT      10
+
+#define DMTXD_MAX_ARGS        48
+
+/* Pixel rows expanded per send while streaming an encoded symbol */
+#define DMTXD_ENCODE_STRIP    32
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL          0
+#endif
+
+typedef enum {
+   ConnFree,                   /* Slot unused */
+   ConnIdle,                   /* Polled by the main thread */
+   ConnBusy                    /* Queued or being served by a worker */
+} ConnState;
+
+typedef struct {
+   int             fd;
+   ConnState       state;      /* Set by the main thread, server lock held */
+   DmtxTime        ready;      /* When the pending request was noticed */
+   char            buf[DMTXD_LINE_MAX];
+   size_t          have;       /* Bytes read into buf but not consumed */
+   int             passedFd;   /* Descriptor received with the request, or -1 */
+} Conn;
+
+typedef struct {
+   Conn           *conn;
+   int             connMax;
+   int            *queue;      /* Ring of connection indexes */
+   int             queueMax;
+   int             queueHead;
+   int             queueCount;
+   int             workerCount;
+   int             stopping;
+   long            served;
+   long            failed;
+   int             wake[2];    /* Workers and signals -> main thread */
+   pthread_mutex_t lock;
+   pthread_cond_t  pending;
+   DmtxwCache     *cache;
+   DmtxwStats      stats;      /* Instrumentation totals of all workers */
+} Server;
+
+typedef struct {
+   Server         *server;
+   DmtxwSession   *session;
+   DmtxwTraceJson *trace;      /* NULL unless started with -t */
+   pthread_t       thread;
+   unsigned char  *buf;        /* Inline payloads */
+   size_t          capacity;
+} Worker;
+
+static const char *formatNames[] = DMTXD_FORMAT_NAMES;
+static const char *statusNames[] = DMTXD_STATUS_NAMES;
+
+/* Write end of the wake pipe, for the signal handler */
+static int signalFd = -1;
+
+static void OnSignal(int sig);
+static int OpenSocket(const char *path, int mode);
+static DmtxPassFail RunServer(Server *server, int listenFd);
+static void AcceptConnection(Server *server, int listenFd);
+static void Enqueue(Server *server, int idx);
+static void *WorkerMain(void *arg);
+static DmtxPassFail ServeRequest(Worker *worker, Conn *conn);
+static DmtxPassFail HandleDecode(Worker *worker, Conn *conn, char **argv, int argc);
+static DmtxPassFail SendResults(Conn *conn, DmtxwSession *session);
+static DmtxPassFail HandleEncode(Worker *worker, Conn *conn, char **argv, int argc);
+static DmtxPassFail HandleStats(Worker *worker, Conn *conn);
+static DmtxPassFail HandleCounters(Worker *worker, Conn *conn, char **argv, int argc);
+static DmtxPassFail ReadLine(Conn *conn, char *line);
+static DmtxPassFail ReadPassedFd(Conn *conn);
+static DmtxPassFail ReadPayload(Worker *worker, Conn *conn, long length);
+static DmtxPassFail ReadPassedPixels(Worker *worker, Conn *conn, long length);
+static DmtxBoolean IsSealed(int fd);
+static DmtxPassFail ReserveBuffer(Worker *worker, size_t size);
+static DmtxPassFail ReadSome(Conn *conn, char *dst, size_t size, ssize_t *got);
+static DmtxPassFail SendAll(int fd, const void *data, size_t length);
+static DmtxPassFail SendError(Conn *conn, const char *reason);
+static int SplitLine(char *line, char **argv, int maxArgs);
+static int ParseInt(const char *text, int *value);
+static int LookupName(const char **names, const char *name);
+static double ElapsedMsec(DmtxTime start);
+
+/**
+ * @brief  Parse the command line, start the workers and serve until a
+ *         signal asks to stop
+ * @param  argc Argument count
+ * @param  argv Options (see the file comment)
+ * @return 0 on clean shutdown, 1 on error
+ */
+int
+main(int argc, char *argv[])
+{
+   Server server;
+   Worker *worker;
+   const char *path = DMTXD_SOCKET_PATH;
+   const char *tracePrefix = NULL;
+   char tracePath[1024];
+   double traceMinMsec = 0.0;
+   int opt, i, listenFd, mode = 0660, cacheEntries = 0;
+   int started = 0;
+   DmtxPassFail err;
+   struct sigaction sa;
+
+   memset(&server, 0x00, sizeof(Server));
+   server.workerCount = DMTXD_WORKERS;
+   server.queueMax = DMTXD_QUEUE;
+   server.connMax = DMTXD_CONNECTIONS;
+
+   while((opt = getopt(argc, argv, "s:w:q:c:m:C:t:T:h")) != -1) {
+      switch(opt) {
+         case 's':
+            path = optarg;
+            break;
+         case 'w':
+            server.workerCount = atoi(optarg);
+            break;
+         case 'q':
+            server.queueMax = atoi(optarg);
+            break;
+         case 'c':
+            server.connMax = atoi(optarg);
+            break;
+         case 'm':
+            mode = (int)strtol(optarg, NULL, 8);
+            break;
+         case 'C':
+            cacheEntries = atoi(optarg);
+            break;
+         case 't':
+            tracePrefix = optarg;
+            break;
+         case 'T':
+            traceMinMsec = atof(optarg);
+            break;
+         default:
+            fprintf(stderr, "usage: %s [-s socket] [-w workers] [-q queue] "
+                  "[-c connections] [-m mode] [-C cache entries] "
+                  "[-t trace prefix [-T min ms]]\n", argv[0]);
+            return 1;
+      }
+   }
+
+   if(server.workerCount < 1 || server.queueMax < 1 || server.connMax < 1) {
+      fprintf(stderr, "%s: workers, queue and connections must be positive\n", argv[0]);
+      return 1;
+   }
+
+   server.conn = (Conn *)calloc(server.connMax, sizeof(Conn));
+   server.queue = (int *)malloc(server.queueMax * sizeof(int));
+   worker = (Worker *)calloc(server.workerCount, sizeof(Worker));
+   if(server.conn == NULL || server.queue == NULL || worker == NULL) {
+      fprintf(stderr, "%s: out of memory\n", argv[0]);
+      return 1;
+   }
+   for(i = 0; i < server.connMax; i++)
+      server.conn[i].fd = server.conn[i].passedFd = -1;
+
+   if(cacheEntries > 0) {
+      server.cache = dmtxwCacheCreate(cacheEntries, 1000, DmtxUndefined);
+      if(server.cache == NULL) {
+         fprintf(stderr, "%s: invalid cache size %d\n", argv[0], cacheEntries);
+         return 1;
+      }
+   }
+
+   if(pipe(server.wake) != 0) {
+      perror("pipe");
+      return 1;
+   }
+   fcntl(server.wake[0], F_SETFL, O_NONBLOCK);
+   signalFd = server.wake[1];
+
+   memset(&sa, 0x00, sizeof(sa));
+   sa.sa_handler = OnSignal;
+   sigemptyset(&sa.sa_mask);
+   sigaction(SIGINT, &sa, NULL);
+   sigaction(SIGTERM, &sa, NULL);
+   sa.sa_handler = SIG_IGN;
+   sigaction(SIGPIPE, &sa, NULL);
+
+   listenFd = OpenSocket(path, mode);
+   if(listenFd < 0)
+      return 1;
+
+   pthread_mutex_init(&server.lock, NULL);
+   pthread_cond_init(&server.pending, NULL);
+
+   /* Each worker keeps its session (and its buffers) for its lifetime */
+   err = DmtxPass;
+   for(i = 0; i < server.workerCount; i++) {
+      worker[i].server = &server;
+      worker[i].session = dmtxwSessionCreate();
+      if(worker[i].session != NULL && tracePrefix != NULL) {
+         sprintf(tracePath, "%.1000s.%d.json", tracePrefix, i);
+         worker[i].trace = dmtxwTraceJsonOpen(tracePath, traceMinMsec);
+         if(worker[i].trace == NULL) {
+            perror(tracePath);
+            err = DmtxFail;
+            break;
+         }
+         dmtxwSessionSetTrace(worker[i].session, dmtxwTraceJsonWrite, worker[i].trace);
+      }
+      if(worker[i].session == NULL ||
+            pthread_create(&(worker[i].thread), NULL, WorkerMain, &(worker[i])) != 0) {
+         err = DmtxFail;
+         break;
+      }
+      started++;
+   }
+
+   if(err == DmtxPass) {
+      fprintf(stderr, "dmtxd: serving %s with %d workers\n", path, server.workerCount);
+      err = RunServer(&server, listenFd);
+   }
+
+   pthread_mutex_lock(&server.lock);
+   server.stopping = 1;
+   pthread_cond_broadcast(&server.pending);
+   pthread_mutex_unlock(&server.lock);
+
+   for(i = 0; i < started; i++)
+      pthread_join(worker[i].thread, NULL);
+
+   for(i = 0; i < server.workerCount; i++) {
+      if(worker[i].session != NULL)
+         dmtxwSessionDestroy(&(worker[i].session));
+      if(worker[i].trace != NULL)
+         dmtxwTraceJsonClose(&(worker[i].trace));
+      free(worker[i].buf);
+   }
+
+   for(i = 0; i < server.connMax; i++) {
+      if(server.conn[i].fd >= 0)
+         close(server.conn[i].fd);
+      if(server.conn[i].passedFd >= 0)
+         close(server.conn[i].passedFd);
+   }
+
+   close(listenFd);
+   unlink(path);
+
+   if(server.cache != NULL)
+      dmtxwCacheDestroy(&server.cache);
+
+   pthread_cond_destroy(&server.pending);
+   pthread_mutex_destroy(&server.lock);
+   free(server.queue);
+   free(server.conn);
+   free(worker);
+
+   fprintf(stderr, "dmtxd: %ld requests served, %ld failed\n", server.served, server.failed);
+
+   return (err == DmtxPass) ? 0 : 1;
+}
+
+/**
+ * @brief  Wake the main thread with a stop request
+ * @param  sig Signal number (unused)
+ * @return void
+ */
+static void
+OnSignal(int sig)
+{
+   int stop = -1;
+   ssize_t ignored;
+
+   (void)sig;
+   ignored = write(signalFd, &stop, sizeof(int));
+   (void)ignored;
+}
+
+/**
+ * @brief  Create the listening socket, replacing a stale one
+ * @param  path Socket path
+ * @param  mode Permission bits of the socket file
+ * @return Listening descriptor, or -1 on error
+ */
+static int
+OpenSocket(const char *path, int mode)
+{
+   struct sockaddr_un addr;
+   struct stat st;
+   int fd;
+
+   if(strlen(path) >= sizeof(addr.sun_path)) {
+      fprintf(stderr, "dmtxd: socket path too long: %s\n", path);
+      return -1;
+   }
+
+   if(lstat(path, &st) == 0 && S_ISSOCK(st.st_mode))
+      unlink(path);
+
+   fd = socket(AF_UNIX, SOCK_STREAM, 0);
+   if(fd < 0) {
+      perror("socket");
+      return -1;
+   }
+   fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+   memset(&addr, 0x00, sizeof(addr));
+   addr.sun_family = AF_UNIX;
+   strcpy(addr.sun_path, path);
+
+   if(bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+         chmod(path, (mode_t)mode) != 0 || listen(fd, DMTXD_BACKLOG) != 0) {
+      perror(path);
+      close(fd);
+      return -1;
+   }
+
+   return fd;
+}
+
+/**
+ * @brief  Main loop: accept connections, queue those with a request pending
+ *         and take them back from the workers when they are done
+ * @param  server Server
+ * @param  listenFd Listening socket
+ * @return DmtxPass on a stop request | DmtxFail on error
+ */
+static DmtxPassFail
+RunServer(Server *server, int listenFd)
+{
+   struct pollfd *pfd;
+   int *slot;
+   int i, n, count, idx, full, freeSlot;
+   ssize_t got;
+
+   /* Wake pipe, listening socket and every connection */
+   pfd = (struct pollfd *)malloc((server->connMax + 2) * sizeof(struct pollfd));
+   slot = (int *)malloc((server->connMax + 2) * sizeof(int));
+   if(pfd == NULL || slot == NULL) {
+      free(pfd);
+      free(slot);
+      return DmtxFail;
+   }
+
+   for(;;) {
+      pthread_mutex_lock(&server->lock);
+      full = (server->queueCount >= server->queueMax);
+
+      /* Leftover bytes of a pipelined request need no poll to be served */
+      for(i = 0; i < server->connMax && !full; i++) {
+         if(server->conn[i].state == ConnIdle && server->conn[i].have > 0) {
+            Enqueue(server, i);
+            full = (server->queueCount >= server->queueMax);
+         }
+      }
+      pthread_mutex_unlock(&server->lock);
+
+      freeSlot = 0;
+      for(i = 0; i < server->connMax; i++) {
+         if(server->conn[i].state == ConnFree) {
+            freeSlot = 1;
+            break;
+         }
+      }
+
+      count = 0;
+      pfd[count].fd = server->wake[0];
+      pfd[count].events = POLLIN;
+      slot[count++] = -1;
+
+      /* A full queue stops intake until a worker frees a place */
+      if(!full && freeSlot) {
+         pfd[count].fd = listenFd;
+         pfd[count].events = POLLIN;
+         slot[count++] = -2;
+      }
+
+      for(i = 0; i < server->connMax && !full; i++) {
+         if(server->conn[i].state == ConnIdle) {
+            pfd[count].fd = server->conn[i].fd;
+            pfd[count].events = POLLIN;
+            slot[count++] = i;
+         }
+      }
+
+      n = poll(pfd, count, -1);
+      if(n < 0) {
+         if(errno == EINTR)
+            continue;
+         perror("poll");
+         break;
+      }
+
+      /* Connections handed back by workers, or a stop request */
+      if(pfd[0].revents & POLLIN) {
+         while((got = read(server->wake[0], &idx, sizeof(int))) == sizeof(int)) {
+            if(idx < 0) {
+               free(pfd);
+               free(slot);
+               return DmtxPass;
+            }
+            pthread_mutex_lock(&server->lock);
+            server->conn[idx].state = (server->conn[idx].fd < 0) ? ConnFree : ConnIdle;
+            pthread_mutex_unlock(&server->lock);
+         }
+      }
+
+      pthread_mutex_lock(&server->lock);
+      for(i = 1; i < count; i++) {
+         if(pfd[i].revents == 0 || slot[i] < 0)
+            continue;
+         if(server->queueCount < server->queueMax)
+            Enqueue(server, slot[i]);
+      }
+      pthread_mutex_unlock(&server->lock);
+
+      if(count > 1 && slot[1] == -2 && (pfd[1].revents & POLLIN))
+         AcceptConnection(server, listenFd);
+   }
+
+   free(pfd);
+   free(slot);
+
+   return DmtxFail;
+}
+
+/**
+ * @brief  Accept one client into a free connection slot
+ * @param  server Server
+ * @param  listenFd Listening socket
+ * @return void
+ */
+static void
+AcceptConnection(Server *server, int listenFd)
+{
+   struct timeval tv;
+   Conn *conn = NULL;
+   int i, fd;
+
+   fd = accept(listenFd, NULL, NULL);
+   if(fd < 0)
+      return;
+
+   for(i = 0; i < server->connMax; i++) {
+      if(server->conn[i].state == ConnFree) {
+         conn = &(server->conn[i]);
+         break;
+      }
+   }
+   if(conn == NULL) {
+      close(fd);
+      return;
+   }
+
+   fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+   /* A stalled client must not hold a worker forever */
+   tv.tv_sec = DMTXD_IO_TIMEOUT;
+   tv.tv_usec = 0;
+   setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+   setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+   conn->fd = fd;
+   conn->have = 0;
+   conn->passedFd = -1;
+
+   pthread_mutex_lock(&server->lock);
+   conn->state = ConnIdle;
+   pthread_mutex_unlock(&server->lock);
+}
+
+/**
+ * @brief  Queue a connection for the workers (server lock held)
+ * @param  server Server
+ * @param  idx Connection index
+ * @return void
+ */
+static void
+Enqueue(Server *server, int idx)
+{
+   server->conn[idx].state = ConnBusy;
+   server->conn[idx].ready = dmtxTimeNow();
+   server->queue[(server->queueHead + server->queueCount) % server->queueMax] = idx;
+   server->queueCount++;
+   pthread_cond_signal(&server->pending);
+}
+
+/**
+ * @brief  Worker loop: serve one request of each queued connection, then
+ *         hand the connection back to the main thread
+ * @param  arg Worker
+ * @return NULL
+ */
+static void *
+WorkerMain(void *arg)
+{
+   Worker *worker = (Worker *)arg;
+   Server *server = worker->server;
+   Conn *conn;
+   int idx;
+   ssize_t ignored;
+
+   for(;;) {
+      pthread_mutex_lock(&server->lock);
+      while(server->queueCount == 0 && !server->stopping)
+         pthread_cond_wait(&server->pending, &server->lock);
+      if(server->queueCount == 0) {
+         pthread_mutex_unlock(&server->lock);
+         break;
+      }
+      idx = server->queue[server->queueHead];
+      server->queueHead = (server->queueHead + 1) % server->queueMax;
+      server->queueCount--;
+      pthread_mutex_unlock(&server->lock);
+
+      conn = &(server->conn[idx]);
+      if(ServeRequest(worker, conn) == DmtxFail) {
+         close(conn->fd);
+         conn->fd = -1;
+      }
+      if(conn->passedFd >= 0) {
+         close(conn->passedFd);
+         conn->passedFd = -1;
+      }
+
+      ignored = write(server->wake[1], &idx, sizeof(int));
+      (void)ignored;
+   }
+
+   return NULL;
+}
+
+/**
+ * @brief  Read, execute and answer one request
+ * @param  worker Worker
+ * @param  conn Connection with a request pending
+ * @return DmtxPass | DmtxFail (connection must be closed)
+ */
+static DmtxPassFail
+ServeRequest(Worker *worker, Conn *conn)
+{
+   Server *server = worker->server;
+   char line[DMTXD_LINE_MAX];
+   char *argv[DMTXD_MAX_ARGS];
+   int argc;
+   DmtxPassFail err;
+
+   if(ReadLine(conn, line) == DmtxFail)
+      return DmtxFail;
+
+   argc = SplitLine(line, argv, DMTXD_MAX_ARGS);
+   if(argc == 0)
+      err = SendError(conn, "empty request");
+   else if(strcmp(argv[0], "DECODE") == 0)
+      err = HandleDecode(worker, conn, argv, argc);
+   else if(strcmp(argv[0], "ENCODE") == 0)
+      err = HandleEncode(worker, conn, argv, argc);
+   else if(strcmp(argv[0], "STATS") == 0)
+      err = HandleStats(worker, conn);
+   else if(strcmp(argv[0], "COUNTERS") == 0)
+      err = HandleCounters(worker, conn, argv, argc);
+   else
+      err = SendError(conn, "unknown request");
+
+   pthread_mutex_lock(&server->lock);
+   server->served++;
+   pthread_mutex_unlock(&server->lock);
+
+   return err;
+}
+
+/**
+ * @brief  Decode pixels sent inline or passed as a descriptor
+ * @param  worker Worker (its session does the decoding)
+ * @param  conn Connection
+ * @param  argv Request words
+ * @param  argc Number of request words
+ * @return DmtxPass | DmtxFail (connection must be closed)
+ */
+static DmtxPassFail
+HandleDecode(Worker *worker, Conn *conn, char **argv, int argc)
+{
+   DmtxwSession *session = worker->session;
+   unsigned char *pxl;
+   void *map = NULL;
+   char line[DMTXD_LINE_MAX];
+   char *value;
+   int i, width, height, format, rowSizeBytes, prop, propValue, inline_;
+   int timeout = DmtxUndefined;
+   long length, needed;
+   struct stat st;
+   DmtxTime deadline;
+   DmtxwStats stats;
+   DmtxPassFail err;
+
+   /* Without a valid length the bytes that follow cannot be skipped */
+   if(argc < 7) {
+      SendError(conn, "usage: DECODE width height format rowSizeBytes source length [name=value ...]");
+      return DmtxFail;
+   }
+
+   format = LookupName(formatNames, argv[3]);
+   inline_ = (strcmp(argv[5], "inline") == 0);
+   length = atol(argv[6]);
+   if(!ParseInt(argv[1], &width) || !ParseInt(argv[2], &height) ||
+         !ParseInt(argv[4], &rowSizeBytes) || format == DmtxUndefined ||
+         (!inline_ && strcmp(argv[5], "fd") != 0) || length < 0 ||
+         length > DMTXD_PAYLOAD_MAX) {
+      SendError(conn, "bad DECODE arguments");
+      return DmtxFail;
+   }
+
+   /* Take the pixels first so the stream stays in step on option errors */
+   if(inline_) {
+      if(ReadPayload(worker, conn, length) == DmtxFail)
+         return DmtxFail;
+      pxl = worker->buf;
+   }
+   else {
+      if(ReadPassedFd(conn) == DmtxFail)
+         return DmtxFail;
+      if(conn->passedFd < 0)
+         return SendError(conn, "no descriptor passed");
+      if(fstat(conn->passedFd, &st) != 0 || st.st_size < (off_t)length || length == 0)
+         return SendError(conn, "descriptor smaller than length");
+      if(IsSealed(conn->passedFd) == DmtxTrue) {
+         map = mmap(NULL, (size_t)length, PROT_READ, MAP_SHARED, conn->passedFd, 0);
+         if(map == MAP_FAILED)
+            return SendError(conn, "cannot map descriptor");
+         pxl = (unsigned char *)map;
+      }
+      else {
+         if(ReadPassedPixels(worker, conn, length) == DmtxFail)
+            return SendError(conn, "cannot read descriptor");
+         pxl = worker->buf;
+      }
+   }
+
+   needed = (long)dmtxwFormatGetBytesPerPixel(format) * width;
+   if(rowSizeBytes > 0)
+      needed = (long)rowSizeBytes * (height - 1) + needed;
+   else
+      needed *= height;
+   if(width < 1 || height < 1 || needed > length) {
+      if(map != NULL)
+         munmap(map, (size_t)length);
+      return SendError(conn, "payload smaller than the image");
+   }
+
+   dmtxwSessionResetProps(session);
+   dmtxwSessionSetCache(session, worker->server->cache);
+
+   for(i = 7; i < argc; i++) {
+      value = strchr(argv[i], '=');
+      if(value != NULL)
+         *(value++) = '\0';
+      prop = dmtxwPropByName(argv[i]);
+      if(value == NULL || prop == DmtxUndefined || !ParseInt(value, &propValue) ||
+            (prop != DmtxwPropTimeout && dmtxwSessionSetProp(session, prop, propValue) == DmtxFail)) {
+         if(map != NULL)
+            munmap(map, (size_t)length);
+         sprintf(line, "bad option %.64s", argv[i]);
+         return SendError(conn, line);
+      }
+      if(prop == DmtxwPropTimeout)
+         timeout = propValue;
+   }
+
+   /* Time spent in the queue counts against the caller's budget */
+   if(timeout != DmtxUndefined)
+      deadline = dmtxTimeAdd(conn->ready, timeout);
+
+   err = dmtxwSessionDecodeBefore(session, pxl, width, height, rowSizeBytes,
+         format, (timeout != DmtxUndefined) ? &deadline : NULL);
+
+   if(map != NULL)
+      munmap(map, (size_t)length);
+
+   /* Instrumentation totals are kept per thread; COUNTERS reports the sum,
+    * so the worker hands its share over before answering */
+   if(dmtxwStatsGet(&stats) == DmtxPass) {
+      pthread_mutex_lock(&worker->server->lock);
+      dmtxwStatsMerge(&worker->server->stats, &stats);
+      pthread_mutex_unlock(&worker->server->lock);
+      dmtxwStatsReset();
+   }
+
+   if(err == DmtxFail) {
+      pthread_mutex_lock(&worker->server->lock);
+      worker->server->failed++;
+      pthread_mutex_unlock(&worker->server->lock);
+      return SendError(conn, "decode failed");
+   }
+
+   /* Slow clients show up in the trace as long marshal spans */
+   dmtxwSessionTrace(session, DmtxwSpanMarshal, 1, DmtxwOutcomeNone);
+   err = SendResults(conn, session);
+   dmtxwSessionTrace(session, DmtxwSpanMarshal, 0,
+         (err == DmtxPass) ? DmtxwOutcomeFound : DmtxwOutcomeError);
+
+   return err;
+}
+
+/**
+ * @brief  Answer a decode request with the status line and every symbol
+ * @param  conn Connection
+ * @param  session Session holding the results
+ * @return DmtxPass | DmtxFail (connection must be closed)
+ */
+static DmtxPassFail
+SendResults(Conn *conn, DmtxwSession *session)
+{
+   const DmtxwResult *result;
+   const unsigned char *payload;
+   char line[DMTXD_LINE_MAX];
+   size_t payloadLength;
+   int i;
+
+   sprintf(line, "OK %s %d %.1f\n", statusNames[session->status],
+         dmtxwSessionGetResultCount(session), ElapsedMsec(conn->ready));
+   if(SendAll(conn->fd, line, strlen(line)) == DmtxFail)
+      return DmtxFail;
+
+   for(i = 0; i < dmtxwSessionGetResultCount(session); i++) {
+      result = dmtxwSessionGetResult(session, i);
+      payload = dmtxwSessionGetPayload(session, i, &payloadLength);
+      sprintf(line, "SYMBOL %lu %d %d %d %d %d %d %d %d %d %d\n",
+            (unsigned long)payloadLength,
+            result->corner[0].X, result->corner[0].Y,
+            result->corner[1].X, result->corner[1].Y,
+            result->corner[2].X, result->corner[2].Y,
+            result->corner[3].X, result->corner[3].Y,
+            result->angle, result->sizeIdx);
+      if(SendAll(conn->fd, line, strlen(line)) == DmtxFail ||
+            SendAll(conn->fd, payload, payloadLength) == DmtxFail ||
+            SendAll(conn->fd, "\n", 1) == DmtxFail)
+         return DmtxFail;
+   }
+
+   return DmtxPass;
+}
+
+/**
+ * @brief  Encode a message as a Data Matrix bitmap
+ * @param  worker Worker
+ * @param  conn Connection
+ * @param  argv Request words
+ * @param  argc Number of request words
+ * @return DmtxPass | DmtxFail (connection must be closed)
+ */
+static DmtxPassFail
+HandleEncode(Worker *worker, Conn *conn, char **argv, int argc)
+{
+   static const struct { const char *name; int prop; } encodeProps[] = {
+      { "module_size", DmtxPropModuleSize },
+      { "margin_size", DmtxPropMarginSize },
+      { "scheme",      DmtxPropScheme },
+      { "size",        DmtxPropSizeRequest },
+      { NULL,          DmtxUndefined }
+   };
+   DmtxEncode *enc;
+   char line[DMTXD_LINE_MAX];
+   char *value;
+   unsigned char *strip;
+   int i, j, width, height, rows, propValue;
+   long length;
+   DmtxPassFail err;
+
+   length = (argc >= 2) ? atol(argv[1]) : -1;
+   if(length < 1 || length > DMTXD_PAYLOAD_MAX) {
+      SendError(conn, "usage: ENCODE length [name=value ...]");
+      return DmtxFail;
+   }
+
+   if(ReadPayload(worker, conn, length) == DmtxFail)
+      return DmtxFail;
+
+   enc = dmtxEncodeCreate();
+   if(enc == NULL)
+      return SendError(conn, "out of memory");
+
+   for(i = 2; i < argc; i++) {
+      value = strchr(argv[i], '=');
+      if(value != NULL)
+         *(value++) = '\0';
+      for(j = 0; encodeProps[j].name != NULL; j++) {
+         if(strcmp(encodeProps[j].name, argv[i]) == 0)
+            break;
+      }
+      if(value == NULL || encodeProps[j].name == NULL || !ParseInt(value, &propValue) ||
+            dmtxEncodeSetProp(enc, encodeProps[j].prop, propValue) == DmtxFail) {
+         dmtxEncodeDestroy(&enc);
+         sprintf(line, "bad option %.64s", argv[i]);
+         return SendError(conn, line);
+      }
+   }
+
+   if(dmtxwEncodeDataMatrix(enc, (int)length, worker->buf) == DmtxFail ||
+         dmtxwEncodeGetSize(enc, &width, &height) == DmtxFail) {
+      dmtxEncodeDestroy(&enc);
+      return SendError(conn, "message does not fit");
+   }
+
+   /* Symbol is held at module size 1; expand a strip of rows at a time */
+   strip = (unsigned char *)malloc((size_t)width * 3 * DMTXD_ENCODE_STRIP);
+   if(strip == NULL) {
+      dmtxEncodeDestroy(&enc);
+      return SendError(conn, "out of memory");
+   }
+
+   sprintf(line, "OK %d %d %ld\n", width, height, (long)width * height * 3);
+   err = SendAll(conn->fd, line, strlen(line));
+   for(i = 0; i < height && err == DmtxPass; i += rows) {
+      rows = (height - i < DMTXD_ENCODE_STRIP) ? height - i : DMTXD_ENCODE_STRIP;
+      err = dmtxwEncodeExpandRows(enc, i, rows, strip, 0, DmtxwFormatRGB24);
+      if(err == DmtxPass)
+         err = SendAll(conn->fd, strip, (size_t)width * 3 * rows);
+   }
+
+   free(strip);
+   dmtxEncodeDestroy(&enc);
+
+   return err;
+}
+
+/**
+ * @brief  Report pool and queue counters
+ * @param  worker Worker
+ * @param  conn Connection
+ * @return DmtxPass | DmtxFail (connection must be closed)
+ */
+static DmtxPassFail
+HandleStats(Worker *worker, Conn *conn)
+{
+   Server *server = worker->server;
+   char line[DMTXD_LINE_MAX];
+   int i, connections = 0;
+
+   pthread_mutex_lock(&server->lock);
+   for(i = 0; i < server->connMax; i++) {
+      if(server->conn[i].state != ConnFree)
+         connections++;
+   }
+   sprintf(line, "OK %d %d %d %ld %ld\n", server->workerCount, connections,
+         server->queueCount, server->served, server->failed);
+   pthread_mutex_unlock(&server->lock);
+
+   return SendAll(conn->fd, line, strlen(line));
+}
+
+/**
+ * @brief  Report the libdmtxw instrumentation totals of all workers, and
+ *         clear them if asked to
+ * @param  worker Worker
+ * @param  conn Connection
+ * @param  argv Request words
+ * @param  argc Number of request words
+ * @return DmtxPass | DmtxFail (connection must be closed)
+ */
+static DmtxPassFail
+HandleCounters(Worker *worker, Conn *conn, char **argv, int argc)
+{
+   Server *server = worker->server;
+   DmtxwStats stats;
+   char line[DMTXD_LINE_MAX];
+   const char *name;
+   int i;
+
+   if(argc > 2 || (argc == 2 && strcmp(argv[1], "reset") != 0))
+      return SendError(conn, "usage: COUNTERS [reset]");
+
+   if(dmtxwStatsEnabled() == DmtxFalse)
+      return SendError(conn, "built without instrumentation counters");
+
+   pthread_mutex_lock(&server->lock);
+   stats = server->stats;
+   if(argc == 2)
+      memset(&server->stats, 0x00, sizeof(DmtxwStats));
+   pthread_mutex_unlock(&server->lock);
+
+   strcpy(line, "OK");
+   for(i = 0; (name = dmtxwStatsName(i)) != NULL; i++) {
+      sprintf(line + strlen(line), (strstr(name, "_ms") != NULL) ? " %s=%.3f" : " %s=%.0f",
+            name, dmtxwStatsValue(&stats, i));
+   }
+   strcat(line, "\n");
+
+   return SendAll(conn->fd, line, strlen(line));
+}
+
+/**
+ * @brief  Read one request line, keeping any bytes after it
+ * @param  conn Connection
+ * @param  line Receives the line without its newline (DMTXD_LINE_MAX bytes)
+ * @return DmtxPass | DmtxFail (closed, stalled or overlong)
+ */
+static DmtxPassFail
+ReadLine(Conn *conn, char *line)
+{
+   char *end;
+   size_t used;
+   ssize_t got;
+
+   for(;;) {
+      end = (char *)memchr(conn->buf, '\n', conn->have);
+      if(end != NULL)
+         break;
+      if(conn->have == sizeof(conn->buf))
+         return DmtxFail;
+      if(ReadSome(conn, conn->buf + conn->have, sizeof(conn->buf) - conn->have, &got) == DmtxFail)
+         return DmtxFail;
+      conn->have += (size_t)got;
+   }
+
+   used = (size_t)(end - conn->buf);
+   memcpy(line, conn->buf, used);
+   line[used] = '\0';
+   if(used > 0 && line[used - 1] == '\r')
+      line[used - 1] = '\0';
+
+   conn->have -= used + 1;
+   memmove(conn->buf, end + 1, conn->have);
+
+   return DmtxPass;
+}
+
+/**
+ * @brief  Consume the NUL byte carrying a passed descriptor
+ * @param  conn Connection
+ * @return DmtxPass | DmtxFail (closed or stalled)
+ */
+static DmtxPassFail
+ReadPassedFd(Conn *conn)
+{
+   char byte;
+   ssize_t got;
+
+   if(conn->have == 0) {
+      if(ReadSome(conn, &byte, 1, &got) == DmtxFail)
+         return DmtxFail;
+   }
+   else {
+      conn->have--;
+      memmove(conn->buf, conn->buf + 1, conn->have);
+   }
+
+   return DmtxPass;
+}
+
+/**
+ * @brief  Read a payload following the request line into the worker buffer
+ * @param  worker Worker
+ * @param  conn Connection
+ * @param  length Payload size in bytes
+ * @return DmtxPass | DmtxFail (closed, stalled or out of memory)
+ */
+static DmtxPassFail
+ReadPayload(Worker *worker, Conn *conn, long length)
+{
+   size_t done, take;
+   ssize_t got;
+
+   if(ReserveBuffer(worker, (size_t)length + 1) == DmtxFail)
+      return DmtxFail;
+
+   take = (conn->have < (size_t)length) ? conn->have : (size_t)length;
+   memcpy(worker->buf, conn->buf, take);
+   conn->have -= take;
+   memmove(conn->buf, conn->buf + take, conn->have);
+
+   for(done = take; done < (size_t)length; done += (size_t)got) {
+      if(ReadSome(conn, (char *)worker->buf + done, (size_t)length - done, &got) == DmtxFail)
+         return DmtxFail;
+   }
+
+   return DmtxPass;
+}
+
+/**
+ * @brief  Copy the pixels of a passed descriptor that is not sealed into
+ *         the worker's buffer
+ * @param  worker Worker (its buffer receives the bytes)
+ * @param  conn Connection holding the descriptor
+ * @param  length Bytes to read from offset 0
+ * @return DmtxPass | DmtxFail (out of memory, or the file shrank)
+ */
+static DmtxPassFail
+ReadPassedPixels(Worker *worker, Conn *conn, long length)
+{
+   size_t done;
+   ssize_t got;
+
+   if(ReserveBuffer(worker, (size_t)length + 1) == DmtxFail)
+      return DmtxFail;
+
+   for(done = 0; done < (size_t)length; done += (size_t)got) {
+      got = pread(conn->passedFd, worker->buf + done, (size_t)length - done, (off_t)done);
+      if(got < 0 && errno == EINTR) {
+         got = 0;
+         continue;
+      }
+      if(got <= 0)
+         return DmtxFail;
+   }
+
+   return DmtxPass;
+}
+
+/**
+ * @brief  Tell whether a descriptor can be mapped safely: only a memfd
+ *         sealed against shrinking (no SIGBUS while decoding) and writing
+ *         (pixels stay put) qualifies
+ * @param  fd Descriptor
+ * @return DmtxTrue | DmtxFalse
+ */
+static DmtxBoolean
+IsSealed(int fd)
+{
+#ifdef F_GET_SEALS
+   int seals;
+
+   seals = fcntl(fd, F_GET_SEALS);
+   if(seals != -1 && (seals & F_SEAL_SHRINK) && (seals & F_SEAL_WRITE))
+      return DmtxTrue;
+#endif
+
+   return DmtxFalse;
+}
+
+/**
+ * @brief  Grow the worker's buffer to hold at least size bytes
+ * @param  worker Worker
+ * @param  size Bytes needed
+ * @return DmtxPass | DmtxFail (out of memory)
+ */
+static DmtxPassFail
+ReserveBuffer(Worker *worker, size_t size)
+{
+   unsigned char *buf;
+
+   if(size <= worker->capacity)
+      return DmtxPass;
+
+   buf = (unsigned char *)realloc(worker->buf, size);
+   if(buf == NULL)
+      return DmtxFail;
+   worker->buf = buf;
+   worker->capacity = size;
+
+   return DmtxPass;
+}
+
+/**
+ * @brief  Receive bytes, collecting a descriptor sent along with them
+ * @param  conn Connection
+ * @param  dst Destination
+ * @param  size Room in dst
+ * @param  got Receives the number of bytes read
+ * @return DmtxPass | DmtxFail (closed, stalled or error)
+ */
+static DmtxPassFail
+ReadSome(Conn *conn, char *dst, size_t size, ssize_t *got)
+{
+   union { struct cmsghdr align; char buf[CMSG_SPACE(4 * sizeof(int))]; } control;
+   struct msghdr msg;
+   struct iovec iov;
+   struct cmsghdr *cmsg;
+   int *fds;
+   int i, count;
+
+   iov.iov_base = dst;
+   iov.iov_len = size;
+   memset(&msg, 0x00, sizeof(msg));
+   msg.msg_iov = &iov;
+   msg.msg_iovlen = 1;
+   msg.msg_control = control.buf;
+   msg.msg_controllen = sizeof(control.buf);
+
+   do {
+      *got = recvmsg(conn->fd, &msg, 0);
+   } while(*got < 0 && errno == EINTR);
+
+   if(*got <= 0)
+      return DmtxFail;
+
+   for(cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+      if(cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+         continue;
+      fds = (int *)CMSG_DATA(cmsg);
+      count = (int)((cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+      for(i = 0; i < count; i++) {
+         /* Only the latest descriptor is kept */
+         if(conn->passedFd >= 0)
+            close(conn->passedFd);
+         conn->passedFd = fds[i];
+      }
+   }
+
+   return DmtxPass;
+}
+
+/**
+ * @brief  Write a whole buffer
+ * @param  fd Socket
+ * @param  data Bytes to write
+ * @param  length Number of bytes
+ * @return DmtxPass | DmtxFail (closed or stalled)
+ */
+static DmtxPassFail
+SendAll(int fd, const void *data, size_t length)
+{
+   const char *p = (const char *)data;
+   ssize_t sent;
+
+   while(length > 0) {
+      sent = send(fd, p, length, MSG_NOSIGNAL);
+      if(sent < 0 && errno == EINTR)
+         continue;
+      if(sent <= 0)
+         return DmtxFail;
+      p += sent;
+      length -= (size_t)sent;
+   }
+
+   return DmtxPass;
+}
+
+/**
+ * @brief  Answer a request with an error line
+ * @param  conn Connection
+ * @param  reason Message for the client
+ * @return DmtxPass | DmtxFail (connection must be closed)
+ */
+static DmtxPassFail
+SendError(Conn *conn, const char *reason)
+{
+   char line[DMTXD_LINE_MAX];
+
+   sprintf(line, "ERR %.900s\n", reason);
+
+   return SendAll(conn->fd, line, strlen(line));
+}
+
+/**
+ * @brief  Split a line into words at spaces (in place)
+ * @param  line Line to split
+ * @param  argv Receives the words
+ * @param  maxArgs Room in argv
+ * @return Number of words
+ */
+static int
+SplitLine(char *line, char **argv, int maxArgs)
+{
+   int argc = 0;
+   char *word;
+
+   for(word = strtok(line, " \t"); word != NULL && argc < maxArgs;
+         word = strtok(NULL, " \t"))
+      argv[argc++] = word;
+
+   return argc;
+}
+
+/**
+ * @brief  Parse a whole word as a decimal integer
+ * @param  text Word
+ * @param  value Receives the number
+ * @return 1 if the word is a number, 0 otherwise
+ */
+static int
+ParseInt(const char *text, int *value)
+{
+   char *end;
+   long n;
+
+   errno = 0;
+   n = strtol(text, &end, 10);
+   if(end == text || *end != '\0' || errno != 0 || n < -2147483647L || n > 2147483647L)
+      return 0;
+
+   *value = (int)n;
+
+   return 1;
+}
+
+/**
+ * @brief  Find a name in a NULL-terminated table
+ * @param  names Table
+ * @param  name Name to find
+ * @return Table index, or DmtxUndefined
+ */
+static int
+LookupName(const char **names, const char *name)
+{
+   int i;
+
+   for(i = 0; names[i] != NULL; i++) {
+      if(strcmp(names[i], name) == 0)
+         return i;
+   }
+
+   return DmtxUndefined;
+}
+
+/**
+ * @brief  Milliseconds since a point in time
+ * @param  start Start time
+ * @return Elapsed milliseconds
+ */
+static double
+ElapsedMsec(DmtxTime start)
+{
+   DmtxTime now = dmtxTimeNow();
+
+   return (now.sec - start.sec) * 1000.0 +
+         ((double)now.usec - (double)start.usec) / 1000.0;
+}
@@ -0,0 +1,92 @@
+/*
+dmtxd - Decode daemon for the libdmtx wrappers
+
+Copyright (C) 2026 The libdmtx-wrappers project
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+Contact: mike@dragonflylogic.com
+*/
+
+/* $Id$ */
+
+/**
+ * @file dmtxd.h
+ * @brief Wire protocol shared by dmtxd and its clients
+ *
+ * Every request is one text line, optionally followed by binary data.
+ * Every response starts with a text line beginning with "OK" or "ERR":
+ *
+ *   DECODE <width> <height> <format> <rowSizeBytes> <source> <length> [name=value ...]
+ *      Pixels come from <source>: "inline" sends <length> bytes right after
+ *      the line; "fd" passes a descriptor (memfd, shm_open, file) after the
+ *      line, attached to a single NUL byte, whose first <length> bytes hold
+ *      the pixels. A memfd sealed with F_SEAL_SHRINK and F_SEAL_WRITE is
+ *      mapped read-only; any other descriptor is read. <format> is a name from
+ *      DMTXD_FORMAT_NAMES and <rowSizeBytes> may be 0 for packed rows.
+ *      Options are libdmtxw property names (dmtxwPropByName()); "timeout"
+ *      counts from the moment the daemon saw the request, so time spent
+ *      queued is part of it.
+ *
+ *      OK <status> <count> <msec>
+ *      followed by <count> times
+ *      SYMBOL <length> <x0> <y0> <x1> <y1> <x2> <y2> <x3> <y3> <angle> <sizeIdx>
+ *      <length payload bytes> "\n"
+ *
+ *      <status> is a name from DMTXD_STATUS_NAMES; "timeout" means the
+ *      symbols listed are the ones found in time.
+ *
+ *   ENCODE <length> [module_size=n] [margin_size=n] [scheme=n] [size=n]
+ *      <length> message bytes follow the line.
+ *
+ *      OK <width> <height> <length>
+ *      <length bytes of top-down RGB rows, 3 bytes per pixel>
+ *
+ *   STATS
+ *      OK <workers> <connections> <queued> <served> <failed>
+ *
+ *   COUNTERS [reset]
+ *      OK <name>=<value> ...
+ *
+ *      libdmtxw instrumentation totals of all workers, one word per
+ *      dmtxwStatsName() value (convert_calls, convert_ms, ..., allocations);
+ *      "reset" clears them after reporting. Answered with ERR unless
+ *      libdmtxw was built with DMTXW_STATS.
+ *
+ *   Any request can be answered with "ERR <reason>" instead. The connection
+ *   stays usable afterwards, except after a malformed request line: its
+ *   data cannot be skipped, so the daemon closes the connection.
+ */
+
+#ifndef __DMTXD_H__
+#define __DMTXD_H__
+
+#define DMTXD_SOCKET_PATH     "/tmp/dmtxd.sock"
+
+/* Longest request or response line, including the newline */
+#define DMTXD_LINE_MAX        1024
+
+/* Largest pixel or message payload accepted (bytes) */
+#define DMTXD_PAYLOAD_MAX     (256L * 1024L * 1024L)
+
+/* Format names in DmtxwFormat order */
+#define DMTXD_FORMAT_NAMES    { "gray8", "rgb24", "bgr24", "rgbx32", "bgrx32", \
+                                "xrgb32", "xbgr32", "int32rgb", NULL }
+
+/* Status names in DmtxwStatus order */
+#define DMTXD_STATUS_NAMES    { "complete", "max_count", "timeout", "cancelled", \
+                                "error", "blurred", "empty", NULL }
+
+#endif
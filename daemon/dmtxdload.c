@@ -0,0 +1,585 @@
+/*
+dmtxd - Decode daemon for the libdmtx wrappers
+
+Copyright (C) 2026 The libdmtx-wrappers project
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+Contact: mike@dragonflylogic.com
+*/
+
+/* $Id$ */
+
+/**
+ * @file dmtxdload.c
+ * @brief Load generator for dmtxd
+ *
+ * Starts a number of client threads that each open one connection and
+ * send the same image as fast as the daemon answers, then reports
+ * throughput, latency percentiles and how the decodes ended. Pixels are
+ * sent inline or through one shared memory descriptor that every request
+ * passes along (-m fd). Without an image file, a symbol encoded by the
+ * daemon itself is placed on a blank page.
+ *
+ *   $ make dmtxdload
+ *   $ ./dmtxdload [-s socket] [-c clients] [-n requests] [-m inline|fd]
+ *                 [-t timeout] [-o "name=value ..."] [image.pgm|image.ppm]
+ */
+
+#define _XOPEN_SOURCE 700
+#define _DEFAULT_SOURCE
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include "dmtxd.h"
+
+#define PAGE_WIDTH       1024
+#define PAGE_HEIGHT      768
+#define MAX_STATUS       8
+
+typedef struct {
+   const char     *socketPath;
+   const char     *options;    /* Extra name=value words for every request */
+   int             requests;   /* Per client */
+   int             passFd;
+   int             timeout;
+   unsigned char  *pxl;        /* Gray8 or RGB24 rows */
+   int             width;
+   int             height;
+   const char     *format;
+   long            length;
+   int             shmFd;      /* Descriptor holding pxl, or -1 */
+} Job;
+
+typedef struct {
+   Job            *job;
+   pthread_t       thread;
+   double         *latency;    /* Milliseconds of each request */
+   int             done;
+   int             errors;
+   long            symbols;
+   int             status[MAX_STATUS];
+} Client;
+
+static const char *statusNames[] = DMTXD_STATUS_NAMES;
+
+static void *ClientMain(void *arg);
+static int Connect(const char *path);
+static int SendFd(int sock, int fd);
+static int SendAll(int sock, const void *data, size_t length);
+static int ReadLine(int sock, char *line, size_t size);
+static int ReadBytes(int sock, void *dst, size_t length);
+static int LoadPnm(const char *path, Job *job);
+static int MakePage(Job *job);
+static int ShareImage(Job *job);
+static double NowMsec(void);
+static int CompareDouble(const void *a, const void *b);
+
+/**
+ * @brief  Run the clients and print the report
+ * @param  argc Argument count
+ * @param  argv Options (see the file comment)
+ * @return 0 if every request was answered, 1 otherwise
+ */
+int
+main(int argc, char *argv[])
+{
+   Job job;
+   Client *client;
+   double *all, start, elapsed;
+   int opt, i, j, clients = 4, total, errors = 0, status[MAX_STATUS];
+   long symbols = 0;
+
+   memset(&job, 0x00, sizeof(Job));
+   job.socketPath = DMTXD_SOCKET_PATH;
+   job.options = "";
+   job.requests = 100;
+   job.timeout = -1;
+   job.shmFd = -1;
+   memset(status, 0x00, sizeof(status));
+
+   while((opt = getopt(argc, argv, "s:c:n:m:t:o:h")) != -1) {
+      switch(opt) {
+         case 's':
+            job.socketPath = optarg;
+            break;
+         case 'c':
+            clients = atoi(optarg);
+            break;
+         case 'n':
+            job.requests = atoi(optarg);
+            break;
+         case 'm':
+            job.passFd = (strcmp(optarg, "fd") == 0);
+            break;
+         case 't':
+            job.timeout = atoi(optarg);
+            break;
+         case 'o':
+            job.options = optarg;
+            break;
+         default:
+            fprintf(stderr, "usage: %s [-s socket] [-c clients] [-n requests] "
+                  "[-m inline|fd] [-t timeout] [-o \"name=value ...\"] [image]\n", argv[0]);
+            return 1;
+      }
+   }
+
+   if(clients < 1 || job.requests < 1) {
+      fprintf(stderr, "%s: clients and requests must be positive\n", argv[0]);
+      return 1;
+   }
+
+   if((optind < argc) ? LoadPnm(argv[optind], &job) : MakePage(&job))
+      return 1;
+
+   if(job.passFd && ShareImage(&job))
+      return 1;
+
+   client = (Client *)calloc(clients, sizeof(Client));
+   all = (double *)malloc((size_t)clients * job.requests * sizeof(double));
+   if(client == NULL || all == NULL) {
+      fprintf(stderr, "%s: out of memory\n", argv[0]);
+      return 1;
+   }
+
+   start = NowMsec();
+   for(i = 0; i < clients; i++) {
+      client[i].job = &job;
+      client[i].latency = all + (size_t)i * job.requests;
+      if(pthread_create(&(client[i].thread), NULL, ClientMain, &(client[i])) != 0) {
+         fprintf(stderr, "%s: cannot start client %d\n", argv[0], i);
+         return 1;
+      }
+   }
+
+   total = 0;
+   for(i = 0; i < clients; i++) {
+      pthread_join(client[i].thread, NULL);
+      /* Answered requests of each client are packed at the front of its slice */
+      memmove(all + total, client[i].latency, client[i].done * sizeof(double));
+      total += client[i].done;
+      errors += client[i].errors;
+      symbols += client[i].symbols;
+      for(j = 0; j < MAX_STATUS; j++)
+         status[j] += client[i].status[j];
+   }
+   elapsed = NowMsec() - start;
+
+   printf("%d clients x %d requests, %s pixels, %dx%d %s\n", clients, job.requests,
+         job.passFd ? "fd" : "inline", job.width, job.height, job.format);
+   printf("answered %d, errors %d, %.1f requests/s, %.2f symbols/request\n",
+         total, errors, (elapsed > 0.0) ? total * 1000.0 / elapsed : 0.0,
+         (total > 0) ? (double)symbols / total : 0.0);
+
+   if(total > 0) {
+      qsort(all, total, sizeof(double), CompareDouble);
+      printf("latency ms: min %.2f  p50 %.2f  p95 %.2f  p99 %.2f  max %.2f\n",
+            all[0], all[total / 2], all[(total * 95) / 100], all[(total * 99) / 100],
+            all[total - 1]);
+   }
+
+   for(j = 0; j < MAX_STATUS && statusNames[j] != NULL; j++) {
+      if(status[j] > 0)
+         printf("   %-10s %d\n", statusNames[j], status[j]);
+   }
+
+   if(job.shmFd >= 0)
+      close(job.shmFd);
+   free(job.pxl);
+   free(all);
+   free(client);
+
+   return (errors == 0 && total == clients * job.requests) ? 0 : 1;
+}
+
+/**
+ * @brief  One client connection sending requests back to back
+ * @param  arg Client
+ * @return NULL
+ */
+static void *
+ClientMain(void *arg)
+{
+   Client *client = (Client *)arg;
+   Job *job = client->job;
+   char line[DMTXD_LINE_MAX], word[32], *payload = NULL;
+   double t0;
+   int i, k, sock, count, length;
+
+   sock = Connect(job->socketPath);
+   if(sock < 0) {
+      client->errors = job->requests;
+      return NULL;
+   }
+
+   for(i = 0; i < job->requests; i++) {
+      if(job->timeout >= 0)
+         sprintf(line, "DECODE %d %d %s 0 %s %ld timeout=%d %.800s\n", job->width,
+               job->height, job->format, job->passFd ? "fd" : "inline", job->length,
+               job->timeout, job->options);
+      else
+         sprintf(line, "DECODE %d %d %s 0 %s %ld %.800s\n", job->width, job->height,
+               job->format, job->passFd ? "fd" : "inline", job->length, job->options);
+
+      t0 = NowMsec();
+      if(SendAll(sock, line, strlen(line)) != 0 ||
+            (job->passFd ? SendFd(sock, job->shmFd) : SendAll(sock, job->pxl, job->length)) != 0 ||
+            ReadLine(sock, line, sizeof(line)) != 0) {
+         client->errors++;
+         break;
+      }
+
+      if(sscanf(line, "OK %31s %d", word, &count) != 2) {
+         client->errors++;
+         continue;
+      }
+
+      /* Symbols: header line, payload, newline */
+      for(k = 0; k < count; k++) {
+         if(ReadLine(sock, line, sizeof(line)) != 0 ||
+               sscanf(line, "SYMBOL %d", &length) != 1 || length < 0 ||
+               (payload = (char *)realloc(payload, (size_t)length + 1)) == NULL ||
+               ReadBytes(sock, payload, (size_t)length + 1) != 0)
+            break;
+      }
+      if(k < count) {
+         client->errors++;
+         break;
+      }
+
+      client->latency[client->done++] = NowMsec() - t0;
+      client->symbols += count;
+      for(k = 0; k < MAX_STATUS && statusNames[k] != NULL; k++) {
+         if(strcmp(statusNames[k], word) == 0)
+            client->status[k]++;
+      }
+   }
+
+   free(payload);
+   close(sock);
+
+   return NULL;
+}
+
+/**
+ * @brief  Connect to the daemon
+ * @param  path Socket path
+ * @return Socket, or -1 on error
+ */
+static int
+Connect(const char *path)
+{
+   struct sockaddr_un addr;
+   int sock;
+
+   sock = socket(AF_UNIX, SOCK_STREAM, 0);
+   if(sock < 0)
+      return -1;
+
+   memset(&addr, 0x00, sizeof(addr));
+   addr.sun_family = AF_UNIX;
+   strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+
+   if(connect(sock, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+      perror(path);
+      close(sock);
+      return -1;
+   }
+
+   return sock;
+}
+
+/**
+ * @brief  Pass a descriptor attached to one NUL byte
+ * @param  sock Socket
+ * @param  fd Descriptor to pass
+ * @return 0 on success, -1 on error
+ */
+static int
+SendFd(int sock, int fd)
+{
+   union { struct cmsghdr align; char buf[CMSG_SPACE(sizeof(int))]; } control;
+   struct msghdr msg;
+   struct iovec iov;
+   struct cmsghdr *cmsg;
+   char byte = '\0';
+
+   iov.iov_base = &byte;
+   iov.iov_len = 1;
+   memset(&msg, 0x00, sizeof(msg));
+   memset(&control, 0x00, sizeof(control));
+   msg.msg_iov = &iov;
+   msg.msg_iovlen = 1;
+   msg.msg_control = control.buf;
+   msg.msg_controllen = sizeof(control.buf);
+
+   cmsg = CMSG_FIRSTHDR(&msg);
+   cmsg->cmsg_level = SOL_SOCKET;
+   cmsg->cmsg_type = SCM_RIGHTS;
+   cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+   memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+
+   return (sendmsg(sock, &msg, 0) == 1) ? 0 : -1;
+}
+
+/**
+ * @brief  Write a whole buffer
+ * @param  sock Socket
+ * @param  data Bytes to write
+ * @param  length Number of bytes
+ * @return 0 on success, -1 on error
+ */
+static int
+SendAll(int sock, const void *data, size_t length)
+{
+   const char *p = (const char *)data;
+   ssize_t sent;
+
+   while(length > 0) {
+      sent = write(sock, p, length);
+      if(sent < 0 && errno == EINTR)
+         continue;
+      if(sent <= 0)
+         return -1;
+      p += sent;
+      length -= (size_t)sent;
+   }
+
+   return 0;
+}
+
+/**
+ * @brief  Read a response line byte by byte (responses are short)
+ * @param  sock Socket
+ * @param  line Receives the line without its newline
+ * @param  size Room in line
+ * @return 0 on success, -1 on error
+ */
+static int
+ReadLine(int sock, char *line, size_t size)
+{
+   size_t used = 0;
+
+   while(used + 1 < size) {
+      if(ReadBytes(sock, line + used, 1) != 0)
+         return -1;
+      if(line[used] == '\n') {
+         line[used] = '\0';
+         return 0;
+      }
+      used++;
+   }
+
+   return -1;
+}
+
+/**
+ * @brief  Read exactly length bytes
+ * @param  sock Socket
+ * @param  dst Destination
+ * @param  length Number of bytes
+ * @return 0 on success, -1 on error
+ */
+static int
+ReadBytes(int sock, void *dst, size_t length)
+{
+   char *p = (char *)dst;
+   ssize_t got;
+
+   while(length > 0) {
+      got = read(sock, p, length);
+      if(got < 0 && errno == EINTR)
+         continue;
+      if(got <= 0)
+         return -1;
+      p += got;
+      length -= (size_t)got;
+   }
+
+   return 0;
+}
+
+/**
+ * @brief  Load a binary PGM (P5) or PPM (P6) image with 8 bit samples
+ * @param  path Image file
+ * @param  job Receives pixels, size and format
+ * @return 0 on success, 1 on error
+ */
+static int
+LoadPnm(const char *path, Job *job)
+{
+   FILE *fp;
+   char magic[3];
+   int maxval, channels;
+
+   fp = fopen(path, "rb");
+   if(fp == NULL) {
+      perror(path);
+      return 1;
+   }
+
+   if(fscanf(fp, "%2s %d %d %d", magic, &job->width, &job->height, &maxval) != 4 ||
+         (strcmp(magic, "P5") != 0 && strcmp(magic, "P6") != 0) || maxval != 255 ||
+         job->width < 1 || job->height < 1 || fgetc(fp) == EOF) {
+      fprintf(stderr, "%s: not an 8 bit binary PGM or PPM image\n", path);
+      fclose(fp);
+      return 1;
+   }
+
+   channels = (magic[1] == '5') ? 1 : 3;
+   job->format = (channels == 1) ? "gray8" : "rgb24";
+   job->length = (long)job->width * job->height * channels;
+   job->pxl = (unsigned char *)malloc((size_t)job->length);
+   if(job->pxl == NULL || fread(job->pxl, 1, (size_t)job->length, fp) != (size_t)job->length) {
+      fprintf(stderr, "%s: truncated image\n", path);
+      fclose(fp);
+      return 1;
+   }
+
+   fclose(fp);
+
+   return 0;
+}
+
+/**
+ * @brief  Ask the daemon for a symbol and place it on a blank gray page
+ * @param  job Receives pixels, size and format
+ * @return 0 on success, 1 on error
+ */
+static int
+MakePage(Job *job)
+{
+   const char *message = "dmtxdload test page";
+   char line[DMTXD_LINE_MAX];
+   unsigned char *rgb;
+   int sock, width, height, x, y;
+   long length;
+
+   sock = Connect(job->socketPath);
+   if(sock < 0)
+      return 1;
+
+   sprintf(line, "ENCODE %d module_size=4\n", (int)strlen(message));
+   if(SendAll(sock, line, strlen(line)) != 0 || SendAll(sock, message, strlen(message)) != 0 ||
+         ReadLine(sock, line, sizeof(line)) != 0 ||
+         sscanf(line, "OK %d %d %ld", &width, &height, &length) != 3 ||
+         width > PAGE_WIDTH || height > PAGE_HEIGHT) {
+      fprintf(stderr, "dmtxdload: cannot encode test symbol (%s)\n", line);
+      close(sock);
+      return 1;
+   }
+
+   rgb = (unsigned char *)malloc((size_t)length);
+   job->pxl = (unsigned char *)malloc(PAGE_WIDTH * PAGE_HEIGHT);
+   if(rgb == NULL || job->pxl == NULL || ReadBytes(sock, rgb, (size_t)length) != 0) {
+      fprintf(stderr, "dmtxdload: cannot read test symbol\n");
+      close(sock);
+      return 1;
+   }
+   close(sock);
+
+   memset(job->pxl, 230, PAGE_WIDTH * PAGE_HEIGHT);
+   for(y = 0; y < height; y++) {
+      for(x = 0; x < width; x++)
+         job->pxl[(PAGE_HEIGHT / 3 + y) * PAGE_WIDTH + PAGE_WIDTH / 3 + x] =
+               rgb[(y * width + x) * 3 + 1];
+   }
+   free(rgb);
+
+   job->width = PAGE_WIDTH;
+   job->height = PAGE_HEIGHT;
+   job->format = "gray8";
+   job->length = (long)PAGE_WIDTH * PAGE_HEIGHT;
+
+   return 0;
+}
+
+/**
+ * @brief  Copy the image into an anonymous shared memory object
+ * @param  job Image; receives the descriptor
+ * @return 0 on success, 1 on error
+ */
+static int
+ShareImage(Job *job)
+{
+   void *map;
+
+#if defined(__linux__) && defined(MFD_CLOEXEC)
+   job->shmFd = memfd_create("dmtxdload", MFD_CLOEXEC);
+#else
+   char name[64];
+
+   sprintf(name, "/dmtxdload.%ld", (long)getpid());
+   job->shmFd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+   if(job->shmFd >= 0)
+      shm_unlink(name);
+#endif
+
+   if(job->shmFd < 0 || ftruncate(job->shmFd, (off_t)job->length) != 0) {
+      perror("shared memory");
+      return 1;
+   }
+
+   map = mmap(NULL, (size_t)job->length, PROT_READ | PROT_WRITE, MAP_SHARED, job->shmFd, 0);
+   if(map == MAP_FAILED) {
+      perror("shared memory");
+      return 1;
+   }
+   memcpy(map, job->pxl, (size_t)job->length);
+   munmap(map, (size_t)job->length);
+
+   return 0;
+}
+
+/**
+ * @brief  Wall clock time
+ * @return Milliseconds
+ */
+static double
+NowMsec(void)
+{
+   struct timeval tv;
+
+   gettimeofday(&tv, NULL);
+
+   return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+}
+
+/**
+ * @brief  qsort() comparison of two doubles
+ * @param  a First value
+ * @param  b Second value
+ * @return -1, 0 or 1
+ */
+static int
+CompareDouble(const void *a, const void *b)
+{
+   double x = *(const double *)a, y = *(const double *)b;
+
+   return (x < y) ? -1 : (x > y) ? 1 : 0;
+}
@@ -0,0 +1,98 @@
+/*
+libdmtxw - Shared native glue for the libdmtx wrappers
+
+Copyright (C) 2026 The libdmtx-wrappers project
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+Contact: mike@dragonflylogic.com
+*/
+
+/* $Id$ */
+
+/**
+ * @file dmtxw.c
+ * @brief Main libdmtxw source file
+ *
+ * Like libdmtx itself, the individual source files are pulled into this one
+ * translation unit so their helpers can stay static.
+ */
+
+/* The frame ring needs memfd_create(), ftruncate() and nanosleep(), which
+ * -ansi hides */
+#if !defined(_WIN32) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include "dmtxw.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <emmintrin.h>
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+#include "dmtxwstatic.h"
+
+#include "dmtxwsession.c"
+#include "dmtxwformat.c"
+#include "dmtxwconvert.c"
+#include "dmtxwdecode.c"
+#include "dmtxwtile.c"
+#include "dmtxwlocate.c"
+#include "dmtxwquality.c"
+#include "dmtxwcache.c"
+#include "dmtxwtune.c"
+#include "dmtxwring.c"
+#include "dmtxwpnm.c"
+#include "dmtxwvector.c"
+#include "dmtxwprinter.c"
+#include "dmtxwsheet.c"
+#include "dmtxwthread.c"
+#include "dmtxwsymbol.c"
+#include "dmtxwexpand.c"
+#include "dmtxwstats.c"
+#include "dmtxwtrace.c"
+
+/**
+ * @brief  Return libdmtxw version
+ * @return Version string
+ */
+extern char *
+dmtxwVersion(void)
+{
+   return DmtxwVersion;
+}
@@ -0,0 +1,545 @@
+/*
+libdmtxw - Shared native glue for the libdmtx wrappers
+
+Copyright (C) 2026 The libdmtx-wrappers project
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+Contact: mike@dragonflylogic.com
+*/
+
+/* $Id$ */
+
+/**
+ * @file dmtxw.h
+ * @brief Public interface of the shared wrapper glue
+ *
+ * Every language wrapper used to carry its own copy of the libdmtx decode
+ * loop (image setup, property handling, region search, corner transforms,
+ * y-flip and cleanup). libdmtxw implements that loop once. A wrapper keeps
+ * one DmtxwSession per decoder object, sets properties on it, hands it a
+ * pixel buffer and reads back a flat array of results whose payloads live
+ * in a single arena owned by the session.
+ */
+
+#ifndef __DMTXW_H__
+#define __DMTXW_H__
+
+#include <stddef.h>
+#include <dmtx.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DmtxwVersion              "0.1.0"
+
+/* Session properties without a libdmtx equivalent. The libdmtx decode
+ * properties (DmtxPropEdgeMin ... DmtxPropYmax) are accepted as well. */
+typedef enum {
+   DmtxwPropMaxCount = 1000,
+   DmtxwPropTimeout,
+   DmtxwPropCorrections,
+   DmtxwPropMosaic,
+   DmtxwPropShrink,
+   DmtxwPropLuma,
+   DmtxwPropThreads,
+   DmtxwPropLocate,
+   DmtxwPropMinSharpness,
+   DmtxwPropMinEdgeDensity,
+   DmtxwPropAutoTune,
+   DmtxwPropAutoTuneProbe,
+   DmtxwPropSearchShare
+} DmtxwProperty;
+
+/* Row kernels used by dmtxwConvertToLuma() */
+typedef enum {
+   DmtxwKernelAuto,             /* Best kernel reported by CPUID */
+   DmtxwKernelScalar,
+   DmtxwKernelSse2,
+   DmtxwKernelAvx2,
+   DmtxwKernelNeon
+} DmtxwKernel;
+
+/* Pixel layouts handed over by the wrapper host environments */
+typedef enum {
+   DmtxwFormatGray8,            /* 8bpp luminance */
+   DmtxwFormatRGB24,            /* PIL "RGB", RMagick "RGB" */
+   DmtxwFormatBGR24,            /* .NET Format24bppRgb */
+   DmtxwFormatRGBX32,
+   DmtxwFormatBGRX32,
+   DmtxwFormatXRGB32,           /* CoreGraphics premultiplied ARGB */
+   DmtxwFormatXBGR32,
+   DmtxwFormatInt32RGB,         /* 0x00RRGGBB ints in host byte order (Java int[]) */
+   DmtxwFormatMono1             /* 1bpp, first pixel in the high bit, 1 dark (as PBM); encode output only */
+} DmtxwFormat;
+
+/* Why the most recent decode stopped */
+typedef enum {
+   DmtxwStatusComplete,         /* Whole image was scanned */
+   DmtxwStatusMaxCount,         /* DmtxwPropMaxCount results were found */
+   DmtxwStatusTimeout,          /* Deadline or DmtxwPropTimeout expired (results are partial) */
+   DmtxwStatusCancelled,        /* dmtxwSessionCancel() was called */
+   DmtxwStatusError,            /* Bad arguments or out of memory */
+   DmtxwStatusBlurred,          /* Not searched: sharpness below DmtxwPropMinSharpness */
+   DmtxwStatusEmpty             /* Not searched: edge density below DmtxwPropMinEdgeDensity */
+} DmtxwStatus;
+
+/* Decode phases timed by the instrumentation counters (see dmtxwstats.c) */
+typedef enum {
+   DmtxwPhaseConvert,           /* Host image to pixel rows, pixel rows to luminance */
+   DmtxwPhaseSetup,             /* Sessions, options, DmtxImage and DmtxDecode structs */
+   DmtxwPhaseSearch,            /* dmtxRegionFindNext() */
+   DmtxwPhaseDecode,            /* dmtxDecodeMatrixRegion() and dmtxDecodeMosaicRegion() */
+   DmtxwPhaseMarshal,           /* Results into the session and on to host objects */
+   DmtxwPhaseCount
+} DmtxwPhase;
+
+/* Events counted by the instrumentation counters */
+typedef enum {
+   DmtxwCounterRegionsTried,    /* Regions returned by dmtxRegionFindNext() */
+   DmtxwCounterRegionsDecoded,  /* Regions that yielded a message */
+   DmtxwCounterBytesConverted,  /* Pixel bytes read by conversions */
+   DmtxwCounterAllocations,     /* Heap blocks allocated or grown on the decode path */
+   DmtxwCounterCount
+} DmtxwCounter;
+
+/**
+ * @struct DmtxwStats
+ * @brief Instrumentation totals of one thread since its last
+ *        dmtxwStatsReset(). Counters are doubles so byte totals do not wrap.
+ */
+typedef struct DmtxwStats_struct {
+   long            calls[DmtxwPhaseCount];
+   double          msec[DmtxwPhaseCount];  /* Monotonic clock */
+   double          count[DmtxwCounterCount];
+} DmtxwStats;
+
+/* Instrumentation hooks for libdmtxw and the wrapper glue. Unless
+ * DMTXW_STATS is defined (./configure --enable-stats) they compile to
+ * nothing, and the timer variable t is never read. */
+#if defined(DMTXW_STATS)
+#define DMTXW_STATS_START(t)          ((t) = dmtxwStatsClock())
+#define DMTXW_STATS_STOP(t, phase)    dmtxwStatsAddPhase((phase), dmtxwStatsClock() - (t))
+#define DMTXW_STATS_COUNT(counter, n) dmtxwStatsCount((counter), (double)(n))
+#else
+#define DMTXW_STATS_START(t)          ((t) = 0.0)
+#define DMTXW_STATS_STOP(t, phase)    ((void)(t))
+#define DMTXW_STATS_COUNT(counter, n) ((void)0)
+#endif
+
+/* Spans reported to a session's trace hook (see dmtxwtrace.c) */
+typedef enum {
+   DmtxwSpanDecode,             /* One dmtxwSessionDecode() call */
+   DmtxwSpanPrepare,            /* Search plane setup, luminance conversion included */
+   DmtxwSpanSearch,             /* One dmtxRegionFindNext() call */
+   DmtxwSpanRegion,             /* One dmtxDecodeMatrixRegion() or dmtxDecodeMosaicRegion() call */
+   DmtxwSpanMarshal,            /* Storing a result; wrappers report their own result objects */
+   DmtxwSpanCount
+} DmtxwSpan;
+
+/* How a traced span ended */
+typedef enum {
+   DmtxwOutcomeNone,            /* Begin events */
+   DmtxwOutcomeFound,           /* Region found, symbol decoded, result stored */
+   DmtxwOutcomeMissed,          /* Search exhausted, region did not decode, no results */
+   DmtxwOutcomeSlice,           /* Search slice used up, the search goes on */
+   DmtxwOutcomeDropped,         /* Result was a duplicate or arrived after max_count */
+   DmtxwOutcomeError
+} DmtxwOutcome;
+
+/**
+ * @struct DmtxwTraceEvent
+ * @brief Beginning or end of a traced span. Corners are set on the end of
+ *        a search that found a region and on region and marshal spans, in
+ *        the coordinates of DmtxwResult.
+ */
+typedef struct DmtxwTraceEvent_struct {
+   int             span;           /* DmtxwSpan */
+   int             begin;          /* 1 when the span starts, 0 when it ends */
+   double          msec;           /* dmtxwStatsClock() time */
+   int             thread;         /* 0: decoding thread, n: tile worker n */
+   int             outcome;        /* DmtxwOutcome */
+   int             hasCorners;
+   DmtxPixelLoc    corner[4];
+   int             sizeIdx;        /* Region spans: symbol size found */
+   int             status;         /* Decode end: DmtxwStatus */
+   int             results;        /* Decode end: symbols stored */
+} DmtxwTraceEvent;
+
+/**
+ * @struct DmtxwResult
+ * @brief One decoded symbol. Corners are in full resolution, top-down image
+ *        coordinates, ordered bottom-left, bottom-right, top-right, top-left
+ *        relative to the symbol (libdmtx p00, p10, p11, p01).
+ */
+typedef struct DmtxwResult_struct {
+   DmtxPixelLoc    corner[4];
+   int             angle;
+   int             sizeIdx;
+   int             padCount;
+   size_t          payloadOffset;
+   size_t          payloadLength;
+   int             contrast;       /* Difference between dark and light module color */
+   int             sharpness;      /* Quality metrics of the frame the symbol came from */
+   int             edgeDensity;
+} DmtxwResult;
+
+/**
+ * @struct DmtxwBox
+ * @brief Candidate region from dmtxwSessionLocate(), in top-down image
+ *        coordinates
+ */
+typedef struct DmtxwBox_struct {
+   int             x;
+   int             y;
+   int             width;
+   int             height;
+   double          score;
+} DmtxwBox;
+
+/* Receives session log messages, e.g. auto-tuner parameter changes */
+typedef void (*DmtxwLogFunc)(const char *message, void *context);
+
+/* Receives trace events; called from tile worker threads too */
+typedef void (*DmtxwTraceFunc)(const DmtxwTraceEvent *event, void *context);
+
+/* Chrome trace-event JSON writer (see dmtxwtrace.c) */
+typedef struct DmtxwTraceJson_struct DmtxwTraceJson;
+
+/* Result cache shared by any number of sessions (see dmtxwcache.c) */
+typedef struct DmtxwCache_struct DmtxwCache;
+
+/* Documents written by dmtxwEncodeVector() */
+typedef enum {
+   DmtxwVectorSvg,
+   DmtxwVectorPdf,
+   DmtxwVectorEps
+} DmtxwVectorFormat;
+
+/* Labels written by dmtxwEncodePrinter() */
+typedef enum {
+   DmtxwPrinterZpl,        /* ZPL ^BX field, the printer encodes the data */
+   DmtxwPrinterZplGraphic, /* ZPL ^GFA graphic of the modules, compressed */
+   DmtxwPrinterEplGraphic  /* EPL GW graphic of the modules */
+} DmtxwPrinterMode;
+
+/* Pages filled by dmtxwSheetRender() */
+typedef enum {
+   DmtxwSheetGray8,        /* One byte per pixel, 0 dark and 255 light */
+   DmtxwSheetMono1         /* One bit per pixel, first pixel in the high bit, 1 dark (as PBM) */
+} DmtxwSheetFormat;
+
+/**
+ * @struct DmtxwSheetSpec
+ * @brief Page and encode options of a label sheet (see dmtxwSheetSpecInit())
+ */
+typedef struct DmtxwSheetSpec_struct {
+   int             width;          /* Page width, pixels or output units */
+   int             height;         /* Page height, pixels or output units */
+   double          moduleSize;     /* Module edge; whole pixels on raster pages */
+   int             margin;         /* Quiet zone in modules */
+   int             scheme;         /* DmtxPropScheme value or DmtxUndefined */
+   int             sizeRequest;    /* DmtxPropSizeRequest value or DmtxUndefined */
+   int             threads;        /* Encoding threads, 1 to 64 */
+} DmtxwSheetSpec;
+
+/**
+ * @struct DmtxwSheetLabel
+ * @brief One symbol of a label sheet; x and y are the top-left corner of its
+ *        quiet zone
+ */
+typedef struct DmtxwSheetLabel_struct {
+   const unsigned char *data;
+   int             dataSize;
+   int             x;
+   int             y;
+   DmtxPassFail    status;         /* Set by the renderer: DmtxFail if skipped */
+} DmtxwSheetLabel;
+
+/**
+ * @struct DmtxwSymbolInfo
+ * @brief Attributes of one ECC200 symbol size (see dmtxwSymbolInfo())
+ */
+typedef struct DmtxwSymbolInfo_struct {
+   int             rows;
+   int             cols;
+   int             dataRegionRows;     /* Per region, without the finder */
+   int             dataRegionCols;
+   int             horizDataRegions;
+   int             vertDataRegions;
+   int             interleavedBlocks;
+   int             blockErrorWords;
+   int             dataWords;          /* Capacity of the whole symbol */
+   int             errorWords;
+} DmtxwSymbolInfo;
+
+/**
+ * @struct DmtxwBuffer
+ * @brief Growable output buffer, released with dmtxwBufferFree()
+ */
+typedef struct DmtxwBuffer_struct {
+   unsigned char  *data;
+   size_t          length;
+   size_t          capacity;
+} DmtxwBuffer;
+
+/**
+ * @struct DmtxwPnm
+ * @brief Binary PGM/PPM file mapped by dmtxwPnmMap(), ready for
+ *        dmtxwSessionDecode()
+ */
+typedef struct DmtxwPnm_struct {
+   unsigned char  *pxl;            /* Top row, packed */
+   int             width;
+   int             height;
+   int             rowSizeBytes;
+   int             format;         /* DmtxwFormatGray8 or DmtxwFormatRGB24 */
+   void           *map;            /* Whole file */
+   size_t          mapSize;
+} DmtxwPnm;
+
+/* Frame and result rings in shared memory (see dmtxwring.c) */
+typedef struct DmtxwRing_struct DmtxwRing;
+
+/**
+ * @struct DmtxwRingResult
+ * @brief Outcome of one ring frame, followed in shared memory by
+ *        symbolCount DmtxwRingSymbol records
+ */
+typedef struct DmtxwRingResult_struct {
+   unsigned int    frame;          /* Frame number assigned by the producer */
+   int             status;         /* DmtxwStatus, DmtxUndefined on decode error
+                                      or when the frame was reclaimed */
+   int             symbolCount;
+   int             truncated;      /* More symbols than fit in the result slot */
+   DmtxTime        published;
+   DmtxTime        decoded;
+} DmtxwRingResult;
+
+/**
+ * @struct DmtxwRingSymbol
+ * @brief Symbol of a ring result, in the coordinates of DmtxwResult
+ */
+typedef struct DmtxwRingSymbol_struct {
+   DmtxPixelLoc    corner[4];
+   int             angle;
+   int             sizeIdx;
+   int             length;         /* Payload bytes */
+} DmtxwRingSymbol;
+
+/**
+ * @struct DmtxwSession
+ * @brief Reusable decode state: options, result array and payload arena
+ */
+typedef struct DmtxwSession_struct {
+   /* Options (DmtxUndefined keeps the libdmtx default) */
+   int             edgeMin;
+   int             edgeMax;
+   int             scanGap;
+   int             squareDevn;
+   int             sizeIdxExpected;
+   int             edgeThresh;
+   int             xMin;
+   int             xMax;
+   int             yMin;
+   int             yMax;
+   int             shrink;
+   int             maxCount;
+   int             timeout;
+   int             searchShare;    /* Percent of a time budget spent on region search */
+   int             corrections;
+   int             mosaic;
+   int             luma;           /* 0: decode as given, 1/2/4: luminance at 1/n size */
+   int             threads;        /* 0: sequential, n: tiled search on n threads (needs edgeMax) */
+   int             locate;         /* 0: search everything, k: search the k best candidates first */
+   int             minSharpness;   /* Skip frames whose Laplacian variance is lower */
+   int             minEdgeDensity; /* Skip frames with fewer strong edge samples (per mille) */
+   DmtxwCache     *cache;          /* Answer repeated frames from here (not owned, may be NULL) */
+   int             autoTune;       /* 0: options as given, n: tune them from the last n decodes */
+   int             autoTuneProbe;  /* Tuned decodes between two full-option probes */
+   DmtxwLogFunc    logFunc;
+   void           *logContext;
+   DmtxwTraceFunc  traceFunc;      /* NULL: no tracing */
+   void           *traceContext;
+
+   /* Outcome of the most recent decode */
+   DmtxwStatus     status;
+   DmtxwResult    *result;
+   int             resultCount;
+   int             resultCapacity;
+   int             candidateCount; /* Candidate boxes searched, 0 if none were used */
+   int             sharpness;      /* Variance of the Laplacian on the search plane */
+   int             edgeDensity;    /* Grid samples on a strong edge, per mille */
+   int             cached;         /* Results were taken from the cache */
+
+   /* Payload bytes of all results, each followed by a NUL byte */
+   unsigned char  *arena;
+   size_t          arenaSize;
+   size_t          arenaCapacity;
+
+   /* Luminance plane reused by DmtxwPropLuma decodes */
+   unsigned char  *lumaBuf;
+   size_t          lumaCapacity;
+
+   /* Scratch space of the candidate locator */
+   unsigned char  *locateBuf;
+   size_t          locateCapacity;
+   struct DmtxwCell_struct *cellBuf;
+   size_t          cellCapacity;
+
+   /* Decode history of the auto-tuner */
+   struct DmtxwTuner_struct *tuner;
+
+   /* Set from another thread to stop the running decode */
+   volatile int    cancelled;
+
+   /* Set once maxCount results are stored, stops the remaining tiles */
+   volatile int    halted;
+} DmtxwSession;
+
+/* dmtxwsession.c */
+extern DmtxwSession *dmtxwSessionCreate(void);
+extern DmtxPassFail dmtxwSessionDestroy(DmtxwSession **session);
+extern DmtxPassFail dmtxwSessionResetProps(DmtxwSession *session);
+extern DmtxPassFail dmtxwSessionSetProp(DmtxwSession *session, int prop, int value);
+extern int dmtxwSessionGetProp(DmtxwSession *session, int prop);
+extern int dmtxwPropByName(const char *name);
+extern void dmtxwSessionCancel(DmtxwSession *session);
+extern int dmtxwSessionGetResultCount(const DmtxwSession *session);
+extern const DmtxwResult *dmtxwSessionGetResult(const DmtxwSession *session, int idx);
+extern const unsigned char *dmtxwSessionGetPayload(const DmtxwSession *session, int idx, size_t *length);
+extern DmtxPassFail dmtxwSessionSetCache(DmtxwSession *session, DmtxwCache *cache);
+
+/* dmtxwcache.c */
+extern DmtxwCache *dmtxwCacheCreate(int capacity, int ttl, int tolerance);
+extern DmtxPassFail dmtxwCacheDestroy(DmtxwCache **cache);
+extern void dmtxwCacheFlush(DmtxwCache *cache);
+extern DmtxPassFail dmtxwCacheGetStats(DmtxwCache *cache, long *hits, long *misses);
+
+/* dmtxwformat.c */
+extern int dmtxwFormatGetPack(int format);
+extern int dmtxwFormatGetBytesPerPixel(int format);
+extern DmtxImage *dmtxwImageCreate(unsigned char *pxl, int width, int height, int rowSizeBytes, int format);
+
+/* dmtxwconvert.c */
+extern DmtxPassFail dmtxwConvertToLuma(unsigned char *dst, int dstRowSizeBytes,
+      const unsigned char *src, int width, int height, int srcRowSizeBytes,
+      int format, int scale);
+extern int dmtxwConvertGetKernel(void);
+extern DmtxPassFail dmtxwConvertSetKernel(int kernel);
+
+/* dmtxwlocate.c */
+extern int dmtxwSessionLocate(DmtxwSession *session, unsigned char *pxl, int width,
+      int height, int rowSizeBytes, int format, DmtxwBox *box, int maxBoxes);
+
+/* dmtxwtune.c */
+extern DmtxPassFail dmtxwSessionSetLog(DmtxwSession *session, DmtxwLogFunc func, void *context);
+
+/* dmtxwring.c */
+extern DmtxwRing *dmtxwRingCreate(int slotCount, size_t slotBytes, int resultCount, size_t resultBytes);
+extern DmtxwRing *dmtxwRingAttach(int fd);
+extern DmtxPassFail dmtxwRingDestroy(DmtxwRing **ring);
+extern int dmtxwRingGetFd(DmtxwRing *ring);
+extern DmtxPassFail dmtxwRingSetLease(DmtxwRing *ring, int msec);
+extern unsigned char *dmtxwRingAcquireFrame(DmtxwRing *ring, size_t *size);
+extern DmtxPassFail dmtxwRingPublishFrame(DmtxwRing *ring, int width, int height,
+      int rowSizeBytes, int format);
+extern void dmtxwRingClose(DmtxwRing *ring);
+extern DmtxPassFail dmtxwRingDecodeNext(DmtxwRing *ring, DmtxwSession *session, int timeout);
+extern long dmtxwRingRunConsumer(DmtxwRing *ring, DmtxwSession *session);
+extern const DmtxwRingResult *dmtxwRingReadResult(DmtxwRing *ring, int timeout);
+extern void dmtxwRingReleaseResult(DmtxwRing *ring);
+extern const DmtxwRingSymbol *dmtxwRingResultGetSymbol(const DmtxwRingResult *result,
+      int index, const unsigned char **payload);
+extern DmtxPassFail dmtxwRingGetStats(DmtxwRing *ring, long *published, long *dropped,
+      long *reclaimed);
+
+/* dmtxwvector.c */
+extern DmtxPassFail dmtxwEncodeVector(DmtxEncode *enc, int format, double moduleSize,
+      int margin, DmtxwBuffer *out);
+extern int dmtxwVectorByName(const char *name);
+extern void dmtxwBufferFree(DmtxwBuffer *buffer);
+
+/* dmtxwsheet.c */
+extern void dmtxwSheetSpecInit(DmtxwSheetSpec *spec);
+extern DmtxPassFail dmtxwSheetGrid(DmtxwSheetLabel *labels, int count, int columns,
+      int x, int y, int pitchX, int pitchY);
+extern int dmtxwSheetRender(const DmtxwSheetSpec *spec, DmtxwSheetLabel *labels,
+      int count, unsigned char *page, int rowSize, int format);
+extern int dmtxwSheetVector(const DmtxwSheetSpec *spec, DmtxwSheetLabel *labels,
+      int count, int format, DmtxwBuffer *out);
+extern int dmtxwSheetWrite(const DmtxwSheetSpec *spec, DmtxwSheetLabel *labels,
+      int count, const char *format, DmtxwBuffer *out);
+
+/* dmtxwprinter.c */
+extern DmtxPassFail dmtxwEncodePrinter(DmtxEncode *enc, const unsigned char *data,
+      int dataSize, int mode, int dots, int margin, DmtxwBuffer *out);
+extern int dmtxwPrinterByName(const char *name);
+
+/* dmtxwsymbol.c */
+extern const DmtxwSymbolInfo *dmtxwSymbolInfo(int sizeIdx);
+extern int dmtxwSymbolCountWords(const unsigned char *data, int dataSize, int scheme);
+extern int dmtxwSymbolEstimate(const unsigned char *data, int dataSize, int scheme,
+      int sizeRequest);
+extern int dmtxwSymbolFit(int words, int sizeRequest);
+
+/* dmtxwexpand.c */
+extern DmtxPassFail dmtxwEncodeDataMatrix(DmtxEncode *enc, int inputSize,
+      const unsigned char *inputString);
+extern DmtxPassFail dmtxwEncodeGetSize(const DmtxEncode *enc, int *width, int *height);
+extern DmtxPassFail dmtxwEncodeExpand(DmtxEncode *enc, unsigned char *pxl, int rowSizeBytes,
+      int format);
+extern DmtxPassFail dmtxwEncodeExpandRows(DmtxEncode *enc, int firstRow, int rowCount,
+      unsigned char *pxl, int rowSizeBytes, int format);
+
+/* dmtxwpnm.c */
+extern DmtxPassFail dmtxwPnmMap(const char *path, DmtxwPnm *pnm);
+extern void dmtxwPnmUnmap(DmtxwPnm *pnm);
+extern DmtxPassFail dmtxwSessionDecodeFile(DmtxwSession *session, const char *path);
+
+/* dmtxwdecode.c */
+extern DmtxPassFail dmtxwSessionDecode(DmtxwSession *session, unsigned char *pxl,
+      int width, int height, int rowSizeBytes, int format);
+extern DmtxPassFail dmtxwSessionDecodeBefore(DmtxwSession *session, unsigned char *pxl,
+      int width, int height, int rowSizeBytes, int format, DmtxTime *deadline);
+
+/* dmtxwstats.c */
+extern DmtxBoolean dmtxwStatsEnabled(void);
+extern DmtxPassFail dmtxwStatsGet(DmtxwStats *stats);
+extern void dmtxwStatsReset(void);
+extern void dmtxwStatsMerge(DmtxwStats *dst, const DmtxwStats *src);
+extern const char *dmtxwStatsName(int idx);
+extern double dmtxwStatsValue(const DmtxwStats *stats, int idx);
+extern double dmtxwStatsClock(void);
+extern void dmtxwStatsAddPhase(int phase, double msec);
+extern void dmtxwStatsCount(int counter, double n);
+
+/* dmtxwtrace.c */
+extern DmtxPassFail dmtxwSessionSetTrace(DmtxwSession *session, DmtxwTraceFunc func, void *context);
+extern void dmtxwSessionTrace(DmtxwSession *session, int span, int begin, int outcome);
+extern const char *dmtxwSpanName(int span);
+extern const char *dmtxwOutcomeName(int outcome);
+extern DmtxwTraceJson *dmtxwTraceJsonOpen(const char *path, double minMsec);
+extern DmtxPassFail dmtxwTraceJsonClose(DmtxwTraceJson **writer);
+extern void dmtxwTraceJsonWrite(const DmtxwTraceEvent *event, void *context);
+
+extern char *dmtxwVersion(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,497 @@
+/*
+libdmtxw - Shared native glue for the libdmtx wrappers
+
+Copyright (C) 2026 The libdmtx-wrappers project
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+Contact: mike@dragonflylogic.com
+*/
+
+/* $Id$ */
+
+/**
+ * @file dmtxwcache.c
+ * @brief Result cache for fixed-mount scanners that see the same frame
+ *        over and over
+ *
+ * Each entry remembers a coarse thumbnail of a decoded plane, a finer
+ * sample grid over every symbol found in it, and the results. A new frame
+ * whose thumbnail and symbol grids are within tolerance of an entry that
+ * was stored with the same options gets that entry's results without any
+ * region search. Entries expire after a fixed time to live, and the least
+ * recently used one is replaced when the cache is full. A cache may be
+ * shared by several sessions, even on different threads.
+ *
+ * Frames in which nothing was found are never stored: the thumbnail alone
+ * would not notice a label placed into an otherwise unchanged scene, and
+ * there is no symbol to compare up close. For the same reason every entry
+ * expires; there is no unlimited time to live.
+ */
+
+/**
+ * @brief  Create a result cache
+ * @param  capacity Number of frames remembered, 1 .. DMTXW_CACHE_MAX_ENTRIES
+ * @param  ttl Milliseconds an entry stays valid, at least 1
+ * @param  tolerance Mean absolute luminance difference still considered
+ *         the same frame, DmtxUndefined for DMTXW_CACHE_TOLERANCE
+ * @return Address of new cache, or NULL on failure
+ */
+extern DmtxwCache *
+dmtxwCacheCreate(int capacity, int ttl, int tolerance)
+{
+   DmtxwCache *cache;
+
+   if(capacity < 1 || capacity > DMTXW_CACHE_MAX_ENTRIES ||
+         ttl < 1 ||
+         (tolerance != DmtxUndefined && tolerance < 0))
+      return NULL;
+
+   cache = (DmtxwCache *)calloc(1, sizeof(DmtxwCache));
+   if(cache == NULL)
+      return NULL;
+
+   cache->entry = (DmtxwCacheEntry *)calloc(capacity, sizeof(DmtxwCacheEntry));
+   if(cache->entry == NULL || MutexInit(&cache->lock) == DmtxFail) {
+      if(cache->entry != NULL)
+         free(cache->entry);
+      free(cache);
+      return NULL;
+   }
+
+   cache->capacity = capacity;
+   cache->ttl = ttl;
+   cache->tolerance = (tolerance == DmtxUndefined) ? DMTXW_CACHE_TOLERANCE : tolerance;
+
+   return cache;
+}
+
+/**
+ * @brief  Free a result cache. Sessions using it must be detached first.
+ * @param  cache Address of cache pointer, set to NULL on return
+ * @return DmtxPass | DmtxFail
+ */
+extern DmtxPassFail
+dmtxwCacheDestroy(DmtxwCache **cache)
+{
+   int i;
+   DmtxwCacheEntry *entry;
+
+   if(cache == NULL || *cache == NULL)
+      return DmtxFail;
+
+   for(i = 0; i < (*cache)->capacity; i++) {
+      entry = &((*cache)->entry[i]);
+      if(entry->result != NULL)
+         free(entry->result);
+      if(entry->arena != NULL)
+         free(entry->arena);
+      if(entry->patch != NULL)
+         free(entry->patch);
+   }
+
+   MutexDestroy(&(*cache)->lock);
+   free((*cache)->entry);
+   free(*cache);
+   *cache = NULL;
+
+   return DmtxPass;
+}
+
+/**
+ * @brief  Forget every stored frame, e.g. after the scene changed on purpose.
+ *         Storage and counters are kept.
+ * @param  cache Cache
+ * @return void
+ */
+extern void
+dmtxwCacheFlush(DmtxwCache *cache)
+{
+   int i;
+
+   if(cache == NULL)
+      return;
+
+   MutexLock(&cache->lock);
+   for(i = 0; i < cache->capacity; i++)
+      cache->entry[i].used = DmtxFalse;
+   MutexUnlock(&cache->lock);
+}
+
+/**
+ * @brief  Read the hit and miss counters accumulated since creation
+ * @param  cache Cache
+ * @param  hits Receives the number of decodes answered from the cache
+ * @param  misses Receives the number of decodes that had to search
+ * @return DmtxPass | DmtxFail
+ */
+extern DmtxPassFail
+dmtxwCacheGetStats(DmtxwCache *cache, long *hits, long *misses)
+{
+   if(cache == NULL)
+      return DmtxFail;
+
+   MutexLock(&cache->lock);
+   if(hits != NULL)
+      *hits = cache->hits;
+   if(misses != NULL)
+      *misses = cache->misses;
+   MutexUnlock(&cache->lock);
+
+   return DmtxPass;
+}
+
+/**
+ * @brief  Describe a plane for cache lookups: a key covering everything that
+ *         changes the decode outcome besides the pixels, and a thumbnail of
+ *         cell means
+ * @param  session Session holding the decode options
+ * @param  plane Plane about to be searched
+ * @param  print Receives the description
+ * @return void
+ */
+static void
+CachePrint(DmtxwSession *session, const DmtxwPlane *plane, DmtxwCachePrint *print)
+{
+   int i, j, si, sj, x, y, sum, samples;
+   int weight[4];
+   unsigned long key;
+
+   key = 2166136261UL;
+   key = HashInt(key, plane->width);
+   key = HashInt(key, plane->height);
+   key = HashInt(key, plane->format);
+   key = HashInt(key, plane->scale);
+   key = HashInt(key, session->edgeMin);
+   key = HashInt(key, session->edgeMax);
+   key = HashInt(key, session->scanGap);
+   key = HashInt(key, session->squareDevn);
+   key = HashInt(key, session->sizeIdxExpected);
+   key = HashInt(key, session->edgeThresh);
+   key = HashInt(key, session->xMin);
+   key = HashInt(key, session->xMax);
+   key = HashInt(key, session->yMin);
+   key = HashInt(key, session->yMax);
+   key = HashInt(key, session->shrink);
+   key = HashInt(key, session->maxCount);
+   key = HashInt(key, session->corrections);
+   key = HashInt(key, session->mosaic);
+   key = HashInt(key, session->locate);
+   key = HashInt(key, session->minSharpness);
+   key = HashInt(key, session->minEdgeDensity);
+   print->key = key;
+
+   GetLumaWeights(plane->format, weight);
+
+   /* Cell means over an evenly spaced sample grid; planes smaller than the
+    * grid simply repeat pixels */
+   samples = DMTXW_CACHE_GRID * DMTXW_CACHE_CELL_SAMPLES;
+   for(j = 0; j < DMTXW_CACHE_GRID; j++) {
+      for(i = 0; i < DMTXW_CACHE_GRID; i++) {
+         sum = 0;
+         for(sj = 0; sj < DMTXW_CACHE_CELL_SAMPLES; sj++) {
+            y = (2 * (j * DMTXW_CACHE_CELL_SAMPLES + sj) + 1) * plane->height / (2 * samples);
+            for(si = 0; si < DMTXW_CACHE_CELL_SAMPLES; si++) {
+               x = (2 * (i * DMTXW_CACHE_CELL_SAMPLES + si) + 1) * plane->width / (2 * samples);
+               sum += SampleLuma(plane->pxl + y * plane->rowSizeBytes +
+                     x * plane->bytesPerPixel, plane->bytesPerPixel, weight);
+            }
+         }
+         print->thumb[j * DMTXW_CACHE_GRID + i] = (unsigned char)(sum /
+               (DMTXW_CACHE_CELL_SAMPLES * DMTXW_CACHE_CELL_SAMPLES));
+      }
+   }
+}
+
+/**
+ * @brief  Mix one int into an FNV-1a hash
+ * @param  key Hash so far
+ * @param  value Value to add
+ * @return Updated hash
+ */
+static unsigned long
+HashInt(unsigned long key, int value)
+{
+   int i;
+
+   for(i = 0; i < 4; i++) {
+      key ^= (unsigned long)((value >> (i * 8)) & 0xff);
+      key = (key * 16777619UL) & 0xffffffffUL;
+   }
+
+   return key;
+}
+
+/**
+ * @brief  Sample a grid over the bounding box of a result, much finer than
+ *         the thumbnail, so a different symbol on an otherwise unchanged
+ *         frame is noticed
+ * @param  plane Plane the result was found in
+ * @param  result Result with full-resolution, top-down corners
+ * @param  patch Receives DMTXW_CACHE_PATCH^2 samples
+ * @return void
+ */
+static void
+SamplePatch(const DmtxwPlane *plane, const DmtxwResult *result, unsigned char *patch)
+{
+   int i, j, x, y, x0, y0, x1, y1;
+   int weight[4];
+
+   x0 = x1 = result->corner[0].X / plane->scale;
+   y0 = y1 = result->corner[0].Y / plane->scale;
+   for(i = 1; i < 4; i++) {
+      x = result->corner[i].X / plane->scale;
+      y = result->corner[i].Y / plane->scale;
+      if(x < x0)
+         x0 = x;
+      if(x > x1)
+         x1 = x;
+      if(y < y0)
+         y0 = y;
+      if(y > y1)
+         y1 = y;
+   }
+
+   if(x0 < 0)
+      x0 = 0;
+   if(y0 < 0)
+      y0 = 0;
+   if(x1 > plane->width - 1)
+      x1 = plane->width - 1;
+   if(y1 > plane->height - 1)
+      y1 = plane->height - 1;
+   if(x1 < x0 || y1 < y0) {
+      memset(patch, 0x00, DMTXW_CACHE_PATCH * DMTXW_CACHE_PATCH);
+      return;
+   }
+
+   GetLumaWeights(plane->format, weight);
+
+   for(j = 0; j < DMTXW_CACHE_PATCH; j++) {
+      y = y0 + (2 * j + 1) * (y1 - y0 + 1) / (2 * DMTXW_CACHE_PATCH);
+      for(i = 0; i < DMTXW_CACHE_PATCH; i++) {
+         x = x0 + (2 * i + 1) * (x1 - x0 + 1) / (2 * DMTXW_CACHE_PATCH);
+         patch[j * DMTXW_CACHE_PATCH + i] = (unsigned char)SampleLuma(plane->pxl +
+               y * plane->rowSizeBytes + x * plane->bytesPerPixel,
+               plane->bytesPerPixel, weight);
+      }
+   }
+}
+
+/**
+ * @brief  Sum of absolute differences between two sample arrays
+ * @param  a First array
+ * @param  b Second array
+ * @param  count Number of samples
+ * @return Sum
+ */
+static long
+SumAbsDiff(const unsigned char *a, const unsigned char *b, int count)
+{
+   int i;
+   long sum = 0;
+
+   for(i = 0; i < count; i++)
+      sum += abs((int)a[i] - (int)b[i]);
+
+   return sum;
+}
+
+/**
+ * @brief  Answer a decode from the session's cache when an entry matches.
+ *         On a hit the session holds the stored results and status.
+ * @param  session Session with a cache attached
+ * @param  plane Plane about to be searched
+ * @param  print Description of the plane from CachePrint()
+ * @return DmtxTrue on a hit, DmtxFalse if the plane must be searched
+ */
+static DmtxBoolean
+CacheLookup(DmtxwSession *session, const DmtxwPlane *plane, const DmtxwCachePrint *print)
+{
+   DmtxwCache *cache = session->cache;
+   DmtxwCacheEntry *entry, *best;
+   DmtxwResult *result;
+   DmtxTime now;
+   unsigned char patch[DMTXW_CACHE_PATCH * DMTXW_CACHE_PATCH];
+   long diff, bestDiff, limit;
+   int i, k;
+
+   now = dmtxTimeNow();
+   limit = (long)cache->tolerance * DMTXW_CACHE_GRID * DMTXW_CACHE_GRID;
+   best = NULL;
+   bestDiff = 0;
+
+   MutexLock(&cache->lock);
+   cache->tick++;
+
+   for(i = 0; i < cache->capacity; i++) {
+      entry = &(cache->entry[i]);
+      if(entry->used == DmtxFalse || entry->key != print->key)
+         continue;
+
+      if(TimeBefore(now, entry->expires) == DmtxFalse) {
+         entry->used = DmtxFalse;
+         continue;
+      }
+
+      diff = SumAbsDiff(entry->thumb, print->thumb, DMTXW_CACHE_GRID * DMTXW_CACHE_GRID);
+      if(diff > limit || (best != NULL && diff >= bestDiff))
+         continue;
+
+      /* Every stored symbol must still look the same up close */
+      for(k = 0; k < entry->resultCount; k++) {
+         SamplePatch(plane, &(entry->result[k]), patch);
+         if(SumAbsDiff(entry->patch + k * DMTXW_CACHE_PATCH * DMTXW_CACHE_PATCH, patch,
+               DMTXW_CACHE_PATCH * DMTXW_CACHE_PATCH) >
+               (long)cache->tolerance * DMTXW_CACHE_PATCH * DMTXW_CACHE_PATCH)
+            break;
+      }
+
+      if(k == entry->resultCount) {
+         best = entry;
+         bestDiff = diff;
+      }
+   }
+
+   for(k = 0; best != NULL && k < best->resultCount; k++) {
+      result = AppendResult(session, best->arena + best->result[k].payloadOffset,
+            best->result[k].payloadLength);
+      if(result == NULL) {
+         /* Out of memory: let the search report it */
+         ResetResults(session);
+         best = NULL;
+         break;
+      }
+      memcpy(result->corner, best->result[k].corner, sizeof(result->corner));
+      result->angle = best->result[k].angle;
+      result->sizeIdx = best->result[k].sizeIdx;
+      result->padCount = best->result[k].padCount;
+      result->contrast = best->result[k].contrast;
+      result->sharpness = best->result[k].sharpness;
+      result->edgeDensity = best->result[k].edgeDensity;
+   }
+
+   if(best == NULL) {
+      cache->misses++;
+      MutexUnlock(&cache->lock);
+      return DmtxFalse;
+   }
+
+   best->lastUsed = cache->tick;
+   cache->hits++;
+
+   session->status = best->status;
+   session->sharpness = best->sharpness;
+   session->edgeDensity = best->edgeDensity;
+   session->cached = DmtxTrue;
+
+   MutexUnlock(&cache->lock);
+
+   return DmtxTrue;
+}
+
+/**
+ * @brief  Remember the outcome of a finished search. Partial outcomes
+ *         (timeout, cancel, error), rejected frames and frames without any
+ *         symbol are not stored.
+ *         Storing is best effort; running out of memory only drops the entry.
+ * @param  session Session holding the results
+ * @param  plane Plane that was searched
+ * @param  print Description of the plane from CachePrint()
+ * @return void
+ */
+static void
+CacheStore(DmtxwSession *session, const DmtxwPlane *plane, const DmtxwCachePrint *print)
+{
+   DmtxwCache *cache = session->cache;
+   DmtxwCacheEntry *entry, *slot;
+   DmtxTime now;
+   size_t size;
+   void *p;
+   int i;
+
+   if(session->status != DmtxwStatusComplete && session->status != DmtxwStatusMaxCount)
+      return;
+
+   /* Only the symbols found can be checked up close on a later frame */
+   if(session->resultCount == 0)
+      return;
+
+   now = dmtxTimeNow();
+
+   MutexLock(&cache->lock);
+   cache->tick++;
+
+   /* Free or expired slot first, otherwise the least recently used one */
+   slot = NULL;
+   for(i = 0; i < cache->capacity; i++) {
+      entry = &(cache->entry[i]);
+      if(entry->used == DmtxFalse || TimeBefore(now, entry->expires) == DmtxFalse) {
+         slot = entry;
+         break;
+      }
+      if(slot == NULL || entry->lastUsed < slot->lastUsed)
+         slot = entry;
+   }
+
+   slot->used = DmtxFalse;
+
+   if(session->resultCount > slot->resultCapacity) {
+      p = realloc(slot->result, session->resultCount * sizeof(DmtxwResult));
+      if(p == NULL) {
+         MutexUnlock(&cache->lock);
+         return;
+      }
+      slot->result = (DmtxwResult *)p;
+
+      size = (size_t)session->resultCount * DMTXW_CACHE_PATCH * DMTXW_CACHE_PATCH;
+      p = realloc(slot->patch, size);
+      if(p == NULL) {
+         MutexUnlock(&cache->lock);
+         return;
+      }
+      slot->patch = (unsigned char *)p;
+      slot->resultCapacity = session->resultCount;
+   }
+
+   if(session->arenaSize > slot->arenaCapacity) {
+      p = realloc(slot->arena, session->arenaSize);
+      if(p == NULL) {
+         MutexUnlock(&cache->lock);
+         return;
+      }
+      slot->arena = (unsigned char *)p;
+      slot->arenaCapacity = session->arenaSize;
+   }
+
+   slot->key = print->key;
+   memcpy(slot->thumb, print->thumb, sizeof(slot->thumb));
+   slot->resultCount = session->resultCount;
+   memcpy(slot->result, session->result, session->resultCount * sizeof(DmtxwResult));
+   if(session->arenaSize > 0)
+      memcpy(slot->arena, session->arena, session->arenaSize);
+   for(i = 0; i < session->resultCount; i++)
+      SamplePatch(plane, &(session->result[i]),
+            slot->patch + i * DMTXW_CACHE_PATCH * DMTXW_CACHE_PATCH);
+
+   slot->status = session->status;
+   slot->sharpness = session->sharpness;
+   slot->edgeDensity = session->edgeDensity;
+   slot->expires = dmtxTimeAdd(now, cache->ttl);
+   slot->lastUsed = cache->tick;
+   slot->used = DmtxTrue;
+
+   MutexUnlock(&cache->lock);
+}
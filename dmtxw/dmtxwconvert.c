@@ -0,0 +1,599 @@
+/*
+libdmtxw - Shared native glue for the libdmtx wrappers
+
+Copyright (C) 2026 The libdmtx-wrappers project
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+Contact: mike@dragonflylogic.com
+*/
+
+/* $Id$ */
+
+/**
+ * @file dmtxwconvert.c
+ * @brief Conversion of wrapper pixel formats to an 8bpp luminance plane
+ *
+ * libdmtx scans every color channel of a 24 or 32bpp image separately, so
+ * handing it a single luminance plane cuts the work of the region search to
+ * a third, and an optional 2x2 or 4x4 box downscale in the same pass cuts
+ * it further for large camera frames. The per-row kernels are written for
+ * SSE2, AVX2 and NEON with a portable fallback; the x86 kernels are chosen
+ * at runtime from CPUID. All kernels compute Y = (77R + 150G + 29B + 128) >> 8
+ * and therefore produce identical output.
+ */
+
+static const int lumaWeightRGB[3] = { 77, 150, 29 };
+
+static int activeKernel = DmtxwKernelAuto;
+static LumaRowFunc activeRowFunc = NULL;
+
+/**
+ * @brief  Convert a region of pixels to luminance (optionally box filtered)
+ * @param  dst Top-down destination plane, (width/scale) x (height/scale)
+ * @param  dstRowSizeBytes Distance between destination rows, 0 for packed
+ * @param  src Top-down source pixels
+ * @param  width Source width in pixels
+ * @param  height Source height in pixels
+ * @param  srcRowSizeBytes Distance between source rows, 0 for packed
+ * @param  format DmtxwFormat of the source
+ * @param  scale 1, 2 or 4
+ * @return DmtxPass | DmtxFail
+ */
+extern DmtxPassFail
+dmtxwConvertToLuma(unsigned char *dst, int dstRowSizeBytes,
+      const unsigned char *src, int width, int height, int srcRowSizeBytes,
+      int format, int scale)
+{
+   int x, y, k, chunk, chunkOut;
+   int bytesPerPixel, outWidth, outHeight, area;
+   int weight[4];
+   unsigned char line[DMTXW_CONVERT_CHUNK];
+   unsigned short acc[DMTXW_CONVERT_CHUNK];
+   const unsigned char *srcRow;
+   unsigned char *dstRow;
+   LumaRowFunc rowFunc;
+
+   bytesPerPixel = dmtxwFormatGetBytesPerPixel(format);
+   if(dst == NULL || src == NULL || bytesPerPixel == DmtxUndefined)
+      return DmtxFail;
+
+   if(scale != 1 && scale != 2 && scale != 4)
+      return DmtxFail;
+
+   outWidth = width / scale;
+   outHeight = height / scale;
+   if(outWidth < 1 || outHeight < 1)
+      return DmtxFail;
+
+   if(srcRowSizeBytes <= 0)
+      srcRowSizeBytes = width * bytesPerPixel;
+   if(dstRowSizeBytes <= 0)
+      dstRowSizeBytes = outWidth;
+   if(srcRowSizeBytes < width * bytesPerPixel || dstRowSizeBytes < outWidth)
+      return DmtxFail;
+
+   GetLumaWeights(format, weight);
+   rowFunc = (bytesPerPixel == 1) ? LumaRowCopy : GetRowFunc();
+
+   if(scale == 1) {
+      for(y = 0; y < height; y++)
+         rowFunc(dst + y * dstRowSizeBytes, src + y * srcRowSizeBytes,
+               width, bytesPerPixel, weight);
+      return DmtxPass;
+   }
+
+   /* Box filter in column chunks so the scratch rows fit on the stack */
+   area = scale * scale;
+   for(y = 0; y < outHeight; y++) {
+      dstRow = dst + y * dstRowSizeBytes;
+      for(x = 0; x < outWidth * scale; x += chunk) {
+         chunk = outWidth * scale - x;
+         if(chunk > DMTXW_CONVERT_CHUNK)
+            chunk = DMTXW_CONVERT_CHUNK;
+         chunkOut = chunk / scale;
+
+         memset(acc, 0x00, chunkOut * sizeof(unsigned short));
+         for(k = 0; k < scale; k++) {
+            srcRow = src + (y * scale + k) * srcRowSizeBytes + x * bytesPerPixel;
+            rowFunc(line, srcRow, chunk, bytesPerPixel, weight);
+            AccumulateLine(acc, line, chunkOut, scale);
+         }
+
+         for(k = 0; k < chunkOut; k++)
+            dstRow[x / scale + k] = (unsigned char)((acc[k] + area / 2) / area);
+      }
+   }
+
+   return DmtxPass;
+}
+
+/**
+ * @brief  Report which row kernel conversions use
+ * @return DmtxwKernel value (never DmtxwKernelAuto)
+ */
+extern int
+dmtxwConvertGetKernel(void)
+{
+   (void)GetRowFunc();
+
+   return activeKernel;
+}
+
+/**
+ * @brief  Force a row kernel, e.g. to benchmark or compare kernels
+ * @param  kernel DmtxwKernel value, DmtxwKernelAuto to pick from CPUID
+ * @return DmtxPass, or DmtxFail if the kernel is not available here
+ */
+extern DmtxPassFail
+dmtxwConvertSetKernel(int kernel)
+{
+   LumaRowFunc rowFunc;
+
+   if(kernel == DmtxwKernelAuto) {
+      activeRowFunc = NULL;
+      activeKernel = DmtxwKernelAuto;
+      (void)GetRowFunc();
+      return DmtxPass;
+   }
+
+   rowFunc = KernelRowFunc(kernel);
+   if(rowFunc == NULL)
+      return DmtxFail;
+
+   activeRowFunc = rowFunc;
+   activeKernel = kernel;
+
+   return DmtxPass;
+}
+
+/**
+ * @brief  Weights applied to each byte of a pixel, summing to 256
+ * @param  format DmtxwFormat value
+ * @param  weight Receives 4 weights (unused bytes get 0)
+ * @return void
+ */
+static void
+GetLumaWeights(int format, int weight[4])
+{
+   int i, rgbOffset;
+   unsigned int one = 1;
+
+   weight[0] = weight[1] = weight[2] = weight[3] = 0;
+
+   switch(format) {
+      case DmtxwFormatGray8:
+         weight[0] = 256;
+         return;
+      case DmtxwFormatRGB24:
+      case DmtxwFormatRGBX32:
+         rgbOffset = 0;
+         break;
+      case DmtxwFormatXRGB32:
+         rgbOffset = 1;
+         break;
+      case DmtxwFormatBGR24:
+      case DmtxwFormatBGRX32:
+         rgbOffset = -1;
+         break;
+      case DmtxwFormatXBGR32:
+         rgbOffset = -2;
+         break;
+      case DmtxwFormatInt32RGB:
+         /* 0x00RRGGBB is B,G,R,X in memory on little-endian hosts */
+         rgbOffset = (*(unsigned char *)&one == 1) ? -1 : 1;
+         break;
+      default:
+         return;
+   }
+
+   /* Non-negative offsets are R,G,B order; negative ones are B,G,R */
+   for(i = 0; i < 3; i++) {
+      if(rgbOffset >= 0)
+         weight[rgbOffset + i] = lumaWeightRGB[i];
+      else
+         weight[-rgbOffset - 1 + i] = lumaWeightRGB[2 - i];
+   }
+}
+
+/**
+ * @brief  Row function in use, choosing one on first call
+ * @return Row function
+ */
+static LumaRowFunc
+GetRowFunc(void)
+{
+   if(activeRowFunc != NULL)
+      return activeRowFunc;
+
+   activeKernel = DetectKernel();
+   activeRowFunc = KernelRowFunc(activeKernel);
+
+   return activeRowFunc;
+}
+
+/**
+ * @brief  Best kernel the running CPU supports
+ * @return DmtxwKernel value
+ */
+static int
+DetectKernel(void)
+{
+#if defined(DMTXW_HAVE_AVX2)
+   if(CpuHasAvx2() == DmtxTrue)
+      return DmtxwKernelAvx2;
+#endif
+#if defined(DMTXW_HAVE_SSE2)
+   if(CpuHasSse2() == DmtxTrue)
+      return DmtxwKernelSse2;
+#endif
+#if defined(DMTXW_HAVE_NEON)
+   return DmtxwKernelNeon;
+#else
+   return DmtxwKernelScalar;
+#endif
+}
+
+/**
+ * @brief  Row function implementing a kernel
+ * @param  kernel DmtxwKernel value
+ * @return Row function, or NULL if the kernel is unavailable
+ */
+static LumaRowFunc
+KernelRowFunc(int kernel)
+{
+   switch(kernel) {
+      case DmtxwKernelScalar:
+         return LumaRowScalar;
+#if defined(DMTXW_HAVE_SSE2)
+      case DmtxwKernelSse2:
+         return (CpuHasSse2() == DmtxTrue) ? LumaRowSse2 : NULL;
+#endif
+#if defined(DMTXW_HAVE_AVX2)
+      case DmtxwKernelAvx2:
+         return (CpuHasAvx2() == DmtxTrue) ? LumaRowAvx2 : NULL;
+#endif
+#if defined(DMTXW_HAVE_NEON)
+      case DmtxwKernelNeon:
+         return LumaRowNeon;
+#endif
+   }
+
+   return NULL;
+}
+
+/**
+ * @brief  Add each group of scale luminance values into one accumulator
+ * @param  acc Accumulators
+ * @param  line Luminance values
+ * @param  count Number of accumulators
+ * @param  scale Group size
+ * @return void
+ */
+static void
+AccumulateLine(unsigned short *acc, const unsigned char *line, int count, int scale)
+{
+   int i;
+
+   if(scale == 2) {
+      for(i = 0; i < count; i++)
+         acc[i] += line[2*i] + line[2*i+1];
+   }
+   else {
+      for(i = 0; i < count; i++)
+         acc[i] += line[4*i] + line[4*i+1] + line[4*i+2] + line[4*i+3];
+   }
+}
+
+/**
+ * @brief  Row "conversion" of 8bpp input
+ * @param  dst Destination row
+ * @param  src Source row
+ * @param  width Pixels in row
+ * @param  bytesPerPixel Unused (always 1)
+ * @param  weight Unused
+ * @return void
+ */
+static void
+LumaRowCopy(unsigned char *dst, const unsigned char *src, int width,
+      int bytesPerPixel, const int weight[4])
+{
+   (void)bytesPerPixel;
+   (void)weight;
+
+   memcpy(dst, src, width);
+}
+
+/**
+ * @brief  Portable luminance row kernel
+ * @param  dst Destination row
+ * @param  src Source row
+ * @param  width Pixels in row
+ * @param  bytesPerPixel 3 or 4
+ * @param  weight Per-byte weights from GetLumaWeights()
+ * @return void
+ */
+static void
+LumaRowScalar(unsigned char *dst, const unsigned char *src, int width,
+      int bytesPerPixel, const int weight[4])
+{
+   int x, sum;
+
+   if(bytesPerPixel == 3) {
+      for(x = 0; x < width; x++, src += 3) {
+         sum = weight[0] * src[0] + weight[1] * src[1] + weight[2] * src[2];
+         dst[x] = (unsigned char)((sum + 128) >> 8);
+      }
+   }
+   else {
+      for(x = 0; x < width; x++, src += 4) {
+         sum = weight[0] * src[0] + weight[1] * src[1] +
+               weight[2] * src[2] + weight[3] * src[3];
+         dst[x] = (unsigned char)((sum + 128) >> 8);
+      }
+   }
+}
+
+#if defined(DMTXW_HAVE_SSE2) || defined(DMTXW_HAVE_AVX2)
+/**
+ * @brief  Read 4 bytes starting at an unaligned address
+ * @param  p Address
+ * @return Bytes as a host-order int
+ */
+static int
+LoadUnaligned32(const unsigned char *p)
+{
+   int v;
+
+   memcpy(&v, p, sizeof(int));
+
+   return v;
+}
+#endif
+
+#if defined(DMTXW_HAVE_SSE2)
+/**
+ * @brief  Luminance of 4 pixels held in 32-bit lanes
+ * @param  v Pixels, one per 32-bit lane
+ * @param  wEven Weights of bytes 0 and 2 of each pixel, as 16-bit lanes
+ * @param  wOdd Weights of bytes 1 and 3 of each pixel, as 16-bit lanes
+ * @return Luminance in the low byte of each 32-bit lane
+ */
+DMTXW_TARGET_SSE2 static __m128i
+LumaSse2(__m128i v, __m128i wEven, __m128i wOdd)
+{
+   __m128i even, odd, sum;
+
+   even = _mm_and_si128(v, _mm_set1_epi16(0x00ff));
+   odd = _mm_srli_epi16(v, 8);
+   sum = _mm_add_epi32(_mm_madd_epi16(even, wEven), _mm_madd_epi16(odd, wOdd));
+
+   return _mm_srli_epi32(_mm_add_epi32(sum, _mm_set1_epi32(128)), 8);
+}
+
+/**
+ * @brief  SSE2 luminance row kernel, 8 pixels per iteration
+ * @param  dst Destination row
+ * @param  src Source row
+ * @param  width Pixels in row
+ * @param  bytesPerPixel 3 or 4
+ * @param  weight Per-byte weights from GetLumaWeights()
+ * @return void
+ */
+DMTXW_TARGET_SSE2 static void
+LumaRowSse2(unsigned char *dst, const unsigned char *src, int width,
+      int bytesPerPixel, const int weight[4])
+{
+   int x, limit;
+   const unsigned char *p;
+   __m128i wEven, wOdd, v0, v1, y;
+
+   wEven = _mm_setr_epi16((short)weight[0], (short)weight[2], (short)weight[0], (short)weight[2],
+         (short)weight[0], (short)weight[2], (short)weight[0], (short)weight[2]);
+   wOdd = _mm_setr_epi16((short)weight[1], (short)weight[3], (short)weight[1], (short)weight[3],
+         (short)weight[1], (short)weight[3], (short)weight[1], (short)weight[3]);
+
+   /* 24bpp loads read one byte past the last pixel, so stop one early */
+   limit = (bytesPerPixel == 3) ? width - 1 : width;
+
+   for(x = 0; x + 8 <= limit; x += 8) {
+      p = src + x * bytesPerPixel;
+      if(bytesPerPixel == 4) {
+         v0 = _mm_loadu_si128((const __m128i *)p);
+         v1 = _mm_loadu_si128((const __m128i *)(p + 16));
+      }
+      else {
+         v0 = _mm_setr_epi32(LoadUnaligned32(p), LoadUnaligned32(p + 3),
+               LoadUnaligned32(p + 6), LoadUnaligned32(p + 9));
+         v1 = _mm_setr_epi32(LoadUnaligned32(p + 12), LoadUnaligned32(p + 15),
+               LoadUnaligned32(p + 18), LoadUnaligned32(p + 21));
+      }
+
+      y = _mm_packs_epi32(LumaSse2(v0, wEven, wOdd), LumaSse2(v1, wEven, wOdd));
+      _mm_storel_epi64((__m128i *)(dst + x), _mm_packus_epi16(y, y));
+   }
+
+   LumaRowScalar(dst + x, src + x * bytesPerPixel, width - x, bytesPerPixel, weight);
+}
+#endif
+
+#if defined(DMTXW_HAVE_AVX2)
+/**
+ * @brief  Luminance of 8 pixels held in 32-bit lanes
+ * @param  v Pixels, one per 32-bit lane
+ * @param  wEven Weights of bytes 0 and 2 of each pixel, as 16-bit lanes
+ * @param  wOdd Weights of bytes 1 and 3 of each pixel, as 16-bit lanes
+ * @return Luminance in the low byte of each 32-bit lane
+ */
+DMTXW_TARGET_AVX2 static __m256i
+LumaAvx2(__m256i v, __m256i wEven, __m256i wOdd)
+{
+   __m256i even, odd, sum;
+
+   even = _mm256_and_si256(v, _mm256_set1_epi16(0x00ff));
+   odd = _mm256_srli_epi16(v, 8);
+   sum = _mm256_add_epi32(_mm256_madd_epi16(even, wEven), _mm256_madd_epi16(odd, wOdd));
+
+   return _mm256_srli_epi32(_mm256_add_epi32(sum, _mm256_set1_epi32(128)), 8);
+}
+
+/**
+ * @brief  AVX2 luminance row kernel, 16 pixels per iteration
+ * @param  dst Destination row
+ * @param  src Source row
+ * @param  width Pixels in row
+ * @param  bytesPerPixel 3 or 4
+ * @param  weight Per-byte weights from GetLumaWeights()
+ * @return void
+ */
+DMTXW_TARGET_AVX2 static void
+LumaRowAvx2(unsigned char *dst, const unsigned char *src, int width,
+      int bytesPerPixel, const int weight[4])
+{
+   int x, limit;
+   const unsigned char *p;
+   __m256i wEven, wOdd, gather, order, v0, v1, y;
+
+   wEven = _mm256_set1_epi32((weight[2] << 16) | weight[0]);
+   wOdd = _mm256_set1_epi32((weight[3] << 16) | weight[1]);
+   gather = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+   order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+   /* 24bpp gathers read one byte past the last pixel, so stop one early */
+   limit = (bytesPerPixel == 3) ? width - 1 : width;
+
+   for(x = 0; x + 16 <= limit; x += 16) {
+      p = src + x * bytesPerPixel;
+      if(bytesPerPixel == 4) {
+         v0 = _mm256_loadu_si256((const __m256i *)p);
+         v1 = _mm256_loadu_si256((const __m256i *)(p + 32));
+      }
+      else {
+         v0 = _mm256_i32gather_epi32((const int *)p, gather, 1);
+         v1 = _mm256_i32gather_epi32((const int *)(p + 24), gather, 1);
+      }
+
+      /* Packing works within 128-bit lanes; restore pixel order after */
+      y = _mm256_packs_epi32(LumaAvx2(v0, wEven, wOdd), LumaAvx2(v1, wEven, wOdd));
+      y = _mm256_packus_epi16(y, y);
+      y = _mm256_permutevar8x32_epi32(y, order);
+      _mm_storeu_si128((__m128i *)(dst + x), _mm256_castsi256_si128(y));
+   }
+
+   LumaRowScalar(dst + x, src + x * bytesPerPixel, width - x, bytesPerPixel, weight);
+}
+#endif
+
+#if defined(DMTXW_HAVE_NEON)
+/**
+ * @brief  NEON luminance row kernel, 16 pixels per iteration
+ * @param  dst Destination row
+ * @param  src Source row
+ * @param  width Pixels in row
+ * @param  bytesPerPixel 3 or 4
+ * @param  weight Per-byte weights from GetLumaWeights()
+ * @return void
+ */
+static void
+LumaRowNeon(unsigned char *dst, const unsigned char *src, int width,
+      int bytesPerPixel, const int weight[4])
+{
+   int x;
+   uint8x16x3_t v3;
+   uint8x16x4_t v4;
+   uint8x8_t w0, w1, w2, w3;
+   uint16x8_t lo, hi;
+
+   w0 = vdup_n_u8((uint8_t)weight[0]);
+   w1 = vdup_n_u8((uint8_t)weight[1]);
+   w2 = vdup_n_u8((uint8_t)weight[2]);
+   w3 = vdup_n_u8((uint8_t)weight[3]);
+
+   for(x = 0; x + 16 <= width; x += 16) {
+      if(bytesPerPixel == 3) {
+         v3 = vld3q_u8(src + x * 3);
+         v4.val[0] = v3.val[0];
+         v4.val[1] = v3.val[1];
+         v4.val[2] = v3.val[2];
+         v4.val[3] = vdupq_n_u8(0);
+      }
+      else {
+         v4 = vld4q_u8(src + x * 4);
+      }
+
+      /* Weights sum to 256, so 16-bit accumulators cannot overflow */
+      lo = vmull_u8(vget_low_u8(v4.val[0]), w0);
+      lo = vmlal_u8(lo, vget_low_u8(v4.val[1]), w1);
+      lo = vmlal_u8(lo, vget_low_u8(v4.val[2]), w2);
+      lo = vmlal_u8(lo, vget_low_u8(v4.val[3]), w3);
+      hi = vmull_u8(vget_high_u8(v4.val[0]), w0);
+      hi = vmlal_u8(hi, vget_high_u8(v4.val[1]), w1);
+      hi = vmlal_u8(hi, vget_high_u8(v4.val[2]), w2);
+      hi = vmlal_u8(hi, vget_high_u8(v4.val[3]), w3);
+
+      vst1q_u8(dst + x, vcombine_u8(vrshrn_n_u16(lo, 8), vrshrn_n_u16(hi, 8)));
+   }
+
+   LumaRowScalar(dst + x, src + x * bytesPerPixel, width - x, bytesPerPixel, weight);
+}
+#endif
+
+#if defined(DMTXW_HAVE_SSE2)
+/**
+ * @brief  Check for SSE2 support
+ * @return DmtxTrue | DmtxFalse
+ */
+static DmtxBoolean
+CpuHasSse2(void)
+{
+#if defined(__x86_64__) || defined(_M_X64)
+   return DmtxTrue;
+#elif defined(__GNUC__)
+   __builtin_cpu_init();
+   return __builtin_cpu_supports("sse2") ? DmtxTrue : DmtxFalse;
+#else
+   int info[4];
+
+   __cpuid(info, 1);
+   return (info[3] & (1 << 26)) ? DmtxTrue : DmtxFalse;
+#endif
+}
+#endif
+
+#if defined(DMTXW_HAVE_AVX2)
+/**
+ * @brief  Check for AVX2 support, including OS support for YMM state
+ * @return DmtxTrue | DmtxFalse
+ */
+static DmtxBoolean
+CpuHasAvx2(void)
+{
+#if defined(__GNUC__)
+   __builtin_cpu_init();
+   return __builtin_cpu_supports("avx2") ? DmtxTrue : DmtxFalse;
+#else
+   int info[4];
+
+   __cpuid(info, 1);
+   if((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0)
+      return DmtxFalse;
+   if((_xgetbv(0) & 0x06) != 0x06)
+      return DmtxFalse;
+
+   __cpuidex(info, 7, 0);
+   return (info[1] & (1 << 5)) ? DmtxTrue : DmtxFalse;
+#endif
+}
+#endif
@@ -0,0 +1,656 @@
+/*
+libdmtxw - Shared native glue for the libdmtx wrappers
+
+Copyright (C) 2026 The libdmtx-wrappers project
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+Contact: mike@dragonflylogic.com
+*/
+
+/* $Id$ */
+
+/**
+ * @file dmtxwdecode.c
+ * @brief Decode loop shared by all wrappers
+ */
+
+/**
+ * @brief  Find and decode every symbol in a caller-owned pixel buffer.
+ *         Previous results are discarded; the new ones are available through
+ *         dmtxwSessionGetResult() and dmtxwSessionGetPayload(), and the
+ *         reason the scan stopped through session->status.
+ * @param  session Session holding the decode options
+ * @param  pxl Top-down pixel rows (not copied)
+ * @param  width Image width in pixels
+ * @param  height Image height in pixels
+ * @param  rowSizeBytes Distance between rows in bytes, 0 for packed rows
+ * @param  format DmtxwFormat value
+ * @return DmtxPass | DmtxFail (bad arguments or out of memory)
+ *
+ * With DmtxwPropLuma set the pixels are first converted to a luminance
+ * plane in session-owned memory (downscaled by the property value), which
+ * libdmtx then scans as a single channel. With DmtxwPropThreads set the
+ * plane is searched as overlapping tiles on a thread pool (see
+ * dmtxwtile.c). With DmtxwPropLocate set the best candidate regions from
+ * dmtxwSessionLocate() are searched first (see dmtxwlocate.c). With
+ * DmtxwPropMinSharpness or DmtxwPropMinEdgeDensity set, blurred or empty
+ * frames are rejected before any search (see dmtxwquality.c). With a
+ * cache attached (dmtxwSessionSetCache()), frames matching a recent one
+ * get its results without a search (see dmtxwcache.c). Result
+ * geometry is always reported in the caller's full-resolution coordinates.
+ */
+extern DmtxPassFail
+dmtxwSessionDecode(DmtxwSession *session, unsigned char *pxl, int width,
+      int height, int rowSizeBytes, int format)
+{
+   return dmtxwSessionDecodeBefore(session, pxl, width, height, rowSizeBytes,
+         format, NULL);
+}
+
+/**
+ * @brief  Like dmtxwSessionDecode(), but finish by an absolute deadline.
+ *         The budget up to the deadline is split between the region search
+ *         (DmtxwPropSearchShare percent of it) and decoding the regions
+ *         found; no new search starts once its share is used up. Symbols
+ *         decoded before the deadline are kept, and session->status tells
+ *         whether the image was exhausted (DmtxwStatusComplete), enough
+ *         symbols were found (DmtxwStatusMaxCount) or time ran out
+ *         (DmtxwStatusTimeout).
+ * @param  session Session holding the decode options
+ * @param  pxl Top-down pixel rows (not copied)
+ * @param  width Image width in pixels
+ * @param  height Image height in pixels
+ * @param  rowSizeBytes Distance between rows in bytes, 0 for packed rows
+ * @param  format DmtxwFormat value
+ * @param  deadline Absolute deadline, or NULL for DmtxwPropTimeout alone
+ * @return DmtxPass | DmtxFail (bad arguments or out of memory)
+ *
+ * When DmtxwPropTimeout is set as well, whichever ends first applies.
+ */
+extern DmtxPassFail
+dmtxwSessionDecodeBefore(DmtxwSession *session, unsigned char *pxl, int width,
+      int height, int rowSizeBytes, int format, DmtxTime *deadline)
+{
+   DmtxwPlane plane;
+   DmtxwCachePrint print;
+   DmtxTime start, end;
+   DmtxPassFail err;
+
+   if(session == NULL)
+      return DmtxFail;
+
+   ResetResults(session);
+   TraceSpan(session, DmtxwSpanDecode, 1, DmtxwOutcomeNone, NULL);
+
+   /* Narrow the options to what recent frames looked like */
+   if(TuneBegin(session) == DmtxFail) {
+      session->status = DmtxwStatusError;
+      FinishDecode(session);
+      return DmtxFail;
+   }
+
+   start = dmtxTimeNow();
+   if(deadline != NULL)
+      end = *deadline;
+   if(session->timeout != DmtxUndefined) {
+      if(deadline == NULL || TimeBefore(dmtxTimeAdd(start, session->timeout), end) == DmtxTrue)
+         end = dmtxTimeAdd(start, session->timeout);
+      deadline = &end;
+   }
+
+   TraceSpan(session, DmtxwSpanPrepare, 1, DmtxwOutcomeNone, NULL);
+   err = PrepareSearchPlane(session, &plane, pxl, width, height, rowSizeBytes, format);
+   TraceSpan(session, DmtxwSpanPrepare, 0,
+         (err == DmtxFail) ? DmtxwOutcomeError : DmtxwOutcomeNone, NULL);
+   if(err == DmtxFail) {
+      session->status = DmtxwStatusError;
+      TuneEnd(session);
+      FinishDecode(session);
+      return DmtxFail;
+   }
+
+   /* A frame seen recently is answered without searching */
+   if(session->cache != NULL) {
+      CachePrint(session, &plane, &print);
+      if(CacheLookup(session, &plane, &print) == DmtxTrue) {
+         TuneEnd(session);
+         FinishDecode(session);
+         return DmtxPass;
+      }
+   }
+
+   err = SearchPlane(session, &plane, start, deadline, pxl, width, height,
+         rowSizeBytes, format);
+
+   if(err == DmtxPass && session->cache != NULL)
+      CacheStore(session, &plane, &print);
+
+   TuneEnd(session);
+   FinishDecode(session);
+
+   return err;
+}
+
+/**
+ * @brief  Close a decode: consume a pending cancel request and report the
+ *         end of the decode span
+ * @param  session Session
+ * @return void
+ */
+static void
+FinishDecode(DmtxwSession *session)
+{
+   session->cancelled = 0;
+   TraceDecodeEnd(session);
+}
+
+/**
+ * @brief  Run the quality gate and the region search over a prepared plane
+ * @param  session Session holding the decode options
+ * @param  plane Plane to search
+ * @param  start Beginning of the time budget
+ * @param  deadline End of the time budget, or NULL for none
+ * @param  pxl Top-down pixel rows as handed to dmtxwSessionDecode()
+ * @param  width Image width in pixels
+ * @param  height Image height in pixels
+ * @param  rowSizeBytes Distance between rows in bytes, 0 for packed rows
+ * @param  format DmtxwFormat value
+ * @return DmtxPass | DmtxFail
+ */
+static DmtxPassFail
+SearchPlane(DmtxwSession *session, DmtxwPlane *plane, DmtxTime start,
+      DmtxTime *deadline, unsigned char *pxl, int width, int height,
+      int rowSizeBytes, int format)
+{
+   DmtxwTile whole;
+   DmtxwScan scan;
+   DmtxTime searchEnd;
+   DmtxwStatus status;
+   DmtxPassFail err;
+
+   /* Frames that cannot hold a readable symbol end here */
+   status = CheckQuality(session, plane);
+   if(status != DmtxwStatusComplete) {
+      session->status = status;
+      return DmtxPass;
+   }
+
+   scan.session = session;
+   scan.plane = plane;
+   scan.deadline = deadline;
+   scan.searchDeadline = NULL;
+   scan.lock = NULL;
+
+   if(deadline != NULL) {
+      searchEnd = SplitBudget(start, *deadline, session->searchShare);
+      scan.searchDeadline = &searchEnd;
+   }
+
+   /* Candidate regions first; the full search only runs if they yield
+    * nothing and there is time left */
+   if(session->locate > 0) {
+      err = DecodeCandidates(&scan, pxl, width, height, rowSizeBytes, format);
+      if(err == DmtxFail) {
+         session->status = DmtxwStatusError;
+         return DmtxFail;
+      }
+      if(session->resultCount > 0 || session->status != DmtxwStatusComplete)
+         return DmtxPass;
+   }
+
+   if(session->threads > 0 && session->edgeMax != DmtxUndefined)
+      return DecodeTiled(&scan);
+
+   whole.x = whole.y = 0;
+   whole.width = plane->width;
+   whole.height = plane->height;
+
+   status = DmtxwStatusComplete;
+   err = DecodeTile(&scan, &whole, &status);
+   session->status = (err == DmtxFail) ? DmtxwStatusError : status;
+
+   return err;
+}
+
+/**
+ * @brief  Describe the pixels libdmtx will search: the caller's buffer, or
+ *         its luminance plane when DmtxwPropLuma is set
+ * @param  session Session (owns the luminance buffer)
+ * @param  plane Receives the description
+ * @param  pxl Top-down pixel rows
+ * @param  width Image width in pixels
+ * @param  height Image height in pixels
+ * @param  rowSizeBytes Distance between rows in bytes, 0 for packed rows
+ * @param  format DmtxwFormat value
+ * @return DmtxPass | DmtxFail
+ */
+static DmtxPassFail
+PrepareSearchPlane(DmtxwSession *session, DmtxwPlane *plane, unsigned char *pxl,
+      int width, int height, int rowSizeBytes, int format)
+{
+   size_t lumaSize;
+   unsigned char *lumaBuf;
+   double timer;
+   DmtxPassFail err;
+
+   plane->bytesPerPixel = dmtxwFormatGetBytesPerPixel(format);
+   if(pxl == NULL || plane->bytesPerPixel == DmtxUndefined || width < 1 || height < 1)
+      return DmtxFail;
+
+   if(rowSizeBytes <= 0)
+      rowSizeBytes = width * plane->bytesPerPixel;
+   else if(rowSizeBytes < width * plane->bytesPerPixel)
+      return DmtxFail;
+
+   if(session->luma == 0) {
+      plane->pxl = pxl;
+      plane->width = width;
+      plane->height = height;
+      plane->rowSizeBytes = rowSizeBytes;
+      plane->format = format;
+      plane->scale = 1;
+      return DmtxPass;
+   }
+
+   plane->width = width / session->luma;
+   plane->height = height / session->luma;
+   if(plane->width < 1 || plane->height < 1)
+      return DmtxFail;
+
+   lumaSize = (size_t)plane->width * plane->height;
+   if(lumaSize > session->lumaCapacity) {
+      lumaBuf = (unsigned char *)realloc(session->lumaBuf, lumaSize);
+      if(lumaBuf == NULL)
+         return DmtxFail;
+      session->lumaBuf = lumaBuf;
+      session->lumaCapacity = lumaSize;
+      DMTXW_STATS_COUNT(DmtxwCounterAllocations, 1);
+   }
+
+   DMTXW_STATS_START(timer);
+   err = dmtxwConvertToLuma(session->lumaBuf, plane->width, pxl, width, height,
+         rowSizeBytes, format, session->luma);
+   DMTXW_STATS_STOP(timer, DmtxwPhaseConvert);
+   if(err == DmtxFail)
+      return DmtxFail;
+   DMTXW_STATS_COUNT(DmtxwCounterBytesConverted, (double)width * height * plane->bytesPerPixel);
+
+   plane->pxl = session->lumaBuf;
+   plane->rowSizeBytes = plane->width;
+   plane->format = DmtxwFormatGray8;
+   plane->bytesPerPixel = 1;
+   plane->scale = session->luma;
+
+   return DmtxPass;
+}
+
+/**
+ * @brief  Search one rectangle of the plane and store what it contains.
+ *         The rectangle is wrapped as its own DmtxImage pointing into the
+ *         shared pixels, so concurrent tiles never copy or modify them.
+ * @param  scan Scan in progress
+ * @param  tile Rectangle of the plane to search
+ * @param  status Updated when the search stops early
+ * @return DmtxPass | DmtxFail (out of memory)
+ */
+static DmtxPassFail
+DecodeTile(DmtxwScan *scan, const DmtxwTile *tile, DmtxwStatus *status)
+{
+   DmtxwSession *session = scan->session;
+   DmtxwPlane *plane = scan->plane;
+   DmtxImage *img;
+   DmtxDecode *dec;
+   DmtxRegion *reg;
+   DmtxMessage *msg;
+   DmtxwResult found;
+   DmtxPassFail err = DmtxPass;
+   double timer;
+
+   DMTXW_STATS_START(timer);
+   img = dmtxwImageCreate(plane->pxl + tile->y * plane->rowSizeBytes +
+         tile->x * plane->bytesPerPixel, tile->width, tile->height,
+         plane->rowSizeBytes, plane->format);
+   if(img == NULL)
+      return DmtxFail;
+
+   dec = dmtxDecodeCreate(img, session->shrink);
+   if(dec == NULL || ApplyDecodeProps(session, dec, plane, tile) == DmtxFail) {
+      if(dec != NULL)
+         dmtxDecodeDestroy(&dec);
+      dmtxImageDestroy(&img);
+      return DmtxFail;
+   }
+   DMTXW_STATS_STOP(timer, DmtxwPhaseSetup);
+   DMTXW_STATS_COUNT(DmtxwCounterAllocations, 2);
+
+   for(;;) {
+      reg = FindNextRegion(scan, tile, dec, status);
+      if(reg == NULL)
+         break;
+
+      /* A region found too late is dropped rather than overrunning */
+      if(scan->deadline != NULL && dmtxTimeExceeded(*scan->deadline)) {
+         dmtxRegionDestroy(&reg);
+         *status = DmtxwStatusTimeout;
+         break;
+      }
+
+      TraceSpan(session, DmtxwSpanRegion, 1, DmtxwOutcomeNone, NULL);
+      DMTXW_STATS_START(timer);
+      msg = (session->mosaic == DmtxTrue) ?
+            dmtxDecodeMosaicRegion(dec, reg, session->corrections) :
+            dmtxDecodeMatrixRegion(dec, reg, session->corrections);
+      DMTXW_STATS_STOP(timer, DmtxwPhaseDecode);
+
+      if(msg != NULL || session->traceFunc != NULL) {
+         memset(&found, 0x00, sizeof(DmtxwResult));
+         StoreGeometry(&found, reg, session->shrink, plane, tile);
+         found.sizeIdx = reg->sizeIdx;
+      }
+      TraceSpan(session, DmtxwSpanRegion, 0,
+            (msg != NULL) ? DmtxwOutcomeFound : DmtxwOutcomeMissed, &found);
+
+      if(msg != NULL) {
+         DMTXW_STATS_COUNT(DmtxwCounterRegionsDecoded, 1);
+         DMTXW_STATS_COUNT(DmtxwCounterAllocations, 1);
+         found.padCount = msg->padCount;
+         found.contrast = abs(reg->onColor - reg->offColor);
+
+         err = AddResult(scan, &found, msg->output, (size_t)msg->outputIdx);
+         dmtxMessageDestroy(&msg);
+      }
+
+      dmtxRegionDestroy(&reg);
+
+      if(err == DmtxFail)
+         break;
+
+      if(session->halted) {
+         *status = DmtxwStatusMaxCount;
+         break;
+      }
+   }
+
+   dmtxDecodeDestroy(&dec);
+   dmtxImageDestroy(&img);
+
+   return err;
+}
+
+/**
+ * @brief  Store a decoded symbol unless an overlapping tile already did
+ * @param  scan Scan in progress (its lock is held while results change)
+ * @param  found Geometry of the symbol
+ * @param  payload Decoded bytes
+ * @param  length Number of decoded bytes
+ * @return DmtxPass | DmtxFail (out of memory)
+ */
+static DmtxPassFail
+AddResult(DmtxwScan *scan, const DmtxwResult *found, const unsigned char *payload,
+      size_t length)
+{
+   DmtxwSession *session = scan->session;
+   DmtxwResult *result;
+   DmtxPassFail err = DmtxPass;
+   int outcome = DmtxwOutcomeDropped;
+   double timer;
+
+   TraceSpan(session, DmtxwSpanMarshal, 1, DmtxwOutcomeNone, NULL);
+   DMTXW_STATS_START(timer);
+   MutexLock(scan->lock);
+
+   /* Another tile may have reached DmtxwPropMaxCount since this one looked */
+   if(session->halted) {
+      MutexUnlock(scan->lock);
+      DMTXW_STATS_STOP(timer, DmtxwPhaseMarshal);
+      TraceSpan(session, DmtxwSpanMarshal, 0, DmtxwOutcomeDropped, found);
+      return DmtxPass;
+   }
+
+   if(scan->lock == NULL || IsDuplicate(session, found, payload, length) == DmtxFalse) {
+      outcome = DmtxwOutcomeFound;
+      result = AppendResult(session, payload, length);
+      if(result != NULL) {
+         memcpy(result->corner, found->corner, sizeof(found->corner));
+         result->angle = found->angle;
+         result->sizeIdx = found->sizeIdx;
+         result->padCount = found->padCount;
+         result->contrast = found->contrast;
+         result->sharpness = session->sharpness;
+         result->edgeDensity = session->edgeDensity;
+      }
+      else {
+         err = DmtxFail;
+         outcome = DmtxwOutcomeError;
+      }
+
+      if(session->maxCount != DmtxUndefined && session->resultCount >= session->maxCount)
+         session->halted = 1;
+   }
+
+   MutexUnlock(scan->lock);
+   DMTXW_STATS_STOP(timer, DmtxwPhaseMarshal);
+   TraceSpan(session, DmtxwSpanMarshal, 0, outcome, found);
+
+   return err;
+}
+
+/**
+ * @brief  Transfer the session options to a new decode struct. Pixel-valued
+ *         options are given at full resolution and are divided by the plane
+ *         scale; region bounds are also clipped to the tile (libdmtx counts
+ *         rows from the bottom of the image).
+ * @param  session Session
+ * @param  dec Decode struct
+ * @param  plane Plane being searched
+ * @param  tile Rectangle of the plane wrapped by dec
+ * @return DmtxPass | DmtxFail
+ */
+static DmtxPassFail
+ApplyDecodeProps(DmtxwSession *session, DmtxDecode *dec, const DmtxwPlane *plane,
+      const DmtxwTile *tile)
+{
+   int i, value, offset, limit;
+   struct { int prop; int value; } props[10];
+
+   props[0].prop = DmtxPropEdgeMin;     props[0].value = session->edgeMin;
+   props[1].prop = DmtxPropEdgeMax;     props[1].value = session->edgeMax;
+   props[2].prop = DmtxPropScanGap;     props[2].value = session->scanGap;
+   props[3].prop = DmtxPropSquareDevn;  props[3].value = session->squareDevn;
+   props[4].prop = DmtxPropSymbolSize;  props[4].value = session->sizeIdxExpected;
+   props[5].prop = DmtxPropEdgeThresh;  props[5].value = session->edgeThresh;
+   props[6].prop = DmtxPropXmin;        props[6].value = session->xMin;
+   props[7].prop = DmtxPropXmax;        props[7].value = session->xMax;
+   props[8].prop = DmtxPropYmin;        props[8].value = session->yMin;
+   props[9].prop = DmtxPropYmax;        props[9].value = session->yMax;
+
+   for(i = 0; i < 10; i++) {
+      if(props[i].value == DmtxUndefined)
+         continue;
+      value = props[i].value;
+
+      switch(props[i].prop) {
+         case DmtxPropSquareDevn:
+         case DmtxPropSymbolSize:
+         case DmtxPropEdgeThresh:
+            break;
+         case DmtxPropXmin:
+         case DmtxPropXmax:
+         case DmtxPropYmin:
+         case DmtxPropYmax:
+            if(props[i].prop == DmtxPropXmin || props[i].prop == DmtxPropXmax) {
+               offset = tile->x;
+               limit = tile->width - 1;
+            }
+            else {
+               offset = plane->height - tile->y - tile->height;
+               limit = tile->height - 1;
+            }
+            value = value / plane->scale - offset;
+            value = (value < 0) ? 0 : (value > limit) ? limit : value;
+            break;
+         default:
+            value = (value / plane->scale > 0) ? value / plane->scale : 1;
+            break;
+      }
+
+      if(dmtxDecodeSetProp(dec, props[i].prop, value) == DmtxFail)
+         return DmtxFail;
+   }
+
+   return DmtxPass;
+}
+
+/**
+ * @brief  Find the next region, in short slices so cancellation is noticed.
+ *         dmtxRegionFindNext() returns NULL both when the scan is finished
+ *         and when it runs out of time; a NULL before the slice expired can
+ *         only mean the former.
+ * @param  scan Scan in progress (searchDeadline applies)
+ * @param  tile Rectangle of the plane wrapped by dec
+ * @param  dec Decode struct
+ * @param  status Receives the reason when NULL is returned
+ * @return Next region, or NULL when the search stopped
+ */
+static DmtxRegion *
+FindNextRegion(DmtxwScan *scan, const DmtxwTile *tile, DmtxDecode *dec,
+      DmtxwStatus *status)
+{
+   DmtxwSession *session = scan->session;
+   DmtxTime *deadline = scan->searchDeadline;
+   DmtxwResult found;
+   DmtxRegion *reg;
+   DmtxTime slice;
+   double timer;
+
+   for(;;) {
+      if(session->cancelled) {
+         *status = DmtxwStatusCancelled;
+         return NULL;
+      }
+
+      if(session->halted) {
+         *status = DmtxwStatusMaxCount;
+         return NULL;
+      }
+
+      slice = dmtxTimeAdd(dmtxTimeNow(), DMTXW_SEARCH_SLICE_MSEC);
+      if(deadline != NULL && TimeBefore(*deadline, slice) == DmtxTrue)
+         slice = *deadline;
+
+      TraceSpan(session, DmtxwSpanSearch, 1, DmtxwOutcomeNone, NULL);
+      DMTXW_STATS_START(timer);
+      reg = dmtxRegionFindNext(dec, &slice);
+      DMTXW_STATS_STOP(timer, DmtxwPhaseSearch);
+      if(reg != NULL) {
+         DMTXW_STATS_COUNT(DmtxwCounterRegionsTried, 1);
+         DMTXW_STATS_COUNT(DmtxwCounterAllocations, 1);
+         if(session->traceFunc != NULL) {
+            StoreGeometry(&found, reg, session->shrink, scan->plane, tile);
+            found.sizeIdx = reg->sizeIdx;
+            TraceSpan(session, DmtxwSpanSearch, 0, DmtxwOutcomeFound, &found);
+         }
+         return reg;
+      }
+
+      if(!dmtxTimeExceeded(slice)) {
+         TraceSpan(session, DmtxwSpanSearch, 0, DmtxwOutcomeMissed, NULL);
+         return NULL;
+      }
+      TraceSpan(session, DmtxwSpanSearch, 0, DmtxwOutcomeSlice, NULL);
+
+      if(deadline != NULL && dmtxTimeExceeded(*deadline)) {
+         *status = DmtxwStatusTimeout;
+         return NULL;
+      }
+   }
+}
+
+/**
+ * @brief  Find the end of the region search within a time budget
+ * @param  start Beginning of the budget
+ * @param  deadline End of the budget
+ * @param  share Percent of the budget given to the region search
+ * @return Time after which no new region search starts
+ */
+static DmtxTime
+SplitBudget(DmtxTime start, DmtxTime deadline, int share)
+{
+   long budget;
+
+   if(TimeBefore(start, deadline) == DmtxFalse)
+      return deadline;
+
+   budget = (long)(deadline.sec - start.sec) * 1000 +
+         ((long)deadline.usec - (long)start.usec) / 1000;
+
+   return dmtxTimeAdd(start, budget * share / 100);
+}
+
+/**
+ * @brief  Compare two times
+ * @param  t0 First time
+ * @param  t1 Second time
+ * @return DmtxTrue if t0 is earlier than t1
+ */
+static DmtxBoolean
+TimeBefore(DmtxTime t0, DmtxTime t1)
+{
+   if(t0.sec != t1.sec)
+      return (t0.sec < t1.sec) ? DmtxTrue : DmtxFalse;
+
+   return (t0.usec < t1.usec) ? DmtxTrue : DmtxFalse;
+}
+
+/**
+ * @brief  Store corners and rotation of a region in a result. Corners are
+ *         moved from tile to plane coordinates, scaled back to the caller's
+ *         full resolution and flipped to top-down rows.
+ * @param  result Result to update
+ * @param  reg Decoded region
+ * @param  shrink Scale factor the region was found at
+ * @param  plane Plane that was searched
+ * @param  tile Rectangle of the plane the region was found in
+ * @return void
+ */
+static void
+StoreGeometry(DmtxwResult *result, DmtxRegion *reg, int shrink,
+      const DmtxwPlane *plane, const DmtxwTile *tile)
+{
+   int i, scale, bottom;
+   double rotate;
+   DmtxVector2 p[4];
+
+   scale = plane->scale;
+   bottom = (tile->y + tile->height) * scale;
+
+   p[0].X = p[0].Y = p[1].Y = p[3].X = 0.0;
+   p[1].X = p[2].X = p[2].Y = p[3].Y = 1.0;
+
+   for(i = 0; i < 4; i++) {
+      dmtxMatrix3VMultiplyBy(&p[i], reg->fit2raw);
+      result->corner[i].X = tile->x * scale + (int)((scale * shrink * p[i].X) + 0.5);
+      result->corner[i].Y = bottom - 1 - (int)((scale * shrink * p[i].Y) + 0.5);
+   }
+
+   rotate = (2 * M_PI) + (atan2(reg->fit2raw[0][1], reg->fit2raw[1][1]) -
+         atan2(reg->fit2raw[1][0], reg->fit2raw[0][0])) / 2.0;
+   rotate = rotate * 180.0 / M_PI;
+   if(rotate >= 360.0)
+      rotate -= 360.0;
+
+   result->angle = (int)(rotate + 0.5) % 360;
+}
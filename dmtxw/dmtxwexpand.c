@@ -0,0 +1,453 @@
+/*
+libdmtxw - Shared native glue for the libdmtx wrappers
+
+Copyright (C) 2026 The libdmtx-wrappers project
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+Contact: mike@dragonflylogic.com
+*/
+
+/* $Id$ */
+
+/**
+ * @file dmtxwexpand.c
+ * @brief Encoder output expanded straight into the wrapper's pixel buffer
+ *
+ * libdmtx renders an encoded symbol at DmtxPropModuleSize into an image of
+ * its own, which every wrapper then copies (and often converts) once more.
+ * dmtxwEncodeDataMatrix() lets libdmtx render at module size 1 without a
+ * quiet zone instead, keeping the requested module and margin size on the
+ * encoder, and dmtxwEncodeExpand() writes the final pixels into the
+ * caller's buffer in its format and row stride. Each module row is drawn
+ * once as runs of light and dark pixels and repeated by copying the row
+ * just written, so every destination byte is written once and nothing
+ * the size of the final image is allocated. Light pixels are all 0xff
+ * bytes and dark ones 0x00 bytes except for the padding byte of 32-bit
+ * formats, which stays 0xff (opaque where it holds alpha); dark runs of
+ * those formats are filled by an SSE2, AVX2 or NEON kernel chosen like
+ * the conversion kernels.
+ */
+
+/**
+ * @brief  Encode a message at module size 1, keeping the requested module
+ *         and margin size for dmtxwEncodeExpand()
+ * @param  enc Encoder with its properties set, new or used before
+ * @param  inputSize Length of inputString
+ * @param  inputString Message
+ * @return DmtxPass | DmtxFail
+ */
+extern DmtxPassFail
+dmtxwEncodeDataMatrix(DmtxEncode *enc, int inputSize, const unsigned char *inputString)
+{
+   int moduleSize, marginSize;
+   DmtxPassFail err;
+
+   if(enc == NULL || inputString == NULL)
+      return DmtxFail;
+
+   /* libdmtx allocates a new message and image on every encode without
+    * freeing the previous ones, so drop those and the encoder can be
+    * reused for any number of messages */
+   if(enc->image != NULL) {
+      free(enc->image->pxl);
+      dmtxImageDestroy(&(enc->image));
+   }
+   if(enc->message != NULL)
+      dmtxMessageDestroy(&(enc->message));
+
+   moduleSize = dmtxEncodeGetProp(enc, DmtxPropModuleSize);
+   marginSize = dmtxEncodeGetProp(enc, DmtxPropMarginSize);
+
+   dmtxEncodeSetProp(enc, DmtxPropModuleSize, 1);
+   dmtxEncodeSetProp(enc, DmtxPropMarginSize, 0);
+
+   err = dmtxEncodeDataMatrix(enc, inputSize, (unsigned char *)inputString);
+
+   dmtxEncodeSetProp(enc, DmtxPropModuleSize, moduleSize);
+   dmtxEncodeSetProp(enc, DmtxPropMarginSize, marginSize);
+
+   return err;
+}
+
+/**
+ * @brief  Size of the image dmtxwEncodeExpand() writes
+ * @param  enc Encoder after a successful encode
+ * @param  width Receives the width in pixels
+ * @param  height Receives the height in pixels
+ * @return DmtxPass | DmtxFail
+ */
+extern DmtxPassFail
+dmtxwEncodeGetSize(const DmtxEncode *enc, int *width, int *height)
+{
+   const DmtxwSymbolInfo *info;
+
+   if(enc == NULL || enc->message == NULL || width == NULL || height == NULL)
+      return DmtxFail;
+
+   info = dmtxwSymbolInfo(enc->region.sizeIdx);
+   if(info == NULL || enc->moduleSize < 1 || enc->marginSize < 0 ||
+         enc->moduleSize > DMTXW_EXPAND_MAX_MODULE || enc->marginSize > DMTXW_EXPAND_MAX_MARGIN)
+      return DmtxFail;
+
+   *width = info->cols * enc->moduleSize + 2 * enc->marginSize;
+   *height = info->rows * enc->moduleSize + 2 * enc->marginSize;
+
+   return DmtxPass;
+}
+
+/**
+ * @brief  Write the whole encoded image into a caller's buffer
+ * @param  enc Encoder after a successful encode
+ * @param  pxl Top row of the destination
+ * @param  rowSizeBytes Distance between rows in bytes, 0 for packed rows
+ * @param  format DmtxwFormat value, including DmtxwFormatMono1
+ * @return DmtxPass | DmtxFail
+ */
+extern DmtxPassFail
+dmtxwEncodeExpand(DmtxEncode *enc, unsigned char *pxl, int rowSizeBytes, int format)
+{
+   int width, height;
+
+   if(dmtxwEncodeGetSize(enc, &width, &height) == DmtxFail)
+      return DmtxFail;
+
+   return dmtxwEncodeExpandRows(enc, 0, height, pxl, rowSizeBytes, format);
+}
+
+/**
+ * @brief  Write some rows of the encoded image into a caller's buffer, e.g.
+ *         to hand it over in strips
+ * @param  enc Encoder after a successful encode
+ * @param  firstRow First image row to write, counted from the top
+ * @param  rowCount Rows to write
+ * @param  pxl Destination of image row firstRow
+ * @param  rowSizeBytes Distance between rows in bytes, 0 for packed rows
+ * @param  format DmtxwFormat value, including DmtxwFormatMono1
+ * @return DmtxPass | DmtxFail
+ */
+extern DmtxPassFail
+dmtxwEncodeExpandRows(DmtxEncode *enc, int firstRow, int rowCount, unsigned char *pxl,
+      int rowSizeBytes, int format)
+{
+   const DmtxwSymbolInfo *info;
+   ExpandFillFunc fill;
+   unsigned char *row;
+   int width, height, rowBytes, moduleSize, margin, y, symbolRow, inMargin;
+
+   if(dmtxwEncodeGetSize(enc, &width, &height) == DmtxFail || pxl == NULL ||
+         firstRow < 0 || rowCount < 0 || firstRow + rowCount > height)
+      return DmtxFail;
+
+   rowBytes = ExpandRowBytes(width, format);
+   if(rowBytes == DmtxUndefined || (rowSizeBytes != 0 && rowSizeBytes < rowBytes))
+      return DmtxFail;
+   if(rowSizeBytes == 0)
+      rowSizeBytes = rowBytes;
+
+   info = dmtxwSymbolInfo(enc->region.sizeIdx);
+   moduleSize = enc->moduleSize;
+   margin = enc->marginSize;
+   fill = GetExpandFill();
+
+   for(y = firstRow; y < firstRow + rowCount; y++) {
+      row = pxl + (size_t)(y - firstRow) * rowSizeBytes;
+
+      inMargin = (y < margin || y >= height - margin) ? 1 : 0;
+
+      /* Rows repeating the one above are copied from the destination */
+      if(y > firstRow && ((inMargin && y != height - margin) ||
+            (!inMargin && (y - margin) % moduleSize != 0))) {
+         memcpy(row, row - rowSizeBytes, (size_t)rowBytes);
+         continue;
+      }
+
+      if(inMargin) {
+         ExpandFill(row, 0, width, 0, format, fill);
+         continue;
+      }
+
+      symbolRow = (y - margin) / moduleSize;
+      ExpandModuleRow(enc, info, symbolRow, row, width, format, fill);
+   }
+
+   return DmtxPass;
+}
+
+/**
+ * @brief  Bytes of a packed destination row
+ * @param  width Pixels in row
+ * @param  format DmtxwFormat value
+ * @return Byte count, or DmtxUndefined for unknown formats
+ */
+static int
+ExpandRowBytes(int width, int format)
+{
+   int bytesPerPixel;
+
+   if(format == DmtxwFormatMono1)
+      return (width + 7) / 8;
+
+   bytesPerPixel = dmtxwFormatGetBytesPerPixel(format);
+
+   return (bytesPerPixel == DmtxUndefined) ? DmtxUndefined : width * bytesPerPixel;
+}
+
+/**
+ * @brief  Draw one module row of the symbol with its quiet zone
+ * @param  enc Encoder after a successful encode
+ * @param  info Attributes of the encoded size
+ * @param  symbolRow Module row, counted from the top
+ * @param  row Destination row
+ * @param  width Pixels in row
+ * @param  format DmtxwFormat value
+ * @param  fill Dark pixel kernel for 32-bit formats
+ * @return void
+ */
+static void
+ExpandModuleRow(DmtxEncode *enc, const DmtxwSymbolInfo *info, int symbolRow,
+      unsigned char *row, int width, int format, ExpandFillFunc fill)
+{
+   int col, run, dark, nextDark, x;
+
+   x = enc->marginSize;
+   if(x > 0)
+      ExpandFill(row, 0, x, 0, format, fill);
+
+   /* libdmtx counts symbol rows from the bottom */
+   symbolRow = info->rows - 1 - symbolRow;
+   dark = ExpandModuleDark(enc, symbolRow, 0);
+
+   for(col = 0; col < info->cols; col += run) {
+      nextDark = dark;
+      for(run = 1; col + run < info->cols; run++) {
+         nextDark = ExpandModuleDark(enc, symbolRow, col + run);
+         if(nextDark != dark)
+            break;
+      }
+
+      ExpandFill(row, x, run * enc->moduleSize, dark, format, fill);
+      x += run * enc->moduleSize;
+      dark = nextDark;
+   }
+
+   if(x < width)
+      ExpandFill(row, x, width - x, 0, format, fill);
+}
+
+/**
+ * @brief  Whether a module is dark
+ * @param  enc Encoder after a successful encode
+ * @param  symbolRow Module row, counted from the bottom as in libdmtx
+ * @param  col Module column
+ * @return 1 if dark, 0 if light
+ */
+static int
+ExpandModuleDark(DmtxEncode *enc, int symbolRow, int col)
+{
+   int status;
+
+   status = dmtxSymbolModuleStatus(enc->message, enc->region.sizeIdx, symbolRow, col);
+
+   return (status & DmtxModuleOnRGB) ? 1 : 0;
+}
+
+/**
+ * @brief  Fill a run of pixels with one color
+ * @param  row Destination row
+ * @param  x First pixel
+ * @param  count Pixels in run
+ * @param  dark 1 for dark, 0 for light
+ * @param  format DmtxwFormat value
+ * @param  fill Dark pixel kernel for 32-bit formats
+ * @return void
+ */
+static void
+ExpandFill(unsigned char *row, int x, int count, int dark, int format, ExpandFillFunc fill)
+{
+   int bytesPerPixel, first, last;
+   unsigned char pixel[4];
+
+   if(count < 1)
+      return;
+
+   if(format == DmtxwFormatMono1) {
+      /* Runs arrive left to right, so clearing the rest of each byte
+       * before setting bits leaves the padding bits light */
+      first = x / 8;
+      last = (x + count - 1) / 8;
+      if((x & 7) == 0)
+         row[first] = 0x00;
+      if(last > first)
+         memset(row + first + 1, 0x00, (size_t)(last - first));
+      if(dark)
+         SheetSetBits(row, x, count);
+      return;
+   }
+
+   bytesPerPixel = dmtxwFormatGetBytesPerPixel(format);
+   if(!dark || bytesPerPixel < 4) {
+      memset(row + x * bytesPerPixel, dark ? 0x00 : 0xff, (size_t)count * bytesPerPixel);
+      return;
+   }
+
+   ExpandDarkPixel(format, pixel);
+   fill(row + x * 4, pixel, count);
+}
+
+/**
+ * @brief  Bytes of a dark 32-bit pixel: black with an opaque padding byte
+ * @param  format 32-bit DmtxwFormat value
+ * @param  pixel Receives 4 bytes
+ * @return void
+ */
+static void
+ExpandDarkPixel(int format, unsigned char pixel[4])
+{
+   unsigned int value = 0xff000000;
+
+   switch(format) {
+      case DmtxwFormatRGBX32:
+      case DmtxwFormatBGRX32:
+         pixel[0] = pixel[1] = pixel[2] = 0x00;
+         pixel[3] = 0xff;
+         break;
+      case DmtxwFormatXRGB32:
+      case DmtxwFormatXBGR32:
+         pixel[0] = 0xff;
+         pixel[1] = pixel[2] = pixel[3] = 0x00;
+         break;
+      default:
+         /* DmtxwFormatInt32RGB: 0xff000000 in host byte order */
+         memcpy(pixel, &value, 4);
+         break;
+   }
+}
+
+/**
+ * @brief  Fill kernel in use, following the conversion kernel choice
+ * @return Fill function
+ */
+static ExpandFillFunc
+GetExpandFill(void)
+{
+   (void)GetRowFunc();
+
+#if defined(DMTXW_HAVE_AVX2)
+   if(activeKernel == DmtxwKernelAvx2)
+      return ExpandFillAvx2;
+#endif
+#if defined(DMTXW_HAVE_SSE2)
+   if(activeKernel == DmtxwKernelSse2 || activeKernel == DmtxwKernelAvx2)
+      return ExpandFillSse2;
+#endif
+#if defined(DMTXW_HAVE_NEON)
+   if(activeKernel == DmtxwKernelNeon)
+      return ExpandFillNeon;
+#endif
+
+   return ExpandFillScalar;
+}
+
+/**
+ * @brief  Portable fill kernel: repeat a 4-byte pixel
+ * @param  dst First pixel
+ * @param  pixel Pixel bytes
+ * @param  count Pixels to write
+ * @return void
+ */
+static void
+ExpandFillScalar(unsigned char *dst, const unsigned char pixel[4], int count)
+{
+   int i;
+
+   for(i = 0; i < count; i++, dst += 4) {
+      dst[0] = pixel[0];
+      dst[1] = pixel[1];
+      dst[2] = pixel[2];
+      dst[3] = pixel[3];
+   }
+}
+
+#if defined(DMTXW_HAVE_SSE2)
+/**
+ * @brief  SSE2 fill kernel, 4 pixels per store
+ * @param  dst First pixel
+ * @param  pixel Pixel bytes
+ * @param  count Pixels to write
+ * @return void
+ */
+DMTXW_TARGET_SSE2 static void
+ExpandFillSse2(unsigned char *dst, const unsigned char pixel[4], int count)
+{
+   int i;
+   __m128i v;
+
+   v = _mm_set1_epi32(LoadUnaligned32(pixel));
+
+   for(i = 0; i + 4 <= count; i += 4)
+      _mm_storeu_si128((__m128i *)(dst + i * 4), v);
+
+   ExpandFillScalar(dst + i * 4, pixel, count - i);
+}
+#endif
+
+#if defined(DMTXW_HAVE_AVX2)
+/**
+ * @brief  AVX2 fill kernel, 8 pixels per store
+ * @param  dst First pixel
+ * @param  pixel Pixel bytes
+ * @param  count Pixels to write
+ * @return void
+ */
+DMTXW_TARGET_AVX2 static void
+ExpandFillAvx2(unsigned char *dst, const unsigned char pixel[4], int count)
+{
+   int i;
+   __m256i v;
+
+   v = _mm256_set1_epi32(LoadUnaligned32(pixel));
+
+   for(i = 0; i + 8 <= count; i += 8)
+      _mm256_storeu_si256((__m256i *)(dst + i * 4), v);
+
+   ExpandFillScalar(dst + i * 4, pixel, count - i);
+}
+#endif
+
+#if defined(DMTXW_HAVE_NEON)
+/**
+ * @brief  NEON fill kernel, 4 pixels per store
+ * @param  dst First pixel
+ * @param  pixel Pixel bytes
+ * @param  count Pixels to write
+ * @return void
+ */
+static void
+ExpandFillNeon(unsigned char *dst, const unsigned char pixel[4], int count)
+{
+   int i;
+   uint32_t value;
+   uint8x16_t v;
+
+   memcpy(&value, pixel, 4);
+   v = vreinterpretq_u8_u32(vdupq_n_u32(value));
+
+   for(i = 0; i + 4 <= count; i += 4)
+      vst1q_u8(dst + i * 4, v);
+
+   ExpandFillScalar(dst + i * 4, pixel, count - i);
+}
+#endif
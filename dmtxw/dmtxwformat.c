@@ -0,0 +1,122 @@
+/*
+libdmtxw - Shared native glue for the libdmtx wrappers
+
+Copyright (C) 2026 The libdmtx-wrappers project
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+Contact: mike@dragonflylogic.com
+*/
+
+/* $Id$ */
+
+/**
+ * @file dmtxwformat.c
+ * @brief Pixel-format adapters
+ */
+
+/**
+ * @brief  Map a wrapper pixel format onto a libdmtx packing order
+ * @param  format DmtxwFormat value
+ * @return DmtxPack* value, or DmtxUndefined for unknown formats
+ */
+extern int
+dmtxwFormatGetPack(int format)
+{
+   unsigned int one = 1;
+   DmtxBoolean littleEndian = (*(unsigned char *)&one == 1) ? DmtxTrue : DmtxFalse;
+
+   switch(format) {
+      case DmtxwFormatGray8:
+         return DmtxPack8bppK;
+      case DmtxwFormatRGB24:
+         return DmtxPack24bppRGB;
+      case DmtxwFormatBGR24:
+         return DmtxPack24bppBGR;
+      case DmtxwFormatRGBX32:
+         return DmtxPack32bppRGBX;
+      case DmtxwFormatBGRX32:
+         return DmtxPack32bppBGRX;
+      case DmtxwFormatXRGB32:
+         return DmtxPack32bppXRGB;
+      case DmtxwFormatXBGR32:
+         return DmtxPack32bppXBGR;
+      case DmtxwFormatInt32RGB:
+         return (littleEndian == DmtxTrue) ? DmtxPack32bppBGRX : DmtxPack32bppXRGB;
+   }
+
+   return DmtxUndefined;
+}
+
+/**
+ * @brief  Bytes used by one pixel of a wrapper pixel format
+ * @param  format DmtxwFormat value
+ * @return Bytes per pixel, or DmtxUndefined for unknown formats
+ */
+extern int
+dmtxwFormatGetBytesPerPixel(int format)
+{
+   switch(format) {
+      case DmtxwFormatGray8:
+         return 1;
+      case DmtxwFormatRGB24:
+      case DmtxwFormatBGR24:
+         return 3;
+      case DmtxwFormatRGBX32:
+      case DmtxwFormatBGRX32:
+      case DmtxwFormatXRGB32:
+      case DmtxwFormatXBGR32:
+      case DmtxwFormatInt32RGB:
+         return 4;
+   }
+
+   return DmtxUndefined;
+}
+
+/**
+ * @brief  Wrap caller-owned pixels in a DmtxImage without copying them
+ * @param  pxl Top-down pixel rows
+ * @param  width Image width in pixels
+ * @param  height Image height in pixels
+ * @param  rowSizeBytes Distance between rows in bytes, 0 for packed rows
+ * @param  format DmtxwFormat value
+ * @return Address of new image, or NULL on failure
+ */
+extern DmtxImage *
+dmtxwImageCreate(unsigned char *pxl, int width, int height, int rowSizeBytes, int format)
+{
+   DmtxImage *img;
+   int pack, bytesPerPixel, rowPadBytes;
+
+   pack = dmtxwFormatGetPack(format);
+   bytesPerPixel = dmtxwFormatGetBytesPerPixel(format);
+   if(pxl == NULL || pack == DmtxUndefined || width < 1 || height < 1)
+      return NULL;
+
+   rowPadBytes = (rowSizeBytes > 0) ? rowSizeBytes - width * bytesPerPixel : 0;
+   if(rowPadBytes < 0)
+      return NULL;
+
+   img = dmtxImageCreate(pxl, width, height, pack);
+   if(img == NULL)
+      return NULL;
+
+   if(rowPadBytes > 0 && dmtxImageSetProp(img, DmtxPropRowPadBytes, rowPadBytes) == DmtxFail) {
+      dmtxImageDestroy(&img);
+      return NULL;
+   }
+
+   return img;
+}
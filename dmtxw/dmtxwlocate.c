@@ -0,0 +1,644 @@
+/*
+libdmtxw - Shared native glue for the libdmtx wrappers
+
+Copyright (C) 2026 The libdmtx-wrappers project
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+Contact: mike@dragonflylogic.com
+*/
+
+/* $Id$ */
+
+/**
+ * @file dmtxwlocate.c
+ * @brief Coarse pre-pass proposing regions worth handing to libdmtx
+ *
+ * dmtxRegionFindNext() follows every edge it meets, so on large frames it
+ * spends most of its time on background. The locator instead looks at the
+ * image once at 1/DMTXW_LOCATE_SCALE size and builds, for every cell of
+ * DMTXW_LOCATE_CELL x DMTXW_LOCATE_CELL pixels, a histogram of gradient
+ * energy over eight orientations (0 to 157.5 degrees).
+ *
+ * A Data Matrix symbol is a dense grid of modules, so its cells carry far
+ * more edge energy than background and spread it over several
+ * orientations. Rules, block outlines and rows of text strokes are mostly
+ * parallel edges. Writing each bin as an angle phi, parallel edges make
+ * the histogram coherent in 2 * phi, so a cell scores its energy times
+ * (1 - R2), where R2 is the length of the mean resultant vector at
+ * 2 * phi. Neighbouring cells that score are merged into candidate boxes,
+ * squat boxes are preferred to elongated ones, and upright boxes (judged
+ * by the resultant at 4 * phi) whose outline shows a solid "L" side next
+ * to an alternating (timing pattern) side get a bonus. The best boxes are
+ * then searched as tiles in place of the whole image.
+ */
+
+/**
+ * @brief  Propose boxes likely to contain a symbol, best first. This is the
+ *         pre-pass used by DmtxwPropLocate, exposed for callers that want to
+ *         combine it with their own ROI finder.
+ * @param  session Session (owns the scratch buffers)
+ * @param  pxl Top-down pixel rows (not copied)
+ * @param  width Image width in pixels
+ * @param  height Image height in pixels
+ * @param  rowSizeBytes Distance between rows in bytes, 0 for packed rows
+ * @param  format DmtxwFormat value
+ * @param  box Receives up to maxBoxes boxes in top-down image coordinates
+ * @param  maxBoxes Capacity of box
+ * @return Number of boxes stored, or DmtxUndefined on bad arguments or
+ *         out of memory
+ */
+extern int
+dmtxwSessionLocate(DmtxwSession *session, unsigned char *pxl, int width,
+      int height, int rowSizeBytes, int format, DmtxwBox *box, int maxBoxes)
+{
+   int lw, lh, stride, cols, rows;
+   size_t size;
+   unsigned char *buf;
+   DmtxwCell *cell;
+
+   if(session == NULL || pxl == NULL || box == NULL || maxBoxes < 1 ||
+         dmtxwFormatGetBytesPerPixel(format) == DmtxUndefined)
+      return DmtxUndefined;
+
+   lw = width / DMTXW_LOCATE_SCALE;
+   lh = height / DMTXW_LOCATE_SCALE;
+   cols = lw / DMTXW_LOCATE_CELL;
+   rows = lh / DMTXW_LOCATE_CELL;
+   if(cols < 1 || rows < 1)
+      return 0;
+
+   /* One spare column on each side lets the row kernels read x-1 and x+1
+    * without bounds checks */
+   stride = lw + 2;
+   size = (size_t)stride * lh;
+   if(size > session->locateCapacity) {
+      buf = (unsigned char *)realloc(session->locateBuf, size);
+      if(buf == NULL)
+         return DmtxUndefined;
+      session->locateBuf = buf;
+      session->locateCapacity = size;
+   }
+
+   size = (size_t)cols * rows;
+   if(size > session->cellCapacity) {
+      cell = (DmtxwCell *)realloc(session->cellBuf, size * sizeof(DmtxwCell));
+      if(cell == NULL)
+         return DmtxUndefined;
+      session->cellBuf = cell;
+      session->cellCapacity = size;
+   }
+
+   if(dmtxwConvertToLuma(session->locateBuf + 1, stride, pxl, width, height,
+         rowSizeBytes, format, DMTXW_LOCATE_SCALE) == DmtxFail)
+      return DmtxUndefined;
+
+   MeasureCells(session->locateBuf + 1, stride, lw, lh, session->cellBuf, cols, rows);
+   ScoreCells(session->cellBuf, cols, rows);
+
+   return GroupCells(session->locateBuf + 1, stride, session->cellBuf, cols, rows,
+         width, height, box, maxBoxes);
+}
+
+/**
+ * @brief  Search the best candidate boxes as tiles
+ * @param  scan Scan in progress
+ * @param  pxl Top-down pixel rows as passed to dmtxwSessionDecode()
+ * @param  width Image width in pixels
+ * @param  height Image height in pixels
+ * @param  rowSizeBytes Distance between rows in bytes, 0 for packed rows
+ * @param  format DmtxwFormat value
+ * @return DmtxPass | DmtxFail
+ */
+static DmtxPassFail
+DecodeCandidates(DmtxwScan *scan, unsigned char *pxl, int width, int height,
+      int rowSizeBytes, int format)
+{
+   DmtxwSession *session = scan->session;
+   DmtxwPlane *plane = scan->plane;
+   DmtxwBox box[DMTXW_LOCATE_MAX_CANDIDATES];
+   DmtxwTile tile[DMTXW_LOCATE_MAX_CANDIDATES];
+   int i, count, tileCount, x1, y1;
+
+   count = dmtxwSessionLocate(session, pxl, width, height, rowSizeBytes, format,
+         box, session->locate);
+   if(count == DmtxUndefined)
+      return DmtxFail;
+
+   tileCount = 0;
+   for(i = 0; i < count; i++) {
+      /* Round outward when moving to the (possibly downscaled) plane */
+      tile[tileCount].x = box[i].x / plane->scale;
+      tile[tileCount].y = box[i].y / plane->scale;
+      x1 = (box[i].x + box[i].width + plane->scale - 1) / plane->scale;
+      y1 = (box[i].y + box[i].height + plane->scale - 1) / plane->scale;
+      tile[tileCount].width = ((x1 < plane->width) ? x1 : plane->width) - tile[tileCount].x;
+      tile[tileCount].height = ((y1 < plane->height) ? y1 : plane->height) - tile[tileCount].y;
+
+      if(tile[tileCount].width > 0 && tile[tileCount].height > 0 &&
+            TileIntersectsRoi(scan, &(tile[tileCount])) == DmtxTrue)
+         tileCount++;
+   }
+
+   session->candidateCount = tileCount;
+   if(tileCount == 0)
+      return DmtxPass;
+
+   return DecodeTiles(scan, tile, tileCount);
+}
+
+/**
+ * @brief  Accumulate per-cell orientation histograms of gradient energy
+ * @param  plane Locator plane (readable at x = -1 and x = width)
+ * @param  stride Distance between plane rows in bytes
+ * @param  width Plane width
+ * @param  height Plane height
+ * @param  cell Cells to fill, cols x rows
+ * @param  cols Cells per row
+ * @param  rows Cell rows
+ * @return void
+ */
+static void
+MeasureCells(unsigned char *plane, int stride, int width, int height,
+      DmtxwCell *cell, int cols, int rows)
+{
+   int y, cy;
+   unsigned char *row;
+   GradientRowFunc rowFunc;
+
+   rowFunc = GetGradientFunc();
+
+   /* Replicate the outermost columns into the spare ones */
+   for(y = 0; y < height; y++) {
+      row = plane + y * stride;
+      row[-1] = row[0];
+      row[width] = row[width - 1];
+   }
+
+   memset(cell, 0x00, cols * rows * sizeof(DmtxwCell));
+
+   for(y = 0; y < rows * DMTXW_LOCATE_CELL; y++) {
+      cy = y / DMTXW_LOCATE_CELL;
+      row = plane + y * stride;
+      rowFunc((y > 0) ? row - stride : row, row,
+            (y < height - 1) ? row + stride : row, cell + cy * cols, cols);
+   }
+}
+
+/**
+ * @brief  Gradient row kernel in use, following the conversion kernel choice
+ * @return Row function
+ */
+static GradientRowFunc
+GetGradientFunc(void)
+{
+   (void)GetRowFunc();
+
+#if defined(DMTXW_HAVE_SSE2)
+   if(activeKernel == DmtxwKernelSse2 || activeKernel == DmtxwKernelAvx2)
+      return GradientRowSse2;
+#endif
+
+   return GradientRowScalar;
+}
+
+/**
+ * @brief  Portable gradient row kernel. Gradients come from 3x3 Sobel
+ *         filters; every pixel whose magnitude (|gx| + |gy|) / 4 reaches
+ *         DMTXW_LOCATE_EDGE_MIN adds it to the orientation bin of its cell.
+ *         The bin follows from comparing |gy| against |gx| at the ratios
+ *         between the bin centres (tangents of 11.25, 33.75, 56.25 and
+ *         78.75 degrees, about 1/5, 2/3, 3/2 and 5) and from the signs.
+ * @param  above Row above (may equal row)
+ * @param  row Row being measured
+ * @param  below Row below (may equal row)
+ * @param  cell First cell of this cell row
+ * @param  cols Cells per row
+ * @return void
+ */
+static void
+GradientRowScalar(const unsigned char *above, const unsigned char *row,
+      const unsigned char *below, DmtxwCell *cell, int cols)
+{
+   int x, gx, gy, ax, ay, m, sector;
+
+   for(x = 0; x < cols * DMTXW_LOCATE_CELL; x++) {
+      gx = (above[x + 1] - above[x - 1]) + 2 * (row[x + 1] - row[x - 1]) +
+            (below[x + 1] - below[x - 1]);
+      gy = (below[x - 1] + 2 * below[x] + below[x + 1]) -
+            (above[x - 1] + 2 * above[x] + above[x + 1]);
+      ax = abs(gx);
+      ay = abs(gy);
+
+      m = (ax + ay) >> 2;
+      if(m < DMTXW_LOCATE_EDGE_MIN)
+         continue;
+
+      /* 0 (horizontal gradient) through 4 (vertical gradient) */
+      sector = 4 - (5 * ay < ax) - (3 * ay < 2 * ax) - (2 * ay < 3 * ax) - (ay < 5 * ax);
+
+      if(sector > 0 && sector < 4 && (gx > 0) != (gy > 0))
+         sector = 8 - sector;
+
+      cell[x / DMTXW_LOCATE_CELL].bin[sector] += m;
+   }
+}
+
+#if defined(DMTXW_HAVE_SSE2)
+/**
+ * @brief  Load 8 bytes and widen them to 16-bit lanes
+ * @param  p Address
+ * @return Widened bytes
+ */
+DMTXW_TARGET_SSE2 static __m128i
+Load8Widen(const unsigned char *p)
+{
+   return _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)p), _mm_setzero_si128());
+}
+
+/**
+ * @brief  SSE2 gradient row kernel, one 8-pixel cell per iteration in
+ *         16-bit lanes. Same result as GradientRowScalar().
+ * @param  above Row above (may equal row)
+ * @param  row Row being measured
+ * @param  below Row below (may equal row)
+ * @param  cell First cell of this cell row
+ * @param  cols Cells per row
+ * @return void
+ */
+DMTXW_TARGET_SSE2 static void
+GradientRowSse2(const unsigned char *above, const unsigned char *row,
+      const unsigned char *below, DmtxwCell *cell, int cols)
+{
+   int x, k;
+   short total[8];
+   __m128i zero, thresh, four, al, ac, ar, cl, cr, bl, bc, br, gx, gy, ax, ay;
+   __m128i m, sector, opposite, mirror, bin[8], s01, s23, s45, s67, t0, t1;
+
+   zero = _mm_setzero_si128();
+   four = _mm_set1_epi16(4);
+   thresh = _mm_set1_epi16(DMTXW_LOCATE_EDGE_MIN - 1);
+
+   for(x = 0; x < cols * DMTXW_LOCATE_CELL; x += DMTXW_LOCATE_CELL) {
+      al = Load8Widen(above + x - 1);
+      ac = Load8Widen(above + x);
+      ar = Load8Widen(above + x + 1);
+      cl = Load8Widen(row + x - 1);
+      cr = Load8Widen(row + x + 1);
+      bl = Load8Widen(below + x - 1);
+      bc = Load8Widen(below + x);
+      br = Load8Widen(below + x + 1);
+
+      gx = _mm_add_epi16(_mm_add_epi16(_mm_sub_epi16(ar, al), _mm_sub_epi16(br, bl)),
+            _mm_slli_epi16(_mm_sub_epi16(cr, cl), 1));
+      gy = _mm_sub_epi16(_mm_add_epi16(_mm_add_epi16(bl, br), _mm_slli_epi16(bc, 1)),
+            _mm_add_epi16(_mm_add_epi16(al, ar), _mm_slli_epi16(ac, 1)));
+      ax = _mm_max_epi16(gx, _mm_sub_epi16(zero, gx));
+      ay = _mm_max_epi16(gy, _mm_sub_epi16(zero, gy));
+
+      m = _mm_srli_epi16(_mm_add_epi16(ax, ay), 2);
+      m = _mm_and_si128(m, _mm_cmpgt_epi16(m, thresh));
+
+      /* Each true comparison is -1, so adding them counts down from 4 */
+      sector = _mm_add_epi16(four, _mm_cmplt_epi16(_mm_mullo_epi16(ay, _mm_set1_epi16(5)), ax));
+      sector = _mm_add_epi16(sector, _mm_cmplt_epi16(_mm_mullo_epi16(ay, _mm_set1_epi16(3)),
+            _mm_slli_epi16(ax, 1)));
+      sector = _mm_add_epi16(sector, _mm_cmplt_epi16(_mm_slli_epi16(ay, 1),
+            _mm_mullo_epi16(ax, _mm_set1_epi16(3))));
+      sector = _mm_add_epi16(sector, _mm_cmplt_epi16(ay, _mm_mullo_epi16(ax, _mm_set1_epi16(5))));
+
+      opposite = _mm_xor_si128(_mm_cmpgt_epi16(gx, zero), _mm_cmpgt_epi16(gy, zero));
+      opposite = _mm_and_si128(opposite, _mm_and_si128(_mm_cmpgt_epi16(sector, zero),
+            _mm_cmplt_epi16(sector, four)));
+      mirror = _mm_sub_epi16(_mm_set1_epi16(8), sector);
+      sector = _mm_or_si128(_mm_and_si128(opposite, mirror), _mm_andnot_si128(opposite, sector));
+
+      for(k = 0; k < 8; k++)
+         bin[k] = _mm_and_si128(m, _mm_cmpeq_epi16(sector, _mm_set1_epi16((short)k)));
+
+      /* Transpose-add so lane k holds the total of bin k */
+      s01 = _mm_add_epi16(_mm_unpacklo_epi16(bin[0], bin[1]), _mm_unpackhi_epi16(bin[0], bin[1]));
+      s23 = _mm_add_epi16(_mm_unpacklo_epi16(bin[2], bin[3]), _mm_unpackhi_epi16(bin[2], bin[3]));
+      s45 = _mm_add_epi16(_mm_unpacklo_epi16(bin[4], bin[5]), _mm_unpackhi_epi16(bin[4], bin[5]));
+      s67 = _mm_add_epi16(_mm_unpacklo_epi16(bin[6], bin[7]), _mm_unpackhi_epi16(bin[6], bin[7]));
+      t0 = _mm_add_epi16(_mm_unpacklo_epi32(s01, s23), _mm_unpackhi_epi32(s01, s23));
+      t1 = _mm_add_epi16(_mm_unpacklo_epi32(s45, s67), _mm_unpackhi_epi32(s45, s67));
+      _mm_storeu_si128((__m128i *)total, _mm_add_epi16(_mm_unpacklo_epi64(t0, t1),
+            _mm_unpackhi_epi64(t0, t1)));
+
+      for(k = 0; k < 8; k++)
+         cell[x / DMTXW_LOCATE_CELL].bin[k] += (unsigned short)total[k];
+   }
+}
+#endif
+
+/**
+ * @brief  Score every cell as energy * (1 - R2), or 0 when the cell is too
+ *         flat or its edges are too close to parallel. The resultant at
+ *         4 * phi is kept for judging the orientation of whole boxes.
+ * @param  cell Cells
+ * @param  cols Cells per row
+ * @param  rows Cell rows
+ * @return void
+ */
+static void
+ScoreCells(DmtxwCell *cell, int cols, int rows)
+{
+   /* cos/sin of 2 * phi for bin centres phi = k * 22.5 degrees; 4 * phi
+    * is k * 90 degrees, so those are 1, 0, -1, 0, ... */
+   static const double cos2[8] = { 1.0, 0.70710678, 0.0, -0.70710678, -1.0, -0.70710678, 0.0, 0.70710678 };
+   static const double sin2[8] = { 0.0, 0.70710678, 1.0, 0.70710678, 0.0, -0.70710678, -1.0, -0.70710678 };
+   static const double cos4[8] = { 1.0, 0.0, -1.0, 0.0, 1.0, 0.0, -1.0, 0.0 };
+   static const double sin4[8] = { 0.0, 1.0, 0.0, -1.0, 0.0, 1.0, 0.0, -1.0 };
+   int i, k;
+   double energy, c2, s2, r2;
+   DmtxwCell *c;
+
+   for(i = 0; i < cols * rows; i++) {
+      c = &(cell[i]);
+      energy = c2 = s2 = c->c4 = c->s4 = 0.0;
+
+      for(k = 0; k < 8; k++) {
+         energy += c->bin[k];
+         c2 += c->bin[k] * cos2[k];
+         s2 += c->bin[k] * sin2[k];
+         c->c4 += c->bin[k] * cos4[k];
+         c->s4 += c->bin[k] * sin4[k];
+      }
+
+      c->score = 0.0;
+      c->label = 0;
+
+      if(energy < DMTXW_LOCATE_ENERGY_MIN * DMTXW_LOCATE_CELL * DMTXW_LOCATE_CELL)
+         continue;
+
+      r2 = sqrt(c2 * c2 + s2 * s2) / energy;
+      if((1.0 - r2) * 100.0 >= DMTXW_LOCATE_QUALITY_MIN)
+         c->score = energy * (1.0 - r2);
+   }
+}
+
+/**
+ * @brief  Merge 8-connected scoring cells into boxes and keep the best
+ * @param  plane Locator plane
+ * @param  stride Distance between plane rows in bytes
+ * @param  cell Scored cells
+ * @param  cols Cells per row
+ * @param  rows Cell rows
+ * @param  width Caller image width
+ * @param  height Caller image height
+ * @param  box Receives the best boxes in caller coordinates, best first
+ * @param  maxBoxes Capacity of box
+ * @return Number of boxes stored
+ */
+static int
+GroupCells(const unsigned char *plane, int stride, DmtxwCell *cell, int cols,
+      int rows, int width, int height, DmtxwBox *box, int maxBoxes)
+{
+   int i, j, k, n, label, count, tail, cx, cy, nx, ny;
+   int x0, y0, x1, y1, w, h, unit;
+   double score, c4, s4;
+   DmtxwCell *c;
+
+   if(maxBoxes > DMTXW_LOCATE_MAX_CANDIDATES)
+      maxBoxes = DMTXW_LOCATE_MAX_CANDIDATES;
+
+   unit = DMTXW_LOCATE_CELL * DMTXW_LOCATE_SCALE;
+   count = 0;
+   label = 0;
+
+   for(i = 0; i < cols * rows; i++) {
+      if(cell[i].score == 0.0 || cell[i].label != 0)
+         continue;
+
+      /* Breadth-first fill, queueing cells through their next field */
+      label++;
+      cell[i].label = label;
+      tail = i;
+      x0 = x1 = i % cols;
+      y0 = y1 = i / cols;
+      score = c4 = s4 = 0.0;
+      n = i;
+
+      while(n >= 0) {
+         c = &(cell[n]);
+         cx = n % cols;
+         cy = n / cols;
+         score += c->score;
+         c4 += c->c4;
+         s4 += c->s4;
+         x0 = (cx < x0) ? cx : x0;
+         x1 = (cx > x1) ? cx : x1;
+         y0 = (cy < y0) ? cy : y0;
+         y1 = (cy > y1) ? cy : y1;
+
+         for(ny = cy - 1; ny <= cy + 1; ny++) {
+            for(nx = cx - 1; nx <= cx + 1; nx++) {
+               if(nx < 0 || ny < 0 || nx >= cols || ny >= rows)
+                  continue;
+               k = ny * cols + nx;
+               if(cell[k].score == 0.0 || cell[k].label != 0)
+                  continue;
+               cell[k].label = label;
+               cell[tail].next = k;
+               tail = k;
+            }
+         }
+
+         n = (n == tail) ? -1 : cell[n].next;
+      }
+
+      /* One cell of margin for the quiet zone and edges that fell short */
+      x0 = (x0 > 0) ? x0 - 1 : 0;
+      y0 = (y0 > 0) ? y0 - 1 : 0;
+      x1 = (x1 < cols - 1) ? x1 + 1 : cols - 1;
+      y1 = (y1 < rows - 1) ? y1 + 1 : rows - 1;
+
+      /* Symbols are square at any rotation, rows of text are not */
+      w = x1 - x0 + 1;
+      h = y1 - y0 + 1;
+      score *= (w < h) ? (double)w / h : (double)h / w;
+
+      /* The 4 * phi resultant points along 0 degrees for upright grids */
+      if(c4 > fabs(s4) && HasFinderSignature(plane, stride,
+            x0 * DMTXW_LOCATE_CELL, y0 * DMTXW_LOCATE_CELL,
+            (x1 + 1) * DMTXW_LOCATE_CELL, (y1 + 1) * DMTXW_LOCATE_CELL) == DmtxTrue)
+         score *= DMTXW_LOCATE_FINDER_BONUS;
+
+      /* Insert into the sorted list of best boxes */
+      if(count == maxBoxes && score <= box[count - 1].score)
+         continue;
+
+      j = (count < maxBoxes) ? count++ : count - 1;
+      while(j > 0 && box[j - 1].score < score) {
+         box[j] = box[j - 1];
+         j--;
+      }
+
+      box[j].x = x0 * unit;
+      box[j].y = y0 * unit;
+      box[j].width = (x1 + 1) * unit - box[j].x;
+      box[j].height = (y1 + 1) * unit - box[j].y;
+      box[j].score = score;
+
+      /* The last cell row and column also cover the pixels the grid drops */
+      if(x1 == cols - 1)
+         box[j].width = width - box[j].x;
+      if(y1 == rows - 1)
+         box[j].height = height - box[j].y;
+   }
+
+   return count;
+}
+
+/**
+ * @brief  Look for the outline of an upright symbol: one side of the box
+ *         crossed by a solid dark line (finder "L") and another by a line
+ *         alternating between dark and light (timing pattern)
+ * @param  plane Locator plane
+ * @param  stride Distance between plane rows in bytes
+ * @param  x0 Left edge of box (plane pixels)
+ * @param  y0 Top edge of box
+ * @param  x1 Right edge of box, exclusive
+ * @param  y1 Bottom edge of box, exclusive
+ * @return DmtxTrue | DmtxFalse
+ */
+static DmtxBoolean
+HasFinderSignature(const unsigned char *plane, int stride, int x0, int y0,
+      int x1, int y1)
+{
+   int x, y, side, depth, maxDepth, lo, hi, thresh;
+   int solid = 0, timing = 0;
+   const unsigned char *p;
+
+   lo = 255;
+   hi = 0;
+   for(y = y0; y < y1; y += 2) {
+      p = plane + y * stride;
+      for(x = x0; x < x1; x += 2) {
+         lo = (p[x] < lo) ? p[x] : lo;
+         hi = (p[x] > hi) ? p[x] : hi;
+      }
+   }
+
+   if(hi - lo < 2 * DMTXW_LOCATE_EDGE_MIN)
+      return DmtxFalse;
+   thresh = (lo + hi) / 2;
+
+   /* Edges of the symbol lie within about two cells of the box edge */
+   maxDepth = 3 * DMTXW_LOCATE_CELL;
+   if(maxDepth > (x1 - x0) / 2)
+      maxDepth = (x1 - x0) / 2;
+   if(maxDepth > (y1 - y0) / 2)
+      maxDepth = (y1 - y0) / 2;
+
+   /* Sides: 0 left, 1 right, 2 top, 3 bottom */
+   for(side = 0; side < 4; side++) {
+      for(depth = 0; depth < maxDepth; depth++) {
+         switch(side) {
+            case 0:
+               p = plane + y0 * stride + x0 + depth;
+               break;
+            case 1:
+               p = plane + y0 * stride + x1 - 1 - depth;
+               break;
+            case 2:
+               p = plane + (y0 + depth) * stride + x0;
+               break;
+            default:
+               p = plane + (y1 - 1 - depth) * stride + x0;
+               break;
+         }
+
+         switch(ClassifyLine(p, (side < 2) ? stride : 1,
+               (side < 2) ? y1 - y0 : x1 - x0, thresh)) {
+            case DmtxwLineSolid:
+               solid |= (1 << side);
+               break;
+            case DmtxwLineTiming:
+               timing |= (1 << side);
+               break;
+            default:
+               break;
+         }
+      }
+   }
+
+   /* The L covers two adjacent sides and the timing pattern the two sides
+    * opposite; one of those is enough, which rejects bars and blocks */
+   for(side = 0; side < 2; side++) {
+      for(depth = 2; depth < 4; depth++) {
+         if((solid & (1 << side)) && (solid & (1 << depth)) &&
+               (timing & ((1 << (side ^ 1)) | (1 << (depth ^ 1)))))
+            return DmtxTrue;
+      }
+   }
+
+   return DmtxFalse;
+}
+
+/**
+ * @brief  Classify the dark part of a scan line. A timing pattern
+ *         alternates in runs of one module, so its runs must be about
+ *         equally long; text strokes and noise are not.
+ * @param  p First pixel
+ * @param  step Distance between pixels in bytes
+ * @param  length Pixels in line
+ * @param  thresh Dark/light threshold
+ * @return DmtxwLineSolid, DmtxwLineTiming or DmtxwLineOther
+ */
+static int
+ClassifyLine(const unsigned char *p, int step, int length, int thresh)
+{
+   int i, first = -1, last = -1, dark = 0, runs = 0, run = 0, span;
+   int shortest = length, longest = 0, isDark, wasDark = 0;
+
+   for(i = 0; i < length; i++) {
+      isDark = (p[i * step] < thresh);
+      if(isDark) {
+         if(first < 0)
+            first = i;
+         last = i;
+         dark++;
+      }
+
+      /* Measure the runs that end inside the dark span */
+      if(i > 0 && isDark != wasDark) {
+         if(first >= 0 && i > first) {
+            runs++;
+            shortest = (run < shortest) ? run : shortest;
+            longest = (run > longest) ? run : longest;
+         }
+         run = 0;
+      }
+      run++;
+      wasDark = isDark;
+   }
+
+   if(first < 0)
+      return DmtxwLineOther;
+
+   span = last - first + 1;
+   if(span < DMTXW_LOCATE_CELL)
+      return DmtxwLineOther;
+
+   if(dark * 10 >= span * 9)
+      return DmtxwLineSolid;
+
+   if(runs >= 6 && longest <= 2 * shortest + 1)
+      return DmtxwLineTiming;
+
+   return DmtxwLineOther;
+}
@@ -0,0 +1,317 @@
+/*
+libdmtxw - Shared native glue for the libdmtx wrappers
+
+Copyright (C) 2026 The libdmtx-wrappers project
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+Contact: mike@dragonflylogic.com
+*/
+
+/* $Id$ */
+
+/**
+ * @file dmtxwpnm.c
+ * @brief Decode binary PGM/PPM files without loading them
+ *
+ * Archived scans are often kept as raw PNM files, whose pixels follow a
+ * short text header as packed top-down rows, which is exactly what
+ * dmtxwSessionDecode() takes. dmtxwPnmMap() maps the file and points at
+ * the first pixel, so libdmtx reads the page cache directly and no image
+ * object is built in the host language.
+ *
+ * Only maxval up to 255 is supported (P5 gray, P6 RGB). The mapping is
+ * private and writable, so a search that scribbles on its input never
+ * reaches the file, and samples of a file with a smaller maxval are
+ * stretched to 0..255 in place (copying those pages). On Windows the file
+ * is read into memory instead.
+ */
+
+/**
+ * @brief  Map a binary PGM (P5) or PPM (P6) file
+ * @param  path File name
+ * @param  pnm Receives the pixel layout; release with dmtxwPnmUnmap()
+ * @return DmtxPass | DmtxFail (errno tells why; EINVAL for a file that
+ *         is not a supported PNM)
+ */
+extern DmtxPassFail
+dmtxwPnmMap(const char *path, DmtxwPnm *pnm)
+{
+   size_t offset;
+   int maxval;
+
+   if(path == NULL || pnm == NULL) {
+      errno = EINVAL;
+      return DmtxFail;
+   }
+
+   memset(pnm, 0x00, sizeof(DmtxwPnm));
+
+   if(PnmLoad(path, pnm) == DmtxFail)
+      return DmtxFail;
+
+   offset = PnmParseHeader((unsigned char *)pnm->map, pnm->mapSize, pnm, &maxval);
+   if(offset == 0) {
+      dmtxwPnmUnmap(pnm);
+      errno = EINVAL;
+      return DmtxFail;
+   }
+
+   pnm->pxl = (unsigned char *)pnm->map + offset;
+
+   /* libdmtx expects full-range samples */
+   if(maxval < 255)
+      PnmRescale(pnm, maxval);
+
+   return DmtxPass;
+}
+
+/**
+ * @brief  Release a file mapped by dmtxwPnmMap()
+ * @param  pnm Mapped file
+ * @return void
+ */
+extern void
+dmtxwPnmUnmap(DmtxwPnm *pnm)
+{
+   if(pnm == NULL || pnm->map == NULL)
+      return;
+
+#if defined(_WIN32)
+   free(pnm->map);
+#else
+   munmap(pnm->map, pnm->mapSize);
+#endif
+
+   pnm->map = NULL;
+   pnm->pxl = NULL;
+   pnm->mapSize = 0;
+}
+
+/**
+ * @brief  Decode a binary PGM/PPM file in place (see dmtxwPnmMap())
+ * @param  session Session holding the decode options
+ * @param  path File name
+ * @return DmtxPass | DmtxFail (status DmtxwStatusError and no results
+ *         when the file cannot be mapped)
+ */
+extern DmtxPassFail
+dmtxwSessionDecodeFile(DmtxwSession *session, const char *path)
+{
+   DmtxwPnm pnm;
+   DmtxPassFail err;
+
+   if(session == NULL)
+      return DmtxFail;
+
+   if(dmtxwPnmMap(path, &pnm) == DmtxFail) {
+      ResetResults(session);
+      session->status = DmtxwStatusError;
+      return DmtxFail;
+   }
+
+   err = dmtxwSessionDecode(session, pnm.pxl, pnm.width, pnm.height,
+         pnm.rowSizeBytes, pnm.format);
+
+   /* Results hold copies of the payloads, so the file can go */
+   dmtxwPnmUnmap(&pnm);
+
+   return err;
+}
+
+/**
+ * @brief  Bring a whole file into memory, mapped where possible
+ * @param  path File name
+ * @param  pnm Receives map and mapSize
+ * @return DmtxPass | DmtxFail (errno set)
+ */
+static DmtxPassFail
+PnmLoad(const char *path, DmtxwPnm *pnm)
+{
+#if defined(_WIN32)
+   FILE *fp;
+   long size;
+
+   fp = fopen(path, "rb");
+   if(fp == NULL)
+      return DmtxFail;
+
+   if(fseek(fp, 0, SEEK_END) != 0 || (size = ftell(fp)) <= 0 || fseek(fp, 0, SEEK_SET) != 0) {
+      fclose(fp);
+      errno = EINVAL;
+      return DmtxFail;
+   }
+
+   pnm->map = malloc((size_t)size);
+   if(pnm->map == NULL || fread(pnm->map, 1, (size_t)size, fp) != (size_t)size) {
+      free(pnm->map);
+      pnm->map = NULL;
+      fclose(fp);
+      errno = EIO;
+      return DmtxFail;
+   }
+   fclose(fp);
+   pnm->mapSize = (size_t)size;
+#else
+   struct stat st;
+   void *map;
+   int fd;
+
+   fd = open(path, O_RDONLY);
+   if(fd < 0)
+      return DmtxFail;
+
+   if(fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0) {
+      close(fd);
+      errno = EINVAL;
+      return DmtxFail;
+   }
+
+   map = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+   close(fd);
+   if(map == MAP_FAILED)
+      return DmtxFail;
+
+   /* Every page is read at least once by the search; start reading now */
+#if defined(MADV_WILLNEED)
+   madvise(map, (size_t)st.st_size, MADV_WILLNEED);
+#endif
+
+   pnm->map = map;
+   pnm->mapSize = (size_t)st.st_size;
+#endif
+
+   return DmtxPass;
+}
+
+/**
+ * @brief  Stretch samples of 0..maxval to 0..255
+ * @param  pnm Mapped file
+ * @param  maxval Largest sample value of the file, 1 .. 254
+ * @return void
+ */
+static void
+PnmRescale(DmtxwPnm *pnm, int maxval)
+{
+   unsigned char table[256];
+   unsigned char *p, *end;
+   int i;
+
+   /* Samples above maxval are invalid; they end up white */
+   for(i = 0; i < 256; i++)
+      table[i] = (unsigned char)((i >= maxval) ? 255 : (i * 255 + maxval / 2) / maxval);
+
+   end = pnm->pxl + (size_t)pnm->rowSizeBytes * pnm->height;
+   for(p = pnm->pxl; p < end; p++)
+      *p = table[*p];
+}
+
+/**
+ * @brief  Parse a PNM header and check that the file holds every row
+ * @param  data File contents
+ * @param  size File size in bytes
+ * @param  pnm Receives width, height, rowSizeBytes and format
+ * @param  maxval Receives the largest sample value, 1 .. 255
+ * @return Offset of the first pixel, or 0 if not a supported PNM
+ */
+static size_t
+PnmParseHeader(const unsigned char *data, size_t size, DmtxwPnm *pnm, int *maxval)
+{
+   size_t pos = 2;
+   int bytesPerPixel;
+
+   if(size < 2 || data[0] != 'P' || (data[1] != '5' && data[1] != '6'))
+      return 0;
+
+   pnm->format = (data[1] == '5') ? DmtxwFormatGray8 : DmtxwFormatRGB24;
+   bytesPerPixel = (data[1] == '5') ? 1 : 3;
+
+   if(PnmParseNumber(data, size, &pos, &(pnm->width)) == DmtxFail ||
+         PnmParseNumber(data, size, &pos, &(pnm->height)) == DmtxFail ||
+         PnmParseNumber(data, size, &pos, maxval) == DmtxFail)
+      return 0;
+
+   /* Exactly one whitespace byte separates maxval from the pixels */
+   if(pos >= size || !PnmIsSpace(data[pos]))
+      return 0;
+   pos++;
+
+   if(pnm->width < 1 || pnm->height < 1 || *maxval < 1 || *maxval > 255 ||
+         pnm->width > DMTXW_PNM_MAX_SIDE || pnm->height > DMTXW_PNM_MAX_SIDE)
+      return 0;
+
+   pnm->rowSizeBytes = pnm->width * bytesPerPixel;
+   if((size - pos) / pnm->rowSizeBytes < (size_t)pnm->height)
+      return 0;
+
+   return pos;
+}
+
+/**
+ * @brief  Read one header number, skipping whitespace and comments
+ * @param  data File contents
+ * @param  size File size in bytes
+ * @param  pos Read position, advanced past the number
+ * @param  value Receives the number
+ * @return DmtxPass | DmtxFail
+ */
+static DmtxPassFail
+PnmParseNumber(const unsigned char *data, size_t size, size_t *pos, int *value)
+{
+   size_t p = *pos;
+   long n = 0;
+
+   for(;;) {
+      if(p >= size)
+         return DmtxFail;
+      if(data[p] == '#') {
+         while(p < size && data[p] != '\n' && data[p] != '\r')
+            p++;
+      }
+      else if(PnmIsSpace(data[p])) {
+         p++;
+      }
+      else {
+         break;
+      }
+   }
+
+   if(data[p] < '0' || data[p] > '9')
+      return DmtxFail;
+
+   while(p < size && data[p] >= '0' && data[p] <= '9') {
+      n = n * 10 + (data[p] - '0');
+      if(n > DMTXW_PNM_MAX_SIDE)
+         return DmtxFail;
+      p++;
+   }
+
+   *value = (int)n;
+   *pos = p;
+
+   return DmtxPass;
+}
+
+/**
+ * @brief  PNM whitespace test (isspace() depends on the locale)
+ * @param  c Byte
+ * @return DmtxTrue | DmtxFalse
+ */
+static DmtxBoolean
+PnmIsSpace(unsigned char c)
+{
+   return (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f') ?
+         DmtxTrue : DmtxFalse;
+}
@@ -0,0 +1,343 @@
+/*
+libdmtxw - Shared native glue for the libdmtx wrappers
+
+Copyright (C) 2026 The libdmtx-wrappers project
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+Contact: mike@dragonflylogic.com
+*/
+
+/* $Id$ */
+
+/**
+ * @file dmtxwprinter.c
+ * @brief ZPL and EPL labels for thermal printers
+ *
+ * Printing an encoded symbol usually means converting the wrapper's raster
+ * image into a printer graphic and sending an uncompressed bitmap with
+ * every label. These writers build the printer job from the encoder
+ * instead: either the printer's own Data Matrix command (^BX), which
+ * sends little more than the data, or a graphic rendered straight from
+ * the module grid at a whole number of dots per module. ZPL graphics use
+ * the printer's ASCII run-length compression, so the solid finder edges
+ * and repeated module rows cost a few characters each. The quiet zone is
+ * an offset from the label origin, not blank dots in the graphic.
+ */
+
+/**
+ * @brief  Write a complete printer label for an encoded symbol
+ * @param  enc Encoder after a successful dmtxEncodeDataMatrix()
+ * @param  data Encoded data; only needed by DmtxwPrinterZpl, which sends it
+ *         to the printer instead of the modules
+ * @param  dataSize Length of data
+ * @param  mode DmtxwPrinterMode value
+ * @param  dots Dots per module edge at the printer's density
+ * @param  margin Quiet zone in modules, DmtxUndefined to use the encoder's
+ *         margin size relative to its module size
+ * @param  out Receives the label; its contents are replaced and its memory
+ *         reused. Release with dmtxwBufferFree().
+ * @return DmtxPass | DmtxFail
+ */
+extern DmtxPassFail
+dmtxwEncodePrinter(DmtxEncode *enc, const unsigned char *data, int dataSize, int mode,
+      int dots, int margin, DmtxwBuffer *out)
+{
+   DmtxwVectorGrid grid;
+   DmtxPassFail err;
+
+   if(enc == NULL || enc->message == NULL || out == NULL ||
+         dots < 1 || dots > DMTXW_PRINTER_MAX_DOTS)
+      return DmtxFail;
+
+   if(margin == DmtxUndefined)
+      margin = (enc->moduleSize > 0) ? enc->marginSize / enc->moduleSize : 0;
+   if(margin < 0 || margin > DMTXW_VECTOR_MAX_MARGIN)
+      return DmtxFail;
+
+   out->length = 0;
+
+   if(mode == DmtxwPrinterZpl) {
+      if(data == NULL || dataSize < 1)
+         return DmtxFail;
+      return PrinterWriteZpl(enc, data, dataSize, dots, margin * dots, out);
+   }
+   else if(mode != DmtxwPrinterZplGraphic && mode != DmtxwPrinterEplGraphic) {
+      return DmtxFail;
+   }
+
+   if(VectorGridCreate(enc, 0, &grid) == DmtxFail)
+      return DmtxFail;
+
+   if(mode == DmtxwPrinterZplGraphic)
+      err = PrinterWriteZplGraphic(&grid, dots, margin * dots, out);
+   else
+      err = PrinterWriteEplGraphic(&grid, dots, margin * dots, out);
+
+   free(grid.dark);
+
+   return err;
+}
+
+/**
+ * @brief  Look up a printer mode by name ("zpl", "zpl-graphic" or
+ *         "epl-graphic")
+ * @param  name Mode name
+ * @return DmtxwPrinterMode value, or DmtxUndefined
+ */
+extern int
+dmtxwPrinterByName(const char *name)
+{
+   if(name == NULL)
+      return DmtxUndefined;
+   else if(strcmp(name, "zpl") == 0)
+      return DmtxwPrinterZpl;
+   else if(strcmp(name, "zpl-graphic") == 0)
+      return DmtxwPrinterZplGraphic;
+   else if(strcmp(name, "epl-graphic") == 0)
+      return DmtxwPrinterEplGraphic;
+
+   return DmtxUndefined;
+}
+
+/**
+ * @brief  Write a ZPL label with a native ^BX Data Matrix field
+ * @param  enc Encoder; its symbol size is requested from the printer
+ * @param  data Data to encode
+ * @param  dataSize Length of data
+ * @param  dots Module height in dots
+ * @param  origin Field origin in dots (quiet zone)
+ * @param  out Output buffer
+ * @return DmtxPass | DmtxFail
+ *
+ * Field data is hex-escaped with ^FH wherever it could be taken for a ZPL
+ * command or is not printable. A tilde is the ^BX escape character, so it
+ * is sent as its decimal code word (~d126).
+ */
+static DmtxPassFail
+PrinterWriteZpl(DmtxEncode *enc, const unsigned char *data, int dataSize, int dots,
+      int origin, DmtxwBuffer *out)
+{
+   char text[DMTXW_VECTOR_LINE_MAX];
+   int sizeIdx, rows, cols, i;
+   DmtxPassFail err;
+
+   sizeIdx = enc->region.sizeIdx;
+   rows = dmtxGetSymbolAttribute(DmtxSymAttribSymbolRows, sizeIdx);
+   cols = dmtxGetSymbolAttribute(DmtxSymAttribSymbolCols, sizeIdx);
+   if(rows < 1 || cols < 1)
+      return DmtxFail;
+
+   sprintf(text, "^XA\n^FO%d,%d^BXN,%d,200,%d,%d,6,~,%d\n^FH\\^FD", origin, origin,
+         dots, cols, rows, (rows == cols) ? 1 : 2);
+   err = BufferAppend(out, text, strlen(text));
+
+   for(i = 0; i < dataSize && err == DmtxPass; i++) {
+      if(data[i] == '~')
+         err = BufferAppend(out, "\\7Ed126", 7);
+      else if(data[i] < 0x20 || data[i] > 0x7e || data[i] == '^' || data[i] == '\\') {
+         sprintf(text, "\\%02X", data[i]);
+         err = BufferAppend(out, text, 3);
+      }
+      else {
+         err = BufferAppend(out, (const char *)data + i, 1);
+      }
+   }
+
+   if(err == DmtxPass)
+      err = BufferAppend(out, "^FS\n^XZ\n", 8);
+
+   return err;
+}
+
+/**
+ * @brief  Write a ZPL label with a compressed ^GFA graphic of the modules
+ * @param  grid Module grid without quiet zone
+ * @param  dots Dots per module edge
+ * @param  origin Field origin in dots (quiet zone)
+ * @param  out Output buffer
+ * @return DmtxPass | DmtxFail
+ *
+ * Each dot row is written as hex digits with runs as ZPL repeat counts;
+ * a row ending in white is closed with ',', one ending in black with '!',
+ * and a row equal to the one above is a single ':'. Each module row is
+ * thus written at most once, whatever the dot density.
+ */
+static DmtxPassFail
+PrinterWriteZplGraphic(DmtxwVectorGrid *grid, int dots, int origin, DmtxwBuffer *out)
+{
+   char text[DMTXW_VECTOR_LINE_MAX];
+   char *hex;
+   unsigned char *row, *prev;
+   int rowBytes, hexCount, y, i, run, end;
+   DmtxPassFail err;
+
+   rowBytes = (grid->width * dots + 7) / 8;
+   hexCount = rowBytes * 2;
+   row = (unsigned char *)malloc(2 * (size_t)rowBytes + (size_t)hexCount);
+   if(row == NULL)
+      return DmtxFail;
+   prev = row + rowBytes;
+   hex = (char *)prev + rowBytes;
+
+   sprintf(text, "^XA\n^FO%d,%d^GFA,%d,%d,%d,", origin, origin,
+         rowBytes * grid->height * dots, rowBytes * grid->height * dots, rowBytes);
+   err = BufferAppend(out, text, strlen(text));
+
+   for(y = 0; y < grid->height && err == DmtxPass; y++) {
+      PrinterPackRow(grid->dark + y * grid->width, grid->width, dots, 1, row, rowBytes);
+      if(y > 0 && memcmp(row, prev, (size_t)rowBytes) == 0) {
+         for(i = 0; i < dots && err == DmtxPass; i++)
+            err = BufferAppend(out, ":", 1);
+         continue;
+      }
+      memcpy(prev, row, (size_t)rowBytes);
+
+      for(i = 0; i < rowBytes; i++) {
+         hex[2 * i] = "0123456789ABCDEF"[row[i] >> 4];
+         hex[2 * i + 1] = "0123456789ABCDEF"[row[i] & 0x0f];
+      }
+
+      /* Trailing run replaced by a fill character */
+      for(end = hexCount; end > 0 && hex[end - 1] == hex[hexCount - 1]; end--)
+         ;
+      if(hex[hexCount - 1] != '0' && hex[hexCount - 1] != 'F')
+         end = hexCount;
+
+      for(i = 0; i < end && err == DmtxPass; i += run) {
+         for(run = 1; i + run < end && hex[i + run] == hex[i]; run++)
+            ;
+         err = PrinterZplRun(out, hex[i], run);
+      }
+
+      if(err == DmtxPass && end < hexCount)
+         err = BufferAppend(out, (hex[hexCount - 1] == '0') ? "," : "!", 1);
+
+      for(i = 1; i < dots && err == DmtxPass; i++)
+         err = BufferAppend(out, ":", 1);
+   }
+
+   if(err == DmtxPass)
+      err = BufferAppend(out, "^FS\n^XZ\n", 8);
+
+   free(row);
+
+   return err;
+}
+
+/**
+ * @brief  Write an EPL label with a binary GW graphic of the modules
+ * @param  grid Module grid without quiet zone
+ * @param  dots Dots per module edge
+ * @param  origin Graphic position in dots (quiet zone)
+ * @param  out Output buffer
+ * @return DmtxPass | DmtxFail
+ *
+ * EPL has no graphic compression; the rows are sent as raw bytes, where
+ * a cleared bit prints a dot.
+ */
+static DmtxPassFail
+PrinterWriteEplGraphic(DmtxwVectorGrid *grid, int dots, int origin, DmtxwBuffer *out)
+{
+   char text[DMTXW_VECTOR_LINE_MAX];
+   unsigned char *row;
+   int rowBytes, y, i;
+   DmtxPassFail err;
+
+   rowBytes = (grid->width * dots + 7) / 8;
+   row = (unsigned char *)malloc((size_t)rowBytes);
+   if(row == NULL)
+      return DmtxFail;
+
+   sprintf(text, "\nN\nGW%d,%d,%d,%d,", origin, origin, rowBytes, grid->height * dots);
+   err = BufferAppend(out, text, strlen(text));
+
+   for(y = 0; y < grid->height && err == DmtxPass; y++) {
+      PrinterPackRow(grid->dark + y * grid->width, grid->width, dots, 0, row, rowBytes);
+      for(i = 0; i < dots && err == DmtxPass; i++)
+         err = BufferAppend(out, (char *)row, (size_t)rowBytes);
+   }
+
+   if(err == DmtxPass)
+      err = BufferAppend(out, "\nP1\n", 4);
+
+   free(row);
+
+   return err;
+}
+
+/**
+ * @brief  Pack one module row into a row of dots, most significant bit first
+ * @param  dark Module row, nonzero for dark modules
+ * @param  width Modules in the row
+ * @param  dots Dots per module
+ * @param  darkBit Bit value of a dark dot (padding takes the other value)
+ * @param  row Receives the packed dots
+ * @param  rowBytes Bytes in row
+ * @return void
+ */
+static void
+PrinterPackRow(const unsigned char *dark, int width, int dots, int darkBit,
+      unsigned char *row, int rowBytes)
+{
+   int x, i, bit;
+
+   memset(row, darkBit ? 0x00 : 0xff, (size_t)rowBytes);
+
+   for(x = 0, bit = 0; x < width; x++) {
+      if((dark[x] != 0) == (darkBit != 0)) {
+         for(i = 0; i < dots; i++, bit++)
+            row[bit >> 3] |= (unsigned char)(0x80 >> (bit & 7));
+      }
+      else {
+         for(i = 0; i < dots; i++, bit++)
+            row[bit >> 3] &= (unsigned char)~(0x80 >> (bit & 7));
+      }
+   }
+}
+
+/**
+ * @brief  Append a run of one hex digit with a ZPL repeat count
+ * @param  out Output buffer
+ * @param  digit Hex digit
+ * @param  count Run length
+ * @return DmtxPass | DmtxFail
+ *
+ * Counts are the sum of a multiple of 20 ('g' 20 to 'z' 400) and a
+ * remainder ('G' 1 to 'Y' 19); longer runs are split.
+ */
+static DmtxPassFail
+PrinterZplRun(DmtxwBuffer *out, char digit, int count)
+{
+   char text[4];
+   int n, length;
+
+   while(count > 0) {
+      n = (count > 419) ? 419 : count;
+      count -= n;
+
+      length = 0;
+      if(n >= 20)
+         text[length++] = (char)('g' + n / 20 - 1);
+      if(n % 20 > 1 || (n % 20 == 1 && n >= 20))
+         text[length++] = (char)('G' + n % 20 - 1);
+      text[length++] = digit;
+
+      if(BufferAppend(out, text, (size_t)length) == DmtxFail)
+         return DmtxFail;
+   }
+
+   return DmtxPass;
+}
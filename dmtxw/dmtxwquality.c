@@ -0,0 +1,136 @@
+/*
+libdmtxw - Shared native glue for the libdmtx wrappers
+
+Copyright (C) 2026 The libdmtx-wrappers project
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+Contact: mike@dragonflylogic.com
+*/
+
+/* $Id$ */
+
+/**
+ * @file dmtxwquality.c
+ * @brief Cheap image quality gate run before the region search
+ *
+ * A frame that is out of focus or shows nothing but background costs a full
+ * region search and cannot yield a symbol. Two numbers measured on a sparse
+ * grid of the search plane tell such frames apart in a fraction of that
+ * time: the variance of the Laplacian, which collapses when edges are
+ * smeared, and the share of samples sitting on a strong edge, which is near
+ * zero for blank frames.
+ */
+
+/**
+ * @brief  Measure sharpness and edge density of the plane, skipping a frame
+ *         border of one pixel
+ * @param  plane Plane about to be searched
+ * @param  sharpness Receives the variance of the 4-neighbour Laplacian
+ * @param  edgeDensity Receives samples on a strong edge, per mille
+ * @return DmtxPass | DmtxFail (plane too small to measure)
+ */
+static DmtxPassFail
+MeasureQuality(const DmtxwPlane *plane, int *sharpness, int *edgeDensity)
+{
+   int x, y, bpp, stride, center, left, right, up, down, lap;
+   int weight[4];
+   long samples, edges;
+   double sum, sumSq, mean;
+   const unsigned char *p;
+
+   *sharpness = 0;
+   *edgeDensity = 0;
+
+   if(plane->width < 3 || plane->height < 3)
+      return DmtxFail;
+
+   GetLumaWeights(plane->format, weight);
+   bpp = plane->bytesPerPixel;
+   stride = plane->rowSizeBytes;
+
+   samples = edges = 0;
+   sum = sumSq = 0.0;
+
+   for(y = 1; y < plane->height - 1; y += DMTXW_QUALITY_STEP) {
+      for(x = 1; x < plane->width - 1; x += DMTXW_QUALITY_STEP) {
+         p = plane->pxl + y * stride + x * bpp;
+         center = SampleLuma(p, bpp, weight);
+         left = SampleLuma(p - bpp, bpp, weight);
+         right = SampleLuma(p + bpp, bpp, weight);
+         up = SampleLuma(p - stride, bpp, weight);
+         down = SampleLuma(p + stride, bpp, weight);
+
+         lap = 4 * center - left - right - up - down;
+         sum += lap;
+         sumSq += (double)lap * lap;
+
+         if(abs(right - left) >= DMTXW_QUALITY_EDGE_MIN ||
+               abs(down - up) >= DMTXW_QUALITY_EDGE_MIN)
+            edges++;
+
+         samples++;
+      }
+   }
+
+   mean = sum / samples;
+   *sharpness = (int)(sumSq / samples - mean * mean + 0.5);
+   *edgeDensity = (int)((edges * 1000 + samples / 2) / samples);
+
+   return DmtxPass;
+}
+
+/**
+ * @brief  Luminance of one pixel, using the weights of dmtxwConvertToLuma()
+ * @param  p First byte of the pixel
+ * @param  bytesPerPixel Bytes per pixel
+ * @param  weight Per-byte weights from GetLumaWeights(), summing to 256
+ * @return Luminance 0..255
+ */
+static int
+SampleLuma(const unsigned char *p, int bytesPerPixel, const int weight[4])
+{
+   int i, luma;
+
+   if(bytesPerPixel == 1)
+      return p[0];
+
+   luma = 0;
+   for(i = 0; i < bytesPerPixel; i++)
+      luma += weight[i] * p[i];
+
+   return (luma + 128) >> 8;
+}
+
+/**
+ * @brief  Measure the plane and decide whether it is worth searching
+ * @param  session Session holding the thresholds, receives the metrics
+ * @param  plane Plane about to be searched
+ * @return DmtxwStatusComplete to go ahead, otherwise the rejection reason
+ */
+static DmtxwStatus
+CheckQuality(DmtxwSession *session, const DmtxwPlane *plane)
+{
+   if(MeasureQuality(plane, &session->sharpness, &session->edgeDensity) == DmtxFail)
+      return DmtxwStatusComplete;
+
+   if(session->minEdgeDensity != DmtxUndefined && session->edgeDensity < session->minEdgeDensity)
+      return DmtxwStatusEmpty;
+
+   if(session->minSharpness != DmtxUndefined && session->sharpness < session->minSharpness)
+      return DmtxwStatusBlurred;
+
+   return DmtxwStatusComplete;
+}
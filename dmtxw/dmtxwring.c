@@ -0,0 +1,989 @@
+/*
+libdmtxw - Shared native glue for the libdmtx wrappers
+
+Copyright (C) 2026 The libdmtx-wrappers project
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+Contact: mike@dragonflylogic.com
+*/
+
+/* $Id$ */
+
+/**
+ * @file dmtxwring.c
+ * @brief Frame ring in shared memory between a camera process and decode
+ *        worker processes
+ *
+ * One memfd holds a ring of frame slots and a companion ring of result
+ * slots. The producer renders or DMAs each frame straight into a free slot
+ * and publishes it; any number of consumers (other processes that mapped
+ * the same descriptor, or threads) claim published frames, decode them in
+ * place with their own session and publish a compact copy of the results
+ * into the result ring, which one collector reads.
+ *
+ * Both rings are bounded lock-free queues: every slot carries a sequence
+ * number telling whose turn it is, and the shared counters only move by
+ * compare-and-swap. A full frame ring makes dmtxwRingAcquireFrame() return
+ * NULL (the producer decides whether to drop or wait); a full result ring
+ * drops the result and counts it. Sequence numbers are compared by
+ * difference, so they may wrap. All processes must run the same build of
+ * libdmtxw.
+ *
+ * A consumer holds a claimed frame under a lease (dmtxwRingSetLease()).
+ * Once it runs out, the producer needing the slot or the collector waiting
+ * for results takes the frame back and reports it with status
+ * DmtxUndefined, so a consumer that died mid-frame holds up its slot for
+ * at most one lease. A consumer that was merely slow finds its frame gone
+ * and drops its result. The lease must therefore be longer than any
+ * decode (see DmtxwPropTimeout). Result slots are leased the same way: one
+ * claimed and still not published a lease later belongs to a consumer that
+ * died while storing it, and the collector skips it and counts it as
+ * dropped.
+ *
+ * Only POSIX systems are supported; elsewhere every function fails.
+ */
+
+#if !defined(_WIN32)
+
+/**
+ * @brief  Create a ring in a new anonymous shared memory object
+ * @param  slotCount Frame slots, a power of two from 2 to DMTXW_RING_MAX_SLOTS
+ * @param  slotBytes Largest frame in bytes (rows included)
+ * @param  resultCount Result slots, a power of two from 2 to DMTXW_RING_MAX_SLOTS
+ * @param  resultBytes Room for symbol records in each result slot
+ * @return Address of new ring (owning the descriptor), or NULL on failure
+ */
+extern DmtxwRing *
+dmtxwRingCreate(int slotCount, size_t slotBytes, int resultCount, size_t resultBytes)
+{
+   DmtxwRingHeader header;
+   DmtxwRingFrame *frame;
+   DmtxwRingSlot *slot;
+   DmtxwRing *ring;
+   int i, fd;
+
+   /* One slot would make "published" and "free for the next lap" equal */
+   if(slotCount < 2 || slotCount > DMTXW_RING_MAX_SLOTS || (slotCount & (slotCount - 1)) != 0 ||
+         resultCount < 2 || resultCount > DMTXW_RING_MAX_SLOTS ||
+         (resultCount & (resultCount - 1)) != 0 || slotBytes < 1)
+      return NULL;
+
+   memset(&header, 0x00, sizeof(DmtxwRingHeader));
+   header.magic = DMTXW_RING_MAGIC;
+   header.layout = RingLayout();
+   header.slotCount = slotCount;
+   header.resultCount = resultCount;
+   header.leaseMsec = DMTXW_RING_LEASE_MSEC;
+   header.slotStride = RingAlign(sizeof(DmtxwRingFrame)) + RingAlign(slotBytes);
+   header.resultStride = RingAlign(sizeof(DmtxwRingSlot)) + RingAlign(resultBytes);
+   header.size = RingAlign(sizeof(DmtxwRingHeader)) + slotCount * header.slotStride +
+         resultCount * header.resultStride;
+
+#if defined(__linux__) && defined(MFD_CLOEXEC)
+   fd = memfd_create("dmtxwring", MFD_CLOEXEC);
+#else
+   {
+      char name[64];
+
+      sprintf(name, "/dmtxwring.%ld.%p", (long)getpid(), (void *)&header);
+      fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+      if(fd >= 0)
+         shm_unlink(name);
+   }
+#endif
+   if(fd < 0)
+      return NULL;
+
+   if(ftruncate(fd, (off_t)header.size) != 0) {
+      close(fd);
+      return NULL;
+   }
+
+   ring = RingMap(fd, header.size);
+   if(ring == NULL) {
+      close(fd);
+      return NULL;
+   }
+   ring->owner = DmtxTrue;
+
+   /* Slot i is free for lap 0 of both rings */
+   memcpy(ring->header, &header, sizeof(DmtxwRingHeader));
+   for(i = 0; i < slotCount; i++) {
+      frame = RingFrame(ring, (unsigned int)i);
+      frame->seq = (unsigned int)i;
+   }
+   for(i = 0; i < resultCount; i++) {
+      slot = RingSlot(ring, (unsigned int)i);
+      slot->seq = (unsigned int)i;
+      slot->owner = (unsigned int)i - (unsigned int)resultCount;
+   }
+
+   return ring;
+}
+
+/**
+ * @brief  Map a ring created by another process (e.g., inherited across
+ *         fork() or received over a Unix socket)
+ * @param  fd Descriptor returned by dmtxwRingGetFd() in the creator
+ * @return Address of new ring (the descriptor stays the caller's), or NULL
+ */
+extern DmtxwRing *
+dmtxwRingAttach(int fd)
+{
+   DmtxwRingHeader header;
+   DmtxwRing *ring;
+   ssize_t got;
+
+   got = pread(fd, &header, sizeof(DmtxwRingHeader), 0);
+   if(got != (ssize_t)sizeof(DmtxwRingHeader) || header.magic != DMTXW_RING_MAGIC ||
+         header.layout != RingLayout())
+      return NULL;
+
+   ring = RingMap(fd, header.size);
+   if(ring != NULL)
+      ring->owner = DmtxFalse;
+
+   return ring;
+}
+
+/**
+ * @brief  Unmap a ring, closing its descriptor if this process created it
+ * @param  ring Pointer to ring
+ * @return DmtxPass | DmtxFail
+ */
+extern DmtxPassFail
+dmtxwRingDestroy(DmtxwRing **ring)
+{
+   if(ring == NULL || *ring == NULL)
+      return DmtxFail;
+
+   munmap((*ring)->base, (*ring)->size);
+   if((*ring)->owner == DmtxTrue)
+      close((*ring)->fd);
+
+   free(*ring);
+   *ring = NULL;
+
+   return DmtxPass;
+}
+
+/**
+ * @brief  Descriptor to hand to consumer processes
+ * @param  ring Ring
+ * @return Descriptor, or -1
+ */
+extern int
+dmtxwRingGetFd(DmtxwRing *ring)
+{
+   return (ring == NULL) ? -1 : ring->fd;
+}
+
+/**
+ * @brief  Set how long a consumer may hold a frame or a result slot before
+ *         it is taken back. Applies to every process sharing the ring.
+ * @param  ring Ring
+ * @param  msec Lease in milliseconds, at least 1 (default
+ *         DMTXW_RING_LEASE_MSEC)
+ * @return DmtxPass | DmtxFail
+ */
+extern DmtxPassFail
+dmtxwRingSetLease(DmtxwRing *ring, int msec)
+{
+   if(ring == NULL || msec < 1)
+      return DmtxFail;
+
+   __atomic_store_n(&ring->header->leaseMsec, msec, __ATOMIC_RELEASE);
+
+   return DmtxPass;
+}
+
+/**
+ * @brief  Producer: get the pixel buffer of the next free slot
+ * @param  ring Ring
+ * @param  size Receives the slot size in bytes (may be NULL)
+ * @return Slot pixels to fill, or NULL while every slot is in use
+ */
+extern unsigned char *
+dmtxwRingAcquireFrame(DmtxwRing *ring, size_t *size)
+{
+   DmtxwRingFrame *frame;
+   unsigned int pos;
+
+   if(ring == NULL)
+      return NULL;
+
+   pos = ring->header->head.value;
+   frame = RingFrame(ring, pos);
+
+   /* The consumer of this slot one lap ago may still be decoding it, or
+    * have died with it */
+   if(RingLoad(&frame->seq) != pos) {
+      if(RingReclaim(ring, pos - (unsigned int)ring->header->slotCount) == DmtxFalse ||
+            RingLoad(&frame->seq) != pos)
+         return NULL;
+   }
+
+   if(size != NULL)
+      *size = ring->header->slotStride - RingAlign(sizeof(DmtxwRingFrame));
+
+   return (unsigned char *)frame + RingAlign(sizeof(DmtxwRingFrame));
+}
+
+/**
+ * @brief  Producer: hand the slot filled after dmtxwRingAcquireFrame() to
+ *         the consumers
+ * @param  ring Ring
+ * @param  width Image width in pixels
+ * @param  height Image height in pixels
+ * @param  rowSizeBytes Distance between rows in bytes, 0 for packed rows
+ * @param  format DmtxwFormat value
+ * @return DmtxPass | DmtxFail (no slot acquired or frame larger than slot)
+ */
+extern DmtxPassFail
+dmtxwRingPublishFrame(DmtxwRing *ring, int width, int height, int rowSizeBytes,
+      int format)
+{
+   DmtxwRingFrame *frame;
+   unsigned int pos;
+   int bytesPerPixel;
+   size_t needed;
+
+   if(ring == NULL)
+      return DmtxFail;
+
+   pos = ring->header->head.value;
+   frame = RingFrame(ring, pos);
+   bytesPerPixel = dmtxwFormatGetBytesPerPixel(format);
+   if(RingLoad(&frame->seq) != pos || bytesPerPixel == DmtxUndefined || width < 1 || height < 1)
+      return DmtxFail;
+
+   needed = (rowSizeBytes > 0) ? (size_t)rowSizeBytes * height : (size_t)width * bytesPerPixel * height;
+   if(needed > ring->header->slotStride - RingAlign(sizeof(DmtxwRingFrame)))
+      return DmtxFail;
+
+   frame->frame = pos;
+   frame->width = width;
+   frame->height = height;
+   frame->rowSizeBytes = rowSizeBytes;
+   frame->format = format;
+   frame->published = dmtxTimeNow();
+
+   /* Covers a consumer dying between its claim and renewing the lease */
+   RingStore(&frame->lease, RingLeaseEnd(ring));
+   RingStore(&frame->seq, pos + 1);
+   RingStore(&ring->header->head.value, pos + 1);
+
+   return DmtxPass;
+}
+
+/**
+ * @brief  Producer: tell consumers and collector that no frames will follow
+ * @param  ring Ring
+ * @return void
+ */
+extern void
+dmtxwRingClose(DmtxwRing *ring)
+{
+   if(ring != NULL)
+      RingStore(&ring->header->closed, 1);
+}
+
+/**
+ * @brief  Consumer: wait for the next frame, decode it in place and
+ *         publish its results
+ * @param  ring Ring
+ * @param  session Session holding the decode options
+ * @param  timeout Milliseconds to wait for a frame, DmtxUndefined to wait
+ *         until the ring is closed
+ * @return DmtxPass (a frame was taken; its result status tells the
+ *         outcome) | DmtxFail (timeout, or ring closed and drained)
+ *
+ * A frame held past the lease is reclaimed by others; its result is then
+ * dropped here and the frame reported with status DmtxUndefined.
+ */
+extern DmtxPassFail
+dmtxwRingDecodeNext(DmtxwRing *ring, DmtxwSession *session, int timeout)
+{
+   DmtxwRingHeader *header;
+   DmtxwRingFrame *frame;
+   DmtxTime deadline, published;
+   unsigned int pos, seq, frameNumber;
+   int diff, spins = 0;
+   DmtxPassFail err;
+
+   if(ring == NULL || session == NULL)
+      return DmtxFail;
+
+   header = ring->header;
+   if(timeout != DmtxUndefined)
+      deadline = dmtxTimeAdd(dmtxTimeNow(), timeout);
+
+   for(;;) {
+      pos = RingLoad(&header->claim.value);
+      frame = RingFrame(ring, pos);
+      seq = RingLoad(&frame->seq);
+      diff = (int)(seq - (pos + 1));
+
+      if(diff == 0) {
+         if(RingClaim(&header->claim.value, pos) == DmtxTrue)
+            break;
+      }
+      else if(diff < 0) {
+         /* Nothing published yet */
+         if(RingLoad(&header->closed) && RingLoad(&header->head.value) == pos)
+            return DmtxFail;
+         if(timeout != DmtxUndefined && dmtxTimeExceeded(deadline))
+            return DmtxFail;
+         RingBackoff(&spins);
+      }
+   }
+
+   RingStore(&frame->lease, RingLeaseEnd(ring));
+   frameNumber = frame->frame;
+   published = frame->published;
+
+   err = dmtxwSessionDecode(session, (unsigned char *)frame + RingAlign(sizeof(DmtxwRingFrame)),
+         frame->width, frame->height, frame->rowSizeBytes, frame->format);
+
+   /* Reclaimed meanwhile: the slot may already hold another frame */
+   if(RingSwap(&frame->seq, pos + 1, pos + header->slotCount) == DmtxFalse)
+      return DmtxPass;
+
+   PublishResult(ring, frameNumber, published, session, err);
+
+   return DmtxPass;
+}
+
+/**
+ * @brief  Consumer: decode frames until the producer closes the ring and
+ *         every published frame is taken
+ * @param  ring Ring
+ * @param  session Session holding the decode options
+ * @return Number of frames decoded
+ */
+extern long
+dmtxwRingRunConsumer(DmtxwRing *ring, DmtxwSession *session)
+{
+   long count = 0;
+
+   if(ring == NULL || session == NULL)
+      return 0;
+
+   while(dmtxwRingDecodeNext(ring, session, DmtxUndefined) == DmtxPass)
+      count++;
+
+   return count;
+}
+
+/**
+ * @brief  Collector: wait for the next result. It stays valid in shared
+ *         memory until dmtxwRingReleaseResult().
+ * @param  ring Ring
+ * @param  timeout Milliseconds to wait, DmtxUndefined to wait until the
+ *         ring is closed and every published frame is accounted for
+ * @return Result, or NULL
+ */
+extern const DmtxwRingResult *
+dmtxwRingReadResult(DmtxwRing *ring, int timeout)
+{
+   DmtxwRingHeader *header;
+   DmtxwRingSlot *slot;
+   DmtxTime deadline;
+   unsigned int pos, scanned;
+   int spins = 0;
+
+   if(ring == NULL)
+      return NULL;
+
+   header = ring->header;
+   if(timeout != DmtxUndefined)
+      deadline = dmtxTimeAdd(dmtxTimeNow(), timeout);
+
+   scanned = RingClock();
+
+   for(;;) {
+      pos = header->resultTail.value;
+      slot = RingSlot(ring, pos);
+      if(RingLoad(&slot->seq) == pos + 1)
+         break;
+
+      /* The result may be held up by a consumer that died, either
+       * mid-frame or while storing this result */
+      if(RingClock() - scanned >= DMTXW_RING_SCAN_MSEC) {
+         RingReclaimAll(ring);
+         scanned = RingClock();
+         if(RingReclaimResult(ring, pos) == DmtxTrue)
+            continue;
+      }
+      /* done only moves after a result is stored, so check it first */
+      if(RingLoad(&header->closed) &&
+            RingLoad(&header->done) == RingLoad(&header->head.value) &&
+            RingLoad(&slot->seq) != pos + 1)
+         return NULL;
+      if(timeout != DmtxUndefined && dmtxTimeExceeded(deadline))
+         return NULL;
+      RingBackoff(&spins);
+   }
+
+   return &(slot->result);
+}
+
+/**
+ * @brief  Collector: give the result returned last back to the consumers
+ * @param  ring Ring
+ * @return void
+ */
+extern void
+dmtxwRingReleaseResult(DmtxwRing *ring)
+{
+   DmtxwRingSlot *slot;
+   unsigned int pos;
+
+   if(ring == NULL)
+      return;
+
+   pos = ring->header->resultTail.value;
+   slot = RingSlot(ring, pos);
+   if(RingLoad(&slot->seq) != pos + 1)
+      return;
+
+   ring->header->resultTail.value = pos + 1;
+   RingStore(&slot->seq, pos + ring->header->resultCount);
+}
+
+/**
+ * @brief  Symbol of a ring result
+ * @param  result Result from dmtxwRingReadResult()
+ * @param  index Symbol index, 0 .. result->symbolCount - 1
+ * @param  payload Receives the decoded bytes (not NUL-terminated)
+ * @return Symbol record, or NULL if index is out of range
+ */
+extern const DmtxwRingSymbol *
+dmtxwRingResultGetSymbol(const DmtxwRingResult *result, int index,
+      const unsigned char **payload)
+{
+   const unsigned char *p;
+   const DmtxwRingSymbol *symbol;
+   int i;
+
+   if(result == NULL || index < 0 || index >= result->symbolCount)
+      return NULL;
+
+   p = (const unsigned char *)result + RingAlign(sizeof(DmtxwRingResult));
+   for(i = 0; ; i++) {
+      symbol = (const DmtxwRingSymbol *)p;
+      if(i == index)
+         break;
+      p += RingAlign(sizeof(DmtxwRingSymbol)) + RingAlign((size_t)symbol->length);
+   }
+
+   if(payload != NULL)
+      *payload = p + RingAlign(sizeof(DmtxwRingSymbol));
+
+   return symbol;
+}
+
+/**
+ * @brief  Frames published, results dropped and frames reclaimed so far
+ * @param  ring Ring
+ * @param  published Receives the number of frames published (may be NULL)
+ * @param  dropped Receives the number of results lost to a full result
+ *         ring or to a consumer that died storing one (may be NULL)
+ * @param  reclaimed Receives the number of frames taken back from
+ *         consumers that overran the lease (may be NULL)
+ * @return DmtxPass | DmtxFail
+ */
+extern DmtxPassFail
+dmtxwRingGetStats(DmtxwRing *ring, long *published, long *dropped, long *reclaimed)
+{
+   if(ring == NULL)
+      return DmtxFail;
+
+   if(published != NULL)
+      *published = (long)RingLoad(&ring->header->head.value);
+   if(dropped != NULL)
+      *dropped = (long)RingLoad(&ring->header->dropped);
+   if(reclaimed != NULL)
+      *reclaimed = (long)RingLoad(&ring->header->reclaimed);
+
+   return DmtxPass;
+}
+
+/**
+ * @brief  Copy the outcome of a decode into the next free result slot
+ * @param  ring Ring
+ * @param  frameNumber Number of the frame that was decoded
+ * @param  published When the frame was published
+ * @param  session Session holding its results (not used if err is DmtxFail)
+ * @param  err Outcome of dmtxwSessionDecode()
+ * @return DmtxPass | DmtxFail (result ring full or slot reclaimed, result
+ *         dropped)
+ *
+ * The frame counts as done here unless the collector reclaimed the slot,
+ * which then counted it.
+ */
+static DmtxPassFail
+PublishResult(DmtxwRing *ring, unsigned int frameNumber, DmtxTime published,
+      DmtxwSession *session, DmtxPassFail err)
+{
+   DmtxwRingHeader *header = ring->header;
+   DmtxwRingSlot *slot;
+   DmtxwRingSymbol *symbol;
+   const DmtxwResult *found;
+   const unsigned char *payload;
+   unsigned char *p, *end;
+   unsigned int pos, seq;
+   size_t length, need;
+   int i, diff;
+
+   for(;;) {
+      pos = RingLoad(&header->resultHead.value);
+      slot = RingSlot(ring, pos);
+      seq = RingLoad(&slot->seq);
+      diff = (int)(seq - pos);
+
+      if(diff == 0) {
+         if(RingClaim(&header->resultHead.value, pos) == DmtxTrue)
+            break;
+      }
+      else if(diff < 0) {
+         /* The collector is a full lap behind */
+         RingAdd(&header->dropped, 1);
+         RingAdd(&header->done, 1);
+         return DmtxFail;
+      }
+   }
+
+   RingStore(&slot->lease, RingLeaseEnd(ring));
+   RingStore(&slot->owner, pos);
+
+   slot->result.frame = frameNumber;
+   slot->result.status = (err == DmtxPass) ? (int)session->status : DmtxUndefined;
+   slot->result.symbolCount = 0;
+   slot->result.truncated = 0;
+   slot->result.published = published;
+   slot->result.decoded = dmtxTimeNow();
+
+   p = (unsigned char *)&(slot->result) + RingAlign(sizeof(DmtxwRingResult));
+   end = (unsigned char *)slot + header->resultStride;
+
+   for(i = 0; err == DmtxPass && i < dmtxwSessionGetResultCount(session); i++) {
+      found = dmtxwSessionGetResult(session, i);
+      payload = dmtxwSessionGetPayload(session, i, &length);
+      if(payload == NULL)
+         break;
+      need = RingAlign(sizeof(DmtxwRingSymbol)) + RingAlign(length);
+      if(need > (size_t)(end - p)) {
+         slot->result.truncated = 1;
+         break;
+      }
+
+      symbol = (DmtxwRingSymbol *)p;
+      memcpy(symbol->corner, found->corner, sizeof(found->corner));
+      symbol->angle = found->angle;
+      symbol->sizeIdx = found->sizeIdx;
+      symbol->length = (int)length;
+      memcpy(p + RingAlign(sizeof(DmtxwRingSymbol)), payload, length);
+
+      p += need;
+      slot->result.symbolCount++;
+   }
+
+   /* Held past the lease and skipped by the collector */
+   if(RingSwap(&slot->seq, pos, pos + 1) == DmtxFalse)
+      return DmtxFail;
+   RingAdd(&header->done, 1);
+
+   return DmtxPass;
+}
+
+/**
+ * @brief  Take back frame pos if a consumer claimed it and its lease ran
+ *         out, reporting it with status DmtxUndefined
+ * @param  ring Ring
+ * @param  pos Sequence number of the frame
+ * @return DmtxTrue if the frame was reclaimed here
+ */
+static DmtxBoolean
+RingReclaim(DmtxwRing *ring, unsigned int pos)
+{
+   DmtxwRingHeader *header = ring->header;
+   DmtxwRingFrame *frame;
+   DmtxTime published;
+   unsigned int frameNumber;
+
+   frame = RingFrame(ring, pos);
+
+   /* Published, taken by a consumer and held past the lease */
+   if(RingLoad(&frame->seq) != pos + 1 || (int)(RingLoad(&header->claim.value) - pos) <= 0 ||
+         (int)(RingClock() - RingLoad(&frame->lease)) < 0)
+      return DmtxFalse;
+
+   frameNumber = frame->frame;
+   published = frame->published;
+
+   if(RingSwap(&frame->seq, pos + 1, pos + header->slotCount) == DmtxFalse)
+      return DmtxFalse;
+
+   PublishResult(ring, frameNumber, published, NULL, DmtxFail);
+   RingAdd(&header->reclaimed, 1);
+
+   return DmtxTrue;
+}
+
+/**
+ * @brief  Reclaim every frame held past its lease
+ * @param  ring Ring
+ * @return void
+ */
+static void
+RingReclaimAll(DmtxwRing *ring)
+{
+   unsigned int i;
+
+   /* A published frame in slot i has seq - 1 == pos, with pos in slot i */
+   for(i = 0; i < (unsigned int)ring->header->slotCount; i++)
+      RingReclaim(ring, RingLoad(&RingFrame(ring, i)->seq) - 1);
+}
+
+/**
+ * @brief  Collector: skip result slot pos if a consumer claimed it and did
+ *         not publish it within the lease, counting the result as dropped
+ * @param  ring Ring
+ * @param  pos Sequence number of the result, the one the collector reads
+ * @return DmtxTrue if the slot was skipped here
+ */
+static DmtxBoolean
+RingReclaimResult(DmtxwRing *ring, unsigned int pos)
+{
+   DmtxwRingHeader *header = ring->header;
+   DmtxwRingSlot *slot;
+   unsigned int owner;
+
+   slot = RingSlot(ring, pos);
+
+   /* Claimed by a consumer but not published */
+   if(RingLoad(&slot->seq) != pos || (int)(RingLoad(&header->resultHead.value) - pos) <= 0)
+      return DmtxFalse;
+
+   /* A consumer that died before starting its lease gets one from now */
+   owner = RingLoad(&slot->owner);
+   if(owner != pos) {
+      if(RingSwap(&slot->owner, owner, pos) == DmtxTrue)
+         RingStore(&slot->lease, RingLeaseEnd(ring));
+      return DmtxFalse;
+   }
+
+   if((int)(RingClock() - RingLoad(&slot->lease)) < 0)
+      return DmtxFalse;
+
+   /* Free for the next lap at once; a late PublishResult() fails its swap */
+   if(RingSwap(&slot->seq, pos, pos + header->resultCount) == DmtxFalse)
+      return DmtxFalse;
+
+   header->resultTail.value = pos + 1;
+   RingAdd(&header->dropped, 1);
+   RingAdd(&header->done, 1);
+
+   return DmtxTrue;
+}
+
+/**
+ * @brief  End of a lease starting now
+ * @param  ring Ring
+ * @return RingClock() value
+ */
+static unsigned int
+RingLeaseEnd(DmtxwRing *ring)
+{
+   return RingClock() + (unsigned int)__atomic_load_n(&ring->header->leaseMsec, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * @brief  Milliseconds of a clock shared by all processes, wrapping; compare
+ *         values by difference
+ * @return Clock value
+ */
+static unsigned int
+RingClock(void)
+{
+   struct timespec now;
+
+   clock_gettime(CLOCK_MONOTONIC, &now);
+
+   return (unsigned int)((unsigned long)now.tv_sec * 1000UL +
+         (unsigned long)(now.tv_nsec / 1000000L));
+}
+
+/**
+ * @brief  Map a ring descriptor and locate its parts
+ * @param  fd Descriptor
+ * @param  size Bytes to map
+ * @return Address of new ring handle, or NULL on failure
+ */
+static DmtxwRing *
+RingMap(int fd, size_t size)
+{
+   DmtxwRing *ring;
+   void *base;
+
+   ring = (DmtxwRing *)calloc(1, sizeof(DmtxwRing));
+   if(ring == NULL)
+      return NULL;
+
+   base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   if(base == MAP_FAILED) {
+      free(ring);
+      return NULL;
+   }
+
+   ring->fd = fd;
+   ring->size = size;
+   ring->base = (unsigned char *)base;
+   ring->header = (DmtxwRingHeader *)base;
+
+   return ring;
+}
+
+/**
+ * @brief  Frame slot of a sequence number
+ * @param  ring Ring
+ * @param  pos Sequence number
+ * @return Slot
+ */
+static DmtxwRingFrame *
+RingFrame(DmtxwRing *ring, unsigned int pos)
+{
+   DmtxwRingHeader *header = ring->header;
+
+   return (DmtxwRingFrame *)(ring->base + RingAlign(sizeof(DmtxwRingHeader)) +
+         (pos & (unsigned int)(header->slotCount - 1)) * header->slotStride);
+}
+
+/**
+ * @brief  Result slot of a sequence number
+ * @param  ring Ring
+ * @param  pos Sequence number
+ * @return Slot
+ */
+static DmtxwRingSlot *
+RingSlot(DmtxwRing *ring, unsigned int pos)
+{
+   DmtxwRingHeader *header = ring->header;
+
+   return (DmtxwRingSlot *)(ring->base + RingAlign(sizeof(DmtxwRingHeader)) +
+         header->slotCount * header->slotStride +
+         (pos & (unsigned int)(header->resultCount - 1)) * header->resultStride);
+}
+
+/**
+ * @brief  Round a size up to the ring alignment
+ * @param  size Size in bytes
+ * @return Aligned size
+ */
+static size_t
+RingAlign(size_t size)
+{
+   return (size + DMTXW_RING_ALIGN - 1) & ~(size_t)(DMTXW_RING_ALIGN - 1);
+}
+
+/**
+ * @brief  Fingerprint of the structure sizes, so that a process built
+ *         differently refuses to attach
+ * @return Layout value
+ */
+static unsigned int
+RingLayout(void)
+{
+   return (unsigned int)(sizeof(DmtxwRingHeader) * 65599u + sizeof(DmtxwRingFrame) * 257u +
+         sizeof(DmtxwRingSlot) * 17u + sizeof(DmtxwRingSymbol));
+}
+
+/**
+ * @brief  Wait a little longer on every call: spin, then yield, then sleep
+ * @param  spins Calls so far, updated
+ * @return void
+ */
+static void
+RingBackoff(int *spins)
+{
+   struct timespec ts;
+
+   if(*spins < DMTXW_RING_SPINS) {
+      (*spins)++;
+   }
+   else if(*spins < 2 * DMTXW_RING_SPINS) {
+      (*spins)++;
+      sched_yield();
+   }
+   else {
+      ts.tv_sec = 0;
+      ts.tv_nsec = DMTXW_RING_SLEEP_USEC * 1000L;
+      nanosleep(&ts, NULL);
+   }
+}
+
+/**
+ * @brief  Read a shared counter (acquire)
+ * @param  value Counter
+ * @return Value
+ */
+static unsigned int
+RingLoad(volatile unsigned int *value)
+{
+   return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * @brief  Write a shared counter (release)
+ * @param  value Counter
+ * @param  n New value
+ * @return void
+ */
+static void
+RingStore(volatile unsigned int *value, unsigned int n)
+{
+   __atomic_store_n(value, n, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief  Advance a shared counter from pos to pos + 1 unless another
+ *         process got there first
+ * @param  value Counter
+ * @param  pos Value seen
+ * @return DmtxTrue if this caller moved it
+ */
+static DmtxBoolean
+RingClaim(volatile unsigned int *value, unsigned int pos)
+{
+   return __atomic_compare_exchange_n(value, &pos, pos + 1, 0, __ATOMIC_ACQ_REL,
+         __ATOMIC_RELAXED) ? DmtxTrue : DmtxFalse;
+}
+
+/**
+ * @brief  Move a shared counter from one value to another unless it
+ *         changed meanwhile
+ * @param  value Counter
+ * @param  from Value expected
+ * @param  to New value
+ * @return DmtxTrue if this caller moved it
+ */
+static DmtxBoolean
+RingSwap(volatile unsigned int *value, unsigned int from, unsigned int to)
+{
+   return __atomic_compare_exchange_n(value, &from, to, 0, __ATOMIC_ACQ_REL,
+         __ATOMIC_RELAXED) ? DmtxTrue : DmtxFalse;
+}
+
+/**
+ * @brief  Add to a shared counter
+ * @param  value Counter
+ * @param  n Amount (may be negative)
+ * @return void
+ */
+static void
+RingAdd(volatile unsigned int *value, int n)
+{
+   __atomic_fetch_add(value, (unsigned int)n, __ATOMIC_ACQ_REL);
+}
+
+#else
+
+extern DmtxwRing *
+dmtxwRingCreate(int slotCount, size_t slotBytes, int resultCount, size_t resultBytes)
+{
+   return NULL;
+}
+
+extern DmtxwRing *
+dmtxwRingAttach(int fd)
+{
+   return NULL;
+}
+
+extern DmtxPassFail
+dmtxwRingDestroy(DmtxwRing **ring)
+{
+   return DmtxFail;
+}
+
+extern int
+dmtxwRingGetFd(DmtxwRing *ring)
+{
+   return -1;
+}
+
+extern DmtxPassFail
+dmtxwRingSetLease(DmtxwRing *ring, int msec)
+{
+   return DmtxFail;
+}
+
+extern unsigned char *
+dmtxwRingAcquireFrame(DmtxwRing *ring, size_t *size)
+{
+   return NULL;
+}
+
+extern DmtxPassFail
+dmtxwRingPublishFrame(DmtxwRing *ring, int width, int height, int rowSizeBytes,
+      int format)
+{
+   return DmtxFail;
+}
+
+extern void
+dmtxwRingClose(DmtxwRing *ring)
+{
+}
+
+extern DmtxPassFail
+dmtxwRingDecodeNext(DmtxwRing *ring, DmtxwSession *session, int timeout)
+{
+   return DmtxFail;
+}
+
+extern long
+dmtxwRingRunConsumer(DmtxwRing *ring, DmtxwSession *session)
+{
+   return 0;
+}
+
+extern const DmtxwRingResult *
+dmtxwRingReadResult(DmtxwRing *ring, int timeout)
+{
+   return NULL;
+}
+
+extern void
+dmtxwRingReleaseResult(DmtxwRing *ring)
+{
+}
+
+extern const DmtxwRingSymbol *
+dmtxwRingResultGetSymbol(const DmtxwRingResult *result, int index,
+      const unsigned char **payload)
+{
+   return NULL;
+}
+
+extern DmtxPassFail
+dmtxwRingGetStats(DmtxwRing *ring, long *published, long *dropped, long *reclaimed)
+{
+   return DmtxFail;
+}
+
+#endif
@@ -0,0 +1,500 @@
+/*
+libdmtxw - Shared native glue for the libdmtx wrappers
+
+Copyright (C) 2026 The libdmtx-wrappers project
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+Contact: mike@dragonflylogic.com
+*/
+
+/* $Id$ */
+
+/**
+ * @file dmtxwsession.c
+ * @brief Session lifetime, properties and result storage
+ */
+
+static const DmtxwPropName propNames[] = {
+   { "min_edge",         DmtxPropEdgeMin },
+   { "max_edge",         DmtxPropEdgeMax },
+   { "gap_size",         DmtxPropScanGap },
+   { "deviation",        DmtxPropSquareDevn },
+   { "shape",            DmtxPropSymbolSize },
+   { "threshold",        DmtxPropEdgeThresh },
+   { "x_min",            DmtxPropXmin },
+   { "x_max",            DmtxPropXmax },
+   { "y_min",            DmtxPropYmin },
+   { "y_max",            DmtxPropYmax },
+   { "shrink",           DmtxwPropShrink },
+   { "max_count",        DmtxwPropMaxCount },
+   { "timeout",          DmtxwPropTimeout },
+   { "search_share",     DmtxwPropSearchShare },
+   { "corrections",      DmtxwPropCorrections },
+   { "mosaic",           DmtxwPropMosaic },
+   { "luma",             DmtxwPropLuma },
+   { "threads",          DmtxwPropThreads },
+   { "locate",           DmtxwPropLocate },
+   { "min_sharpness",    DmtxwPropMinSharpness },
+   { "min_edge_density", DmtxwPropMinEdgeDensity },
+   { "auto_tune",        DmtxwPropAutoTune },
+   { "auto_tune_probe",  DmtxwPropAutoTuneProbe },
+   { NULL,               DmtxUndefined }
+};
+
+/**
+ * @brief  Allocate a session with every option at its default
+ * @return Address of new session, or NULL on failure
+ */
+extern DmtxwSession *
+dmtxwSessionCreate(void)
+{
+   DmtxwSession *session;
+
+   session = (DmtxwSession *)calloc(1, sizeof(DmtxwSession));
+   if(session == NULL)
+      return NULL;
+
+   dmtxwSessionResetProps(session);
+   session->status = DmtxwStatusComplete;
+
+   return session;
+}
+
+/**
+ * @brief  Free a session and everything it owns
+ * @param  session Address of session pointer, set to NULL on return
+ * @return DmtxPass | DmtxFail
+ */
+extern DmtxPassFail
+dmtxwSessionDestroy(DmtxwSession **session)
+{
+   if(session == NULL || *session == NULL)
+      return DmtxFail;
+
+   if((*session)->result != NULL)
+      free((*session)->result);
+
+   if((*session)->arena != NULL)
+      free((*session)->arena);
+
+   if((*session)->lumaBuf != NULL)
+      free((*session)->lumaBuf);
+
+   if((*session)->locateBuf != NULL)
+      free((*session)->locateBuf);
+
+   if((*session)->cellBuf != NULL)
+      free((*session)->cellBuf);
+
+   if((*session)->tuner != NULL) {
+      if((*session)->tuner->sample != NULL)
+         free((*session)->tuner->sample);
+      free((*session)->tuner);
+   }
+
+   free(*session);
+   *session = NULL;
+
+   return DmtxPass;
+}
+
+/**
+ * @brief  Restore every option to its default, keeping results and storage
+ * @param  session Session
+ * @return DmtxPass | DmtxFail
+ */
+extern DmtxPassFail
+dmtxwSessionResetProps(DmtxwSession *session)
+{
+   if(session == NULL)
+      return DmtxFail;
+
+   session->edgeMin = DmtxUndefined;
+   session->edgeMax = DmtxUndefined;
+   session->scanGap = DmtxUndefined;
+   session->squareDevn = DmtxUndefined;
+   session->sizeIdxExpected = DmtxUndefined;
+   session->edgeThresh = DmtxUndefined;
+   session->xMin = DmtxUndefined;
+   session->xMax = DmtxUndefined;
+   session->yMin = DmtxUndefined;
+   session->yMax = DmtxUndefined;
+   session->shrink = 1;
+   session->maxCount = DmtxUndefined;
+   session->timeout = DmtxUndefined;
+   session->searchShare = DMTXW_SEARCH_SHARE;
+   session->corrections = DmtxUndefined;
+   session->mosaic = DmtxFalse;
+   session->luma = 0;
+   session->threads = 0;
+   session->locate = 0;
+   session->minSharpness = DmtxUndefined;
+   session->minEdgeDensity = DmtxUndefined;
+   session->autoTune = 0;
+   session->autoTuneProbe = DMTXW_TUNE_PROBE_INTERVAL;
+
+   return DmtxPass;
+}
+
+/**
+ * @brief  Set a session property
+ * @param  session Session
+ * @param  prop A libdmtx decode property or a DmtxwProperty
+ * @param  value New value, DmtxUndefined restores the default
+ * @return DmtxPass | DmtxFail
+ */
+extern DmtxPassFail
+dmtxwSessionSetProp(DmtxwSession *session, int prop, int value)
+{
+   if(session == NULL)
+      return DmtxFail;
+
+   switch(prop) {
+      case DmtxPropEdgeMin:
+         session->edgeMin = value;
+         break;
+      case DmtxPropEdgeMax:
+         session->edgeMax = value;
+         break;
+      case DmtxPropScanGap:
+         session->scanGap = value;
+         break;
+      case DmtxPropSquareDevn:
+         session->squareDevn = value;
+         break;
+      case DmtxPropSymbolSize:
+         session->sizeIdxExpected = value;
+         break;
+      case DmtxPropEdgeThresh:
+         session->edgeThresh = value;
+         break;
+      case DmtxPropXmin:
+         session->xMin = value;
+         break;
+      case DmtxPropXmax:
+         session->xMax = value;
+         break;
+      case DmtxPropYmin:
+         session->yMin = value;
+         break;
+      case DmtxPropYmax:
+         session->yMax = value;
+         break;
+      case DmtxwPropShrink:
+         if(value != DmtxUndefined && value < 1)
+            return DmtxFail;
+         session->shrink = (value == DmtxUndefined) ? 1 : value;
+         break;
+      case DmtxwPropMaxCount:
+         session->maxCount = value;
+         break;
+      case DmtxwPropTimeout:
+         if(value != DmtxUndefined && value < 0)
+            return DmtxFail;
+         session->timeout = value;
+         break;
+      case DmtxwPropSearchShare:
+         if(value != DmtxUndefined && (value < 1 || value > 100))
+            return DmtxFail;
+         session->searchShare = (value == DmtxUndefined) ? DMTXW_SEARCH_SHARE : value;
+         break;
+      case DmtxwPropCorrections:
+         session->corrections = value;
+         break;
+      case DmtxwPropMosaic:
+         session->mosaic = (value == DmtxUndefined) ? DmtxFalse : (value != 0);
+         break;
+      case DmtxwPropLuma:
+         if(value != DmtxUndefined && value != 0 && value != 1 && value != 2 && value != 4)
+            return DmtxFail;
+         session->luma = (value == DmtxUndefined) ? 0 : value;
+         break;
+      case DmtxwPropThreads:
+         if(value != DmtxUndefined && (value < 0 || value > DMTXW_MAX_THREADS))
+            return DmtxFail;
+         session->threads = (value == DmtxUndefined) ? 0 : value;
+         break;
+      case DmtxwPropLocate:
+         if(value != DmtxUndefined && (value < 0 || value > DMTXW_LOCATE_MAX_CANDIDATES))
+            return DmtxFail;
+         session->locate = (value == DmtxUndefined) ? 0 : value;
+         break;
+      case DmtxwPropMinSharpness:
+         if(value != DmtxUndefined && value < 0)
+            return DmtxFail;
+         session->minSharpness = value;
+         break;
+      case DmtxwPropMinEdgeDensity:
+         if(value != DmtxUndefined && (value < 0 || value > 1000))
+            return DmtxFail;
+         session->minEdgeDensity = value;
+         break;
+      case DmtxwPropAutoTune:
+         if(value != DmtxUndefined && (value < 0 || value > DMTXW_TUNE_MAX_WINDOW))
+            return DmtxFail;
+         session->autoTune = (value == DmtxUndefined) ? 0 : value;
+         break;
+      case DmtxwPropAutoTuneProbe:
+         if(value != DmtxUndefined && value < 1)
+            return DmtxFail;
+         session->autoTuneProbe = (value == DmtxUndefined) ? DMTXW_TUNE_PROBE_INTERVAL : value;
+         break;
+      default:
+         return DmtxFail;
+   }
+
+   return DmtxPass;
+}
+
+/**
+ * @brief  Get a session property
+ * @param  session Session
+ * @param  prop A libdmtx decode property or a DmtxwProperty
+ * @return Current value, or DmtxUndefined if unknown
+ */
+extern int
+dmtxwSessionGetProp(DmtxwSession *session, int prop)
+{
+   if(session == NULL)
+      return DmtxUndefined;
+
+   switch(prop) {
+      case DmtxPropEdgeMin:
+         return session->edgeMin;
+      case DmtxPropEdgeMax:
+         return session->edgeMax;
+      case DmtxPropScanGap:
+         return session->scanGap;
+      case DmtxPropSquareDevn:
+         return session->squareDevn;
+      case DmtxPropSymbolSize:
+         return session->sizeIdxExpected;
+      case DmtxPropEdgeThresh:
+         return session->edgeThresh;
+      case DmtxPropXmin:
+         return session->xMin;
+      case DmtxPropXmax:
+         return session->xMax;
+      case DmtxPropYmin:
+         return session->yMin;
+      case DmtxPropYmax:
+         return session->yMax;
+      case DmtxwPropShrink:
+         return session->shrink;
+      case DmtxwPropMaxCount:
+         return session->maxCount;
+      case DmtxwPropTimeout:
+         return session->timeout;
+      case DmtxwPropSearchShare:
+         return session->searchShare;
+      case DmtxwPropCorrections:
+         return session->corrections;
+      case DmtxwPropMosaic:
+         return session->mosaic;
+      case DmtxwPropLuma:
+         return session->luma;
+      case DmtxwPropThreads:
+         return session->threads;
+      case DmtxwPropLocate:
+         return session->locate;
+      case DmtxwPropMinSharpness:
+         return session->minSharpness;
+      case DmtxwPropMinEdgeDensity:
+         return session->minEdgeDensity;
+      case DmtxwPropAutoTune:
+         return session->autoTune;
+      case DmtxwPropAutoTuneProbe:
+         return session->autoTuneProbe;
+   }
+
+   return DmtxUndefined;
+}
+
+/**
+ * @brief  Look up a property by the option name the scripting wrappers use
+ *         (e.g., "max_edge", "timeout")
+ * @param  name Option name
+ * @return Property value, or DmtxUndefined if the name is unknown
+ */
+extern int
+dmtxwPropByName(const char *name)
+{
+   int i;
+
+   if(name == NULL)
+      return DmtxUndefined;
+
+   for(i = 0; propNames[i].name != NULL; i++) {
+      if(strcmp(propNames[i].name, name) == 0)
+         return propNames[i].prop;
+   }
+
+   return DmtxUndefined;
+}
+
+/**
+ * @brief  Ask a decode running in another thread to stop. The decode returns
+ *         the results found so far with status DmtxwStatusCancelled. A
+ *         request made while no decode runs stops the next one; it is
+ *         consumed when a decode finishes.
+ * @param  session Session
+ * @return void
+ */
+extern void
+dmtxwSessionCancel(DmtxwSession *session)
+{
+   if(session != NULL)
+      session->cancelled = 1;
+}
+
+/**
+ * @brief  Number of results from the most recent decode
+ * @param  session Session
+ * @return Result count
+ */
+extern int
+dmtxwSessionGetResultCount(const DmtxwSession *session)
+{
+   return (session == NULL) ? 0 : session->resultCount;
+}
+
+/**
+ * @brief  Access one result of the most recent decode
+ * @param  session Session
+ * @param  idx Result index
+ * @return Result, or NULL if idx is out of range. Valid until the next decode.
+ */
+extern const DmtxwResult *
+dmtxwSessionGetResult(const DmtxwSession *session, int idx)
+{
+   if(session == NULL || idx < 0 || idx >= session->resultCount)
+      return NULL;
+
+   return &(session->result[idx]);
+}
+
+/**
+ * @brief  Access the payload of one result. The bytes are followed by a NUL
+ *         so they may also be used as a C string.
+ * @param  session Session
+ * @param  idx Result index
+ * @param  length Receives the payload length (optional)
+ * @return Payload, or NULL if idx is out of range. Valid until the next decode.
+ */
+extern const unsigned char *
+dmtxwSessionGetPayload(const DmtxwSession *session, int idx, size_t *length)
+{
+   const DmtxwResult *result;
+
+   result = dmtxwSessionGetResult(session, idx);
+   if(result == NULL)
+      return NULL;
+
+   if(length != NULL)
+      *length = result->payloadLength;
+
+   return session->arena + result->payloadOffset;
+}
+
+/**
+ * @brief  Attach a result cache to a session, or detach it. The cache is
+ *         not owned by the session and must outlive its use there; one
+ *         cache may serve several sessions. The attachment survives
+ *         dmtxwSessionResetProps().
+ * @param  session Session
+ * @param  cache Cache from dmtxwCacheCreate(), or NULL to stop caching
+ * @return DmtxPass | DmtxFail
+ */
+extern DmtxPassFail
+dmtxwSessionSetCache(DmtxwSession *session, DmtxwCache *cache)
+{
+   if(session == NULL)
+      return DmtxFail;
+
+   session->cache = cache;
+
+   return DmtxPass;
+}
+
+/**
+ * @brief  Forget the previous results while keeping their storage
+ * @param  session Session
+ * @return void
+ */
+static void
+ResetResults(DmtxwSession *session)
+{
+   session->resultCount = 0;
+   session->candidateCount = 0;
+   session->sharpness = 0;
+   session->edgeDensity = 0;
+   session->cached = DmtxFalse;
+   session->arenaSize = 0;
+   session->status = DmtxwStatusComplete;
+   session->halted = 0;
+}
+
+/**
+ * @brief  Add a result and copy its payload into the arena, growing both
+ *         geometrically so steady-state decoding does not allocate
+ * @param  session Session
+ * @param  payload Decoded bytes
+ * @param  length Number of decoded bytes
+ * @return New result with payload fields filled in, or NULL on failure
+ */
+static DmtxwResult *
+AppendResult(DmtxwSession *session, const unsigned char *payload, size_t length)
+{
+   DmtxwResult *result;
+   unsigned char *arena;
+   size_t capacity;
+
+   if(session->resultCount == session->resultCapacity) {
+      capacity = (session->resultCapacity == 0) ? DMTXW_RESULT_INIT_CAPACITY :
+            session->resultCapacity * 2;
+      result = (DmtxwResult *)realloc(session->result, capacity * sizeof(DmtxwResult));
+      if(result == NULL)
+         return NULL;
+      session->result = result;
+      session->resultCapacity = (int)capacity;
+      DMTXW_STATS_COUNT(DmtxwCounterAllocations, 1);
+   }
+
+   if(session->arenaSize + length + 1 > session->arenaCapacity) {
+      capacity = (session->arenaCapacity == 0) ? DMTXW_ARENA_INIT_CAPACITY :
+            session->arenaCapacity;
+      while(session->arenaSize + length + 1 > capacity)
+         capacity *= 2;
+      arena = (unsigned char *)realloc(session->arena, capacity);
+      if(arena == NULL)
+         return NULL;
+      session->arena = arena;
+      session->arenaCapacity = capacity;
+      DMTXW_STATS_COUNT(DmtxwCounterAllocations, 1);
+   }
+
+   result = &(session->result[session->resultCount]);
+   memset(result, 0x00, sizeof(DmtxwResult));
+   result->payloadOffset = session->arenaSize;
+   result->payloadLength = length;
+
+   memcpy(session->arena + session->arenaSize, payload, length);
+   session->arena[session->arenaSize + length] = '\0';
+   session->arenaSize += length + 1;
+   session->resultCount++;
+
+   return result;
+}
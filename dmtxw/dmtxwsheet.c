@@ -0,0 +1,487 @@
+/*
+libdmtxw - Shared native glue for the libdmtx wrappers
+
+Copyright (C) 2026 The libdmtx-wrappers project
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+Contact: mike@dragonflylogic.com
+*/
+
+/* $Id$ */
+
+/**
+ * @file dmtxwsheet.c
+ * @brief Label sheets: many symbols encoded in parallel onto one page
+ *
+ * A sheet of labels used to take one encode and one image per label,
+ * composited again in the host language. Here the payloads are encoded
+ * on up to spec->threads threads (libdmtx encoders share no state), each
+ * into its module grid only: the encoder renders at one pixel per module
+ * without quiet zone, which costs next to nothing. The grids are then
+ * drawn at the sheet's module size into a caller-owned 8bpp or 1bpp
+ * page, or handed to the vector writers of dmtxwvector.c as one page.
+ *
+ * Label positions are the top-left corner of the quiet zone, in page
+ * pixels for raster pages and output units for vector pages. A label
+ * that does not encode or does not fit on the page is skipped and its
+ * status set to DmtxFail.
+ */
+
+/**
+ * @brief  Default sheet options: 5 pixels per module, 2 modules of quiet
+ *         zone, libdmtx's scheme and size, one thread
+ * @param  spec Options to initialize
+ * @return void
+ */
+extern void
+dmtxwSheetSpecInit(DmtxwSheetSpec *spec)
+{
+   if(spec == NULL)
+      return;
+
+   spec->width = 0;
+   spec->height = 0;
+   spec->moduleSize = 5.0;
+   spec->margin = 2;
+   spec->scheme = DmtxUndefined;
+   spec->sizeRequest = DmtxUndefined;
+   spec->threads = 1;
+}
+
+/**
+ * @brief  Place labels in rows of a grid, left to right and top to bottom
+ * @param  labels Labels to place
+ * @param  count Number of labels
+ * @param  columns Labels per row
+ * @param  x Left edge of the first column
+ * @param  y Top edge of the first row
+ * @param  pitchX Distance between columns
+ * @param  pitchY Distance between rows
+ * @return DmtxPass | DmtxFail
+ */
+extern DmtxPassFail
+dmtxwSheetGrid(DmtxwSheetLabel *labels, int count, int columns, int x, int y,
+      int pitchX, int pitchY)
+{
+   int i;
+
+   if(labels == NULL || count < 0 || columns < 1)
+      return DmtxFail;
+
+   for(i = 0; i < count; i++) {
+      labels[i].x = x + (i % columns) * pitchX;
+      labels[i].y = y + (i / columns) * pitchY;
+   }
+
+   return DmtxPass;
+}
+
+/**
+ * @brief  Render labels into a raster page
+ * @param  spec Sheet options; width and height are page pixels and the
+ *         module size must be a whole number of pixels
+ * @param  labels Labels; their status is set
+ * @param  count Number of labels
+ * @param  page Page pixels, cleared to light first
+ * @param  rowSize Bytes per page row
+ * @param  format DmtxwSheetFormat value
+ * @return Number of labels drawn, or -1 on invalid options or lack of memory
+ */
+extern int
+dmtxwSheetRender(const DmtxwSheetSpec *spec, DmtxwSheetLabel *labels, int count,
+      unsigned char *page, int rowSize, int format)
+{
+   DmtxwVectorGrid *grid;
+   int i, drawn, moduleSize, minRowSize;
+
+   if(SheetCheckSpec(spec, labels, count) == DmtxFail || page == NULL)
+      return -1;
+
+   moduleSize = (int)spec->moduleSize;
+   if((double)moduleSize != spec->moduleSize)
+      return -1;
+
+   if(format == DmtxwSheetGray8)
+      minRowSize = spec->width;
+   else if(format == DmtxwSheetMono1)
+      minRowSize = (spec->width + 7) / 8;
+   else
+      return -1;
+   if(rowSize < minRowSize)
+      return -1;
+
+   grid = SheetEncode(spec, labels, count);
+   if(grid == NULL)
+      return -1;
+
+   memset(page, (format == DmtxwSheetGray8) ? 0xff : 0x00, (size_t)rowSize * spec->height);
+
+   for(i = 0, drawn = 0; i < count; i++) {
+      if(labels[i].status == DmtxFail)
+         continue;
+      SheetBlit(&(grid[i]), labels[i].x + spec->margin * moduleSize,
+            labels[i].y + spec->margin * moduleSize, moduleSize, page, rowSize, format);
+      drawn++;
+   }
+
+   for(i = 0; i < count; i++)
+      free(grid[i].dark);
+   free(grid);
+
+   return drawn;
+}
+
+/**
+ * @brief  Render labels as one vector page
+ * @param  spec Sheet options; width, height and module size are in output
+ *         units (SVG user units, PDF and EPS points)
+ * @param  labels Labels; their status is set
+ * @param  count Number of labels
+ * @param  format DmtxwVectorFormat value
+ * @param  out Receives the document; release with dmtxwBufferFree()
+ * @return Number of labels drawn, or -1 on invalid options or lack of memory
+ */
+extern int
+dmtxwSheetVector(const DmtxwSheetSpec *spec, DmtxwSheetLabel *labels, int count,
+      int format, DmtxwBuffer *out)
+{
+   DmtxwVectorGrid *grid;
+   DmtxwVectorPlace *place;
+   int i, drawn;
+   DmtxPassFail err;
+
+   if(SheetCheckSpec(spec, labels, count) == DmtxFail || out == NULL ||
+         (format != DmtxwVectorSvg && format != DmtxwVectorPdf && format != DmtxwVectorEps))
+      return -1;
+
+   place = (DmtxwVectorPlace *)calloc((size_t)count + 1, sizeof(DmtxwVectorPlace));
+   if(place == NULL)
+      return -1;
+
+   grid = SheetEncode(spec, labels, count);
+   if(grid == NULL) {
+      free(place);
+      return -1;
+   }
+
+   for(i = 0, drawn = 0; i < count; i++) {
+      if(labels[i].status == DmtxFail)
+         continue;
+      place[drawn].grid = grid[i];
+      place[drawn].x = labels[i].x + spec->margin * spec->moduleSize;
+      place[drawn].y = labels[i].y + spec->margin * spec->moduleSize;
+      drawn++;
+   }
+
+   err = VectorWrite(format, place, drawn, spec->moduleSize, (double)spec->width,
+         (double)spec->height, out);
+
+   for(i = 0; i < count; i++)
+      free(grid[i].dark);
+   free(grid);
+   free(place);
+
+   return (err == DmtxPass) ? drawn : -1;
+}
+
+/**
+ * @brief  Render labels into a document named by its format, as the
+ *         wrappers need it: "pgm" (8bpp) or "pbm" (1bpp) pages in binary
+ *         PNM with header, or "svg", "pdf" and "eps" vector pages
+ * @param  spec Sheet options, in pixels for pgm and pbm
+ * @param  labels Labels; their status is set
+ * @param  count Number of labels
+ * @param  format Format name
+ * @param  out Receives the document; release with dmtxwBufferFree()
+ * @return Number of labels drawn, or -1 on invalid options or lack of memory
+ */
+extern int
+dmtxwSheetWrite(const DmtxwSheetSpec *spec, DmtxwSheetLabel *labels, int count,
+      const char *format, DmtxwBuffer *out)
+{
+   char header[DMTXW_VECTOR_LINE_MAX];
+   int pageFormat, rowSize, drawn;
+   size_t headerLength, size;
+
+   if(format == NULL || spec == NULL || out == NULL)
+      return -1;
+
+   if(strcmp(format, "pgm") == 0)
+      pageFormat = DmtxwSheetGray8;
+   else if(strcmp(format, "pbm") == 0)
+      pageFormat = DmtxwSheetMono1;
+   else if(dmtxwVectorByName(format) != DmtxUndefined)
+      return dmtxwSheetVector(spec, labels, count, dmtxwVectorByName(format), out);
+   else
+      return -1;
+
+   if(spec->width < 1 || spec->height < 1)
+      return -1;
+
+   rowSize = (pageFormat == DmtxwSheetGray8) ? spec->width : (spec->width + 7) / 8;
+   sprintf(header, "%s\n%d %d\n%s", (pageFormat == DmtxwSheetGray8) ? "P5" : "P4",
+         spec->width, spec->height, (pageFormat == DmtxwSheetGray8) ? "255\n" : "");
+   headerLength = strlen(header);
+   size = headerLength + (size_t)rowSize * spec->height;
+
+   out->length = 0;
+   if(BufferReserve(out, size) == DmtxFail ||
+         BufferAppend(out, header, headerLength) == DmtxFail)
+      return -1;
+
+   drawn = dmtxwSheetRender(spec, labels, count, out->data + headerLength, rowSize,
+         pageFormat);
+   if(drawn >= 0)
+      out->length = size;
+
+   return drawn;
+}
+
+/**
+ * @brief  Validate sheet options and label list
+ * @param  spec Sheet options
+ * @param  labels Labels
+ * @param  count Number of labels
+ * @return DmtxPass | DmtxFail
+ */
+static DmtxPassFail
+SheetCheckSpec(const DmtxwSheetSpec *spec, const DmtxwSheetLabel *labels, int count)
+{
+   if(spec == NULL || count < 0 || (labels == NULL && count > 0))
+      return DmtxFail;
+
+   if(spec->width < 1 || spec->height < 1 || spec->moduleSize <= 0.0 ||
+         spec->margin < 0 || spec->margin > DMTXW_VECTOR_MAX_MARGIN ||
+         spec->threads < 1 || spec->threads > DMTXW_MAX_THREADS)
+      return DmtxFail;
+
+   return DmtxPass;
+}
+
+/**
+ * @brief  Encode every label into its module grid, on spec->threads threads
+ * @param  spec Sheet options
+ * @param  labels Labels; status says whether the label encoded and fits
+ * @param  count Number of labels
+ * @return Grids (one per label, dark NULL where status is DmtxFail), to be
+ *         freed with each grid; NULL if out of memory
+ */
+static DmtxwVectorGrid *
+SheetEncode(const DmtxwSheetSpec *spec, DmtxwSheetLabel *labels, int count)
+{
+   DmtxwSheetJob job;
+   DmtxwThread thread[DMTXW_MAX_THREADS];
+   int i, started, threads;
+
+   job.spec = spec;
+   job.label = labels;
+   job.count = count;
+   job.next = 0;
+   job.grid = (DmtxwVectorGrid *)calloc((size_t)count + 1, sizeof(DmtxwVectorGrid));
+   if(job.grid == NULL)
+      return NULL;
+
+   threads = (spec->threads < count) ? spec->threads : count;
+   if(threads > 1 && MutexInit(&(job.lock)) == DmtxFail)
+      threads = 1;
+   job.locked = (threads > 1);
+
+   /* The calling thread encodes too */
+   for(started = 1; started < threads; started++) {
+      if(ThreadStart(&(thread[started]), SheetWorker, &job) == DmtxFail)
+         break;
+   }
+   (void)SheetWorker(&job);
+
+   for(i = 1; i < started; i++)
+      ThreadJoin(&(thread[i]));
+
+   if(job.locked)
+      MutexDestroy(&(job.lock));
+
+   return job.grid;
+}
+
+/**
+ * @brief  Worker loop: encode labels until none are left
+ * @param  arg DmtxwSheetJob
+ * @return Nothing useful
+ */
+static DMTXW_THREAD_RETURN
+SheetWorker(void *arg)
+{
+   DmtxwSheetJob *job = (DmtxwSheetJob *)arg;
+   int idx;
+
+   for(;;) {
+      if(job->locked)
+         MutexLock(&(job->lock));
+      idx = job->next++;
+      if(job->locked)
+         MutexUnlock(&(job->lock));
+
+      if(idx >= job->count)
+         break;
+
+      job->label[idx].status = SheetEncodeLabel(job->spec, &(job->label[idx]),
+            &(job->grid[idx]));
+   }
+
+   return 0;
+}
+
+/**
+ * @brief  Encode one label and check that it fits on the page
+ * @param  spec Sheet options
+ * @param  label Label
+ * @param  grid Receives the module grid (no quiet zone); dark stays NULL
+ *         on failure
+ * @return DmtxPass | DmtxFail
+ */
+static DmtxPassFail
+SheetEncodeLabel(const DmtxwSheetSpec *spec, const DmtxwSheetLabel *label,
+      DmtxwVectorGrid *grid)
+{
+   DmtxEncode *enc;
+   DmtxPassFail err;
+   double width, height;
+
+   grid->dark = NULL;
+   if(label->data == NULL || label->dataSize < 1 || label->x < 0 || label->y < 0)
+      return DmtxFail;
+
+   enc = dmtxEncodeCreate();
+   if(enc == NULL)
+      return DmtxFail;
+
+   dmtxEncodeSetProp(enc, DmtxPropModuleSize, 1);
+   dmtxEncodeSetProp(enc, DmtxPropMarginSize, 0);
+   if(spec->scheme != DmtxUndefined)
+      dmtxEncodeSetProp(enc, DmtxPropScheme, spec->scheme);
+   if(spec->sizeRequest != DmtxUndefined)
+      dmtxEncodeSetProp(enc, DmtxPropSizeRequest, spec->sizeRequest);
+
+   err = dmtxEncodeDataMatrix(enc, label->dataSize, (unsigned char *)label->data);
+   if(err == DmtxPass)
+      err = VectorGridCreate(enc, 0, grid);
+
+   dmtxEncodeDestroy(&enc);
+
+   if(err == DmtxFail)
+      return DmtxFail;
+
+   width = (grid->width + 2 * spec->margin) * spec->moduleSize;
+   height = (grid->height + 2 * spec->margin) * spec->moduleSize;
+   if(label->x + width > spec->width || label->y + height > spec->height) {
+      free(grid->dark);
+      grid->dark = NULL;
+      return DmtxFail;
+   }
+
+   return DmtxPass;
+}
+
+/**
+ * @brief  Draw the dark modules of a grid into a raster page
+ * @param  grid Module grid
+ * @param  x Left edge of the symbol in page pixels
+ * @param  y Top edge of the symbol in page pixels
+ * @param  moduleSize Pixels per module
+ * @param  page Page pixels
+ * @param  rowSize Bytes per page row
+ * @param  format DmtxwSheetFormat value
+ * @return void
+ *
+ * Each module row is drawn once as runs of dark modules, then copied to
+ * the remaining pixel rows of the module. On 1bpp pages the first and
+ * last byte may be shared with a neighbouring label, so only the symbol's
+ * own bits of those are copied.
+ */
+static void
+SheetBlit(const DmtxwVectorGrid *grid, int x, int y, int moduleSize,
+      unsigned char *page, int rowSize, int format)
+{
+   const unsigned char *dark;
+   unsigned char *row, *copy, firstMask, lastMask;
+   int gx, gy, run, i, left, last, end;
+
+   end = x + grid->width * moduleSize;
+   if(format == DmtxwSheetGray8) {
+      left = x;
+      last = end - 1;
+      firstMask = lastMask = 0xff;
+   }
+   else {
+      left = x / 8;
+      last = (end - 1) / 8;
+      firstMask = (unsigned char)(0xff >> (x & 7));
+      lastMask = (unsigned char)(0xff << (7 - ((end - 1) & 7)));
+      if(left == last)
+         firstMask = lastMask = (unsigned char)(firstMask & lastMask);
+   }
+
+   for(gy = 0; gy < grid->height; gy++) {
+      dark = grid->dark + gy * grid->width;
+      row = page + (size_t)(y + gy * moduleSize) * rowSize;
+
+      for(gx = 0; gx < grid->width; gx += run) {
+         for(run = 1; gx + run < grid->width && (dark[gx + run] != 0) == (dark[gx] != 0); run++)
+            ;
+         if(dark[gx] == 0)
+            continue;
+
+         if(format == DmtxwSheetGray8)
+            memset(row + x + gx * moduleSize, 0x00, (size_t)run * moduleSize);
+         else
+            SheetSetBits(row, x + gx * moduleSize, run * moduleSize);
+      }
+
+      for(i = 1; i < moduleSize; i++) {
+         copy = row + (size_t)i * rowSize;
+         if(last > left + 1)
+            memcpy(copy + left + 1, row + left + 1, (size_t)(last - left - 1));
+         copy[left] = (unsigned char)((copy[left] & ~firstMask) | (row[left] & firstMask));
+         copy[last] = (unsigned char)((copy[last] & ~lastMask) | (row[last] & lastMask));
+      }
+   }
+}
+
+/**
+ * @brief  Set a span of bits in a 1bpp row, most significant bit first
+ * @param  row Row bytes
+ * @param  start First pixel
+ * @param  count Number of pixels
+ * @return void
+ */
+static void
+SheetSetBits(unsigned char *row, int start, int count)
+{
+   int end = start + count;
+   int first = start / 8, last = (end - 1) / 8;
+
+   if(count < 1)
+      return;
+
+   if(first == last) {
+      row[first] |= (unsigned char)((0xff >> (start & 7)) & (0xff << (7 - ((end - 1) & 7))));
+      return;
+   }
+
+   row[first] |= (unsigned char)(0xff >> (start & 7));
+   if(last > first + 1)
+      memset(row + first + 1, 0xff, (size_t)(last - first - 1));
+   row[last] |= (unsigned char)(0xff << (7 - ((end - 1) & 7)));
+}
@@ -0,0 +1,646 @@
+/*
+libdmtxw - Shared native glue for the libdmtx wrappers
+
+Copyright (C) 2026 The libdmtx-wrappers project
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+Contact: mike@dragonflylogic.com
+*/
+
+/* $Id$ */
+
+/**
+ * @file dmtxwstatic.h
+ * @brief Static header
+ */
+
+#ifndef __DMTXWSTATIC_H__
+#define __DMTXWSTATIC_H__
+
+#define DMTXW_RESULT_INIT_CAPACITY   8
+#define DMTXW_ARENA_INIT_CAPACITY    1024
+
+/* Region search runs in slices of this many milliseconds so that
+ * dmtxwSessionCancel() takes effect even without a timeout */
+#define DMTXW_SEARCH_SLICE_MSEC      50
+
+/* Default percentage of a time budget spent searching for regions; the
+ * rest is kept for decoding the regions found near its end */
+#define DMTXW_SEARCH_SHARE           90
+
+/* Columns converted per pass when box filtering (multiple of 4) */
+#define DMTXW_CONVERT_CHUNK          512
+
+/* SIMD kernels compiled into this build; the x86 ones are still only used
+ * when CPUID reports support at runtime. Each x86 kernel is marked with its
+ * target, so the build needs no -msse2 or -mavx2 (i386 compilers default to
+ * neither); compilers without target attributes only get the kernels their
+ * flags already enable. */
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#if defined(_MSC_VER)
+#define DMTXW_HAVE_SSE2
+#define DMTXW_TARGET_SSE2
+#if _MSC_VER >= 1700
+#define DMTXW_HAVE_AVX2
+#define DMTXW_TARGET_AVX2
+#endif
+#elif defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)))
+#define DMTXW_HAVE_SSE2
+#define DMTXW_TARGET_SSE2 __attribute__((target("sse2")))
+#define DMTXW_HAVE_AVX2
+#define DMTXW_TARGET_AVX2 __attribute__((target("avx2")))
+#elif defined(__SSE2__)
+#define DMTXW_HAVE_SSE2
+#define DMTXW_TARGET_SSE2
+#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define DMTXW_HAVE_NEON
+#endif
+
+/* Smallest tile advance in plane pixels; tiles also overlap by the
+ * diagonal of DmtxPropEdgeMax */
+#define DMTXW_TILE_MIN_STEP          512
+
+/* Upper bound for DmtxwPropThreads */
+#define DMTXW_MAX_THREADS            64
+
+/* Corners of duplicate symbols from overlapping tiles may differ by this
+ * many pixels, or a quarter of the symbol edge if that is larger */
+#define DMTXW_DEDUP_MIN_PIXELS       8
+
+/* Locator: plane downscale, cell size in plane pixels (the SSE2 kernel
+ * handles one 8-pixel cell per register) and the smallest gradient
+ * counted as an edge */
+#define DMTXW_LOCATE_SCALE           2
+#define DMTXW_LOCATE_CELL            8
+#define DMTXW_LOCATE_EDGE_MIN        24
+
+/* Locator cell acceptance: mean edge magnitude per pixel, and how far
+ * (percent) the edges must be from all parallel, i.e. 100 * (1 - R2) */
+#define DMTXW_LOCATE_ENERGY_MIN      16
+#define DMTXW_LOCATE_QUALITY_MIN     50
+
+/* Locator: score multiplier for boxes showing the finder signature and the
+ * upper bound for DmtxwPropLocate */
+#define DMTXW_LOCATE_FINDER_BONUS    2.0
+#define DMTXW_LOCATE_MAX_CANDIDATES  64
+
+/* Quality gate: sampling grid step in plane pixels and the smallest
+ * central difference counted as a strong edge */
+#define DMTXW_QUALITY_STEP           4
+#define DMTXW_QUALITY_EDGE_MIN       32
+
+/* Result cache: thumbnail grid (cells per side) and samples per cell side,
+ * sample grid over each cached symbol, default tolerance (mean absolute
+ * luminance difference) and the upper bound for its capacity */
+#define DMTXW_CACHE_GRID             16
+#define DMTXW_CACHE_CELL_SAMPLES     4
+#define DMTXW_CACHE_PATCH            16
+#define DMTXW_CACHE_TOLERANCE        4
+#define DMTXW_CACHE_MAX_ENTRIES      256
+
+/* Auto-tuner: largest DmtxwPropAutoTune window, default probe interval,
+ * successful decodes needed before tuning, margin (percent) around the
+ * observed symbol edges, module pixels kept after shrinking, scan lines
+ * crossing the smallest symbol, libdmtx's own scan gap and the largest
+ * shrink applied */
+#define DMTXW_TUNE_MAX_WINDOW        1024
+#define DMTXW_TUNE_PROBE_INTERVAL    20
+#define DMTXW_TUNE_MIN_FOUND         4
+#define DMTXW_TUNE_MARGIN            25
+#define DMTXW_TUNE_MODULE_PIXELS     3
+#define DMTXW_TUNE_GAP_LINES         4
+#define DMTXW_TUNE_GAP_DEFAULT       2
+#define DMTXW_TUNE_MAX_SHRINK        4
+
+/* Log messages: buffer size and the largest millisecond value printed */
+#define DMTXW_LOG_MAX                512
+#define DMTXW_LOG_MSEC_MAX           1.0e9
+
+/* Longest trace event written by the JSON writer */
+#define DMTXW_TRACE_LINE_MAX         512
+
+/* Frame ring: header magic ("DMRG"), most slots per ring, alignment of
+ * every shared structure (one cache line), busy polls before yielding and
+ * the sleep once yielding did not help either, default lease of a claimed
+ * frame and how often a waiting collector looks for expired leases */
+#define DMTXW_RING_MAGIC             0x444d5247u
+#define DMTXW_RING_MAX_SLOTS         65536
+#define DMTXW_RING_ALIGN             64
+#define DMTXW_RING_SPINS             64
+#define DMTXW_RING_SLEEP_USEC        50
+#define DMTXW_RING_LEASE_MSEC        10000
+#define DMTXW_RING_SCAN_MSEC         10
+
+/* Vector output: widest quiet zone (modules), longest formatted line and
+ * first allocation of a growing buffer */
+#define DMTXW_VECTOR_MAX_MARGIN      100
+#define DMTXW_VECTOR_LINE_MAX        512
+#define DMTXW_BUFFER_MIN             4096
+
+/* Printer labels: most dots per module edge */
+#define DMTXW_PRINTER_MAX_DOTS       64
+
+/* Encoder expansion: largest module and margin size in pixels */
+#define DMTXW_EXPAND_MAX_MODULE      1024
+#define DMTXW_EXPAND_MAX_MARGIN      65535
+
+/* Digits pair up into one ASCII codeword */
+#define DMTXW_ISDIGIT(n)             ((n) >= '0' && (n) <= '9')
+
+/* Largest PNM width or height accepted */
+#define DMTXW_PNM_MAX_SIDE           65535
+
+#if defined(_WIN32)
+typedef HANDLE DmtxwThread;
+typedef CRITICAL_SECTION DmtxwMutex;
+typedef LPTHREAD_START_ROUTINE DmtxwThreadFunc;
+#define DMTXW_THREAD_RETURN DWORD WINAPI
+#else
+typedef pthread_t DmtxwThread;
+typedef pthread_mutex_t DmtxwMutex;
+typedef void *(*DmtxwThreadFunc)(void *);
+#define DMTXW_THREAD_RETURN void *
+#endif
+
+/* Storage class of the per-thread instrumentation totals */
+#if defined(_MSC_VER)
+#define DMTXW_THREAD_LOCAL __declspec(thread)
+#else
+#define DMTXW_THREAD_LOCAL __thread
+#endif
+
+#ifndef M_PI
+#define M_PI      3.14159265358979323846
+#endif
+
+typedef struct DmtxwPropName_struct {
+   const char *name;
+   int         prop;
+} DmtxwPropName;
+
+/* Pixels libdmtx searches: the caller's buffer or its luminance plane */
+typedef struct DmtxwPlane_struct {
+   unsigned char  *pxl;
+   int             width;
+   int             height;
+   int             rowSizeBytes;
+   int             format;
+   int             bytesPerPixel;
+   int             scale;          /* Caller pixels per plane pixel */
+} DmtxwPlane;
+
+/* Rectangle of the plane in top-down plane coordinates */
+typedef struct DmtxwTile_struct {
+   int             x;
+   int             y;
+   int             width;
+   int             height;
+} DmtxwTile;
+
+/* State shared by every tile of one dmtxwSessionDecode() call */
+typedef struct DmtxwScan_struct {
+   DmtxwSession   *session;
+   DmtxwPlane     *plane;
+   DmtxTime       *deadline;       /* Nothing is decoded after this */
+   DmtxTime       *searchDeadline; /* No region search starts after this */
+   DmtxwMutex     *lock;           /* NULL when searching on one thread */
+} DmtxwScan;
+
+/* Locator statistics for one cell; next queues cells while grouping */
+typedef struct DmtxwCell_struct {
+   unsigned int    bin[8];         /* Gradient energy at k * 22.5 degrees */
+   double          c4;             /* Resultant of the bins at 4 * phi */
+   double          s4;
+   double          score;
+   int             label;
+   int             next;
+} DmtxwCell;
+
+typedef enum {
+   DmtxwLineOther,
+   DmtxwLineSolid,
+   DmtxwLineTiming
+} DmtxwLineClass;
+
+typedef void (*GradientRowFunc)(const unsigned char *above, const unsigned char *row,
+      const unsigned char *below, DmtxwCell *cell, int cols);
+
+struct DmtxwPool_struct;
+
+/* One thread of a tiled search and the run of tiles it owns */
+typedef struct DmtxwWorker_struct {
+   struct DmtxwPool_struct *pool;
+   DmtxwThread     thread;
+   int             index;
+   int             head;           /* Next tile taken by this worker */
+   int             tail;           /* One past the last tile, stolen from the back */
+   DmtxwStatus     status;
+   DmtxPassFail    err;
+#if defined(DMTXW_STATS)
+   DmtxwStats      stats;          /* Totals of a spawned thread, for the caller */
+#endif
+} DmtxwWorker;
+
+typedef struct DmtxwPool_struct {
+   DmtxwScan      *scan;
+   DmtxwTile      *tile;
+   int             tileCount;
+   DmtxwWorker    *worker;
+   int             workerCount;
+   int             stopped;
+} DmtxwPool;
+
+/* Key and thumbnail of a plane, compared against the cache entries */
+typedef struct DmtxwCachePrint_struct {
+   unsigned long   key;            /* Hash of geometry, format and decode options */
+   unsigned char   thumb[DMTXW_CACHE_GRID * DMTXW_CACHE_GRID];
+} DmtxwCachePrint;
+
+/* One remembered frame and its decode outcome */
+typedef struct DmtxwCacheEntry_struct {
+   int             used;
+   unsigned long   key;
+   unsigned char   thumb[DMTXW_CACHE_GRID * DMTXW_CACHE_GRID];
+   DmtxwResult    *result;
+   unsigned char  *patch;          /* DMTXW_CACHE_PATCH^2 samples per result */
+   int             resultCount;
+   int             resultCapacity;
+   unsigned char  *arena;
+   size_t          arenaCapacity;
+   DmtxwStatus     status;
+   int             sharpness;
+   int             edgeDensity;
+   DmtxTime        expires;
+   unsigned long   lastUsed;
+} DmtxwCacheEntry;
+
+struct DmtxwCache_struct {
+   DmtxwCacheEntry *entry;
+   int             capacity;
+   int             ttl;
+   int             tolerance;
+   unsigned long   tick;           /* Advances on every lookup and store */
+   long            hits;
+   long            misses;
+   DmtxwMutex      lock;
+};
+
+/* Outcome of one decode as seen by the auto-tuner */
+typedef struct DmtxwTuneSample_struct {
+   int             found;          /* Symbols found, 0 for a miss */
+   int             edgeMin;        /* Shortest and longest symbol side (full resolution) */
+   int             edgeMax;
+   int             moduleMin;      /* Smallest module size (full resolution) */
+   int             sizeIdx;        /* Symbol size shared by all symbols, or DmtxUndefined */
+   int             angleMin;
+   int             angleMax;
+   int             contrastMin;
+   double          msec;
+   int             probe;          /* Decoded with the caller's own options */
+} DmtxwTuneSample;
+
+/* Options the auto-tuner may narrow; DmtxUndefined (shrink 1) leaves the
+ * caller's value alone */
+typedef struct DmtxwTuneParams_struct {
+   int             edgeMin;
+   int             edgeMax;
+   int             sizeIdx;
+   int             scanGap;
+   int             shrink;
+} DmtxwTuneParams;
+
+typedef struct DmtxwTuner_struct {
+   DmtxwTuneSample *sample;        /* Ring of the last capacity decodes */
+   int             capacity;
+   int             count;
+   int             next;
+   int             sinceProbe;
+   int             missed;         /* Last tuned decode found nothing */
+   int             tuned;          /* active narrows at least the symbol edges */
+   int             probing;        /* Current decode uses the caller's options */
+   DmtxwTuneParams active;
+   DmtxwTuneParams saved;          /* Caller's options during a tuned decode */
+   DmtxTime        start;
+} DmtxwTuner;
+
+/* Trace writer; with a minimum duration, the events of a decode are held
+ * back until its end shows whether it was slow enough to keep */
+struct DmtxwTraceJson_struct {
+   FILE           *fp;
+   DmtxwMutex      lock;
+   double          minMsec;        /* Shortest decode written, 0 for all */
+   double          decodeStart;
+   int             holding;        /* Inside a decode that is held back */
+   int             keep;           /* Last decode was kept, so are events after it */
+   int             written;        /* An event was written, the next needs a comma */
+   DmtxwBuffer     pending;
+};
+
+/* Counter alone on its cache line, so producer and consumers don't share one */
+typedef struct DmtxwRingCounter_struct {
+   volatile unsigned int value;
+   char            pad[DMTXW_RING_ALIGN - sizeof(unsigned int)];
+} DmtxwRingCounter;
+
+/* Start of the shared memory object; frame slots and result slots follow */
+typedef struct DmtxwRingHeader_struct {
+   unsigned int    magic;
+   unsigned int    layout;         /* Structure sizes of the creating build */
+   int             slotCount;
+   int             resultCount;
+   size_t          slotStride;
+   size_t          resultStride;
+   size_t          size;
+   volatile unsigned int closed;
+   volatile int    leaseMsec;      /* Longest a consumer may hold a slot */
+   volatile unsigned int done;     /* Frames decoded and accounted for */
+   volatile unsigned int dropped;  /* Results lost to a full result ring or
+                                      a consumer that died storing one */
+   volatile unsigned int reclaimed; /* Frames taken back from late consumers */
+   DmtxwRingCounter head;          /* Next frame the producer publishes */
+   DmtxwRingCounter claim;         /* Next frame a consumer takes */
+   DmtxwRingCounter resultHead;    /* Next result slot a consumer fills */
+   DmtxwRingCounter resultTail;    /* Next result the collector reads */
+} DmtxwRingHeader;
+
+/* Frame slot header, followed by the pixels. seq is pos while free for
+ * frame pos, pos + 1 once published and pos + slotCount when decoded or
+ * reclaimed. lease is renewed by the consumer that claims the frame. */
+typedef struct DmtxwRingFrame_struct {
+   volatile unsigned int seq;
+   volatile unsigned int lease;    /* RingClock() value the claim expires */
+   unsigned int    frame;
+   int             width;
+   int             height;
+   int             rowSizeBytes;
+   int             format;
+   DmtxTime        published;
+} DmtxwRingFrame;
+
+/* Result slot, with the same seq protocol as frame slots. The consumer
+ * that claims it stamps owner with its pos and starts the lease. */
+typedef struct DmtxwRingSlot_struct {
+   volatile unsigned int seq;
+   volatile unsigned int lease;    /* RingClock() value the claim expires */
+   volatile unsigned int owner;    /* pos the lease belongs to */
+   DmtxwRingResult result;
+} DmtxwRingSlot;
+
+/* Process-local handle of a mapped ring */
+struct DmtxwRing_struct {
+   int             fd;
+   DmtxBoolean     owner;          /* Created here; close fd on destroy */
+   size_t          size;
+   unsigned char  *base;
+   DmtxwRingHeader *header;
+};
+
+/* Module grid of an encoded symbol with its quiet zone, top row first */
+typedef struct DmtxwVectorGrid_struct {
+   unsigned char  *dark;           /* 1 dark, 0 light, 2 dark and already covered */
+   int             width;
+   int             height;
+} DmtxwVectorGrid;
+
+/* A grid placed on a page, top-left corner in output units */
+typedef struct DmtxwVectorPlace_struct {
+   DmtxwVectorGrid grid;
+   double          x;
+   double          y;
+} DmtxwVectorPlace;
+
+/* Labels of a sheet shared by the encoding threads */
+typedef struct DmtxwSheetJob_struct {
+   const DmtxwSheetSpec *spec;
+   DmtxwSheetLabel *label;
+   DmtxwVectorGrid *grid;
+   int             count;
+   int             next;           /* Next label to encode */
+   int             locked;         /* Nonzero when lock guards next */
+   DmtxwMutex      lock;
+} DmtxwSheetJob;
+
+typedef DmtxPassFail (*DmtxwRectFunc)(DmtxwBuffer *out, int x, int y, int width,
+      int height, int gridHeight);
+
+typedef void (*LumaRowFunc)(unsigned char *dst, const unsigned char *src,
+      int width, int bytesPerPixel, const int weight[4]);
+
+/* Repeats a 4-byte pixel count times (dmtxwexpand.c) */
+typedef void (*ExpandFillFunc)(unsigned char *dst, const unsigned char pixel[4], int count);
+
+/* dmtxwsession.c */
+static void ResetResults(DmtxwSession *session);
+static DmtxwResult *AppendResult(DmtxwSession *session, const unsigned char *payload, size_t length);
+
+/* dmtxwconvert.c */
+static void GetLumaWeights(int format, int weight[4]);
+static LumaRowFunc GetRowFunc(void);
+static int DetectKernel(void);
+static LumaRowFunc KernelRowFunc(int kernel);
+static void AccumulateLine(unsigned short *acc, const unsigned char *line, int count, int scale);
+static void LumaRowCopy(unsigned char *dst, const unsigned char *src, int width, int bytesPerPixel, const int weight[4]);
+static void LumaRowScalar(unsigned char *dst, const unsigned char *src, int width, int bytesPerPixel, const int weight[4]);
+#if defined(DMTXW_HAVE_SSE2) || defined(DMTXW_HAVE_AVX2)
+static int LoadUnaligned32(const unsigned char *p);
+#endif
+#if defined(DMTXW_HAVE_SSE2)
+DMTXW_TARGET_SSE2 static __m128i LumaSse2(__m128i v, __m128i wEven, __m128i wOdd);
+DMTXW_TARGET_SSE2 static void LumaRowSse2(unsigned char *dst, const unsigned char *src, int width, int bytesPerPixel, const int weight[4]);
+static DmtxBoolean CpuHasSse2(void);
+#endif
+#if defined(DMTXW_HAVE_AVX2)
+DMTXW_TARGET_AVX2 static __m256i LumaAvx2(__m256i v, __m256i wEven, __m256i wOdd);
+DMTXW_TARGET_AVX2 static void LumaRowAvx2(unsigned char *dst, const unsigned char *src, int width, int bytesPerPixel, const int weight[4]);
+static DmtxBoolean CpuHasAvx2(void);
+#endif
+#if defined(DMTXW_HAVE_NEON)
+static void LumaRowNeon(unsigned char *dst, const unsigned char *src, int width, int bytesPerPixel, const int weight[4]);
+#endif
+
+/* dmtxwdecode.c */
+static void FinishDecode(DmtxwSession *session);
+static DmtxPassFail SearchPlane(DmtxwSession *session, DmtxwPlane *plane, DmtxTime start, DmtxTime *deadline, unsigned char *pxl, int width, int height, int rowSizeBytes, int format);
+static DmtxPassFail PrepareSearchPlane(DmtxwSession *session, DmtxwPlane *plane, unsigned char *pxl, int width, int height, int rowSizeBytes, int format);
+static DmtxPassFail DecodeTile(DmtxwScan *scan, const DmtxwTile *tile, DmtxwStatus *status);
+static DmtxPassFail AddResult(DmtxwScan *scan, const DmtxwResult *found, const unsigned char *payload, size_t length);
+static DmtxPassFail ApplyDecodeProps(DmtxwSession *session, DmtxDecode *dec, const DmtxwPlane *plane, const DmtxwTile *tile);
+static DmtxRegion *FindNextRegion(DmtxwScan *scan, const DmtxwTile *tile, DmtxDecode *dec, DmtxwStatus *status);
+static DmtxTime SplitBudget(DmtxTime start, DmtxTime deadline, int share);
+static DmtxBoolean TimeBefore(DmtxTime t0, DmtxTime t1);
+static void StoreGeometry(DmtxwResult *result, DmtxRegion *reg, int shrink, const DmtxwPlane *plane, const DmtxwTile *tile);
+
+/* dmtxwtile.c */
+static DmtxPassFail DecodeTiled(DmtxwScan *scan);
+static DmtxPassFail DecodeTiles(DmtxwScan *scan, DmtxwTile *tile, int tileCount);
+static DmtxPassFail PlanTiles(DmtxwScan *scan, DmtxwPool *pool);
+static DmtxBoolean TileIntersectsRoi(DmtxwScan *scan, const DmtxwTile *tile);
+static DMTXW_THREAD_RETURN TileWorker(void *arg);
+static int NextTile(DmtxwWorker *worker);
+static DmtxBoolean IsDuplicate(DmtxwSession *session, const DmtxwResult *found, const unsigned char *payload, size_t length);
+static int CompareResults(const void *a, const void *b);
+static int StatusRank(DmtxwStatus status);
+
+/* dmtxwstats.c */
+#if defined(DMTXW_STATS)
+static void StatsAbsorb(const DmtxwStats *stats);
+#endif
+
+/* dmtxwtrace.c */
+static void TraceSpan(DmtxwSession *session, int span, int begin, int outcome, const DmtxwResult *found);
+static void TraceDecodeEnd(DmtxwSession *session);
+static void TraceSetThread(int thread);
+static int TraceJsonFormat(const DmtxwTraceEvent *event, char *line);
+static void TraceJsonPut(DmtxwTraceJson *writer, const char *data, size_t length);
+
+/* dmtxwlocate.c */
+static DmtxPassFail DecodeCandidates(DmtxwScan *scan, unsigned char *pxl, int width, int height, int rowSizeBytes, int format);
+static void MeasureCells(unsigned char *plane, int stride, int width, int height, DmtxwCell *cell, int cols, int rows);
+static GradientRowFunc GetGradientFunc(void);
+static void GradientRowScalar(const unsigned char *above, const unsigned char *row, const unsigned char *below, DmtxwCell *cell, int cols);
+#if defined(DMTXW_HAVE_SSE2)
+DMTXW_TARGET_SSE2 static __m128i Load8Widen(const unsigned char *p);
+DMTXW_TARGET_SSE2 static void GradientRowSse2(const unsigned char *above, const unsigned char *row, const unsigned char *below, DmtxwCell *cell, int cols);
+#endif
+static void ScoreCells(DmtxwCell *cell, int cols, int rows);
+static int GroupCells(const unsigned char *plane, int stride, DmtxwCell *cell, int cols, int rows, int width, int height, DmtxwBox *box, int maxBoxes);
+static DmtxBoolean HasFinderSignature(const unsigned char *plane, int stride, int x0, int y0, int x1, int y1);
+static int ClassifyLine(const unsigned char *p, int step, int length, int thresh);
+
+/* dmtxwquality.c */
+static DmtxPassFail MeasureQuality(const DmtxwPlane *plane, int *sharpness, int *edgeDensity);
+static int SampleLuma(const unsigned char *p, int bytesPerPixel, const int weight[4]);
+static DmtxwStatus CheckQuality(DmtxwSession *session, const DmtxwPlane *plane);
+
+/* dmtxwcache.c */
+static void CachePrint(DmtxwSession *session, const DmtxwPlane *plane, DmtxwCachePrint *print);
+static unsigned long HashInt(unsigned long key, int value);
+static void SamplePatch(const DmtxwPlane *plane, const DmtxwResult *result, unsigned char *patch);
+static long SumAbsDiff(const unsigned char *a, const unsigned char *b, int count);
+static DmtxBoolean CacheLookup(DmtxwSession *session, const DmtxwPlane *plane, const DmtxwCachePrint *print);
+static void CacheStore(DmtxwSession *session, const DmtxwPlane *plane, const DmtxwCachePrint *print);
+
+/* dmtxwtune.c */
+static DmtxPassFail TuneBegin(DmtxwSession *session);
+static void TuneEnd(DmtxwSession *session);
+static void TuneReset(DmtxwTuner *tuner);
+static void MeasureSample(DmtxwSession *session, DmtxwTuneSample *sample);
+static double CornerDistance(const DmtxPixelLoc *a, const DmtxPixelLoc *b);
+static void TuneUpdate(DmtxwSession *session);
+static void TuneLog(DmtxwSession *session, int found);
+
+/* dmtxwring.c */
+#if !defined(_WIN32)
+static DmtxPassFail PublishResult(DmtxwRing *ring, unsigned int frameNumber, DmtxTime published,
+      DmtxwSession *session, DmtxPassFail err);
+static DmtxwRing *RingMap(int fd, size_t size);
+static DmtxwRingFrame *RingFrame(DmtxwRing *ring, unsigned int pos);
+static DmtxwRingSlot *RingSlot(DmtxwRing *ring, unsigned int pos);
+static size_t RingAlign(size_t size);
+static unsigned int RingLayout(void);
+static void RingBackoff(int *spins);
+static unsigned int RingLoad(volatile unsigned int *value);
+static void RingStore(volatile unsigned int *value, unsigned int n);
+static DmtxBoolean RingClaim(volatile unsigned int *value, unsigned int pos);
+static DmtxBoolean RingSwap(volatile unsigned int *value, unsigned int from, unsigned int to);
+static DmtxBoolean RingReclaim(DmtxwRing *ring, unsigned int pos);
+static void RingReclaimAll(DmtxwRing *ring);
+static DmtxBoolean RingReclaimResult(DmtxwRing *ring, unsigned int pos);
+static unsigned int RingLeaseEnd(DmtxwRing *ring);
+static unsigned int RingClock(void);
+static void RingAdd(volatile unsigned int *value, int n);
+#endif
+
+/* dmtxwvector.c */
+static DmtxPassFail VectorGridCreate(DmtxEncode *enc, int margin, DmtxwVectorGrid *grid);
+static DmtxPassFail VectorMergeRects(DmtxwVectorGrid *grid, DmtxwRectFunc func, DmtxwBuffer *out);
+static DmtxPassFail VectorWriteSvg(DmtxwVectorPlace *place, int count, double moduleSize,
+      double width, double height, DmtxwBuffer *out);
+static DmtxPassFail VectorWritePdf(DmtxwVectorPlace *place, int count, double moduleSize,
+      double width, double height, DmtxwBuffer *out);
+static DmtxPassFail VectorWriteEps(DmtxwVectorPlace *place, int count, double moduleSize,
+      double width, double height, DmtxwBuffer *out);
+static DmtxPassFail VectorWrite(int format, DmtxwVectorPlace *place, int count,
+      double moduleSize, double width, double height, DmtxwBuffer *out);
+static DmtxPassFail VectorRectSvg(DmtxwBuffer *out, int x, int y, int width, int height, int gridHeight);
+static DmtxPassFail VectorRectPdf(DmtxwBuffer *out, int x, int y, int width, int height, int gridHeight);
+static DmtxPassFail VectorRectEps(DmtxwBuffer *out, int x, int y, int width, int height, int gridHeight);
+static DmtxPassFail BufferAppend(DmtxwBuffer *buffer, const char *data, size_t length);
+static DmtxPassFail BufferReserve(DmtxwBuffer *buffer, size_t capacity);
+
+/* dmtxwprinter.c */
+static DmtxPassFail PrinterWriteZpl(DmtxEncode *enc, const unsigned char *data, int dataSize,
+      int dots, int origin, DmtxwBuffer *out);
+static DmtxPassFail PrinterWriteZplGraphic(DmtxwVectorGrid *grid, int dots, int origin, DmtxwBuffer *out);
+static DmtxPassFail PrinterWriteEplGraphic(DmtxwVectorGrid *grid, int dots, int origin, DmtxwBuffer *out);
+static void PrinterPackRow(const unsigned char *dark, int width, int dots, int darkBit,
+      unsigned char *row, int rowBytes);
+static DmtxPassFail PrinterZplRun(DmtxwBuffer *out, char digit, int count);
+
+/* dmtxwsheet.c */
+static DmtxPassFail SheetCheckSpec(const DmtxwSheetSpec *spec, const DmtxwSheetLabel *labels, int count);
+static DmtxwVectorGrid *SheetEncode(const DmtxwSheetSpec *spec, DmtxwSheetLabel *labels, int count);
+static DMTXW_THREAD_RETURN SheetWorker(void *arg);
+static DmtxPassFail SheetEncodeLabel(const DmtxwSheetSpec *spec, const DmtxwSheetLabel *label,
+      DmtxwVectorGrid *grid);
+static void SheetBlit(const DmtxwVectorGrid *grid, int x, int y, int moduleSize,
+      unsigned char *page, int rowSize, int format);
+static void SheetSetBits(unsigned char *row, int start, int count);
+
+/* dmtxwpnm.c */
+static DmtxPassFail PnmLoad(const char *path, DmtxwPnm *pnm);
+static size_t PnmParseHeader(const unsigned char *data, size_t size, DmtxwPnm *pnm, int *maxval);
+static void PnmRescale(DmtxwPnm *pnm, int maxval);
+static DmtxPassFail PnmParseNumber(const unsigned char *data, size_t size, size_t *pos, int *value);
+static DmtxBoolean PnmIsSpace(unsigned char c);
+
+/* dmtxwthread.c */
+static DmtxPassFail ThreadStart(DmtxwThread *thread, DmtxwThreadFunc func, void *arg);
+static void ThreadJoin(DmtxwThread *thread);
+static DmtxPassFail MutexInit(DmtxwMutex *mutex);
+static void MutexDestroy(DmtxwMutex *mutex);
+static void MutexLock(DmtxwMutex *mutex);
+static void MutexUnlock(DmtxwMutex *mutex);
+
+/* dmtxwsymbol.c */
+static int SymbolCountAscii(const unsigned char *data, int dataSize);
+static int SymbolCountC40Text(const unsigned char *data, int dataSize, int scheme);
+static int SymbolCountX12(const unsigned char *data, int dataSize);
+static int SymbolCountEdifact(const unsigned char *data, int dataSize);
+
+/* dmtxwexpand.c */
+static int ExpandRowBytes(int width, int format);
+static void ExpandModuleRow(DmtxEncode *enc, const DmtxwSymbolInfo *info, int symbolRow,
+      unsigned char *row, int width, int format, ExpandFillFunc fill);
+static int ExpandModuleDark(DmtxEncode *enc, int symbolRow, int col);
+static void ExpandFill(unsigned char *row, int x, int count, int dark, int format,
+      ExpandFillFunc fill);
+static void ExpandDarkPixel(int format, unsigned char pixel[4]);
+static ExpandFillFunc GetExpandFill(void);
+static void ExpandFillScalar(unsigned char *dst, const unsigned char pixel[4], int count);
+#if defined(DMTXW_HAVE_SSE2)
+DMTXW_TARGET_SSE2 static void ExpandFillSse2(unsigned char *dst, const unsigned char pixel[4], int count);
+#endif
+#if defined(DMTXW_HAVE_AVX2)
+DMTXW_TARGET_AVX2 static void ExpandFillAvx2(unsigned char *dst, const unsigned char pixel[4],
+      int count);
+#endif
+#if defined(DMTXW_HAVE_NEON)
+static void ExpandFillNeon(unsigned char *dst, const unsigned char pixel[4], int count);
+#endif
+
+#endif
@@ -0,0 +1,225 @@
+/*
+libdmtxw - Shared native glue for the libdmtx wrappers
+
+Copyright (C) 2026 The libdmtx-wrappers project
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+Contact: mike@dragonflylogic.com
+*/
+/* $Id$ */
+
+/**
+ * @file dmtxwstats.c
+ * @brief Per-thread instrumentation counters and phase timers
+ *
+ * Each thread adds to its own totals, so the hot path takes no lock. A
+ * decode split into tiles hands the totals of its worker threads to the
+ * calling thread before it returns, and dmtxwStatsGet() reads the totals of
+ * the calling thread only: a wrapper that decodes on one thread sees every
+ * decode it made. Without DMTXW_STATS the hooks compile to nothing and
+ * dmtxwStatsGet() reports zeros.
+ */
+
+/* Flat view of DmtxwStats for the wrappers, phases first */
+static const char *statsNames[] = {
+   "convert_calls", "convert_ms", "setup_calls", "setup_ms",
+   "search_calls", "search_ms", "decode_calls", "decode_ms",
+   "marshal_calls", "marshal_ms",
+   "regions_tried", "regions_decoded", "bytes_converted", "allocations",
+   NULL
+};
+
+#if defined(DMTXW_STATS)
+static DMTXW_THREAD_LOCAL DmtxwStats threadStats;
+#endif
+
+/**
+ * @brief  Tell whether this build counts anything
+ * @return DmtxTrue if libdmtxw was built with DMTXW_STATS
+ */
+extern DmtxBoolean
+dmtxwStatsEnabled(void)
+{
+#if defined(DMTXW_STATS)
+   return DmtxTrue;
+#else
+   return DmtxFalse;
+#endif
+}
+
+/**
+ * @brief  Read the totals of the calling thread
+ * @param  stats Receives the totals (all zero without DMTXW_STATS)
+ * @return DmtxPass | DmtxFail (built without DMTXW_STATS)
+ */
+extern DmtxPassFail
+dmtxwStatsGet(DmtxwStats *stats)
+{
+   if(stats == NULL)
+      return DmtxFail;
+
+#if defined(DMTXW_STATS)
+   *stats = threadStats;
+   return DmtxPass;
+#else
+   memset(stats, 0x00, sizeof(DmtxwStats));
+   return DmtxFail;
+#endif
+}
+
+/**
+ * @brief  Clear the totals of the calling thread
+ * @return void
+ */
+extern void
+dmtxwStatsReset(void)
+{
+#if defined(DMTXW_STATS)
+   memset(&threadStats, 0x00, sizeof(DmtxwStats));
+#endif
+}
+
+/**
+ * @brief  Add one set of totals to another
+ * @param  dst Totals to add to
+ * @param  src Totals to add
+ * @return void
+ */
+extern void
+dmtxwStatsMerge(DmtxwStats *dst, const DmtxwStats *src)
+{
+   int i;
+
+   for(i = 0; i < DmtxwPhaseCount; i++) {
+      dst->calls[i] += src->calls[i];
+      dst->msec[i] += src->msec[i];
+   }
+
+   for(i = 0; i < DmtxwCounterCount; i++)
+      dst->count[i] += src->count[i];
+}
+
+/**
+ * @brief  Name of a value in the flat view of DmtxwStats, e.g. "search_ms"
+ *         or "regions_tried"
+ * @param  idx Value index, from 0
+ * @return Name, or NULL past the last value
+ */
+extern const char *
+dmtxwStatsName(int idx)
+{
+   if(idx < 0 || idx >= (int)(sizeof(statsNames) / sizeof(statsNames[0])))
+      return NULL;
+
+   return statsNames[idx];
+}
+
+/**
+ * @brief  Value in the flat view of DmtxwStats
+ * @param  stats Totals
+ * @param  idx Value index, as for dmtxwStatsName()
+ * @return Value, 0 for an unknown index
+ */
+extern double
+dmtxwStatsValue(const DmtxwStats *stats, int idx)
+{
+   if(stats == NULL || dmtxwStatsName(idx) == NULL)
+      return 0.0;
+
+   if(idx < 2 * DmtxwPhaseCount)
+      return (idx % 2 == 0) ? (double)stats->calls[idx / 2] : stats->msec[idx / 2];
+
+   return stats->count[idx - 2 * DmtxwPhaseCount];
+}
+
+/**
+ * @brief  Read the monotonic clock
+ * @return Milliseconds since an arbitrary starting point
+ */
+extern double
+dmtxwStatsClock(void)
+{
+#if defined(_WIN32)
+   static LARGE_INTEGER frequency;
+   LARGE_INTEGER now;
+
+   if(frequency.QuadPart == 0)
+      QueryPerformanceFrequency(&frequency);
+   QueryPerformanceCounter(&now);
+
+   return (double)now.QuadPart * 1000.0 / (double)frequency.QuadPart;
+#else
+   struct timespec now;
+
+   clock_gettime(CLOCK_MONOTONIC, &now);
+
+   return (double)now.tv_sec * 1000.0 + (double)now.tv_nsec / 1.0e6;
+#endif
+}
+
+/**
+ * @brief  Count one pass through a phase (see DMTXW_STATS_STOP)
+ * @param  phase DmtxwPhase value
+ * @param  msec Time spent in it
+ * @return void
+ */
+extern void
+dmtxwStatsAddPhase(int phase, double msec)
+{
+#if defined(DMTXW_STATS)
+   if(phase < 0 || phase >= DmtxwPhaseCount)
+      return;
+
+   threadStats.calls[phase]++;
+   threadStats.msec[phase] += msec;
+#else
+   (void)phase;
+   (void)msec;
+#endif
+}
+
+/**
+ * @brief  Add to an event counter (see DMTXW_STATS_COUNT)
+ * @param  counter DmtxwCounter value
+ * @param  n Amount to add
+ * @return void
+ */
+extern void
+dmtxwStatsCount(int counter, double n)
+{
+#if defined(DMTXW_STATS)
+   if(counter < 0 || counter >= DmtxwCounterCount)
+      return;
+
+   threadStats.count[counter] += n;
+#else
+   (void)counter;
+   (void)n;
+#endif
+}
+
+#if defined(DMTXW_STATS)
+/**
+ * @brief  Add totals gathered on another thread to the calling thread's
+ * @param  stats Totals of a finished worker thread
+ * @return void
+ */
+static void
+StatsAbsorb(const DmtxwStats *stats)
+{
+   dmtxwStatsMerge(&threadStats, stats);
+}
+#endif
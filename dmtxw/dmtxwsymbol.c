@@ -0,0 +1,310 @@
+/*
+libdmtxw - Shared native glue for the libdmtx wrappers
+
+Copyright (C) 2026 The libdmtx-wrappers project
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+Contact: mike@dragonflylogic.com
+*/
+
+/* $Id$ */
+
+/**
+ * @file dmtxwsymbol.c
+ * @brief ECC200 symbol attributes and size prediction
+ *
+ * The attributes of all 30 ECC200 sizes (ISO/IEC 16022, table 7) are kept
+ * here as a constant table indexed like DmtxSymbolSize, so the wrappers
+ * can describe a result without calling back into libdmtx once per
+ * attribute. The estimator counts the codewords a payload needs in a
+ * given scheme and picks the smallest size that holds them, which is what
+ * a trial dmtxEncodeDataMatrix() per size would tell a caller at a much
+ * higher price. The count follows libdmtx's encoder but always keeps room
+ * for the unlatch at the end of a C40, Text, X12 or EDIFACT run, so at a
+ * size boundary the prediction can be one size larger than needed, never
+ * smaller.
+ */
+
+/* Squares first, then rectangles, each in order of capacity */
+static const DmtxwSymbolInfo symbolInfo[DmtxSymbolSquareCount + DmtxSymbolRectCount] = {
+   /* rows cols  regRows regCols  horiz vert  blocks blockErr  data  error */
+   {   10,  10,     8,   8,    1,   1,    1,    5,     3,    5 },
+   {   12,  12,    10,  10,    1,   1,    1,    7,     5,    7 },
+   {   14,  14,    12,  12,    1,   1,    1,   10,     8,   10 },
+   {   16,  16,    14,  14,    1,   1,    1,   12,    12,   12 },
+   {   18,  18,    16,  16,    1,   1,    1,   14,    18,   14 },
+   {   20,  20,    18,  18,    1,   1,    1,   18,    22,   18 },
+   {   22,  22,    20,  20,    1,   1,    1,   20,    30,   20 },
+   {   24,  24,    22,  22,    1,   1,    1,   24,    36,   24 },
+   {   26,  26,    24,  24,    1,   1,    1,   28,    44,   28 },
+   {   32,  32,    14,  14,    2,   2,    1,   36,    62,   36 },
+   {   36,  36,    16,  16,    2,   2,    1,   42,    86,   42 },
+   {   40,  40,    18,  18,    2,   2,    1,   48,   114,   48 },
+   {   44,  44,    20,  20,    2,   2,    1,   56,   144,   56 },
+   {   48,  48,    22,  22,    2,   2,    1,   68,   174,   68 },
+   {   52,  52,    24,  24,    2,   2,    2,   42,   204,   84 },
+   {   64,  64,    14,  14,    4,   4,    2,   56,   280,  112 },
+   {   72,  72,    16,  16,    4,   4,    4,   36,   368,  144 },
+   {   80,  80,    18,  18,    4,   4,    4,   48,   456,  192 },
+   {   88,  88,    20,  20,    4,   4,    4,   56,   576,  224 },
+   {   96,  96,    22,  22,    4,   4,    4,   68,   696,  272 },
+   {  104, 104,    24,  24,    4,   4,    6,   56,   816,  336 },
+   {  120, 120,    18,  18,    6,   6,    6,   68,  1050,  408 },
+   {  132, 132,    20,  20,    6,   6,    8,   62,  1304,  496 },
+   {  144, 144,    22,  22,    6,   6,   10,   62,  1558,  620 },
+   {    8,  18,     6,  16,    1,   1,    1,    7,     5,    7 },
+   {    8,  32,     6,  14,    2,   1,    1,   11,    10,   11 },
+   {   12,  26,    10,  24,    1,   1,    1,   14,    16,   14 },
+   {   12,  36,    10,  16,    2,   1,    1,   18,    22,   18 },
+   {   16,  36,    14,  16,    2,   1,    1,   24,    32,   24 },
+   {   16,  48,    14,  22,    2,   1,    2,   14,    49,   28 }
+};
+
+/**
+ * @brief  Attributes of an ECC200 symbol size
+ * @param  sizeIdx DmtxSymbolSize value of a fixed size, e.g. a result's
+ *         sizeIdx
+ * @return Entry of the attribute table, NULL for an auto or unknown size
+ */
+extern const DmtxwSymbolInfo *
+dmtxwSymbolInfo(int sizeIdx)
+{
+   if(sizeIdx < 0 || sizeIdx >= DmtxSymbolSquareCount + DmtxSymbolRectCount)
+      return NULL;
+
+   return &symbolInfo[sizeIdx];
+}
+
+/**
+ * @brief  Count the data codewords a payload needs in one scheme
+ * @param  data Payload
+ * @param  dataSize Length of data
+ * @param  scheme DmtxPropScheme value; the auto schemes take the cheapest
+ *         single scheme
+ * @return Codeword count, or DmtxUndefined if the scheme cannot encode
+ *         the payload
+ */
+extern int
+dmtxwSymbolCountWords(const unsigned char *data, int dataSize, int scheme)
+{
+   int words, best, i;
+
+   if(data == NULL || dataSize < 0)
+      return DmtxUndefined;
+
+   switch(scheme) {
+      case DmtxSchemeAscii:
+         return SymbolCountAscii(data, dataSize);
+      case DmtxSchemeC40:
+      case DmtxSchemeText:
+         return SymbolCountC40Text(data, dataSize, scheme);
+      case DmtxSchemeX12:
+         return SymbolCountX12(data, dataSize);
+      case DmtxSchemeEdifact:
+         return SymbolCountEdifact(data, dataSize);
+      case DmtxSchemeBase256:
+         return 1 + ((dataSize > 249) ? 2 : 1) + dataSize;
+      case DmtxSchemeAutoFast:
+      case DmtxSchemeAutoBest:
+         break;
+      default:
+         return DmtxUndefined;
+   }
+
+   best = SymbolCountAscii(data, dataSize);
+   for(i = DmtxSchemeC40; i <= DmtxSchemeBase256; i++) {
+      words = dmtxwSymbolCountWords(data, dataSize, i);
+      if(words != DmtxUndefined && words < best)
+         best = words;
+   }
+
+   return best;
+}
+
+/**
+ * @brief  Predict the size dmtxEncodeDataMatrix() will choose for a payload
+ * @param  data Payload
+ * @param  dataSize Length of data
+ * @param  scheme DmtxPropScheme value
+ * @param  sizeRequest DmtxPropSizeRequest value
+ * @return Smallest DmtxSymbolSize holding the payload, or DmtxUndefined if
+ *         none does (or the requested fixed size does not, or sizeRequest
+ *         is DmtxSymbolShapeAuto, which the encoder rejects)
+ */
+extern int
+dmtxwSymbolEstimate(const unsigned char *data, int dataSize, int scheme, int sizeRequest)
+{
+   int words;
+
+   words = dmtxwSymbolCountWords(data, dataSize, scheme);
+   if(words == DmtxUndefined)
+      return DmtxUndefined;
+
+   return dmtxwSymbolFit(words, sizeRequest);
+}
+
+/**
+ * @brief  Smallest symbol size holding a number of data codewords
+ * @param  words Data codewords, e.g. from dmtxwSymbolCountWords()
+ * @param  sizeRequest DmtxPropSizeRequest value
+ * @return DmtxSymbolSize value, or DmtxUndefined if none holds them (or the
+ *         requested fixed size does not, or sizeRequest is
+ *         DmtxSymbolShapeAuto)
+ */
+extern int
+dmtxwSymbolFit(int words, int sizeRequest)
+{
+   int sizeIdx, first, last;
+
+   if(words < 0)
+      return DmtxUndefined;
+
+   if(sizeRequest >= 0) {
+      if(sizeRequest >= DmtxSymbolSquareCount + DmtxSymbolRectCount)
+         return DmtxUndefined;
+      return (symbolInfo[sizeRequest].dataWords >= words) ? sizeRequest : DmtxUndefined;
+   }
+
+   /* Like libdmtx's FindSymbolSize(), which only searches for SquareAuto
+    * and RectAuto; DmtxSymbolShapeAuto is taken as a size there and fails */
+   if(sizeRequest == DmtxSymbolSquareAuto) {
+      first = 0;
+      last = DmtxSymbolSquareCount;
+   }
+   else if(sizeRequest == DmtxSymbolRectAuto) {
+      first = DmtxSymbolSquareCount;
+      last = DmtxSymbolSquareCount + DmtxSymbolRectCount;
+   }
+   else {
+      return DmtxUndefined;
+   }
+
+   for(sizeIdx = first; sizeIdx < last; sizeIdx++) {
+      if(symbolInfo[sizeIdx].dataWords >= words)
+         return sizeIdx;
+   }
+
+   return DmtxUndefined;
+}
+
+/**
+ * @brief  Count ASCII codewords: digit pairs share one, upper half bytes
+ *         take an Upper Shift
+ * @param  data Payload
+ * @param  dataSize Length of data
+ * @return Codeword count
+ */
+static int
+SymbolCountAscii(const unsigned char *data, int dataSize)
+{
+   int i, words;
+
+   words = 0;
+   for(i = 0; i < dataSize; i++) {
+      if(i + 1 < dataSize && DMTXW_ISDIGIT(data[i]) && DMTXW_ISDIGIT(data[i + 1])) {
+         words++;
+         i++;
+      }
+      else {
+         words += (data[i] > 127) ? 2 : 1;
+      }
+   }
+
+   return words;
+}
+
+/**
+ * @brief  Count C40 or Text codewords
+ * @param  data Payload
+ * @param  dataSize Length of data
+ * @param  scheme DmtxSchemeC40 or DmtxSchemeText
+ * @return Codeword count
+ */
+static int
+SymbolCountC40Text(const unsigned char *data, int dataSize, int scheme)
+{
+   int i, values, words;
+   unsigned char c;
+
+   values = 0;
+   for(i = 0; i < dataSize; i++) {
+      c = data[i];
+      if(c > 127) {
+         values += 2; /* Shift 2, Upper Shift */
+         c -= 128;
+      }
+      if(c == ' ' || DMTXW_ISDIGIT(c) ||
+            (scheme == DmtxSchemeC40 && c >= 'A' && c <= 'Z') ||
+            (scheme == DmtxSchemeText && c >= 'a' && c <= 'z'))
+         values++;
+      else
+         values += 2; /* Shift 1, 2 or 3 */
+   }
+
+   /* Latch, two codewords per value triplet; a last single value goes out
+    * as ASCII after the unlatch, a last pair is padded to a triplet */
+   words = 1 + (values / 3) * 2;
+   if(values % 3 == 1)
+      words += 2;
+   else if(values % 3 == 2)
+      words += 2 + 1;
+   else
+      words += 1;
+
+   return words;
+}
+
+/**
+ * @brief  Count X12 codewords
+ * @param  data Payload
+ * @param  dataSize Length of data
+ * @return Codeword count, DmtxUndefined outside the X12 character set
+ */
+static int
+SymbolCountX12(const unsigned char *data, int dataSize)
+{
+   int i;
+
+   for(i = 0; i < dataSize; i++) {
+      if(data[i] != 13 && data[i] != '*' && data[i] != '>' && data[i] != ' ' &&
+            !DMTXW_ISDIGIT(data[i]) && (data[i] < 'A' || data[i] > 'Z'))
+         return DmtxUndefined;
+   }
+
+   /* Latch, two codewords per triplet, unlatch and the rest as ASCII */
+   return 1 + (dataSize / 3) * 2 + 1 +
+         SymbolCountAscii(data + dataSize - dataSize % 3, dataSize % 3);
+}
+
+/**
+ * @brief  Count EDIFACT codewords
+ * @param  data Payload
+ * @param  dataSize Length of data
+ * @return Codeword count, DmtxUndefined outside the EDIFACT character set
+ */
+static int
+SymbolCountEdifact(const unsigned char *data, int dataSize)
+{
+   int i;
+
+   for(i = 0; i < dataSize; i++) {
+      if(data[i] < 32 || data[i] > 94)
+         return DmtxUndefined;
+   }
+
+   /* Latch, then six bits per value including the unlatch value */
+   return 1 + ((dataSize + 1) * 6 + 7) / 8;
+}
@@ -0,0 +1,129 @@
+/*
+libdmtxw - Shared native glue for the libdmtx wrappers
+
+Copyright (C) 2026 The libdmtx-wrappers project
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+Contact: mike@dragonflylogic.com
+*/
+
+/* $Id$ */
+
+/**
+ * @file dmtxwthread.c
+ * @brief Minimal thread and mutex layer (POSIX threads or Win32)
+ */
+
+/**
+ * @brief  Start a thread
+ * @param  thread Receives the thread handle
+ * @param  func Thread entry point
+ * @param  arg Argument handed to func
+ * @return DmtxPass | DmtxFail
+ */
+static DmtxPassFail
+ThreadStart(DmtxwThread *thread, DmtxwThreadFunc func, void *arg)
+{
+#if defined(_WIN32)
+   *thread = CreateThread(NULL, 0, func, arg, 0, NULL);
+   return (*thread != NULL) ? DmtxPass : DmtxFail;
+#else
+   return (pthread_create(thread, NULL, func, arg) == 0) ? DmtxPass : DmtxFail;
+#endif
+}
+
+/**
+ * @brief  Wait for a thread to finish and release its handle
+ * @param  thread Thread handle
+ * @return void
+ */
+static void
+ThreadJoin(DmtxwThread *thread)
+{
+#if defined(_WIN32)
+   WaitForSingleObject(*thread, INFINITE);
+   CloseHandle(*thread);
+#else
+   pthread_join(*thread, NULL);
+#endif
+}
+
+/**
+ * @brief  Initialize a mutex
+ * @param  mutex Mutex
+ * @return DmtxPass | DmtxFail
+ */
+static DmtxPassFail
+MutexInit(DmtxwMutex *mutex)
+{
+#if defined(_WIN32)
+   InitializeCriticalSection(mutex);
+   return DmtxPass;
+#else
+   return (pthread_mutex_init(mutex, NULL) == 0) ? DmtxPass : DmtxFail;
+#endif
+}
+
+/**
+ * @brief  Release a mutex
+ * @param  mutex Mutex
+ * @return void
+ */
+static void
+MutexDestroy(DmtxwMutex *mutex)
+{
+#if defined(_WIN32)
+   DeleteCriticalSection(mutex);
+#else
+   pthread_mutex_destroy(mutex);
+#endif
+}
+
+/**
+ * @brief  Lock a mutex
+ * @param  mutex Mutex, or NULL when running single threaded
+ * @return void
+ */
+static void
+MutexLock(DmtxwMutex *mutex)
+{
+   if(mutex == NULL)
+      return;
+
+#if defined(_WIN32)
+   EnterCriticalSection(mutex);
+#else
+   pthread_mutex_lock(mutex);
+#endif
+}
+
+/**
+ * @brief  Unlock a mutex
+ * @param  mutex Mutex, or NULL when running single threaded
+ * @return void
+ */
+static void
+MutexUnlock(DmtxwMutex *mutex)
+{
+   if(mutex == NULL)
+      return;
+
+#if defined(_WIN32)
+   LeaveCriticalSection(mutex);
+#else
+   pthread_mutex_unlock(mutex);
+#endif
+}
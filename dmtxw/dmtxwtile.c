@@ -0,0 +1,410 @@
+/*
+libdmtxw - Shared native glue for the libdmtx wrappers
+
+Copyright (C) 2026 The libdmtx-wrappers project
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+Contact: mike@dragonflylogic.com
+*/
+
+/* $Id$ */
+
+/**
+ * @file dmtxwtile.c
+ * @brief Tiled, multi-threaded search of very large images
+ *
+ * A single DmtxDecode scans an image sequentially on one core and keeps a
+ * scan cache the size of the whole image. In tiled mode the search plane is
+ * cut into overlapping tiles, each wrapped as its own DmtxImage pointing into
+ * the shared read-only pixels, and the tiles are searched by a pool of
+ * worker threads. Workers start on a contiguous run of tiles and steal from
+ * the far end of other workers' runs once theirs is exhausted.
+ *
+ * The overlap is the diagonal of the largest expected symbol
+ * (DmtxPropEdgeMax), so every symbol lies entirely inside at least one
+ * tile. Symbols found in more than one tile are recognized by payload and
+ * corner proximity and stored once.
+ */
+
+/**
+ * @brief  Search the plane as overlapping tiles on a thread pool
+ * @param  scan Scan in progress (lock must be NULL on entry)
+ * @return DmtxPass | DmtxFail
+ */
+static DmtxPassFail
+DecodeTiled(DmtxwScan *scan)
+{
+   DmtxwPool pool;
+   DmtxPassFail err;
+
+   memset(&pool, 0x00, sizeof(DmtxwPool));
+   pool.scan = scan;
+
+   if(PlanTiles(scan, &pool) == DmtxFail) {
+      scan->session->status = DmtxwStatusError;
+      return DmtxFail;
+   }
+
+   err = DecodeTiles(scan, pool.tile, pool.tileCount);
+   free(pool.tile);
+
+   return err;
+}
+
+/**
+ * @brief  Search a list of tiles on up to DmtxwPropThreads threads (the
+ *         calling thread alone when the property is 0) and store each
+ *         symbol once, in reading order
+ * @param  scan Scan in progress (lock must be NULL on entry)
+ * @param  tile Tiles, in plane coordinates
+ * @param  tileCount Number of tiles
+ * @return DmtxPass | DmtxFail
+ */
+static DmtxPassFail
+DecodeTiles(DmtxwScan *scan, DmtxwTile *tile, int tileCount)
+{
+   DmtxwSession *session = scan->session;
+   DmtxwPool pool;
+   DmtxwMutex lock;
+   DmtxwWorker *worker;
+   DmtxPassFail err = DmtxPass;
+   DmtxwStatus status = DmtxwStatusComplete;
+   int i, started, perWorker;
+
+   memset(&pool, 0x00, sizeof(DmtxwPool));
+   pool.scan = scan;
+   pool.tile = tile;
+   pool.tileCount = tileCount;
+
+   pool.workerCount = (session->threads < tileCount) ? session->threads : tileCount;
+   if(pool.workerCount < 1)
+      pool.workerCount = 1;
+   if(pool.workerCount > DMTXW_MAX_THREADS)
+      pool.workerCount = DMTXW_MAX_THREADS;
+
+   pool.worker = (DmtxwWorker *)calloc(pool.workerCount, sizeof(DmtxwWorker));
+   if(pool.worker == NULL || MutexInit(&lock) == DmtxFail) {
+      free(pool.worker);
+      session->status = DmtxwStatusError;
+      return DmtxFail;
+   }
+   scan->lock = &lock;
+
+   /* Hand out contiguous runs of tiles so neighbours share cache lines */
+   perWorker = (pool.tileCount + pool.workerCount - 1) / pool.workerCount;
+   for(i = 0; i < pool.workerCount; i++) {
+      worker = &(pool.worker[i]);
+      worker->pool = &pool;
+      worker->index = i;
+      worker->head = i * perWorker;
+      worker->tail = (i + 1) * perWorker;
+      if(worker->tail > pool.tileCount)
+         worker->tail = pool.tileCount;
+      if(worker->head > worker->tail)
+         worker->head = worker->tail;
+      worker->status = DmtxwStatusComplete;
+      worker->err = DmtxPass;
+   }
+
+   /* The calling thread works too, as worker 0 */
+   for(started = 1; started < pool.workerCount; started++) {
+      worker = &(pool.worker[started]);
+      if(ThreadStart(&(worker->thread), TileWorker, worker) == DmtxFail)
+         break;
+   }
+   (void)TileWorker(&(pool.worker[0]));
+
+   for(i = 1; i < started; i++)
+      ThreadJoin(&(pool.worker[i].thread));
+
+   /* Threads that failed to start leave their tiles to be stolen, so the
+    * calling thread picks up anything still queued */
+   if(started < pool.workerCount)
+      (void)TileWorker(&(pool.worker[0]));
+
+   for(i = 0; i < pool.workerCount; i++) {
+      worker = &(pool.worker[i]);
+#if defined(DMTXW_STATS)
+      /* Worker 0 counted on this thread already */
+      if(i > 0)
+         StatsAbsorb(&(worker->stats));
+#endif
+      if(worker->err == DmtxFail)
+         err = DmtxFail;
+      if(StatusRank(worker->status) > StatusRank(status))
+         status = worker->status;
+   }
+
+   scan->lock = NULL;
+   MutexDestroy(&lock);
+   free(pool.worker);
+
+   /* Completion order depends on scheduling; report in reading order */
+   qsort(session->result, session->resultCount, sizeof(DmtxwResult), CompareResults);
+
+   session->status = (err == DmtxFail) ? DmtxwStatusError : status;
+
+   return err;
+}
+
+/**
+ * @brief  Cut the plane into overlapping tiles sized from DmtxPropEdgeMax
+ * @param  scan Scan in progress
+ * @param  pool Receives the tiles
+ * @return DmtxPass | DmtxFail
+ */
+static DmtxPassFail
+PlanTiles(DmtxwScan *scan, DmtxwPool *pool)
+{
+   DmtxwPlane *plane = scan->plane;
+   DmtxwTile *tile;
+   int edge, overlap, step, size, cols, rows, col, row;
+
+   /* A symbol of edge e rotated by 45 degrees spans e * sqrt(2) pixels */
+   edge = scan->session->edgeMax / plane->scale;
+   overlap = (int)(edge * 1.4143) + 2;
+   step = 2 * overlap;
+   if(step < DMTXW_TILE_MIN_STEP)
+      step = DMTXW_TILE_MIN_STEP;
+   size = step + overlap;
+
+   cols = (plane->width > size) ? (plane->width - overlap + step - 1) / step : 1;
+   rows = (plane->height > size) ? (plane->height - overlap + step - 1) / step : 1;
+
+   pool->tile = (DmtxwTile *)malloc(cols * rows * sizeof(DmtxwTile));
+   if(pool->tile == NULL)
+      return DmtxFail;
+
+   pool->tileCount = 0;
+   for(row = 0; row < rows; row++) {
+      for(col = 0; col < cols; col++) {
+         tile = &(pool->tile[pool->tileCount]);
+         tile->x = col * step;
+         tile->y = row * step;
+         tile->width = (col == cols - 1) ? plane->width - tile->x : size;
+         tile->height = (row == rows - 1) ? plane->height - tile->y : size;
+
+         if(TileIntersectsRoi(scan, tile) == DmtxTrue)
+            pool->tileCount++;
+      }
+   }
+
+   if(pool->tileCount == 0) {
+      free(pool->tile);
+      pool->tile = NULL;
+      return DmtxFail;
+   }
+
+   return DmtxPass;
+}
+
+/**
+ * @brief  Check whether a tile overlaps the DmtxPropXmin..Ymax bounds
+ * @param  scan Scan in progress
+ * @param  tile Tile
+ * @return DmtxTrue | DmtxFalse
+ */
+static DmtxBoolean
+TileIntersectsRoi(DmtxwScan *scan, const DmtxwTile *tile)
+{
+   DmtxwSession *session = scan->session;
+   int scale = scan->plane->scale;
+   int bottom;
+
+   /* libdmtx counts rows from the bottom of the image */
+   bottom = scan->plane->height - tile->y - tile->height;
+
+   if(session->xMin != DmtxUndefined && session->xMin / scale >= tile->x + tile->width)
+      return DmtxFalse;
+   if(session->xMax != DmtxUndefined && session->xMax / scale < tile->x)
+      return DmtxFalse;
+   if(session->yMin != DmtxUndefined && session->yMin / scale >= bottom + tile->height)
+      return DmtxFalse;
+   if(session->yMax != DmtxUndefined && session->yMax / scale < bottom)
+      return DmtxFalse;
+
+   return DmtxTrue;
+}
+
+/**
+ * @brief  Worker loop: search tiles until none are left or the scan stops
+ * @param  arg DmtxwWorker
+ * @return Nothing useful
+ */
+static DMTXW_THREAD_RETURN
+TileWorker(void *arg)
+{
+   DmtxwWorker *worker = (DmtxwWorker *)arg;
+   DmtxwSession *session = worker->pool->scan->session;
+   int idx;
+
+   TraceSetThread(worker->index);
+
+   while(worker->err == DmtxPass && worker->status == DmtxwStatusComplete &&
+         !session->cancelled && !session->halted) {
+      idx = NextTile(worker);
+      if(idx < 0)
+         break;
+
+      worker->err = DecodeTile(worker->pool->scan, &(worker->pool->tile[idx]),
+            &(worker->status));
+   }
+
+   if(session->cancelled)
+      worker->status = DmtxwStatusCancelled;
+   else if(session->halted)
+      worker->status = DmtxwStatusMaxCount;
+
+   /* A worker that hit an error or the deadline stops the others too */
+   if(worker->err == DmtxFail || worker->status == DmtxwStatusTimeout) {
+      MutexLock(worker->pool->scan->lock);
+      worker->pool->stopped = 1;
+      MutexUnlock(worker->pool->scan->lock);
+   }
+
+   TraceSetThread(0);
+
+#if defined(DMTXW_STATS)
+   /* A spawned thread ends here, taking its totals with it */
+   if(worker->index > 0)
+      dmtxwStatsGet(&(worker->stats));
+#endif
+
+   return 0;
+}
+
+/**
+ * @brief  Take the next tile from the worker's own run, or steal the last
+ *         tile of another worker's run
+ * @param  worker Worker
+ * @return Tile index, or -1 when every run is empty
+ */
+static int
+NextTile(DmtxwWorker *worker)
+{
+   DmtxwPool *pool = worker->pool;
+   DmtxwWorker *victim;
+   int i, idx = -1;
+
+   MutexLock(pool->scan->lock);
+
+   if(pool->stopped == 0) {
+      if(worker->head < worker->tail) {
+         idx = worker->head++;
+      }
+      else {
+         for(i = 1; i < pool->workerCount; i++) {
+            victim = &(pool->worker[(worker->index + i) % pool->workerCount]);
+            if(victim->head < victim->tail) {
+               idx = --(victim->tail);
+               break;
+            }
+         }
+      }
+   }
+
+   MutexUnlock(pool->scan->lock);
+
+   return idx;
+}
+
+/**
+ * @brief  Check whether a symbol was already stored from an overlapping tile:
+ *         same payload and every corner within a quarter of the symbol edge
+ * @param  session Session
+ * @param  found Geometry of the new symbol
+ * @param  payload Decoded bytes
+ * @param  length Number of decoded bytes
+ * @return DmtxTrue | DmtxFalse
+ */
+static DmtxBoolean
+IsDuplicate(DmtxwSession *session, const DmtxwResult *found,
+      const unsigned char *payload, size_t length)
+{
+   int i, j, dx, dy, edge, tolerance;
+   const DmtxwResult *result;
+
+   dx = found->corner[1].X - found->corner[0].X;
+   dy = found->corner[1].Y - found->corner[0].Y;
+   edge = (int)sqrt((double)(dx * dx + dy * dy));
+   tolerance = (edge / 4 > DMTXW_DEDUP_MIN_PIXELS) ? edge / 4 : DMTXW_DEDUP_MIN_PIXELS;
+
+   for(i = 0; i < session->resultCount; i++) {
+      result = &(session->result[i]);
+      if(result->payloadLength != length ||
+            memcmp(session->arena + result->payloadOffset, payload, length) != 0)
+         continue;
+
+      for(j = 0; j < 4; j++) {
+         dx = result->corner[j].X - found->corner[j].X;
+         dy = result->corner[j].Y - found->corner[j].Y;
+         if(abs(dx) > tolerance || abs(dy) > tolerance)
+            break;
+      }
+
+      if(j == 4)
+         return DmtxTrue;
+   }
+
+   return DmtxFalse;
+}
+
+/**
+ * @brief  Order results top to bottom, then left to right
+ * @param  a First DmtxwResult
+ * @param  b Second DmtxwResult
+ * @return qsort() comparison value
+ */
+static int
+CompareResults(const void *a, const void *b)
+{
+   const DmtxwResult *ra = (const DmtxwResult *)a;
+   const DmtxwResult *rb = (const DmtxwResult *)b;
+
+   if(ra->corner[0].Y != rb->corner[0].Y)
+      return (ra->corner[0].Y < rb->corner[0].Y) ? -1 : 1;
+   if(ra->corner[0].X != rb->corner[0].X)
+      return (ra->corner[0].X < rb->corner[0].X) ? -1 : 1;
+
+   return 0;
+}
+
+/**
+ * @brief  Severity of a stop reason when merging worker outcomes
+ * @param  status DmtxwStatus value
+ * @return Rank, higher wins
+ */
+static int
+StatusRank(DmtxwStatus status)
+{
+   switch(status) {
+      case DmtxwStatusComplete:
+         return 0;
+      case DmtxwStatusMaxCount:
+         return 1;
+      case DmtxwStatusTimeout:
+         return 2;
+      case DmtxwStatusCancelled:
+         return 3;
+      case DmtxwStatusError:
+         return 4;
+      case DmtxwStatusBlurred:
+      case DmtxwStatusEmpty:
+         return 0;
+   }
+
+   return 0;
+}
@@ -0,0 +1,392 @@
+/*
+libdmtxw - Shared native glue for the libdmtx wrappers
+
+Copyright (C) 2026 The libdmtx-wrappers project
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+Contact: mike@dragonflylogic.com
+*/
+/* $Id$ */
+
+/**
+ * @file dmtxwtrace.c
+ * @brief Per-decode trace spans and a Chrome trace-event JSON writer
+ *
+ * A session with a trace hook (dmtxwSessionSetTrace()) reports the
+ * beginning and end of every decode, search plane setup, region search
+ * call, region decode and result store, with the region corners and how
+ * each one ended. Tile workers report from their own threads, so with
+ * DmtxwPropThreads set the hook must be thread safe. Times come from
+ * dmtxwStatsClock() and need no DMTXW_STATS build. Without a hook, each
+ * span costs a call and a pointer test.
+ *
+ * dmtxwTraceJsonWrite() is a ready-made hook that writes the events in the
+ * JSON array format read by chrome://tracing and Perfetto, one thread row
+ * per tile worker. Given a minimum duration, it keeps only the decodes that
+ * took at least that long, so a station can trace for days and keep just
+ * its slow frames. Held-back events are told apart by the decode they fall
+ * in, so such a writer must not be shared between sessions; one writer per
+ * session, or a minimum of 0, is always correct.
+ */
+
+static const char *spanNames[] = {
+   "decode", "prepare", "search", "region", "marshal"
+};
+
+static const char *outcomeNames[] = {
+   "none", "found", "missed", "slice", "dropped", "error"
+};
+
+/* DmtxwStatus values, as in DMTXD_STATUS_NAMES */
+static const char *traceStatusNames[] = {
+   "complete", "max_count", "timeout", "cancelled", "error", "blurred", "empty"
+};
+
+/* Tile worker index of the calling thread, 0 outside of tile workers */
+static DMTXW_THREAD_LOCAL int traceThread;
+
+/**
+ * @brief  Set the function receiving the session's trace events
+ * @param  session Session
+ * @param  func Trace function, or NULL to stop tracing
+ * @param  context Handed to func with every event
+ * @return DmtxPass | DmtxFail
+ */
+extern DmtxPassFail
+dmtxwSessionSetTrace(DmtxwSession *session, DmtxwTraceFunc func, void *context)
+{
+   if(session == NULL)
+      return DmtxFail;
+
+   session->traceFunc = func;
+   session->traceContext = context;
+
+   return DmtxPass;
+}
+
+/**
+ * @brief  Report a span of the caller's own to the session's trace hook,
+ *         e.g. a wrapper turning the results into host objects
+ * @param  session Session
+ * @param  span DmtxwSpan value
+ * @param  begin 1 at the beginning of the span, 0 at its end
+ * @param  outcome DmtxwOutcome value (end only)
+ * @return void
+ */
+extern void
+dmtxwSessionTrace(DmtxwSession *session, int span, int begin, int outcome)
+{
+   if(session == NULL)
+      return;
+
+   TraceSpan(session, span, begin, outcome, NULL);
+}
+
+/**
+ * @brief  Name of a span, as written by dmtxwTraceJsonWrite()
+ * @param  span DmtxwSpan value
+ * @return Name, or NULL for an unknown span
+ */
+extern const char *
+dmtxwSpanName(int span)
+{
+   if(span < 0 || span >= DmtxwSpanCount)
+      return NULL;
+
+   return spanNames[span];
+}
+
+/**
+ * @brief  Name of an outcome, as written by dmtxwTraceJsonWrite()
+ * @param  outcome DmtxwOutcome value
+ * @return Name, or NULL for an unknown outcome
+ */
+extern const char *
+dmtxwOutcomeName(int outcome)
+{
+   if(outcome < 0 || outcome > DmtxwOutcomeError)
+      return NULL;
+
+   return outcomeNames[outcome];
+}
+
+/**
+ * @brief  Create a trace file for dmtxwTraceJsonWrite()
+ * @param  path File to write, replaced if it exists
+ * @param  minMsec Shortest decode written, 0 to write every event
+ * @return Writer to pass as the trace context, or NULL on failure
+ */
+extern DmtxwTraceJson *
+dmtxwTraceJsonOpen(const char *path, double minMsec)
+{
+   DmtxwTraceJson *writer;
+
+   if(path == NULL)
+      return NULL;
+
+   writer = (DmtxwTraceJson *)calloc(1, sizeof(DmtxwTraceJson));
+   if(writer == NULL)
+      return NULL;
+
+   if(MutexInit(&(writer->lock)) == DmtxFail) {
+      free(writer);
+      return NULL;
+   }
+
+   writer->fp = fopen(path, "w");
+   if(writer->fp == NULL) {
+      MutexDestroy(&(writer->lock));
+      free(writer);
+      return NULL;
+   }
+
+   writer->minMsec = (minMsec > 0.0) ? minMsec : 0.0;
+   writer->keep = 1;
+   fputs("[", writer->fp);
+
+   return writer;
+}
+
+/**
+ * @brief  Finish and close a trace file. Sessions using it must have
+ *         stopped tracing or been destroyed.
+ * @param  writer Address of writer pointer, set to NULL on return
+ * @return DmtxPass | DmtxFail (write error)
+ */
+extern DmtxPassFail
+dmtxwTraceJsonClose(DmtxwTraceJson **writer)
+{
+   DmtxPassFail err = DmtxPass;
+
+   if(writer == NULL || *writer == NULL)
+      return DmtxFail;
+
+   fputs("\n]\n", (*writer)->fp);
+   if(ferror((*writer)->fp) || fclose((*writer)->fp) != 0)
+      err = DmtxFail;
+
+   MutexDestroy(&((*writer)->lock));
+   dmtxwBufferFree(&((*writer)->pending));
+   free(*writer);
+   *writer = NULL;
+
+   return err;
+}
+
+/**
+ * @brief  Trace hook writing Chrome trace events ("B" and "E" phases, one
+ *         thread per tile worker, outcome and corners as arguments of the
+ *         end event)
+ * @param  event Event
+ * @param  context DmtxwTraceJson from dmtxwTraceJsonOpen()
+ * @return void
+ */
+extern void
+dmtxwTraceJsonWrite(const DmtxwTraceEvent *event, void *context)
+{
+   DmtxwTraceJson *writer = (DmtxwTraceJson *)context;
+   char line[DMTXW_TRACE_LINE_MAX];
+   int length;
+
+   if(writer == NULL || event == NULL)
+      return;
+
+   length = TraceJsonFormat(event, line);
+
+   MutexLock(&(writer->lock));
+
+   if(writer->minMsec <= 0.0) {
+      TraceJsonPut(writer, line, length);
+      if(event->span == DmtxwSpanDecode && !event->begin)
+         fflush(writer->fp);
+      MutexUnlock(&(writer->lock));
+      return;
+   }
+
+   if(event->span == DmtxwSpanDecode && event->begin) {
+      writer->pending.length = 0;
+      writer->decodeStart = event->msec;
+      writer->holding = 1;
+   }
+
+   if(!writer->holding) {
+      /* Wrapper spans after a decode go wherever the decode went */
+      if(writer->keep)
+         TraceJsonPut(writer, line, length);
+   }
+   else if(BufferAppend(&(writer->pending), line, length) == DmtxFail) {
+      /* Out of memory: the decode is written incomplete or not at all */
+      writer->holding = 0;
+      writer->keep = 0;
+   }
+   else if(event->span == DmtxwSpanDecode && !event->begin) {
+      writer->holding = 0;
+      writer->keep = (event->msec - writer->decodeStart >= writer->minMsec);
+      if(writer->keep) {
+         TraceJsonPut(writer, (const char *)writer->pending.data, writer->pending.length);
+         fflush(writer->fp);
+      }
+      writer->pending.length = 0;
+   }
+
+   MutexUnlock(&(writer->lock));
+}
+
+/**
+ * @brief  Build an event and hand it to the session's trace hook, if any
+ * @param  session Session
+ * @param  span DmtxwSpan value
+ * @param  begin 1 at the beginning of the span, 0 at its end
+ * @param  outcome DmtxwOutcome value
+ * @param  found Corners and symbol size to report, or NULL
+ * @return void
+ */
+static void
+TraceSpan(DmtxwSession *session, int span, int begin, int outcome,
+      const DmtxwResult *found)
+{
+   DmtxwTraceEvent event;
+
+   if(session->traceFunc == NULL)
+      return;
+
+   memset(&event, 0x00, sizeof(DmtxwTraceEvent));
+   event.span = span;
+   event.begin = begin;
+   event.msec = dmtxwStatsClock();
+   event.thread = traceThread;
+   event.outcome = begin ? DmtxwOutcomeNone : outcome;
+   event.sizeIdx = DmtxUndefined;
+   event.status = DmtxUndefined;
+   event.results = DmtxUndefined;
+
+   if(found != NULL) {
+      event.hasCorners = 1;
+      memcpy(event.corner, found->corner, sizeof(event.corner));
+      event.sizeIdx = found->sizeIdx;
+   }
+
+   session->traceFunc(&event, session->traceContext);
+}
+
+/**
+ * @brief  Report the end of a decode with its status and result count
+ * @param  session Session
+ * @return void
+ */
+static void
+TraceDecodeEnd(DmtxwSession *session)
+{
+   DmtxwTraceEvent event;
+
+   if(session->traceFunc == NULL)
+      return;
+
+   memset(&event, 0x00, sizeof(DmtxwTraceEvent));
+   event.span = DmtxwSpanDecode;
+   event.msec = dmtxwStatsClock();
+   event.thread = traceThread;
+   event.sizeIdx = DmtxUndefined;
+   event.status = session->status;
+   event.results = session->resultCount;
+
+   if(session->status == DmtxwStatusError)
+      event.outcome = DmtxwOutcomeError;
+   else
+      event.outcome = (session->resultCount > 0) ? DmtxwOutcomeFound : DmtxwOutcomeMissed;
+
+   session->traceFunc(&event, session->traceContext);
+}
+
+/**
+ * @brief  Tell the trace events of the calling thread which tile worker
+ *         sent them
+ * @param  thread Worker index, 0 for the decoding thread
+ * @return void
+ */
+static void
+TraceSetThread(int thread)
+{
+   traceThread = thread;
+}
+
+/**
+ * @brief  Format an event as one Chrome trace event, preceded by a comma
+ * @param  event Event
+ * @param  line Receives the text (DMTXW_TRACE_LINE_MAX bytes)
+ * @return Length of the text
+ */
+static int
+TraceJsonFormat(const DmtxwTraceEvent *event, char *line)
+{
+   const char *name, *outcome;
+   int length, i;
+
+   name = dmtxwSpanName(event->span);
+   outcome = dmtxwOutcomeName(event->outcome);
+
+   length = sprintf(line, ",\n{\"name\":\"%s\",\"cat\":\"dmtxw\",\"ph\":\"%s\","
+         "\"ts\":%.3f,\"pid\":1,\"tid\":%d", (name != NULL) ? name : "span",
+         event->begin ? "B" : "E", event->msec * 1000.0, event->thread);
+
+   if(event->begin)
+      return length + sprintf(line + length, "}");
+
+   length += sprintf(line + length, ",\"args\":{\"outcome\":\"%s\"",
+         (outcome != NULL) ? outcome : "none");
+
+   if(event->hasCorners) {
+      length += sprintf(line + length, ",\"corners\":[");
+      for(i = 0; i < 4; i++)
+         length += sprintf(line + length, "%s[%d,%d]", (i > 0) ? "," : "",
+               event->corner[i].X, event->corner[i].Y);
+      length += sprintf(line + length, "]");
+   }
+
+   if(event->sizeIdx != DmtxUndefined)
+      length += sprintf(line + length, ",\"size_idx\":%d", event->sizeIdx);
+
+   if(event->status >= 0 && event->status <= DmtxwStatusEmpty)
+      length += sprintf(line + length, ",\"status\":\"%s\"",
+            traceStatusNames[event->status]);
+
+   if(event->results != DmtxUndefined)
+      length += sprintf(line + length, ",\"results\":%d", event->results);
+
+   return length + sprintf(line + length, "}}");
+}
+
+/**
+ * @brief  Write formatted events, dropping the comma before the first one
+ * @param  writer Writer (locked)
+ * @param  data Events from TraceJsonFormat()
+ * @param  length Number of bytes
+ * @return void
+ */
+static void
+TraceJsonPut(DmtxwTraceJson *writer, const char *data, size_t length)
+{
+   if(length == 0)
+      return;
+
+   if(!writer->written) {
+      data++;
+      length--;
+      writer->written = 1;
+   }
+
+   fwrite(data, 1, length, writer->fp);
+}
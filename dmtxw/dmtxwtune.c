@@ -0,0 +1,393 @@
+/*
+libdmtxw - Shared native glue for the libdmtx wrappers
+
+Copyright (C) 2026 The libdmtx-wrappers project
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+Contact: mike@dragonflylogic.com
+*/
+
+/* $Id$ */
+
+/**
+ * @file dmtxwtune.c
+ * @brief Scan parameter auto-tuner driven by decode history
+ *
+ * Stations that always see the same kind of label waste most of each scan
+ * on symbol sizes and scan lines they never need. With DmtxwPropAutoTune set
+ * the session remembers the outcome of its last decodes (symbol edges,
+ * module size, symbol size, rotation, contrast, latency) and narrows the
+ * options the caller left at their defaults: DmtxPropEdgeMin/Max,
+ * DmtxPropSymbolSize, DmtxPropScanGap and DmtxwPropShrink. Every
+ * DmtxwPropAutoTuneProbe decodes, and right after a tuned decode that found
+ * nothing, one decode runs with the caller's own options so that drifting
+ * labels are noticed and widen the window again. Each change of the tuned
+ * parameters is reported through the session log function.
+ */
+
+/**
+ * @brief  Set the function receiving the session's log messages
+ * @param  session Session
+ * @param  func Log function, or NULL to discard messages
+ * @param  context Handed to func with every message
+ * @return DmtxPass | DmtxFail
+ */
+extern DmtxPassFail
+dmtxwSessionSetLog(DmtxwSession *session, DmtxwLogFunc func, void *context)
+{
+   if(session == NULL)
+      return DmtxFail;
+
+   session->logFunc = func;
+   session->logContext = context;
+
+   return DmtxPass;
+}
+
+/**
+ * @brief  Prepare a decode: pick probe or tuned mode and apply the tuned
+ *         parameters in place of the caller's defaults
+ * @param  session Session with DmtxwPropAutoTune set
+ * @return DmtxPass | DmtxFail (out of memory)
+ */
+static DmtxPassFail
+TuneBegin(DmtxwSession *session)
+{
+   DmtxwTuner *tuner;
+   DmtxwTuneParams *active;
+
+   if(session->autoTune == 0)
+      return DmtxPass;
+
+   if(session->tuner == NULL) {
+      session->tuner = (DmtxwTuner *)calloc(1, sizeof(DmtxwTuner));
+      if(session->tuner == NULL)
+         return DmtxFail;
+      TuneReset(session->tuner);
+   }
+   tuner = session->tuner;
+
+   /* A new window size starts learning over */
+   if(tuner->capacity != session->autoTune) {
+      free(tuner->sample);
+      tuner->sample = (DmtxwTuneSample *)malloc(session->autoTune * sizeof(DmtxwTuneSample));
+      if(tuner->sample == NULL) {
+         tuner->capacity = 0;
+         return DmtxFail;
+      }
+      tuner->capacity = session->autoTune;
+      TuneReset(tuner);
+   }
+
+   active = &(tuner->active);
+   tuner->probing = (tuner->tuned == DmtxFalse || tuner->missed == DmtxTrue ||
+         tuner->sinceProbe >= session->autoTuneProbe) ? DmtxTrue : DmtxFalse;
+
+   tuner->saved.edgeMin = session->edgeMin;
+   tuner->saved.edgeMax = session->edgeMax;
+   tuner->saved.sizeIdx = session->sizeIdxExpected;
+   tuner->saved.scanGap = session->scanGap;
+   tuner->saved.shrink = session->shrink;
+
+   if(tuner->probing == DmtxFalse) {
+      if(session->edgeMin == DmtxUndefined)
+         session->edgeMin = active->edgeMin;
+      if(session->edgeMax == DmtxUndefined)
+         session->edgeMax = active->edgeMax;
+      if(session->sizeIdxExpected == DmtxUndefined)
+         session->sizeIdxExpected = active->sizeIdx;
+      if(session->scanGap == DmtxUndefined)
+         session->scanGap = active->scanGap;
+      if(session->shrink == 1)
+         session->shrink = active->shrink;
+   }
+
+   tuner->start = dmtxTimeNow();
+
+   return DmtxPass;
+}
+
+/**
+ * @brief  Restore the caller's options after a decode and learn from it
+ * @param  session Session with DmtxwPropAutoTune set
+ * @return void
+ */
+static void
+TuneEnd(DmtxwSession *session)
+{
+   DmtxwTuner *tuner = session->tuner;
+   DmtxwTuneSample *sample;
+   DmtxTime stop;
+
+   if(session->autoTune == 0)
+      return;
+
+   session->edgeMin = tuner->saved.edgeMin;
+   session->edgeMax = tuner->saved.edgeMax;
+   session->sizeIdxExpected = tuner->saved.sizeIdx;
+   session->scanGap = tuner->saved.scanGap;
+   session->shrink = tuner->saved.shrink;
+
+   /* Outcomes that say nothing about the scan parameters */
+   if(session->cached == DmtxTrue || session->status == DmtxwStatusError ||
+         session->status == DmtxwStatusCancelled ||
+         session->status == DmtxwStatusBlurred || session->status == DmtxwStatusEmpty)
+      return;
+
+   stop = dmtxTimeNow();
+
+   sample = &(tuner->sample[tuner->next]);
+   MeasureSample(session, sample);
+   sample->probe = tuner->probing;
+   sample->msec = (stop.sec - tuner->start.sec) * 1000.0 +
+         ((double)stop.usec - (double)tuner->start.usec) / 1000.0;
+
+   tuner->next = (tuner->next + 1) % tuner->capacity;
+   if(tuner->count < tuner->capacity)
+      tuner->count++;
+
+   tuner->missed = (tuner->probing == DmtxFalse && sample->found == 0) ? DmtxTrue : DmtxFalse;
+   tuner->sinceProbe = (tuner->probing == DmtxTrue) ? 0 : tuner->sinceProbe + 1;
+
+   TuneUpdate(session);
+}
+
+/**
+ * @brief  Forget the decode history and every tuned parameter
+ * @param  tuner Tuner
+ * @return void
+ */
+static void
+TuneReset(DmtxwTuner *tuner)
+{
+   tuner->count = 0;
+   tuner->next = 0;
+   tuner->sinceProbe = 0;
+   tuner->missed = DmtxFalse;
+   tuner->tuned = DmtxFalse;
+   tuner->active.edgeMin = DmtxUndefined;
+   tuner->active.edgeMax = DmtxUndefined;
+   tuner->active.sizeIdx = DmtxUndefined;
+   tuner->active.scanGap = DmtxUndefined;
+   tuner->active.shrink = 1;
+}
+
+/**
+ * @brief  Summarize the results of the most recent decode
+ * @param  session Session holding the results
+ * @param  sample Receives the summary
+ * @return void
+ */
+static void
+MeasureSample(DmtxwSession *session, DmtxwTuneSample *sample)
+{
+   int i, width, height, cols, rows, module;
+   const DmtxwResult *result;
+   const DmtxwSymbolInfo *info;
+
+   sample->found = session->resultCount;
+   sample->edgeMin = sample->edgeMax = sample->moduleMin = 0;
+   sample->sizeIdx = DmtxUndefined;
+   sample->angleMin = sample->angleMax = 0;
+   sample->contrastMin = 0;
+
+   for(i = 0; i < session->resultCount; i++) {
+      result = &(session->result[i]);
+
+      width = (int)(CornerDistance(&result->corner[0], &result->corner[1]) + 0.5);
+      height = (int)(CornerDistance(&result->corner[0], &result->corner[3]) + 0.5);
+      info = dmtxwSymbolInfo(result->sizeIdx);
+      cols = (info != NULL) ? info->cols : 0;
+      rows = (info != NULL) ? info->rows : 0;
+      module = (cols > 0 && rows > 0) ? ((width / cols < height / rows) ?
+            width / cols : height / rows) : 0;
+
+      if(i == 0) {
+         sample->edgeMin = (width < height) ? width : height;
+         sample->edgeMax = (width > height) ? width : height;
+         sample->moduleMin = module;
+         sample->sizeIdx = result->sizeIdx;
+         sample->angleMin = sample->angleMax = result->angle;
+         sample->contrastMin = result->contrast;
+         continue;
+      }
+
+      sample->edgeMin = (width < sample->edgeMin) ? width : sample->edgeMin;
+      sample->edgeMin = (height < sample->edgeMin) ? height : sample->edgeMin;
+      sample->edgeMax = (width > sample->edgeMax) ? width : sample->edgeMax;
+      sample->edgeMax = (height > sample->edgeMax) ? height : sample->edgeMax;
+      sample->moduleMin = (module < sample->moduleMin) ? module : sample->moduleMin;
+      if(result->sizeIdx != sample->sizeIdx)
+         sample->sizeIdx = DmtxUndefined;
+      sample->angleMin = (result->angle < sample->angleMin) ? result->angle : sample->angleMin;
+      sample->angleMax = (result->angle > sample->angleMax) ? result->angle : sample->angleMax;
+      sample->contrastMin = (result->contrast < sample->contrastMin) ?
+            result->contrast : sample->contrastMin;
+   }
+}
+
+/**
+ * @brief  Length of the side between two result corners
+ * @param  a First corner
+ * @param  b Second corner
+ * @return Distance in pixels
+ */
+static double
+CornerDistance(const DmtxPixelLoc *a, const DmtxPixelLoc *b)
+{
+   double dx, dy;
+
+   dx = (double)(b->X - a->X);
+   dy = (double)(b->Y - a->Y);
+
+   return sqrt(dx * dx + dy * dy);
+}
+
+/**
+ * @brief  Derive the tuned parameters from the decode history and log them
+ *         when they change. Tuning needs DMTXW_TUNE_MIN_FOUND successful
+ *         decodes in the window; symbol edges get a DMTXW_TUNE_MARGIN
+ *         percent margin on both sides.
+ * @param  session Session
+ * @return void
+ */
+static void
+TuneUpdate(DmtxwSession *session)
+{
+   DmtxwTuner *tuner = session->tuner;
+   DmtxwTuneSample *sample;
+   DmtxwTuneParams next;
+   int i, found, edgeMin, edgeMax, moduleMin, sizeIdx, scale, edgeShrunk;
+
+   found = edgeMin = edgeMax = moduleMin = 0;
+   sizeIdx = DmtxUndefined;
+
+   for(i = 0; i < tuner->count; i++) {
+      sample = &(tuner->sample[i]);
+      if(sample->found == 0)
+         continue;
+
+      if(found == 0) {
+         edgeMin = sample->edgeMin;
+         edgeMax = sample->edgeMax;
+         moduleMin = sample->moduleMin;
+         sizeIdx = sample->sizeIdx;
+      }
+      else {
+         edgeMin = (sample->edgeMin < edgeMin) ? sample->edgeMin : edgeMin;
+         edgeMax = (sample->edgeMax > edgeMax) ? sample->edgeMax : edgeMax;
+         moduleMin = (sample->moduleMin < moduleMin) ? sample->moduleMin : moduleMin;
+         if(sample->sizeIdx != sizeIdx)
+            sizeIdx = DmtxUndefined;
+      }
+      found++;
+   }
+
+   next.edgeMin = next.edgeMax = next.sizeIdx = next.scanGap = DmtxUndefined;
+   next.shrink = 1;
+
+   if(found >= DMTXW_TUNE_MIN_FOUND && edgeMin > 0) {
+      scale = (session->luma > 0) ? session->luma : 1;
+
+      next.edgeMin = edgeMin * (100 - DMTXW_TUNE_MARGIN) / 100;
+      next.edgeMax = edgeMax * (100 + DMTXW_TUNE_MARGIN) / 100 + 1;
+      next.sizeIdx = sizeIdx;
+
+      /* Keep DMTXW_TUNE_MODULE_PIXELS per module after shrinking */
+      next.shrink = moduleMin / (scale * DMTXW_TUNE_MODULE_PIXELS);
+      if(next.shrink < 1)
+         next.shrink = 1;
+      else if(next.shrink > DMTXW_TUNE_MAX_SHRINK)
+         next.shrink = DMTXW_TUNE_MAX_SHRINK;
+
+      /* Let at least DMTXW_TUNE_GAP_LINES scan lines cross the smallest
+       * symbol; libdmtx counts the gap in shrunken pixels */
+      edgeShrunk = next.edgeMin / (scale * next.shrink);
+      if(edgeShrunk / DMTXW_TUNE_GAP_LINES > DMTXW_TUNE_GAP_DEFAULT)
+         next.scanGap = (edgeShrunk / DMTXW_TUNE_GAP_LINES) * scale;
+   }
+
+   tuner->tuned = (next.edgeMin != DmtxUndefined) ? DmtxTrue : DmtxFalse;
+
+   if(memcmp(&next, &(tuner->active), sizeof(DmtxwTuneParams)) != 0) {
+      tuner->active = next;
+      TuneLog(session, found);
+   }
+}
+
+/**
+ * @brief  Report the tuned parameters together with the window statistics
+ *         they were derived from
+ * @param  session Session
+ * @param  found Decodes in the window that found symbols
+ * @return void
+ */
+static void
+TuneLog(DmtxwSession *session, int found)
+{
+   DmtxwTuner *tuner = session->tuner;
+   DmtxwTuneParams *active = &(tuner->active);
+   DmtxwTuneSample *sample;
+   char message[DMTXW_LOG_MAX];
+   double tunedMsec, probeMsec;
+   int i, tunedCount, probeCount, angleMin, angleMax, contrastMin;
+
+   if(session->logFunc == NULL)
+      return;
+
+   tunedMsec = probeMsec = 0.0;
+   tunedCount = probeCount = 0;
+   angleMin = 360;
+   angleMax = 0;
+   contrastMin = 255;
+
+   for(i = 0; i < tuner->count; i++) {
+      sample = &(tuner->sample[i]);
+      if(sample->probe == DmtxTrue) {
+         probeMsec += sample->msec;
+         probeCount++;
+      }
+      else {
+         tunedMsec += sample->msec;
+         tunedCount++;
+      }
+      if(sample->found > 0) {
+         angleMin = (sample->angleMin < angleMin) ? sample->angleMin : angleMin;
+         angleMax = (sample->angleMax > angleMax) ? sample->angleMax : angleMax;
+         contrastMin = (sample->contrastMin < contrastMin) ? sample->contrastMin : contrastMin;
+      }
+   }
+
+   /* Keep the averages within the printed width budget of message */
+   tunedMsec = (tunedCount > 0) ? tunedMsec / tunedCount : 0.0;
+   probeMsec = (probeCount > 0) ? probeMsec / probeCount : 0.0;
+   tunedMsec = (tunedMsec > DMTXW_LOG_MSEC_MAX) ? DMTXW_LOG_MSEC_MAX : tunedMsec;
+   probeMsec = (probeMsec > DMTXW_LOG_MSEC_MAX) ? DMTXW_LOG_MSEC_MAX : probeMsec;
+
+   if(active->edgeMin == DmtxUndefined) {
+      sprintf(message, "auto-tune: full scan (%d of %d decodes found symbols)",
+            found, tuner->count);
+   }
+   else {
+      sprintf(message, "auto-tune: edge %d..%d, size %d, gap %d, shrink %d "
+            "(%d of %d decodes found symbols, angle %d..%d, contrast >= %d, "
+            "%.1f ms tuned, %.1f ms full)", active->edgeMin, active->edgeMax,
+            active->sizeIdx, active->scanGap, active->shrink, found, tuner->count,
+            angleMin, angleMax, contrastMin, tunedMsec, probeMsec);
+   }
+
+   session->logFunc(message, session->logContext);
+}
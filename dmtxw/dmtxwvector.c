@@ -0,0 +1,493 @@
+/*
+libdmtxw - Shared native glue for the libdmtx wrappers
+
+Copyright (C) 2026 The libdmtx-wrappers project
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+Contact: mike@dragonflylogic.com
+*/
+
+/* $Id$ */
+
+/**
+ * @file dmtxwvector.c
+ * @brief SVG, PDF and EPS output straight from the module grid
+ *
+ * The wrappers get encoded symbols as libdmtx's raster image and scale it
+ * again in the host language, which blurs or bloats labels printed at high
+ * resolution. These serialisers read the module grid of an encoded symbol
+ * once and describe it as filled rectangles instead: dark modules are
+ * merged into horizontal runs, and runs repeating on the rows below into
+ * one rectangle. Coordinates are whole modules; the module size and the
+ * position of a symbol only enter as one transform per symbol (matrix,
+ * cm or translate and scale), so the output is exact at any size and
+ * label sheets (dmtxwsheet.c) reuse the same writers.
+ */
+
+/**
+ * @brief  Describe an encoded symbol as vector graphics
+ * @param  enc Encoder after a successful dmtxEncodeDataMatrix()
+ * @param  format DmtxwVectorFormat value
+ * @param  moduleSize Module edge in output units (SVG user units, PDF and
+ *         EPS points)
+ * @param  margin Quiet zone in modules, DmtxUndefined to use the encoder's
+ *         margin size relative to its module size
+ * @param  out Receives the document; its contents are replaced and its
+ *         memory reused. Release with dmtxwBufferFree().
+ * @return DmtxPass | DmtxFail
+ */
+extern DmtxPassFail
+dmtxwEncodeVector(DmtxEncode *enc, int format, double moduleSize, int margin,
+      DmtxwBuffer *out)
+{
+   DmtxwVectorPlace place;
+   DmtxPassFail err;
+
+   if(enc == NULL || enc->message == NULL || out == NULL || moduleSize <= 0.0 ||
+         (format != DmtxwVectorSvg && format != DmtxwVectorPdf && format != DmtxwVectorEps))
+      return DmtxFail;
+
+   if(margin == DmtxUndefined)
+      margin = (enc->moduleSize > 0) ? enc->marginSize / enc->moduleSize : 0;
+   if(margin < 0 || margin > DMTXW_VECTOR_MAX_MARGIN)
+      return DmtxFail;
+
+   if(VectorGridCreate(enc, margin, &(place.grid)) == DmtxFail)
+      return DmtxFail;
+
+   place.x = place.y = 0.0;
+   err = VectorWrite(format, &place, 1, moduleSize, place.grid.width * moduleSize,
+         place.grid.height * moduleSize, out);
+
+   free(place.grid.dark);
+
+   return err;
+}
+
+/**
+ * @brief  Look up a vector format by name ("svg", "pdf" or "eps")
+ * @param  name Format name
+ * @return DmtxwVectorFormat value, or DmtxUndefined
+ */
+extern int
+dmtxwVectorByName(const char *name)
+{
+   if(name == NULL)
+      return DmtxUndefined;
+   else if(strcmp(name, "svg") == 0)
+      return DmtxwVectorSvg;
+   else if(strcmp(name, "pdf") == 0)
+      return DmtxwVectorPdf;
+   else if(strcmp(name, "eps") == 0)
+      return DmtxwVectorEps;
+
+   return DmtxUndefined;
+}
+
+/**
+ * @brief  Release the memory of a buffer filled by libdmtxw
+ * @param  buffer Buffer
+ * @return void
+ */
+extern void
+dmtxwBufferFree(DmtxwBuffer *buffer)
+{
+   if(buffer == NULL)
+      return;
+
+   free(buffer->data);
+   buffer->data = NULL;
+   buffer->length = 0;
+   buffer->capacity = 0;
+}
+
+/**
+ * @brief  Copy the module grid of an encoded symbol, quiet zone included
+ * @param  enc Encoder holding the symbol
+ * @param  margin Quiet zone in modules
+ * @param  grid Receives the grid (top row first); free grid->dark
+ * @return DmtxPass | DmtxFail
+ */
+static DmtxPassFail
+VectorGridCreate(DmtxEncode *enc, int margin, DmtxwVectorGrid *grid)
+{
+   int sizeIdx, rows, cols, row, col, status;
+
+   sizeIdx = enc->region.sizeIdx;
+   rows = dmtxGetSymbolAttribute(DmtxSymAttribSymbolRows, sizeIdx);
+   cols = dmtxGetSymbolAttribute(DmtxSymAttribSymbolCols, sizeIdx);
+   if(rows < 1 || cols < 1)
+      return DmtxFail;
+
+   grid->width = cols + 2 * margin;
+   grid->height = rows + 2 * margin;
+   grid->dark = (unsigned char *)calloc((size_t)grid->width * grid->height, 1);
+   if(grid->dark == NULL)
+      return DmtxFail;
+
+   /* libdmtx counts symbol rows from the bottom */
+   for(row = 0; row < rows; row++) {
+      for(col = 0; col < cols; col++) {
+         status = dmtxSymbolModuleStatus(enc->message, sizeIdx, row, col);
+         if(status & DmtxModuleOnRGB)
+            grid->dark[(margin + rows - 1 - row) * grid->width + margin + col] = 1;
+      }
+   }
+
+   return DmtxPass;
+}
+
+/**
+ * @brief  Cover the dark modules with rectangles, calling func for each
+ * @param  grid Module grid; dark modules are marked as visited (2)
+ * @param  func Receives each rectangle in top-down module coordinates
+ * @param  out Buffer handed to func
+ * @return DmtxPass | DmtxFail (func failed)
+ */
+static DmtxPassFail
+VectorMergeRects(DmtxwVectorGrid *grid, DmtxwRectFunc func, DmtxwBuffer *out)
+{
+   unsigned char *dark = grid->dark;
+   int x, y, x1, y1, i, w = grid->width;
+
+   for(y = 0; y < grid->height; y++) {
+      for(x = 0; x < w; x++) {
+         if(dark[y * w + x] != 1)
+            continue;
+
+         /* Widest run of unvisited dark modules from here */
+         for(x1 = x + 1; x1 < w && dark[y * w + x1] == 1; x1++)
+            ;
+
+         /* Rows below joining in with exactly the same run */
+         for(y1 = y + 1; y1 < grid->height; y1++) {
+            if((x > 0 && dark[y1 * w + x - 1] != 0) || (x1 < w && dark[y1 * w + x1] != 0))
+               break;
+            for(i = x; i < x1 && dark[y1 * w + i] == 1; i++)
+               ;
+            if(i < x1)
+               break;
+         }
+
+         for(i = y; i < y1; i++)
+            memset(dark + i * w + x, 2, (size_t)(x1 - x));
+
+         if((*func)(out, x, y, x1 - x, y1 - y, grid->height) == DmtxFail)
+            return DmtxFail;
+
+         x = x1 - 1;
+      }
+   }
+
+   return DmtxPass;
+}
+
+/**
+ * @brief  Write an SVG document; every grid is a path scaled from modules
+ * @param  place Grids and their positions
+ * @param  count Number of grids
+ * @param  moduleSize Module edge in user units
+ * @param  width Page width in user units
+ * @param  height Page height in user units
+ * @param  out Output buffer
+ * @return DmtxPass | DmtxFail
+ */
+static DmtxPassFail
+VectorWriteSvg(DmtxwVectorPlace *place, int count, double moduleSize, double width,
+      double height, DmtxwBuffer *out)
+{
+   char text[DMTXW_VECTOR_LINE_MAX];
+   int i;
+
+   sprintf(text, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+         "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\" "
+         "width=\"%g\" height=\"%g\" viewBox=\"0 0 %g %g\" shape-rendering=\"crispEdges\">\n"
+         "<rect width=\"%g\" height=\"%g\" fill=\"#fff\"/>\n", width, height, width, height,
+         width, height);
+   if(BufferAppend(out, text, strlen(text)) == DmtxFail)
+      return DmtxFail;
+
+   for(i = 0; i < count; i++) {
+      if(place[i].grid.dark == NULL)
+         continue;
+
+      sprintf(text, "<path fill=\"#000\" transform=\"matrix(%g 0 0 %g %g %g)\" d=\"",
+            moduleSize, moduleSize, place[i].x, place[i].y);
+      if(BufferAppend(out, text, strlen(text)) == DmtxFail ||
+            VectorMergeRects(&(place[i].grid), VectorRectSvg, out) == DmtxFail ||
+            BufferAppend(out, "\"/>\n", 4) == DmtxFail)
+         return DmtxFail;
+   }
+
+   return BufferAppend(out, "</svg>\n", 7);
+}
+
+/**
+ * @brief  Write a one-page PDF document
+ * @param  place Grids and their positions (top-down)
+ * @param  count Number of grids
+ * @param  moduleSize Module edge in points
+ * @param  width Page width in points
+ * @param  height Page height in points
+ * @param  out Output buffer
+ * @return DmtxPass | DmtxFail
+ */
+static DmtxPassFail
+VectorWritePdf(DmtxwVectorPlace *place, int count, double moduleSize, double width,
+      double height, DmtxwBuffer *out)
+{
+   DmtxwBuffer content;
+   char text[DMTXW_VECTOR_LINE_MAX];
+   size_t offset[5], xref;
+   int i;
+   DmtxPassFail err;
+
+   /* The stream length must be known before it is written */
+   memset(&content, 0x00, sizeof(DmtxwBuffer));
+   err = BufferAppend(&content, "0 g\n", 4);
+   for(i = 0; i < count && err == DmtxPass; i++) {
+      if(place[i].grid.dark == NULL)
+         continue;
+
+      sprintf(text, "q %g 0 0 %g %g %g cm\n", moduleSize, moduleSize, place[i].x,
+            height - place[i].y - place[i].grid.height * moduleSize);
+      err = BufferAppend(&content, text, strlen(text));
+      if(err == DmtxPass)
+         err = VectorMergeRects(&(place[i].grid), VectorRectPdf, &content);
+      if(err == DmtxPass)
+         err = BufferAppend(&content, "f\nQ\n", 4);
+   }
+
+   if(err == DmtxPass)
+      err = BufferAppend(out, "%PDF-1.4\n%\xe2\xe3\xcf\xd3\n", 15);
+
+   offset[1] = out->length;
+   sprintf(text, "1 0 obj\n<< /Type /Catalog /Pages 2 0 R >>\nendobj\n");
+   if(err == DmtxPass)
+      err = BufferAppend(out, text, strlen(text));
+
+   offset[2] = out->length;
+   sprintf(text, "2 0 obj\n<< /Type /Pages /Kids [3 0 R] /Count 1 >>\nendobj\n");
+   if(err == DmtxPass)
+      err = BufferAppend(out, text, strlen(text));
+
+   offset[3] = out->length;
+   sprintf(text, "3 0 obj\n<< /Type /Page /Parent 2 0 R /MediaBox [0 0 %g %g] "
+         "/Resources << >> /Contents 4 0 R >>\nendobj\n", width, height);
+   if(err == DmtxPass)
+      err = BufferAppend(out, text, strlen(text));
+
+   offset[4] = out->length;
+   sprintf(text, "4 0 obj\n<< /Length %lu >>\nstream\n", (unsigned long)content.length);
+   if(err == DmtxPass)
+      err = BufferAppend(out, text, strlen(text));
+   if(err == DmtxPass)
+      err = BufferAppend(out, (char *)content.data, content.length);
+   if(err == DmtxPass)
+      err = BufferAppend(out, "endstream\nendobj\n", 17);
+
+   /* Cross-reference entries are exactly 20 bytes each */
+   xref = out->length;
+   if(err == DmtxPass)
+      err = BufferAppend(out, "xref\n0 5\n0000000000 65535 f \n", 29);
+   for(i = 1; i < 5 && err == DmtxPass; i++) {
+      sprintf(text, "%010lu 00000 n \n", (unsigned long)offset[i]);
+      err = BufferAppend(out, text, 20);
+   }
+   sprintf(text, "trailer\n<< /Size 5 /Root 1 0 R >>\nstartxref\n%lu\n%%%%EOF\n",
+         (unsigned long)xref);
+   if(err == DmtxPass)
+      err = BufferAppend(out, text, strlen(text));
+
+   dmtxwBufferFree(&content);
+
+   return err;
+}
+
+/**
+ * @brief  Write an Encapsulated PostScript document
+ * @param  place Grids and their positions (top-down)
+ * @param  count Number of grids
+ * @param  moduleSize Module edge in points
+ * @param  width Page width in points
+ * @param  height Page height in points
+ * @param  out Output buffer
+ * @return DmtxPass | DmtxFail
+ */
+static DmtxPassFail
+VectorWriteEps(DmtxwVectorPlace *place, int count, double moduleSize, double width,
+      double height, DmtxwBuffer *out)
+{
+   char text[DMTXW_VECTOR_LINE_MAX];
+   int i;
+
+   sprintf(text, "%%!PS-Adobe-3.0 EPSF-3.0\n%%%%BoundingBox: 0 0 %d %d\n"
+         "%%%%HiResBoundingBox: 0 0 %g %g\n%%%%Creator: libdmtxw\n%%%%EndComments\n"
+         "0 setgray\n", (int)ceil(width), (int)ceil(height), width, height);
+   if(BufferAppend(out, text, strlen(text)) == DmtxFail)
+      return DmtxFail;
+
+   for(i = 0; i < count; i++) {
+      if(place[i].grid.dark == NULL)
+         continue;
+
+      sprintf(text, "gsave\n%g %g translate\n%g %g scale\n", place[i].x,
+            height - place[i].y - place[i].grid.height * moduleSize, moduleSize, moduleSize);
+      if(BufferAppend(out, text, strlen(text)) == DmtxFail ||
+            VectorMergeRects(&(place[i].grid), VectorRectEps, out) == DmtxFail ||
+            BufferAppend(out, "grestore\n", 9) == DmtxFail)
+         return DmtxFail;
+   }
+
+   return BufferAppend(out, "showpage\n%%EOF\n", 15);
+}
+
+/**
+ * @brief  Write the document of a format for any number of placed grids
+ * @param  format DmtxwVectorFormat value
+ * @param  place Grids and their positions in output units, top-down;
+ *         grids without modules (dark NULL) are skipped
+ * @param  count Number of grids
+ * @param  moduleSize Module edge in output units
+ * @param  width Page width in output units
+ * @param  height Page height in output units
+ * @param  out Output buffer, emptied first
+ * @return DmtxPass | DmtxFail
+ */
+static DmtxPassFail
+VectorWrite(int format, DmtxwVectorPlace *place, int count, double moduleSize,
+      double width, double height, DmtxwBuffer *out)
+{
+   out->length = 0;
+
+   switch(format) {
+      case DmtxwVectorSvg:
+         return VectorWriteSvg(place, count, moduleSize, width, height, out);
+      case DmtxwVectorPdf:
+         return VectorWritePdf(place, count, moduleSize, width, height, out);
+      case DmtxwVectorEps:
+         return VectorWriteEps(place, count, moduleSize, width, height, out);
+   }
+
+   return DmtxFail;
+}
+
+/**
+ * @brief  One rectangle as an SVG path segment
+ * @param  out Output buffer
+ * @param  x Left module
+ * @param  y Top module
+ * @param  width Width in modules
+ * @param  height Height in modules
+ * @param  gridHeight Rows of the grid (unused, SVG is top-down)
+ * @return DmtxPass | DmtxFail
+ */
+static DmtxPassFail
+VectorRectSvg(DmtxwBuffer *out, int x, int y, int width, int height, int gridHeight)
+{
+   char text[DMTXW_VECTOR_LINE_MAX];
+
+   sprintf(text, "M%d %dh%dv%dh-%dz", x, y, width, height, width);
+
+   return BufferAppend(out, text, strlen(text));
+}
+
+/**
+ * @brief  One rectangle as a PDF re operator (bottom-up coordinates)
+ * @param  out Output buffer
+ * @param  x Left module
+ * @param  y Top module
+ * @param  width Width in modules
+ * @param  height Height in modules
+ * @param  gridHeight Rows of the grid
+ * @return DmtxPass | DmtxFail
+ */
+static DmtxPassFail
+VectorRectPdf(DmtxwBuffer *out, int x, int y, int width, int height, int gridHeight)
+{
+   char text[DMTXW_VECTOR_LINE_MAX];
+
+   sprintf(text, "%d %d %d %d re\n", x, gridHeight - y - height, width, height);
+
+   return BufferAppend(out, text, strlen(text));
+}
+
+/**
+ * @brief  One rectangle as a PostScript rectfill (bottom-up coordinates)
+ * @param  out Output buffer
+ * @param  x Left module
+ * @param  y Top module
+ * @param  width Width in modules
+ * @param  height Height in modules
+ * @param  gridHeight Rows of the grid
+ * @return DmtxPass | DmtxFail
+ */
+static DmtxPassFail
+VectorRectEps(DmtxwBuffer *out, int x, int y, int width, int height, int gridHeight)
+{
+   char text[DMTXW_VECTOR_LINE_MAX];
+
+   sprintf(text, "%d %d %d %d rectfill\n", x, gridHeight - y - height, width, height);
+
+   return BufferAppend(out, text, strlen(text));
+}
+
+/**
+ * @brief  Append bytes to a buffer, growing it as needed
+ * @param  buffer Buffer
+ * @param  data Bytes
+ * @param  length Number of bytes
+ * @return DmtxPass | DmtxFail (out of memory)
+ */
+static DmtxPassFail
+BufferAppend(DmtxwBuffer *buffer, const char *data, size_t length)
+{
+   if(BufferReserve(buffer, buffer->length + length) == DmtxFail)
+      return DmtxFail;
+
+   memcpy(buffer->data + buffer->length, data, length);
+   buffer->length += length;
+
+   return DmtxPass;
+}
+
+/**
+ * @brief  Grow a buffer to hold at least capacity bytes
+ * @param  buffer Buffer
+ * @param  capacity Bytes needed in total
+ * @return DmtxPass | DmtxFail (out of memory)
+ */
+static DmtxPassFail
+BufferReserve(DmtxwBuffer *buffer, size_t capacity)
+{
+   unsigned char *grown;
+   size_t grow;
+
+   if(capacity <= buffer->capacity)
+      return DmtxPass;
+
+   grow = (buffer->capacity == 0) ? DMTXW_BUFFER_MIN : buffer->capacity;
+   while(grow < capacity)
+      grow *= 2;
+
+   grown = (unsigned char *)realloc(buffer->data, grow);
+   if(grown == NULL)
+      return DmtxFail;
+   buffer->data = grown;
+   buffer->capacity = grow;
+
+   return DmtxPass;
+}
@@ -0,0 +1,211 @@
+/*
+libdmtxw - Shared native glue for the libdmtx wrappers
+
+Copyright (C) 2026 The libdmtx-wrappers project
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+Contact: mike@dragonflylogic.com
+*/
+
+/* $Id$ */
+
+/**
+ * @file labelbench.c
+ * @brief Bytes per label and label rate of dmtxwEncodePrinter()
+ *
+ * Encodes random serial-number style messages and turns each symbol into
+ * a thermal printer label in every DmtxwPrinterMode. As a baseline the
+ * raster image rendered by libdmtx is scaled to the same dot density and
+ * sent as an uncompressed ^GFA graphic, which is what converting the
+ * wrapper's bitmap amounts to. Times include dmtxEncodeDataMatrix().
+ *
+ *   $ make labelbench
+ *   $ ./labelbench [labels [dots [length [seed]]]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "dmtxw.h"
+
+#define MAX_LENGTH       256
+#define MODE_COUNT       4
+
+typedef struct {
+   const char *name;
+   double ms;
+   double bytes;
+} ModeStats;
+
+/* Small LCG so the messages are the same on every platform */
+static unsigned long seed = 1;
+
+/**
+ * @brief  Next pseudo-random number
+ * @param  n Upper bound
+ * @return Number in 0 .. n-1
+ */
+static int
+Random(int n)
+{
+   seed = seed * 1103515245UL + 12345UL;
+   return (int)((seed >> 16) & 0x7fff) % n;
+}
+
+/**
+ * @brief  Processor time used so far
+ * @return Milliseconds
+ */
+static double
+Now(void)
+{
+   return (double)clock() * 1000.0 / CLOCKS_PER_SEC;
+}
+
+/**
+ * @brief  Scale the encoder's raster image to dots and write it as an
+ *         uncompressed ^GFA label
+ * @param  enc Encoder after dmtxEncodeDataMatrix()
+ * @param  dots Dots per module edge
+ * @param  out Output buffer, grown as needed
+ * @return Label length in bytes, -1 on failure
+ */
+static long
+RasterLabel(DmtxEncode *enc, int dots, DmtxwBuffer *out)
+{
+   int width, height, rowBytes, dotWidth, dotHeight, x, y, value;
+   size_t need;
+   char *p;
+   unsigned char byte;
+
+   width = dmtxImageGetProp(enc->image, DmtxPropWidth);
+   height = dmtxImageGetProp(enc->image, DmtxPropHeight);
+   dotWidth = width * dots / enc->moduleSize;
+   dotHeight = height * dots / enc->moduleSize;
+   rowBytes = (dotWidth + 7) / 8;
+
+   need = (size_t)rowBytes * dotHeight * 2 + 64;
+   if(out->capacity < need) {
+      free(out->data);
+      out->data = (unsigned char *)malloc(need);
+      if(out->data == NULL)
+         return -1;
+      out->capacity = need;
+   }
+
+   p = (char *)out->data;
+   p += sprintf(p, "^XA\n^FO0,0^GFA,%d,%d,%d,", rowBytes * dotHeight,
+         rowBytes * dotHeight, rowBytes);
+
+   for(y = 0; y < dotHeight; y++) {
+      for(x = 0, byte = 0; x < rowBytes * 8; x++) {
+         value = 255;
+         if(x < dotWidth)
+            dmtxImageGetPixelValue(enc->image, x * enc->moduleSize / dots,
+                  y * enc->moduleSize / dots, 0, &value);
+         byte = (unsigned char)((byte << 1) | (value < 128));
+         if((x & 7) == 7) {
+            *p++ = "0123456789ABCDEF"[byte >> 4];
+            *p++ = "0123456789ABCDEF"[byte & 0x0f];
+            byte = 0;
+         }
+      }
+   }
+   p += sprintf(p, "^FS\n^XZ\n");
+   out->length = (size_t)(p - (char *)out->data);
+
+   return (long)out->length;
+}
+
+/**
+ * @brief  Run the benchmark
+ * @param  argc Argument count
+ * @param  argv Labels, dots per module, message length, seed (all optional)
+ * @return 0 on success
+ */
+int
+main(int argc, char *argv[])
+{
+   int labels, dots, length, i, j, mode;
+   unsigned char message[MAX_LENGTH];
+   double t0;
+   DmtxEncode *enc;
+   DmtxwBuffer buffer;
+   ModeStats stats[MODE_COUNT];
+
+   labels = (argc > 1) ? atoi(argv[1]) : 1000;
+   dots = (argc > 2) ? atoi(argv[2]) : 4;
+   length = (argc > 3) ? atoi(argv[3]) : 24;
+   seed = (argc > 4) ? strtoul(argv[4], NULL, 10) : 1;
+
+   if(labels < 1 || dots < 1 || dots > 64 || length < 1 || length > MAX_LENGTH) {
+      fprintf(stderr, "usage: %s [labels [dots (1-64) [length (1-%d) [seed]]]]\n",
+            argv[0], MAX_LENGTH);
+      return 1;
+   }
+
+   memset(stats, 0x00, sizeof(stats));
+   stats[0].name = "raster ^GFA";
+   stats[1 + DmtxwPrinterZpl].name = "zpl ^BX";
+   stats[1 + DmtxwPrinterZplGraphic].name = "zpl-graphic";
+   stats[1 + DmtxwPrinterEplGraphic].name = "epl-graphic";
+   memset(&buffer, 0x00, sizeof(DmtxwBuffer));
+
+   for(i = 0; i < labels; i++) {
+      for(j = 0; j < length; j++)
+         message[j] = (unsigned char)((j < 3) ? 'A' + Random(26) : '0' + Random(10));
+
+      for(mode = 0; mode < MODE_COUNT; mode++) {
+         t0 = Now();
+
+         enc = dmtxEncodeCreate();
+         if(enc == NULL || dmtxEncodeDataMatrix(enc, length, message) == DmtxFail) {
+            fprintf(stderr, "Unable to encode message %d\n", i);
+            return 1;
+         }
+
+         if(mode == 0) {
+            if(RasterLabel(enc, dots, &buffer) < 0) {
+               fprintf(stderr, "Out of memory\n");
+               return 1;
+            }
+         }
+         else if(dmtxwEncodePrinter(enc, message, length, mode - 1, dots,
+               DmtxUndefined, &buffer) == DmtxFail) {
+            fprintf(stderr, "Unable to write label %d (%s)\n", i, stats[mode].name);
+            return 1;
+         }
+
+         dmtxEncodeDestroy(&enc);
+
+         stats[mode].ms += Now() - t0;
+         stats[mode].bytes += (double)buffer.length;
+      }
+   }
+
+   printf("corpus:      %d labels, %d characters, %d dots per module\n",
+         labels, length, dots);
+   for(mode = 0; mode < MODE_COUNT; mode++) {
+      printf("%-12s %9.0f bytes/label %10.0f labels/s\n", stats[mode].name,
+            stats[mode].bytes / labels,
+            (stats[mode].ms > 0.0) ? labels * 1000.0 / stats[mode].ms : 0.0);
+   }
+
+   dmtxwBufferFree(&buffer);
+
+   return 0;
+}
@@ -0,0 +1,365 @@
+/*
+libdmtxw - Shared native glue for the libdmtx wrappers
+
+Copyright (C) 2026 The libdmtx-wrappers project
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+Contact: mike@dragonflylogic.com
+*/
+
+/* $Id$ */
+
+/**
+ * @file locatebench.c
+ * @brief Precision, recall and speedup of the DmtxwPropLocate pre-pass
+ *
+ * Builds a synthetic corpus of cluttered 8bpp frames (noise, solid blocks,
+ * rules and text-like stroke rows) with symbols encoded by libdmtx pasted
+ * at random positions, half of them rotated. For every frame it reports
+ * how the candidate boxes of dmtxwSessionLocate() match the pasted
+ * symbols and how a located decode compares with a full-frame decode.
+ *
+ * A candidate counts as correct (precision) when it covers at least half
+ * of some symbol; a symbol counts as found (recall) when at least 90% of
+ * it lies inside one candidate.
+ *
+ *   $ make locatebench
+ *   $ ./locatebench [frames [symbols [candidates [seed]]]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "dmtxw.h"
+
+#define FRAME_WIDTH      2048
+#define FRAME_HEIGHT     1536
+#define MAX_SYMBOLS      32
+
+#ifndef M_PI
+#define M_PI      3.14159265358979323846
+#endif
+
+typedef struct {
+   int x, y, width, height;
+   char message[32];
+} Truth;
+
+typedef struct {
+   double ms;
+   int decoded;
+} RunStats;
+
+/* Small LCG so the corpus is the same on every platform */
+static unsigned long seed = 1;
+
+/**
+ * @brief  Next pseudo-random number
+ * @param  n Upper bound
+ * @return Number in 0 .. n-1
+ */
+static int
+Random(int n)
+{
+   seed = seed * 1103515245UL + 12345UL;
+   return (int)((seed >> 16) & 0x7fff) % n;
+}
+
+/**
+ * @brief  Processor time used so far
+ * @return Milliseconds
+ */
+static double
+Now(void)
+{
+   return (double)clock() * 1000.0 / CLOCKS_PER_SEC;
+}
+
+/**
+ * @brief  Fill a frame with noise and clutter
+ * @param  frame Frame pixels
+ * @return void
+ */
+static void
+DrawClutter(unsigned char *frame)
+{
+   int i, j, x, y, w, h, v;
+
+   for(i = 0; i < FRAME_WIDTH * FRAME_HEIGHT; i++)
+      frame[i] = (unsigned char)(200 + Random(40) - (i / FRAME_WIDTH) / 32);
+
+   /* Solid blocks and rules */
+   for(i = 0; i < 40; i++) {
+      w = (i % 2) ? 2 + Random(4) : 20 + Random(200);
+      h = (i % 2) ? 20 + Random(400) : 20 + Random(120);
+      x = Random(FRAME_WIDTH - w);
+      y = Random(FRAME_HEIGHT - h);
+      v = Random(100);
+      for(j = 0; j < h; j++)
+         memset(frame + (y + j) * FRAME_WIDTH + x, v, w);
+   }
+
+   /* Rows of short vertical strokes standing in for text */
+   for(i = 0; i < 30; i++) {
+      x = Random(FRAME_WIDTH - 400);
+      y = Random(FRAME_HEIGHT - 20);
+      for(w = 0; w < 400; w += 3 + Random(6)) {
+         h = 8 + Random(12);
+         for(j = 0; j < h; j++)
+            frame[(y + j) * FRAME_WIDTH + x + w] = frame[(y + j) * FRAME_WIDTH + x + w + 1] = 30;
+      }
+   }
+}
+
+/**
+ * @brief  Encode a message and paste it into the frame at a free spot
+ * @param  frame Frame pixels
+ * @param  truth Symbols already placed
+ * @param  count Number of symbols already placed
+ * @param  rotate Nonzero to rotate by a random angle
+ * @return DmtxPass | DmtxFail (no free spot)
+ */
+static DmtxPassFail
+PasteSymbol(unsigned char *frame, Truth *truth, int count, int rotate)
+{
+   DmtxEncode *enc;
+   Truth *t = &(truth[count]);
+   int i, x, y, x0, y0, x1, y1, sw, sh, sx, sy, side, tries;
+   double angle, c, s, dx, dy;
+
+   sprintf(t->message, "bench %05d", Random(100000));
+
+   enc = dmtxEncodeCreate();
+   if(enc == NULL)
+      return DmtxFail;
+   dmtxEncodeSetProp(enc, DmtxPropPixelPacking, DmtxPack8bppK);
+   dmtxEncodeSetProp(enc, DmtxPropModuleSize, 3 + Random(4));
+   if(dmtxEncodeDataMatrix(enc, strlen(t->message), (unsigned char *)t->message) == DmtxFail) {
+      dmtxEncodeDestroy(&enc);
+      return DmtxFail;
+   }
+
+   sw = dmtxImageGetProp(enc->image, DmtxPropWidth);
+   sh = dmtxImageGetProp(enc->image, DmtxPropHeight);
+   angle = rotate ? Random(360) * M_PI / 180.0 : 0.0;
+   c = cos(angle);
+   s = sin(angle);
+   side = (int)(fabs(c) * sw + fabs(s) * sh) + 2;
+   if(side < (int)(fabs(s) * sw + fabs(c) * sh) + 2)
+      side = (int)(fabs(s) * sw + fabs(c) * sh) + 2;
+
+   /* Keep clear of earlier symbols */
+   for(tries = 0; tries < 100; tries++) {
+      t->x = Random(FRAME_WIDTH - side);
+      t->y = Random(FRAME_HEIGHT - side);
+      for(i = 0; i < count; i++) {
+         if(t->x < truth[i].x + truth[i].width + 16 && truth[i].x < t->x + side + 16 &&
+               t->y < truth[i].y + truth[i].height + 16 && truth[i].y < t->y + side + 16)
+            break;
+      }
+      if(i == count)
+         break;
+   }
+   if(tries == 100) {
+      dmtxEncodeDestroy(&enc);
+      return DmtxFail;
+   }
+   /* Nearest neighbour inverse rotation about the symbol centre. The
+    * truth box is the extent of the dark modules, not of the quiet zone. */
+   x0 = y0 = side;
+   x1 = y1 = 0;
+   for(y = 0; y < side; y++) {
+      for(x = 0; x < side; x++) {
+         dx = x - side / 2.0;
+         dy = y - side / 2.0;
+         sx = (int)floor(c * dx + s * dy + sw / 2.0);
+         sy = (int)floor(-s * dx + c * dy + sh / 2.0);
+         if(sx < 0 || sy < 0 || sx >= sw || sy >= sh)
+            continue;
+         frame[(t->y + y) * FRAME_WIDTH + t->x + x] = enc->image->pxl[sy * sw + sx];
+         if(enc->image->pxl[sy * sw + sx] < 128) {
+            x0 = (x < x0) ? x : x0;
+            y0 = (y < y0) ? y : y0;
+            x1 = (x > x1) ? x : x1;
+            y1 = (y > y1) ? y : y1;
+         }
+      }
+   }
+   t->x += x0;
+   t->y += y0;
+   t->width = x1 - x0 + 1;
+   t->height = y1 - y0 + 1;
+
+   dmtxEncodeDestroy(&enc);
+
+   return DmtxPass;
+}
+
+/**
+ * @brief  Area shared by two rectangles
+ * @param  ax Left edge of first rectangle
+ * @param  ay Top edge of first rectangle
+ * @param  aw Width of first rectangle
+ * @param  ah Height of first rectangle
+ * @param  bx Left edge of second rectangle
+ * @param  by Top edge of second rectangle
+ * @param  bw Width of second rectangle
+ * @param  bh Height of second rectangle
+ * @return Shared area in pixels
+ */
+static int
+Overlap(int ax, int ay, int aw, int ah, int bx, int by, int bw, int bh)
+{
+   int w, h;
+
+   w = ((ax + aw < bx + bw) ? ax + aw : bx + bw) - ((ax > bx) ? ax : bx);
+   h = ((ay + ah < by + bh) ? ay + ah : by + bh) - ((ay > by) ? ay : by);
+
+   return (w > 0 && h > 0) ? w * h : 0;
+}
+
+/**
+ * @brief  Decode a frame and count how many pasted symbols were read
+ * @param  session Session
+ * @param  frame Frame pixels
+ * @param  truth Pasted symbols
+ * @param  count Number of pasted symbols
+ * @param  stats Accumulates time and decoded symbols
+ * @return void
+ */
+static void
+TimeDecode(DmtxwSession *session, unsigned char *frame, Truth *truth, int count,
+      RunStats *stats)
+{
+   int i, j;
+   double t0;
+   const unsigned char *payload;
+
+   t0 = Now();
+   dmtxwSessionDecode(session, frame, FRAME_WIDTH, FRAME_HEIGHT, 0, DmtxwFormatGray8);
+   stats->ms += Now() - t0;
+
+   for(i = 0; i < count; i++) {
+      for(j = 0; j < dmtxwSessionGetResultCount(session); j++) {
+         payload = dmtxwSessionGetPayload(session, j, NULL);
+         if(strcmp((const char *)payload, truth[i].message) == 0) {
+            stats->decoded++;
+            break;
+         }
+      }
+   }
+}
+
+/**
+ * @brief  Run the benchmark and print a summary
+ * @param  argc Argument count
+ * @param  argv Frames, symbols per frame, candidates, seed (all optional)
+ * @return 0 on success
+ */
+int
+main(int argc, char *argv[])
+{
+   int frames, symbols, candidates, f, i, j, count, boxCount, hits, area;
+   int totalBoxes = 0, totalHits = 0, totalSymbols = 0, totalFound = 0;
+   unsigned char *frame;
+   double t0, locateMs = 0.0;
+   DmtxwSession *session;
+   DmtxwBox box[64];
+   Truth truth[MAX_SYMBOLS];
+   RunStats full, located;
+
+   frames = (argc > 1) ? atoi(argv[1]) : 20;
+   symbols = (argc > 2) ? atoi(argv[2]) : 4;
+   candidates = (argc > 3) ? atoi(argv[3]) : 8;
+   seed = (argc > 4) ? strtoul(argv[4], NULL, 10) : 1;
+
+   if(frames < 1 || symbols < 1 || symbols > MAX_SYMBOLS || candidates < 1 || candidates > 64) {
+      fprintf(stderr, "usage: %s [frames [symbols (1-%d) [candidates (1-64) [seed]]]]\n",
+            argv[0], MAX_SYMBOLS);
+      return 1;
+   }
+
+   frame = (unsigned char *)malloc(FRAME_WIDTH * FRAME_HEIGHT);
+   session = dmtxwSessionCreate();
+   if(frame == NULL || session == NULL) {
+      fprintf(stderr, "Out of memory\n");
+      return 1;
+   }
+
+   memset(&full, 0x00, sizeof(RunStats));
+   memset(&located, 0x00, sizeof(RunStats));
+
+   for(f = 0; f < frames; f++) {
+      DrawClutter(frame);
+      for(count = 0; count < symbols; count++) {
+         if(PasteSymbol(frame, truth, count, count % 2) == DmtxFail)
+            break;
+      }
+      totalSymbols += count;
+
+      t0 = Now();
+      boxCount = dmtxwSessionLocate(session, frame, FRAME_WIDTH, FRAME_HEIGHT, 0,
+            DmtxwFormatGray8, box, candidates);
+      locateMs += Now() - t0;
+      if(boxCount < 0)
+         boxCount = 0;
+
+      for(i = 0; i < boxCount; i++) {
+         for(j = 0; j < count; j++) {
+            area = Overlap(box[i].x, box[i].y, box[i].width, box[i].height,
+                  truth[j].x, truth[j].y, truth[j].width, truth[j].height);
+            if(area * 2 >= truth[j].width * truth[j].height)
+               break;
+         }
+         if(j < count)
+            totalHits++;
+      }
+      totalBoxes += boxCount;
+
+      for(j = 0; j < count; j++) {
+         for(i = 0, hits = 0; i < boxCount && hits == 0; i++) {
+            area = Overlap(box[i].x, box[i].y, box[i].width, box[i].height,
+                  truth[j].x, truth[j].y, truth[j].width, truth[j].height);
+            hits = (area * 10 >= truth[j].width * truth[j].height * 9);
+         }
+         totalFound += hits;
+      }
+
+      dmtxwSessionSetProp(session, DmtxwPropLocate, 0);
+      TimeDecode(session, frame, truth, count, &full);
+
+      dmtxwSessionSetProp(session, DmtxwPropLocate, candidates);
+      TimeDecode(session, frame, truth, count, &located);
+   }
+
+   printf("corpus:    %d frames of %dx%d, %d symbols\n", frames, FRAME_WIDTH,
+         FRAME_HEIGHT, totalSymbols);
+   printf("locate:    %8.2f ms/frame, %d candidates\n", locateMs / frames, totalBoxes);
+   printf("precision: %8.3f (%d of %d candidates cover a symbol)\n",
+         totalBoxes ? (double)totalHits / totalBoxes : 0.0, totalHits, totalBoxes);
+   printf("recall:    %8.3f (%d of %d symbols inside a candidate)\n",
+         totalSymbols ? (double)totalFound / totalSymbols : 0.0, totalFound, totalSymbols);
+   printf("full scan: %8.2f ms/frame, %d decoded\n", full.ms / frames, full.decoded);
+   printf("located:   %8.2f ms/frame, %d decoded\n", located.ms / frames, located.decoded);
+   printf("speedup:   %8.2fx\n", (located.ms > 0.0) ? full.ms / located.ms : 0.0);
+
+   dmtxwSessionDestroy(&session);
+   free(frame);
+
+   return 0;
+}
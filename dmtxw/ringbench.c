@@ -0,0 +1,323 @@
+/*
+libdmtxw - Shared native glue for the libdmtx wrappers
+
+Copyright (C) 2026 The libdmtx-wrappers project
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2.1 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+Contact: mike@dragonflylogic.com
+*/
+
+/* $Id$ */
+
+/**
+ * @file ringbench.c
+ * @brief Throughput and latency of decoding through a dmtxwRing
+ *
+ * One producer process copies pre-rendered 8bpp camera frames (a symbol
+ * encoded by libdmtx pasted at a varying spot on a noisy background) into
+ * the frame ring, as a frame grabber would. Consumer processes attach to
+ * the inherited descriptor and decode in place, and the parent collects
+ * the results, timing each frame from publication to collection.
+ *
+ * With fps 0 the producer publishes as fast as slots free up and the
+ * run measures peak frames/s. With a frame rate it drops frames when
+ * every slot is busy, like a camera, and the latency percentiles show
+ * what a live scanner would see.
+ *
+ *   $ make ringbench
+ *   $ ./ringbench [frames [consumers [slots [fps [width height]]]]]
+ */
+
+#if !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include "dmtxw.h"
+
+#define SCENES           8
+#define MAX_CONSUMERS    64
+
+/* Small LCG so the frames are the same on every platform */
+static unsigned long seed = 1;
+
+/**
+ * @brief  Next pseudo-random number
+ * @param  n Upper bound
+ * @return Number in 0 .. n-1
+ */
+static int
+Random(int n)
+{
+   seed = seed * 1103515245UL + 12345UL;
+   return (int)((seed >> 16) & 0x7fff) % n;
+}
+
+/**
+ * @brief  Microseconds between two times
+ * @param  from Earlier time
+ * @param  to Later time
+ * @return Microseconds
+ */
+static double
+Elapsed(DmtxTime from, DmtxTime to)
+{
+   return (double)(to.sec - from.sec) * 1.0e6 + ((double)to.usec - (double)from.usec);
+}
+
+/**
+ * @brief  Render a noisy frame holding one symbol
+ * @param  frame Frame pixels
+ * @param  width Frame width
+ * @param  height Frame height
+ * @param  index Scene number, printed in the symbol
+ * @return DmtxPass | DmtxFail
+ */
+static DmtxPassFail
+RenderScene(unsigned char *frame, int width, int height, int index)
+{
+   DmtxEncode *enc;
+   char message[32];
+   int i, x, y, sw, sh, ox, oy;
+
+   for(i = 0; i < width * height; i++)
+      frame[i] = (unsigned char)(160 + Random(64));
+
+   sprintf(message, "ring frame %d", index);
+
+   enc = dmtxEncodeCreate();
+   if(enc == NULL)
+      return DmtxFail;
+   dmtxEncodeSetProp(enc, DmtxPropPixelPacking, DmtxPack8bppK);
+   dmtxEncodeSetProp(enc, DmtxPropModuleSize, 4);
+   if(dmtxEncodeDataMatrix(enc, strlen(message), (unsigned char *)message) == DmtxFail) {
+      dmtxEncodeDestroy(&enc);
+      return DmtxFail;
+   }
+
+   sw = dmtxImageGetProp(enc->image, DmtxPropWidth);
+   sh = dmtxImageGetProp(enc->image, DmtxPropHeight);
+   if(sw > width || sh > height) {
+      dmtxEncodeDestroy(&enc);
+      return DmtxFail;
+   }
+
+   ox = Random(width - sw + 1);
+   oy = Random(height - sh + 1);
+   for(y = 0; y < sh; y++)
+      for(x = 0; x < sw; x++)
+         frame[(oy + y) * width + ox + x] = enc->image->pxl[y * sw + x];
+
+   dmtxEncodeDestroy(&enc);
+
+   return DmtxPass;
+}
+
+/**
+ * @brief  Consumer process: decode until the ring is closed
+ * @param  fd Ring descriptor inherited from the parent
+ * @return Exit status
+ */
+static int
+RunConsumer(int fd)
+{
+   DmtxwRing *ring;
+   DmtxwSession *session;
+
+   ring = dmtxwRingAttach(fd);
+   session = dmtxwSessionCreate();
+   if(ring == NULL || session == NULL)
+      return 1;
+
+   dmtxwSessionSetProp(session, DmtxwPropMaxCount, 1);
+   dmtxwRingRunConsumer(ring, session);
+
+   dmtxwSessionDestroy(&session);
+   dmtxwRingDestroy(&ring);
+
+   return 0;
+}
+
+/**
+ * @brief  Producer process: publish frames, paced at fps if nonzero
+ * @param  ring Ring
+ * @param  scene Pre-rendered frames
+ * @param  frames Frames to publish
+ * @param  fps Frame rate, 0 for as fast as possible
+ * @param  width Frame width
+ * @param  height Frame height
+ * @return Exit status
+ */
+static int
+RunProducer(DmtxwRing *ring, unsigned char **scene, int frames, int fps,
+      int width, int height)
+{
+   struct timespec next;
+   unsigned char *pxl;
+   long stalls = 0, skipped = 0;
+   int f;
+
+   clock_gettime(CLOCK_MONOTONIC, &next);
+
+   for(f = 0; f < frames; f++) {
+      if(fps > 0) {
+         next.tv_nsec += 1000000000L / fps;
+         if(next.tv_nsec >= 1000000000L) {
+            next.tv_sec++;
+            next.tv_nsec -= 1000000000L;
+         }
+         clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+      }
+
+      /* A camera drops the frame when every slot is busy */
+      while((pxl = dmtxwRingAcquireFrame(ring, NULL)) == NULL) {
+         if(fps > 0)
+            break;
+         stalls++;
+         sched_yield();
+      }
+      if(pxl == NULL) {
+         skipped++;
+         continue;
+      }
+
+      memcpy(pxl, scene[f % SCENES], (size_t)width * height);
+      dmtxwRingPublishFrame(ring, width, height, 0, DmtxwFormatGray8);
+   }
+
+   dmtxwRingClose(ring);
+
+   fprintf(stderr, "producer:  %d frames, %ld skipped (ring full), %ld stalls\n",
+         frames, skipped, stalls);
+
+   return 0;
+}
+
+/**
+ * @brief  Order two doubles (qsort callback)
+ * @param  a First value
+ * @param  b Second value
+ * @return Comparison result
+ */
+static int
+CompareDouble(const void *a, const void *b)
+{
+   double x = *(const double *)a, y = *(const double *)b;
+
+   return (x < y) ? -1 : (x > y);
+}
+
+/**
+ * @brief  Run the benchmark and print a summary
+ * @param  argc Argument count
+ * @param  argv Frames, consumers, slots, fps, width, height (all optional)
+ * @return 0 on success
+ */
+int
+main(int argc, char *argv[])
+{
+   int frames, consumers, slots, fps, width, height, i, count = 0, decoded = 0, status;
+   unsigned char *scene[SCENES];
+   double *latency, decodeUsec = 0.0, wall;
+   const DmtxwRingResult *result;
+   DmtxwRing *ring;
+   DmtxTime start, end;
+   pid_t pid[MAX_CONSUMERS + 1];
+   long published, dropped, reclaimed;
+
+   frames = (argc > 1) ? atoi(argv[1]) : 2000;
+   consumers = (argc > 2) ? atoi(argv[2]) : 4;
+   slots = (argc > 3) ? atoi(argv[3]) : 16;
+   fps = (argc > 4) ? atoi(argv[4]) : 0;
+   width = (argc > 6) ? atoi(argv[5]) : 640;
+   height = (argc > 6) ? atoi(argv[6]) : 480;
+
+   if(frames < 1 || consumers < 1 || consumers > MAX_CONSUMERS || fps < 0 ||
+         width < 64 || height < 64) {
+      fprintf(stderr, "usage: %s [frames [consumers (1-%d) [slots (power of 2, >= 2) "
+            "[fps (0 = max) [width height]]]]]\n", argv[0], MAX_CONSUMERS);
+      return 1;
+   }
+
+   for(i = 0; i < SCENES; i++) {
+      scene[i] = (unsigned char *)malloc((size_t)width * height);
+      if(scene[i] == NULL || RenderScene(scene[i], width, height, i) == DmtxFail) {
+         fprintf(stderr, "Unable to render frame %d\n", i);
+         return 1;
+      }
+   }
+
+   latency = (double *)malloc(frames * sizeof(double));
+   ring = dmtxwRingCreate(slots, (size_t)width * height, 4 * slots, 256);
+   if(latency == NULL || ring == NULL) {
+      fprintf(stderr, "Unable to create ring (slots must be a power of 2, at least 2)\n");
+      return 1;
+   }
+
+   for(i = 0; i < consumers; i++) {
+      pid[i] = fork();
+      if(pid[i] == 0)
+         _exit(RunConsumer(dmtxwRingGetFd(ring)));
+   }
+
+   start = dmtxTimeNow();
+   pid[consumers] = fork();
+   if(pid[consumers] == 0)
+      _exit(RunProducer(ring, scene, frames, fps, width, height));
+
+   end = start;
+   while((result = dmtxwRingReadResult(ring, DmtxUndefined)) != NULL) {
+      end = dmtxTimeNow();
+      latency[count++] = Elapsed(result->published, end);
+      decodeUsec += Elapsed(result->published, result->decoded);
+      if(result->symbolCount > 0)
+         decoded++;
+      dmtxwRingReleaseResult(ring);
+   }
+
+   for(i = 0; i <= consumers; i++)
+      waitpid(pid[i], &status, 0);
+
+   dmtxwRingGetStats(ring, &published, &dropped, &reclaimed);
+   wall = Elapsed(start, end) / 1.0e6;
+   qsort(latency, count, sizeof(double), CompareDouble);
+
+   printf("ring:      %d slots of %dx%d, %d consumers, %s\n", slots, width, height,
+         consumers, fps ? "paced" : "unpaced");
+   printf("frames:    %ld published, %d collected, %d decoded, %ld results dropped, "
+         "%ld reclaimed\n", published, count, decoded, dropped, reclaimed);
+   printf("rate:      %8.1f frames/s\n", (wall > 0.0) ? count / wall : 0.0);
+   if(count > 0) {
+      printf("decoded:   %8.2f ms after publish (mean)\n", decodeUsec / count / 1000.0);
+      printf("latency:   p50 %.2f  p90 %.2f  p99 %.2f  max %.2f ms\n",
+            latency[count / 2] / 1000.0, latency[count * 9 / 10] / 1000.0,
+            latency[count * 99 / 100] / 1000.0, latency[count - 1] / 1000.0);
+   }
+
+   dmtxwRingDestroy(&ring);
+   free(latency);
+   for(i = 0; i < SCENES; i++)
+      free(scene[i]);
+
+   return 0;
+}
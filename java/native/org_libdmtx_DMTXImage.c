@@ -26,10 +26,14 @@ Contact: mike@dragonflylogic.com
 
 #include "org_libdmtx_DMTXImage.h"
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <math.h>
-#include <malloc.h>
 #include <dmtx.h>
+#include <dmtxw.h>
+
+/* Result cache shared by every decodeTags() call, NULL while disabled */
+static DmtxwCache *gCache = NULL;
 
 /**
  * Construct from ID (static factory method since JNI doesn't allow native
@@ -43,57 +47,65 @@ Java_org_libdmtx_DMTXImage_createTag(JNIEnv *aEnv, jclass aClass, jstring aID)
    jmethodID   lConstructor;
    jobject     lResult;
    jintArray   lJavaData;
-   int         lW, lH, lBPP;
+   int         lW, lH;
    jint       *lPixels;
+   DmtxPassFail lErr;
 
    /* Convert ID into string */
    const char *sStrID = (*aEnv)->GetStringUTFChars(aEnv, aID, NULL);
 
-   /* Create Data Matrix */
+   /* Create Data Matrix at module size 1; the pixels are expanded straight
+    * into the Java array below */
    lEncoded = dmtxEncodeCreate();
 
-   dmtxEncodeSetProp(lEncoded, DmtxPropPixelPacking, DmtxPack32bppRGBX);
-   dmtxEncodeSetProp(lEncoded, DmtxPropImageFlip, DmtxFlipNone);
-
-   dmtxEncodeDataMatrix(lEncoded, strlen(sStrID), (unsigned char *)sStrID);
+   lErr = dmtxwEncodeDataMatrix(lEncoded, strlen(sStrID), (unsigned char *)sStrID);
 
    /* Finished with ID, so release it */
    (*aEnv)->ReleaseStringUTFChars(aEnv, aID, sStrID);
 
+   if(lErr == DmtxFail || dmtxwEncodeGetSize(lEncoded, &lW, &lH) == DmtxFail) {
+      dmtxEncodeDestroy(&lEncoded);
+      return NULL;
+   }
+
    /* Find DMTXImage class */
    lImageClass = (*aEnv)->FindClass(aEnv, "org/libdmtx/DMTXImage");
-   if(lImageClass == NULL)
+   if(lImageClass == NULL) {
+      dmtxEncodeDestroy(&lEncoded);
       return NULL;
+   }
 
    /* Find constructor */
    lConstructor = (*aEnv)->GetMethodID(aEnv, lImageClass, "<init>", "(II[I)V");
-   if(lConstructor == NULL)
-      return NULL;
-
-   /* Get properties from image */
-   lW = dmtxImageGetProp(lEncoded->image, DmtxPropWidth);
-   lH = dmtxImageGetProp(lEncoded->image, DmtxPropHeight);
-   lBPP = dmtxImageGetProp(lEncoded->image, DmtxPropBytesPerPixel);
-
-   if(lBPP != 4)
+   if(lConstructor == NULL) {
+      dmtxEncodeDestroy(&lEncoded);
       return NULL;
+   }
 
-   /* Copy Pixel Data */
+   /* Draw Pixel Data */
    lJavaData = (*aEnv)->NewIntArray(aEnv, lW * lH);
+   if(lJavaData == NULL) {
+      dmtxEncodeDestroy(&lEncoded);
+      return NULL;
+   }
    lPixels = (*aEnv)->GetIntArrayElements(aEnv, lJavaData, NULL);
+   if(lPixels == NULL) {
+      dmtxEncodeDestroy(&lEncoded);
+      return NULL;
+   }
 
-   memcpy(lPixels, lEncoded->image->pxl, lW * lH * 4);
+   dmtxwEncodeExpand(lEncoded, (unsigned char *)lPixels, 0, DmtxwFormatInt32RGB);
 
    (*aEnv)->ReleaseIntArrayElements(aEnv, lJavaData, lPixels, 0);
 
+   /* Destroy encoder */
+   dmtxEncodeDestroy(&lEncoded);
+
    /* Create Image instance */
    lResult = (*aEnv)->NewObject(aEnv, lImageClass, lConstructor, lW, lH, lJavaData);
    if(lResult == NULL)
       return NULL;
 
-   /* Destroy original image */
-   dmtxEncodeDestroy(&lEncoded);
-
    /* Free local references */
    (*aEnv)->DeleteLocalRef(aEnv, lJavaData);
    (*aEnv)->DeleteLocalRef(aEnv, lImageClass);
@@ -101,26 +113,39 @@ Java_org_libdmtx_DMTXImage_createTag(JNIEnv *aEnv, jclass aClass, jstring aID)
    return lResult;
 }
 
+/**
+ * Create a java.awt.Point for one result corner
+ */
+static jobject
+NewCorner(JNIEnv *aEnv, jclass aPointClass, jmethodID aPointConstructor,
+      const DmtxPixelLoc *aCorner)
+{
+   return (*aEnv)->NewObject(aEnv, aPointClass, aPointConstructor,
+         aCorner->X, aCorner->Y);
+}
+
 /**
  * Decode the image, returning tags found (as DMTXTag objects)
  */
 JNIEXPORT jobjectArray JNICALL
-Java_org_libdmtx_DMTXImage_getTags(JNIEnv *aEnv, jobject aImage,
-      jint aTagCount, jint lSearchTimeout)
+Java_org_libdmtx_DMTXImage_decodeTags(JNIEnv *aEnv, jobject aImage,
+      jint aTagCount, jint lSearchTimeout, jint aLumaScale)
 {
    jclass        lImageClass, lTagClass, lPointClass;
    jmethodID     lTagConstructor, lPointConstructor;
    jfieldID      lWidth, lHeight, lData;
-   DmtxImage    *lImage;
-   DmtxDecode   *lDecode;
-   DmtxRegion   *lRegion;
-   DmtxTime      lTimeout;
+   DmtxwSession *lSession;
+   DmtxPassFail  lDecoded;
+   const DmtxwResult *lFound;
    int           lW, lH, lI;
    jintArray     lJavaData;
    jint         *lPixels;
-   jobject      *lTags;
+   jobject       lTag;
    jobjectArray  lResult;
-   int           lTagCount = 0;
+   jboolean      lCopied = JNI_FALSE;
+   double        lTimer;
+
+   DMTXW_STATS_START(lTimer);
 
    /* Find DMTXImage class */
    lImageClass = (*aEnv)->FindClass(aEnv, "org/libdmtx/DMTXImage");
@@ -160,95 +185,429 @@ Java_org_libdmtx_DMTXImage_getTags(JNIEnv *aEnv, jobject aImage,
    lH = (*aEnv)->GetIntField(aEnv, aImage, lHeight);
 
    lJavaData = (*aEnv)->GetObjectField(aEnv, aImage, lData);
-   lPixels = (*aEnv)->GetIntArrayElements(aEnv, lJavaData, NULL);
+   if(lJavaData == NULL || (*aEnv)->GetArrayLength(aEnv, lJavaData) < lW * lH)
+      return NULL;
+
+   /* Create decoder session */
+   lSession = dmtxwSessionCreate();
+   if(lSession == NULL)
+      return NULL;
 
-   /* Create DmtxImage object */
-   lImage = dmtxImageCreate((unsigned char *)lPixels, lW, lH, DmtxPack32bppRGBX);
-   if(lImage == NULL)
+   dmtxwSessionSetCache(lSession, gCache);
+   dmtxwSessionSetProp(lSession, DmtxwPropMaxCount, aTagCount);
+   dmtxwSessionSetProp(lSession, DmtxwPropTimeout, lSearchTimeout);
+   if(dmtxwSessionSetProp(lSession, DmtxwPropLuma, aLumaScale) == DmtxFail) {
+      dmtxwSessionDestroy(&lSession);
       return NULL;
+   }
+
+   DMTXW_STATS_STOP(lTimer, DmtxwPhaseSetup);
+   DMTXW_STATS_COUNT(DmtxwCounterAllocations, 1);
+   DMTXW_STATS_START(lTimer);
 
-   /* Create DmtxDecode object */
-   lDecode = dmtxDecodeCreate(lImage, 1);
-   if(lDecode == NULL)
+   /* Pixels are 0x00RRGGBB ints in host byte order; the VM may hand over a
+    * copy, but the conversion is done natively */
+   lPixels = (*aEnv)->GetIntArrayElements(aEnv, lJavaData, &lCopied);
+   if(lPixels == NULL) {
+      dmtxwSessionDestroy(&lSession);
       return NULL;
+   }
+
+   DMTXW_STATS_STOP(lTimer, DmtxwPhaseConvert);
+   DMTXW_STATS_COUNT(DmtxwCounterAllocations, (lCopied == JNI_TRUE) ? 1 : 0);
+
+   lDecoded = dmtxwSessionDecode(lSession, (unsigned char *)lPixels, lW, lH,
+         0, DmtxwFormatInt32RGB);
 
-   /* Allocate temporary Tag array */
-   lTags = (jobject *)malloc(aTagCount * sizeof(jobject));
-   if(lTags == NULL)
+   /* Release Image Data (unmodified, so nothing to copy back) */
+   (*aEnv)->ReleaseIntArrayElements(aEnv, lJavaData, lPixels, JNI_ABORT);
+
+   if(lDecoded == DmtxFail) {
+      dmtxwSessionDestroy(&lSession);
       return NULL;
+   }
 
-   /* Find all tags that we can inside timeout */
-   lTimeout = dmtxTimeAdd(dmtxTimeNow(), lSearchTimeout);
+   DMTXW_STATS_START(lTimer);
 
-   while(lTagCount < aTagCount && (lRegion = dmtxRegionFindNext(lDecode, &lTimeout))) {
+   /* Create result array */
+   lResult = (*aEnv)->NewObjectArray(aEnv, dmtxwSessionGetResultCount(lSession),
+         lTagClass, NULL);
+
+   for(lI = 0; lResult != NULL && lI < dmtxwSessionGetResultCount(lSession); lI++) {
       jstring sStringID;
-      DmtxMessage *lMessage = dmtxDecodeMatrixRegion(lDecode, lRegion, DmtxUndefined);
+      jobject lJCorner1, lJCorner2, lJCorner3, lJCorner4;
+
+      lFound = dmtxwSessionGetResult(lSession, lI);
+
+      /* Create Location instances for corners */
+      lJCorner1 = NewCorner(aEnv, lPointClass, lPointConstructor, &lFound->corner[0]);
+      lJCorner2 = NewCorner(aEnv, lPointClass, lPointConstructor, &lFound->corner[1]);
+      lJCorner3 = NewCorner(aEnv, lPointClass, lPointConstructor, &lFound->corner[2]);
+      lJCorner4 = NewCorner(aEnv, lPointClass, lPointConstructor, &lFound->corner[3]);
+
+      /* Decoded Message (NUL terminated in the session arena) */
+      sStringID = (*aEnv)->NewStringUTF(aEnv,
+            (const char *)dmtxwSessionGetPayload(lSession, lI, NULL));
+
+      /* Create Tag instance */
+      lTag = (*aEnv)->NewObject(aEnv, lTagClass, lTagConstructor,
+            sStringID, lJCorner1, lJCorner2, lJCorner3, lJCorner4);
+      if(lTag == NULL)
+         lResult = NULL;
+      else
+         (*aEnv)->SetObjectArrayElement(aEnv, lResult, lI, lTag);
+
+      /* Free per-tag local references */
+      (*aEnv)->DeleteLocalRef(aEnv, lTag);
+      (*aEnv)->DeleteLocalRef(aEnv, sStringID);
+      (*aEnv)->DeleteLocalRef(aEnv, lJCorner1);
+      (*aEnv)->DeleteLocalRef(aEnv, lJCorner2);
+      (*aEnv)->DeleteLocalRef(aEnv, lJCorner3);
+      (*aEnv)->DeleteLocalRef(aEnv, lJCorner4);
+   }
+
+   /* The array, and per tag its string, corners and DMTXTag */
+   DMTXW_STATS_STOP(lTimer, DmtxwPhaseMarshal);
+   DMTXW_STATS_COUNT(DmtxwCounterAllocations, 1 + 6 * dmtxwSessionGetResultCount(lSession));
+
+   dmtxwSessionDestroy(&lSession);
 
-      if(lMessage != NULL) {
-         DmtxVector2 lCorner1, lCorner2, lCorner3, lCorner4;
-         jobject lJCorner1, lJCorner2, lJCorner3, lJCorner4;
+   /* Free local references */
+   (*aEnv)->DeleteLocalRef(aEnv, lJavaData);
+   (*aEnv)->DeleteLocalRef(aEnv, lImageClass);
+   (*aEnv)->DeleteLocalRef(aEnv, lTagClass);
+   (*aEnv)->DeleteLocalRef(aEnv, lPointClass);
 
-         /* Calculate position of Tag */
-         lCorner1.X = lCorner1.Y = lCorner2.Y = lCorner4.X = 0.0;
-         lCorner2.X = lCorner4.Y = lCorner3.X = lCorner3.Y = 1.0;
+   return lResult;
+}
 
-         dmtxMatrix3VMultiplyBy(&lCorner1, lRegion->fit2raw);
-         dmtxMatrix3VMultiplyBy(&lCorner2, lRegion->fit2raw);
-         dmtxMatrix3VMultiplyBy(&lCorner3, lRegion->fit2raw);
-         dmtxMatrix3VMultiplyBy(&lCorner4, lRegion->fit2raw);
+/**
+ * Encode ID as an SVG, PDF or EPS document
+ */
+JNIEXPORT jbyteArray JNICALL
+Java_org_libdmtx_DMTXImage_createVector(JNIEnv *aEnv, jclass aClass,
+      jstring aID, jint aFormat, jdouble aModuleSize, jint aMargin)
+{
+   DmtxEncode *lEncoded;
+   DmtxwBuffer lBuffer;
+   jbyteArray  lResult = NULL;
+   const char *sStrID;
 
-         /* Create Location instances for corners */
-         lJCorner1 = (*aEnv)->NewObject(aEnv, lPointClass, lPointConstructor,
-               (int) lCorner1.X, (int) (lH - lCorner1.Y - 1));
+   sStrID = (*aEnv)->GetStringUTFChars(aEnv, aID, NULL);
+   if(sStrID == NULL)
+      return NULL;
 
-         lJCorner2 = (*aEnv)->NewObject(aEnv, lPointClass, lPointConstructor,
-               (int) lCorner2.X, (int) (lH - lCorner2.Y - 1));
+   lEncoded = dmtxEncodeCreate();
+   if(lEncoded == NULL) {
+      (*aEnv)->ReleaseStringUTFChars(aEnv, aID, sStrID);
+      return NULL;
+   }
 
-         lJCorner3 = (*aEnv)->NewObject(aEnv, lPointClass, lPointConstructor,
-               (int) lCorner3.X, (int) (lH - lCorner3.Y - 1));
+   memset(&lBuffer, 0x00, sizeof(DmtxwBuffer));
+   if(dmtxwEncodeDataMatrix(lEncoded, strlen(sStrID), (unsigned char *)sStrID) == DmtxPass &&
+         dmtxwEncodeVector(lEncoded, aFormat, aModuleSize, aMargin, &lBuffer) == DmtxPass) {
+      lResult = (*aEnv)->NewByteArray(aEnv, (jsize)lBuffer.length);
+      if(lResult != NULL)
+         (*aEnv)->SetByteArrayRegion(aEnv, lResult, 0, (jsize)lBuffer.length,
+               (jbyte *)lBuffer.data);
+   }
 
-         lJCorner4 = (*aEnv)->NewObject(aEnv, lPointClass, lPointConstructor,
-               (int) lCorner4.X, (int) (lH - lCorner4.Y - 1));
+   dmtxwBufferFree(&lBuffer);
+   dmtxEncodeDestroy(&lEncoded);
+   (*aEnv)->ReleaseStringUTFChars(aEnv, aID, sStrID);
 
-         /* Decode Message */
-         sStringID = (*aEnv)->NewStringUTF(aEnv, lMessage->output);
+   return lResult;
+}
 
-         /* Create Tag instance */
-         lTags[lTagCount] = (*aEnv)->NewObject(aEnv, lTagClass, lTagConstructor,
-               sStringID, lJCorner1, lJCorner2, lJCorner3, lJCorner4);
-         if(lTags[lTagCount] == NULL)
-            return NULL;
+/**
+ * Collect sheet labels from parallel ID and position arrays; the UTF
+ * strings stay pinned until ReleaseSheetLabels()
+ */
+static DmtxwSheetLabel *
+GetSheetLabels(JNIEnv *aEnv, jobjectArray aIDs, jintArray aPositions, int *aCount)
+{
+   DmtxwSheetLabel *lLabels;
+   jint *lPositions;
+   jstring lID;
+   int lCount, i;
 
-         /* Increment Count */
-         lTagCount++;
+   lCount = (*aEnv)->GetArrayLength(aEnv, aIDs);
+   if((*aEnv)->GetArrayLength(aEnv, aPositions) < 2 * lCount)
+      return NULL;
+
+   lLabels = (DmtxwSheetLabel *)calloc(lCount + 1, sizeof(DmtxwSheetLabel));
+   if(lLabels == NULL)
+      return NULL;
 
-         /* Free Message */
-         dmtxMessageDestroy(&lMessage);
+   lPositions = (*aEnv)->GetIntArrayElements(aEnv, aPositions, NULL);
+   for(i = 0; i < lCount; i++) {
+      lID = (jstring)(*aEnv)->GetObjectArrayElement(aEnv, aIDs, i);
+      if(lID != NULL) {
+         lLabels[i].data = (const unsigned char *)(*aEnv)->GetStringUTFChars(aEnv, lID, NULL);
+         lLabels[i].dataSize = (lLabels[i].data != NULL) ? strlen((const char *)lLabels[i].data) : 0;
+         (*aEnv)->DeleteLocalRef(aEnv, lID);
       }
+      lLabels[i].x = lPositions[2 * i];
+      lLabels[i].y = lPositions[2 * i + 1];
+   }
+   (*aEnv)->ReleaseIntArrayElements(aEnv, aPositions, lPositions, JNI_ABORT);
+
+   *aCount = lCount;
 
-      /* Free Region */
-      dmtxRegionDestroy(&lRegion);
+   return lLabels;
+}
+
+/**
+ * Unpin the ID strings and free labels from GetSheetLabels()
+ */
+static void
+ReleaseSheetLabels(JNIEnv *aEnv, jobjectArray aIDs, DmtxwSheetLabel *aLabels, int aCount)
+{
+   jstring lID;
+   int i;
+
+   for(i = 0; i < aCount; i++) {
+      if(aLabels[i].data == NULL)
+         continue;
+      lID = (jstring)(*aEnv)->GetObjectArrayElement(aEnv, aIDs, i);
+      (*aEnv)->ReleaseStringUTFChars(aEnv, lID, (const char *)aLabels[i].data);
+      (*aEnv)->DeleteLocalRef(aEnv, lID);
    }
 
-   /* Free DMTX Structures */
-   dmtxDecodeDestroy(&lDecode);
-   dmtxImageDestroy(&lImage);
+   free(aLabels);
+}
 
-   /* Release Image Data */
-   (*aEnv)->ReleaseIntArrayElements(aEnv, lJavaData, lPixels, 0);
+/**
+ * Encode many IDs onto one page image
+ */
+JNIEXPORT jobject JNICALL
+Java_org_libdmtx_DMTXImage_createSheet(JNIEnv *aEnv, jclass aClass,
+      jobjectArray aIDs, jintArray aPositions, jint aWidth, jint aHeight,
+      jint aModuleSize, jint aMargin, jint aThreads)
+{
+   DmtxwSheetSpec lSpec;
+   DmtxwSheetLabel *lLabels;
+   unsigned char *lPage;
+   jclass lImageClass;
+   jmethodID lConstructor;
+   jintArray lJavaData;
+   jint *lPixels;
+   jobject lResult = NULL;
+   int lCount, lDrawn, i;
+
+   if(aWidth < 1 || aHeight < 1)
+      return NULL;
 
-   /* Create result array */
-   lResult = (*aEnv)->NewObjectArray(aEnv, lTagCount, lTagClass, NULL);
+   lLabels = GetSheetLabels(aEnv, aIDs, aPositions, &lCount);
+   if(lLabels == NULL)
+      return NULL;
+
+   dmtxwSheetSpecInit(&lSpec);
+   lSpec.width = aWidth;
+   lSpec.height = aHeight;
+   lSpec.moduleSize = aModuleSize;
+   lSpec.margin = aMargin;
+   lSpec.threads = aThreads;
+
+   lPage = (unsigned char *)malloc((size_t)aWidth * aHeight);
+   lDrawn = (lPage == NULL) ? -1 : dmtxwSheetRender(&lSpec, lLabels, lCount, lPage,
+         aWidth, DmtxwSheetGray8);
+   ReleaseSheetLabels(aEnv, aIDs, lLabels, lCount);
 
-   for(lI = 0; lI < lTagCount; lI++) {
-      (*aEnv)->SetObjectArrayElement(aEnv, lResult, lI, lTags[lI]);
+   if(lDrawn < 0) {
+      free(lPage);
+      return NULL;
    }
 
-   /* Free local references */
-   (*aEnv)->DeleteLocalRef(aEnv, lJavaData);
-   (*aEnv)->DeleteLocalRef(aEnv, lImageClass);
-   (*aEnv)->DeleteLocalRef(aEnv, lTagClass);
-   (*aEnv)->DeleteLocalRef(aEnv, lPointClass);
+   lImageClass = (*aEnv)->FindClass(aEnv, "org/libdmtx/DMTXImage");
+   lConstructor = (lImageClass == NULL) ? NULL :
+         (*aEnv)->GetMethodID(aEnv, lImageClass, "<init>", "(II[I)V");
+   lJavaData = (lConstructor == NULL) ? NULL :
+         (*aEnv)->NewIntArray(aEnv, aWidth * aHeight);
+
+   if(lJavaData != NULL) {
+      lPixels = (*aEnv)->GetIntArrayElements(aEnv, lJavaData, NULL);
+      for(i = 0; i < aWidth * aHeight; i++)
+         lPixels[i] = lPage[i] * 0x010101;
+      (*aEnv)->ReleaseIntArrayElements(aEnv, lJavaData, lPixels, 0);
+
+      lResult = (*aEnv)->NewObject(aEnv, lImageClass, lConstructor, aWidth, aHeight, lJavaData);
+      (*aEnv)->DeleteLocalRef(aEnv, lJavaData);
+   }
+
+   if(lImageClass != NULL)
+      (*aEnv)->DeleteLocalRef(aEnv, lImageClass);
+   free(lPage);
+
+   return lResult;
+}
+
+/**
+ * Encode many IDs onto one SVG, PDF or EPS page
+ */
+JNIEXPORT jbyteArray JNICALL
+Java_org_libdmtx_DMTXImage_createSheetVector(JNIEnv *aEnv, jclass aClass,
+      jobjectArray aIDs, jintArray aPositions, jint aWidth, jint aHeight,
+      jint aFormat, jdouble aModuleSize, jint aMargin, jint aThreads)
+{
+   DmtxwSheetSpec lSpec;
+   DmtxwSheetLabel *lLabels;
+   DmtxwBuffer lBuffer;
+   jbyteArray lResult = NULL;
+   int lCount;
+
+   lLabels = GetSheetLabels(aEnv, aIDs, aPositions, &lCount);
+   if(lLabels == NULL)
+      return NULL;
+
+   dmtxwSheetSpecInit(&lSpec);
+   lSpec.width = aWidth;
+   lSpec.height = aHeight;
+   lSpec.moduleSize = aModuleSize;
+   lSpec.margin = aMargin;
+   lSpec.threads = aThreads;
+
+   memset(&lBuffer, 0x00, sizeof(DmtxwBuffer));
+   if(dmtxwSheetVector(&lSpec, lLabels, lCount, aFormat, &lBuffer) >= 0) {
+      lResult = (*aEnv)->NewByteArray(aEnv, (jsize)lBuffer.length);
+      if(lResult != NULL)
+         (*aEnv)->SetByteArrayRegion(aEnv, lResult, 0, (jsize)lBuffer.length,
+               (jbyte *)lBuffer.data);
+   }
+
+   ReleaseSheetLabels(aEnv, aIDs, lLabels, lCount);
+   dmtxwBufferFree(&lBuffer);
+
+   return lResult;
+}
+
+/**
+ * Answer images matching one of the last aEntries decoded ones from memory
+ */
+JNIEXPORT jboolean JNICALL
+Java_org_libdmtx_DMTXImage_enableCache(JNIEnv *aEnv, jclass aClass,
+      jint aEntries, jint aTtl)
+{
+   DmtxwCache *lCache = NULL;
+
+   if(aEntries > 0) {
+      lCache = dmtxwCacheCreate(aEntries, aTtl, DmtxUndefined);
+      if(lCache == NULL)
+         return JNI_FALSE;
+   }
+
+   if(gCache != NULL)
+      dmtxwCacheDestroy(&gCache);
+   gCache = lCache;
+
+   return JNI_TRUE;
+}
+
+/**
+ * Hits and misses of the result cache, in that order
+ */
+JNIEXPORT jlongArray JNICALL
+Java_org_libdmtx_DMTXImage_getCacheStats(JNIEnv *aEnv, jclass aClass)
+{
+   jlongArray lResult;
+   jlong      lStats[2];
+   long       lHits = 0, lMisses = 0;
+
+   dmtxwCacheGetStats(gCache, &lHits, &lMisses);
+   lStats[0] = lHits;
+   lStats[1] = lMisses;
+
+   lResult = (*aEnv)->NewLongArray(aEnv, 2);
+   if(lResult != NULL)
+      (*aEnv)->SetLongArrayRegion(aEnv, lResult, 0, 2, lStats);
 
    return lResult;
 }
+
+/**
+ * Whether libdmtxw was built with the instrumentation counters
+ */
+JNIEXPORT jboolean JNICALL
+Java_org_libdmtx_DMTXImage_statsEnabled(JNIEnv *aEnv, jclass aClass)
+{
+   return (dmtxwStatsEnabled() == DmtxTrue) ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * Names of the values returned by getStatValues()
+ */
+JNIEXPORT jobjectArray JNICALL
+Java_org_libdmtx_DMTXImage_getStatNames(JNIEnv *aEnv, jclass aClass)
+{
+   jclass       lStringClass;
+   jobjectArray lResult;
+   jstring      lName;
+   int          lCount, lI;
+
+   for(lCount = 0; dmtxwStatsName(lCount) != NULL; lCount++)
+      ;
+
+   lStringClass = (*aEnv)->FindClass(aEnv, "java/lang/String");
+   if(lStringClass == NULL)
+      return NULL;
+
+   lResult = (*aEnv)->NewObjectArray(aEnv, lCount, lStringClass, NULL);
+   for(lI = 0; lResult != NULL && lI < lCount; lI++) {
+      lName = (*aEnv)->NewStringUTF(aEnv, dmtxwStatsName(lI));
+      if(lName == NULL)
+         return NULL;
+      (*aEnv)->SetObjectArrayElement(aEnv, lResult, lI, lName);
+      (*aEnv)->DeleteLocalRef(aEnv, lName);
+   }
+
+   (*aEnv)->DeleteLocalRef(aEnv, lStringClass);
+
+   return lResult;
+}
+
+/**
+ * Instrumentation totals of the calling thread, NULL if not built in
+ */
+JNIEXPORT jdoubleArray JNICALL
+Java_org_libdmtx_DMTXImage_getStatValues(JNIEnv *aEnv, jclass aClass)
+{
+   DmtxwStats   lStats;
+   jdoubleArray lResult;
+   jdouble      lValue;
+   int          lI;
+
+   if(dmtxwStatsGet(&lStats) == DmtxFail)
+      return NULL;
+
+   for(lI = 0; dmtxwStatsName(lI) != NULL; lI++)
+      ;
+
+   lResult = (*aEnv)->NewDoubleArray(aEnv, lI);
+   for(lI = 0; lResult != NULL && dmtxwStatsName(lI) != NULL; lI++) {
+      lValue = dmtxwStatsValue(&lStats, lI);
+      (*aEnv)->SetDoubleArrayRegion(aEnv, lResult, lI, 1, &lValue);
+   }
+
+   return lResult;
+}
+
+/**
+ * Clear the instrumentation totals of the calling thread
+ */
+JNIEXPORT void JNICALL
+Java_org_libdmtx_DMTXImage_resetStats(JNIEnv *aEnv, jclass aClass)
+{
+   dmtxwStatsReset();
+}
+
+/**
+ * Count a conversion done in Java (only called when statsEnabled())
+ */
+JNIEXPORT void JNICALL
+Java_org_libdmtx_DMTXImage_addConvertStats(JNIEnv *aEnv, jclass aClass,
+      jdouble aMsec, jlong aBytes)
+{
+   dmtxwStatsAddPhase(DmtxwPhaseConvert, aMsec);
+   dmtxwStatsCount(DmtxwCounterBytesConverted, (double)aBytes);
+   dmtxwStatsCount(DmtxwCounterAllocations, 1.0);
+}
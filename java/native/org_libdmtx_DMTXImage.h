@@ -17,11 +17,91 @@ JNIEXPORT jobject JNICALL Java_org_libdmtx_DMTXImage_createTag
 
 /*
  * Class:     org_libdmtx_DMTXImage
- * Method:    getTags
- * Signature: (II)[Lorg/libdmtx/DMTXTag;
+ * Method:    createVector
+ * Signature: (Ljava/lang/String;IDI)[B
  */
-JNIEXPORT jobjectArray JNICALL Java_org_libdmtx_DMTXImage_getTags
-  (JNIEnv *, jobject, jint, jint);
+JNIEXPORT jbyteArray JNICALL Java_org_libdmtx_DMTXImage_createVector
+  (JNIEnv *, jclass, jstring, jint, jdouble, jint);
+
+/*
+ * Class:     org_libdmtx_DMTXImage
+ * Method:    createSheet
+ * Signature: ([Ljava/lang/String;[IIIIII)Lorg/libdmtx/DMTXImage;
+ */
+JNIEXPORT jobject JNICALL Java_org_libdmtx_DMTXImage_createSheet
+  (JNIEnv *, jclass, jobjectArray, jintArray, jint, jint, jint, jint, jint);
+
+/*
+ * Class:     org_libdmtx_DMTXImage
+ * Method:    createSheetVector
+ * Signature: ([Ljava/lang/String;[IIIIDII)[B
+ */
+JNIEXPORT jbyteArray JNICALL Java_org_libdmtx_DMTXImage_createSheetVector
+  (JNIEnv *, jclass, jobjectArray, jintArray, jint, jint, jint, jdouble, jint, jint);
+
+/*
+ * Class:     org_libdmtx_DMTXImage
+ * Method:    decodeTags
+ * Signature: (III)[Lorg/libdmtx/DMTXTag;
+ */
+JNIEXPORT jobjectArray JNICALL Java_org_libdmtx_DMTXImage_decodeTags
+  (JNIEnv *, jobject, jint, jint, jint);
+
+/*
+ * Class:     org_libdmtx_DMTXImage
+ * Method:    enableCache
+ * Signature: (II)Z
+ */
+JNIEXPORT jboolean JNICALL Java_org_libdmtx_DMTXImage_enableCache
+  (JNIEnv *, jclass, jint, jint);
+
+/*
+ * Class:     org_libdmtx_DMTXImage
+ * Method:    getCacheStats
+ * Signature: ()[J
+ */
+JNIEXPORT jlongArray JNICALL Java_org_libdmtx_DMTXImage_getCacheStats
+  (JNIEnv *, jclass);
+
+/*
+ * Class:     org_libdmtx_DMTXImage
+ * Method:    statsEnabled
+ * Signature: ()Z
+ */
+JNIEXPORT jboolean JNICALL Java_org_libdmtx_DMTXImage_statsEnabled
+  (JNIEnv *, jclass);
+
+/*
+ * Class:     org_libdmtx_DMTXImage
+ * Method:    getStatNames
+ * Signature: ()[Ljava/lang/String;
+ */
+JNIEXPORT jobjectArray JNICALL Java_org_libdmtx_DMTXImage_getStatNames
+  (JNIEnv *, jclass);
+
+/*
+ * Class:     org_libdmtx_DMTXImage
+ * Method:    getStatValues
+ * Signature: ()[D
+ */
+JNIEXPORT jdoubleArray JNICALL Java_org_libdmtx_DMTXImage_getStatValues
+  (JNIEnv *, jclass);
+
+/*
+ * Class:     org_libdmtx_DMTXImage
+ * Method:    resetStats
+ * Signature: ()V
+ */
+JNIEXPORT void JNICALL Java_org_libdmtx_DMTXImage_resetStats
+  (JNIEnv *, jclass);
+
+/*
+ * Class:     org_libdmtx_DMTXImage
+ * Method:    addConvertStats
+ * Signature: (DJ)V
+ */
+JNIEXPORT void JNICALL Java_org_libdmtx_DMTXImage_addConvertStats
+  (JNIEnv *, jclass, jdouble, jlong);
 
 #ifdef __cplusplus
 }
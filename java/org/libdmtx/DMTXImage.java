@@ -26,6 +26,8 @@ Contact: mike@dragonflylogic.com
 package org.libdmtx;
 
 import java.awt.image.BufferedImage;
+import java.util.LinkedHashMap;
+import java.util.Map;
 
 public class DMTXImage {
   /**
@@ -59,9 +61,14 @@ public class DMTXImage {
    * Construct from BufferedImage
    */
   public DMTXImage(BufferedImage aImage) {
+    long lStart = STATS ? System.nanoTime() : 0;
+
     width  = aImage.getWidth();
     height = aImage.getHeight();
     data   = aImage.getRGB(0, 0, width, height, null, 0, width);
+
+    if(STATS)
+      addConvertStats((System.nanoTime() - lStart) / 1e6, 4L * width * height);
   }
 
   /**
@@ -70,10 +77,101 @@ public class DMTXImage {
    */
   public static native DMTXImage createTag(String aID);
 
+  /**
+   * Document formats understood by createVector()
+   */
+  public static final int VECTOR_SVG = 0;
+  public static final int VECTOR_PDF = 1;
+  public static final int VECTOR_EPS = 2;
+
+  /**
+   * Encode ID as an SVG, PDF or EPS document drawn with rectangles, for
+   * printing at any resolution. aModuleSize is in output units (points for
+   * PDF and EPS), aMargin in modules. Returns null on failure.
+   */
+  public static native byte[] createVector(String aID, int aFormat,
+      double aModuleSize, int aMargin);
+
+  /**
+   * Encode many IDs onto one aWidth x aHeight page on aThreads threads.
+   * aPositions holds an x, y pair per ID: the top-left corner of its quiet
+   * zone in pixels. IDs that do not fit on the page are left out. Returns
+   * null on invalid arguments.
+   */
+  public static native DMTXImage createSheet(String[] aIDs, int[] aPositions,
+      int aWidth, int aHeight, int aModuleSize, int aMargin, int aThreads);
+
+  /**
+   * As createSheet(), as an SVG, PDF or EPS page (VECTOR_*); positions and
+   * page size are in output units (points for PDF and EPS)
+   */
+  public static native byte[] createSheetVector(String[] aIDs, int[] aPositions,
+      int aWidth, int aHeight, int aFormat, double aModuleSize, int aMargin,
+      int aThreads);
+
   /**
    * Decode the image, returning tags found (as DMTXTag objects)
    */
-  public native DMTXTag[] getTags(int aMaxTagCount, int searchTimeout);
+  public DMTXTag[] getTags(int aMaxTagCount, int searchTimeout) {
+    return decodeTags(aMaxTagCount, searchTimeout, 0);
+  }
+
+  /**
+   * Decode the image after converting it to luminance natively, downscaled
+   * by aLumaScale (1, 2 or 4). Much faster on large images.
+   */
+  public DMTXTag[] getTags(int aMaxTagCount, int searchTimeout, int aLumaScale) {
+    return decodeTags(aMaxTagCount, searchTimeout, aLumaScale);
+  }
+
+  private native DMTXTag[] decodeTags(int aMaxTagCount, int searchTimeout, int aLumaScale);
+
+  /**
+   * Answer images matching one of the last aEntries decoded ones from memory
+   * for aTtl milliseconds (at least 1). Shared by all DMTXImage objects;
+   * 0 entries switches it off. Must not be called while decoding.
+   */
+  public static native boolean enableCache(int aEntries, int aTtl);
+
+  /**
+   * Hits and misses of the result cache, in that order
+   */
+  public static native long[] getCacheStats();
+
+  /**
+   * Decode phase times and counters of the calling thread since the last
+   * resetStats(), by name: convert_calls, convert_ms, ..., allocations.
+   * The BufferedImage constructor counts as conversion. Returns null
+   * unless the native library was built with DMTXW_STATS.
+   */
+  public static Map<String, Double> getStats() {
+    String[] lNames;
+    double[] lValues;
+    Map<String, Double> lStats;
+
+    lValues = getStatValues();
+    if(lValues == null)
+      return null;
+
+    lNames = getStatNames();
+    lStats = new LinkedHashMap<String, Double>();
+    for(int i = 0; i < lValues.length; i++)
+      lStats.put(lNames[i], lValues[i]);
+
+    return lStats;
+  }
+
+  /**
+   * Clear the counters of the calling thread
+   */
+  public static native void resetStats();
+
+  private static final boolean STATS = statsEnabled();
+
+  private static native boolean statsEnabled();
+  private static native String[] getStatNames();
+  private static native double[] getStatValues();
+  private static native void addConvertStats(double aMsec, long aBytes);
 
   /**
    * Generate a BufferedImage from the image and return it
@@ -24,6 +24,7 @@ Contact: libdmtx@fernsroth.com
 
 using System;
 using System.Collections.Generic;
+using System.Diagnostics;
 using System.IO;
 using System.Runtime.InteropServices;
 using System.Drawing;
@@ -38,6 +39,13 @@ namespace Libdmtx {
         const byte RETURN_NO_MEMORY = 1;
         const byte RETURN_INVALID_ARGUMENT = 2;
         const byte RETURN_ENCODE_ERROR = 3;
+        const byte RETURN_BLURRED = 4;
+        const byte RETURN_EMPTY = 5;
+        const byte RETURN_TIMEOUT = 6;
+        const byte RETURN_MAX_COUNT = 7;
+        const UInt16 FORMAT_BGR24 = 2; // enum DmtxwFormat in "dmtxw.h"
+        const UInt16 FORMAT_BGRX32 = 4;
+        const UInt16 FORMAT_MONO1 = 8;
         public const int DmtxUndefined = -1; // defined in "dmtx.h"
 
         /// <summary>
@@ -49,6 +57,70 @@ namespace Libdmtx {
             }
         }
 
+        /// <summary>
+        /// Answers bitmaps matching one of the last decoded ones from memory
+        /// instead of searching them again, for fixed-mount scanners that see
+        /// the same label over and over. Entries expire after
+        /// <paramref name="ttlMS"/> milliseconds (at least 1); 0 entries
+        /// switches the cache off. Must not be called while decoding.
+        /// </summary>
+        public static void EnableCache(int entries, int ttlMS) {
+            if (DmtxCacheEnable(entries, ttlMS) == RETURN_INVALID_ARGUMENT) {
+                throw new DmtxInvalidArgumentException("Invalid cache size or time to live.");
+            }
+        }
+
+        /// <summary>
+        /// Gets the number of decodes answered from the cache.
+        /// </summary>
+        public static int CacheHits {
+            get {
+                int hits, misses;
+                DmtxCacheStats(out hits, out misses);
+                return hits;
+            }
+        }
+
+        /// <summary>
+        /// Gets the number of decodes the cache could not answer.
+        /// </summary>
+        public static int CacheMisses {
+            get {
+                int hits, misses;
+                DmtxCacheStats(out hits, out misses);
+                return misses;
+            }
+        }
+
+        /// <summary>
+        /// Gets the decode phase times and counters of the calling thread
+        /// since the last <see cref="ResetStats"/>, by name (convert_calls,
+        /// convert_ms, ..., allocations). Bitmap conversion and result
+        /// marshalling include the managed side. Null unless libdmtx.dll
+        /// was built with DMTXW_STATS.
+        /// </summary>
+        public static Dictionary<string, double> Stats() {
+            double[] values = new double[32];
+            int count = DmtxStatsGet(values, values.Length);
+            if (count < 0) {
+                return null;
+            }
+            Dictionary<string, double> stats = new Dictionary<string, double>();
+            for (int i = 0; i < count; i++) {
+                stats[Marshal.PtrToStringAnsi(DmtxStatsName(i))] = values[i];
+            }
+            return stats;
+        }
+
+        /// <summary>
+        /// Clears the counters of the calling thread.
+        /// </summary>
+        public static void ResetStats() {
+            DmtxStatsReset();
+        }
+
+        private static readonly bool StatsEnabled = DmtxStatsEnabled() != 0;
+
         /// <summary>
         /// Decodes a bitmap returning all symbols found in the image.
         /// </summary>
@@ -93,11 +165,17 @@ namespace Libdmtx {
 
         public delegate void DecodeDiagnosticImageCallback(Bitmap diagnosticImage);
 
-        public static void Decode(Bitmap b, DecodeOptions options, DecodeCallback Callback) {
-            Decode(b, options, Callback, 0, null);
+        public static DecodeStatus Decode(Bitmap b, DecodeOptions options, DecodeCallback Callback) {
+            return Decode(b, options, Callback, 0, null);
         }
 
-        public static void Decode(
+        /// <summary>
+        /// Decodes the bitmap, handing every symbol to the callback as it is
+        /// found. The return value tells whether the whole bitmap was
+        /// searched or the search stopped early, in which case the symbols
+        /// already handed over are all there is.
+        /// </summary>
+        public static DecodeStatus Decode(
             Bitmap b,
             DecodeOptions options,
             DecodeCallback Callback,
@@ -106,7 +184,11 @@ namespace Libdmtx {
             byte status;
             try {
                 int bitmapStride;
+                Stopwatch convertTime = StatsEnabled ? Stopwatch.StartNew() : null;
                 byte[] pxl = BitmapToByteArray(b, out bitmapStride);
+                if (StatsEnabled) {
+                    DmtxStatsAddConvert(convertTime.Elapsed.TotalMilliseconds, pxl.Length);
+                }
 
                 DmtxDiagnosticImageCallback diagnosticImageCallbackParam = null;
                 if (DiagnosticImageCallback != null) {
@@ -137,10 +219,10 @@ namespace Libdmtx {
                             result = new DmtxDecoded();
                             result.Corners = dmtxDecodeResult.Corners;
                             result.SymbolInfo = dmtxDecodeResult.SymbolInfo;
+                            result.Sharpness = dmtxDecodeResult.Sharpness;
+                            result.EdgeDensity = dmtxDecodeResult.EdgeDensity;
                             result.Data = new byte[dmtxDecodeResult.DataSize];
-                            for (int dataIdx = 0; dataIdx < dmtxDecodeResult.DataSize; dataIdx++) {
-                                result.Data[dataIdx] = Marshal.ReadByte(dmtxDecodeResult.Data, dataIdx);
-                            }
+                            Marshal.Copy(dmtxDecodeResult.Data, result.Data, 0, result.Data.Length);
                             Callback(result);
                             return true;
                         } catch (Exception ex) {
@@ -158,9 +240,18 @@ namespace Libdmtx {
                 throw new DmtxOutOfMemoryException("Not enough memory.");
             } else if (status == RETURN_INVALID_ARGUMENT) {
                 throw new DmtxInvalidArgumentException("Invalid options configuration.");
+            } else if (status == RETURN_BLURRED) {
+                throw new DmtxImageQualityException("Image is too blurred to search.");
+            } else if (status == RETURN_EMPTY) {
+                throw new DmtxImageQualityException("Image shows too few edges to hold a symbol.");
+            } else if (status == RETURN_TIMEOUT) {
+                return DecodeStatus.Timeout;
+            } else if (status == RETURN_MAX_COUNT) {
+                return DecodeStatus.MaxCount;
             } else if (status > 0) {
                 throw new DmtxException("Unknown error.");
             }
+            return DecodeStatus.Complete;
         }
 
         private static byte[] BitmapToByteArray(Bitmap b, out int stride) {
@@ -192,8 +283,35 @@ namespace Libdmtx {
         /// </code>
         /// </example>
         public static DmtxEncoded Encode(byte[] data, EncodeOptions options) {
+            return Encode(data, options, PixelFormat.Format24bppRgb);
+        }
+
+        /// <summary>
+        /// Encodes data into a DataMatrix barcode, drawn natively into a
+        /// Bitmap of the given pixel format.
+        /// </summary>
+        /// <param name="data">The data to encode.</param>
+        /// <param name="options">The options used for encoding.</param>
+        /// <param name="format">Format24bppRgb, Format32bppRgb,
+        /// Format32bppArgb or Format1bppIndexed (black and white palette);
+        /// mosaics are only drawn as Format24bppRgb.</param>
+        /// <returns>The results from encoding.</returns>
+        public static DmtxEncoded Encode(byte[] data, EncodeOptions options, PixelFormat format) {
             IntPtr result;
             byte status;
+            UInt16 nativeFormat;
+            if (format == PixelFormat.Format24bppRgb) {
+                nativeFormat = FORMAT_BGR24;
+            } else if (format == PixelFormat.Format32bppRgb || format == PixelFormat.Format32bppArgb) {
+                nativeFormat = FORMAT_BGRX32;
+            } else if (format == PixelFormat.Format1bppIndexed) {
+                nativeFormat = FORMAT_MONO1;
+            } else {
+                throw new DmtxInvalidArgumentException("Unsupported pixel format.");
+            }
+            if (options.CodeType == CodeType.Mosaic && format != PixelFormat.Format24bppRgb) {
+                throw new DmtxInvalidArgumentException("Mosaics are only drawn as Format24bppRgb.");
+            }
             try {
                 status = DmtxEncode(data, (UInt16)data.Length, out result, options);
             } catch (Exception ex) {
@@ -215,11 +333,23 @@ namespace Libdmtx {
                 intResult = (EncodedInternal)Marshal.PtrToStructure(result, typeof(EncodedInternal));
                 ret = new DmtxEncoded();
                 ret.SymbolInfo = intResult.SymbolInfo;
-                ret.Bitmap = new Bitmap((int)intResult.Width, (int)intResult.Height, PixelFormat.Format24bppRgb);
+                ret.Bitmap = new Bitmap((int)intResult.Width, (int)intResult.Height, format);
+                if (format == PixelFormat.Format1bppIndexed) {
+                    // Set bits are dark, as libdmtxw writes them
+                    ColorPalette palette = ret.Bitmap.Palette;
+                    palette.Entries[0] = Color.White;
+                    palette.Entries[1] = Color.Black;
+                    ret.Bitmap.Palette = palette;
+                }
                 Rectangle rect = new Rectangle(0, 0, ret.Bitmap.Width, ret.Bitmap.Height);
-                BitmapData bd = ret.Bitmap.LockBits(rect, ImageLockMode.WriteOnly, PixelFormat.Format24bppRgb);
+                BitmapData bd = ret.Bitmap.LockBits(rect, ImageLockMode.WriteOnly, format);
                 try {
-                    DmtxCopyEncodeResult(intResult.Data, (UInt32)Math.Abs(bd.Stride), bd.Scan0);
+                    if (options.CodeType == CodeType.Mosaic) {
+                        DmtxCopyEncodeResult(intResult.Data, (UInt32)Math.Abs(bd.Stride), bd.Scan0);
+                    } else if (DmtxExpandEncodeResult(intResult.Data, nativeFormat,
+                            (UInt32)Math.Abs(bd.Stride), bd.Scan0) > 0) {
+                        throw new DmtxException("Error drawing encode result.");
+                    }
                 } finally {
                     ret.Bitmap.UnlockBits(bd);
                 }
@@ -237,6 +367,242 @@ namespace Libdmtx {
             return ret;
         }
 
+        /// <summary>
+        /// Predicts the symbol <see cref="Encode"/> would create for the data,
+        /// without encoding it. DataWords is the predicted codeword count;
+        /// at a size boundary the prediction may be one size too large, but
+        /// never too small.
+        /// </summary>
+        /// <param name="data">The data to encode.</param>
+        /// <param name="options">The options used for encoding.</param>
+        /// <returns>The predicted symbol, or null if no symbol size (or not
+        /// the requested one) holds the data. SymbolShapeAuto gives null as
+        /// well, since Encode only picks a size for SymbolSquareAuto and
+        /// SymbolRectAuto.</returns>
+        public static SymbolInfo EstimateSize(byte[] data, EncodeOptions options) {
+            SymbolInfo info = new SymbolInfo();
+            byte status;
+            try {
+                status = DmtxEstimateSize(data, (UInt16)data.Length, options, info);
+            } catch (Exception ex) {
+                throw new DmtxException("Estimate error.", ex);
+            }
+            if (status == RETURN_INVALID_ARGUMENT) {
+                throw new DmtxInvalidArgumentException("Invalid options configuration.");
+            } else if (status == RETURN_ENCODE_ERROR) {
+                return null;
+            } else if (status > 0) {
+                throw new DmtxException("Unknown error.");
+            }
+            return info;
+        }
+
+        /// <summary>
+        /// Encodes data into a DataMatrix barcode drawn as vector graphics,
+        /// which prints sharp at any resolution.
+        /// </summary>
+        /// <param name="data">The data to encode.</param>
+        /// <param name="options">The options used for encoding; the quiet
+        /// zone is MarginSize / ModuleSize modules wide.</param>
+        /// <param name="format">The document format.</param>
+        /// <param name="moduleSize">The module size in output units (points
+        /// for PDF and EPS).</param>
+        /// <returns>The document.</returns>
+        /// <example>
+        /// <code>
+        ///   byte[] pdf = Dmtx.EncodeVector(data, new EncodeOptions(), VectorFormat.Pdf, 2.0);
+        ///   File.WriteAllBytes("label.pdf", pdf);
+        /// </code>
+        /// </example>
+        public static byte[] EncodeVector(byte[] data, EncodeOptions options, VectorFormat format, double moduleSize) {
+            return EncodeDocument(data, options,
+                delegate(IntPtr enc, out IntPtr document, out UInt32 length) {
+                    return DmtxEncodeVector(enc, (UInt16)format, moduleSize, -1, out document, out length);
+                });
+        }
+
+        /// <summary>
+        /// Encodes data into a DataMatrix barcode as a complete label for a
+        /// ZPL or EPL thermal printer, ready to be sent to it.
+        /// </summary>
+        /// <param name="data">The data to encode.</param>
+        /// <param name="options">The options used for encoding; the quiet
+        /// zone is MarginSize / ModuleSize modules wide.</param>
+        /// <param name="mode">Whether the printer encodes the data itself
+        /// (Zpl) or receives the modules as a graphic.</param>
+        /// <param name="dots">The module edge in printer dots.</param>
+        /// <returns>The label.</returns>
+        /// <example>
+        /// <code>
+        ///   byte[] zpl = Dmtx.EncodeLabel(data, new EncodeOptions(), LabelMode.ZplGraphic, 4);
+        ///   printerStream.Write(zpl, 0, zpl.Length);
+        /// </code>
+        /// </example>
+        public static byte[] EncodeLabel(byte[] data, EncodeOptions options, LabelMode mode, int dots) {
+            return EncodeDocument(data, options,
+                delegate(IntPtr enc, out IntPtr document, out UInt32 length) {
+                    return DmtxEncodeLabel(enc, data, (UInt16)data.Length, (UInt16)mode,
+                        (UInt16)dots, -1, out document, out length);
+                });
+        }
+
+        /// <summary>
+        /// Encodes many labels onto one page natively, on several threads,
+        /// instead of compositing one Bitmap per label.
+        /// </summary>
+        /// <param name="labels">The labels; X and Y are the top-left corner
+        /// of the quiet zone in pixels. Labels that do not fit are left out.</param>
+        /// <param name="width">The page width in pixels.</param>
+        /// <param name="height">The page height in pixels.</param>
+        /// <param name="options">The module size, margin, scheme and symbol
+        /// size of every label.</param>
+        /// <param name="threads">The number of encoding threads (1 to 64).</param>
+        /// <returns>The page.</returns>
+        public static Bitmap EncodeSheet(SheetLabel[] labels, int width, int height, EncodeOptions options, int threads) {
+            int moduleSize = (options.ModuleSize > 0) ? options.ModuleSize : 1;
+            byte[] pgm = EncodeSheetDocument(labels, width, height, moduleSize,
+                options.MarginSize / moduleSize, options, threads, "pgm");
+
+            // Skip the "P5", size and maximum value lines
+            int offset = 0;
+            for (int lines = 0; lines < 3; offset++) {
+                if (pgm[offset] == (byte)'\n') {
+                    lines++;
+                }
+            }
+
+            Bitmap page = new Bitmap(width, height, PixelFormat.Format24bppRgb);
+            Rectangle rect = new Rectangle(0, 0, width, height);
+            BitmapData bd = page.LockBits(rect, ImageLockMode.WriteOnly, PixelFormat.Format24bppRgb);
+            try {
+                byte[] row = new byte[width * 3];
+                for (int y = 0; y < height; y++) {
+                    for (int x = 0; x < width; x++) {
+                        byte v = pgm[offset + y * width + x];
+                        row[3 * x] = row[3 * x + 1] = row[3 * x + 2] = v;
+                    }
+                    Marshal.Copy(row, 0, new IntPtr(bd.Scan0.ToInt64() + (long)y * bd.Stride), row.Length);
+                }
+            } finally {
+                page.UnlockBits(bd);
+            }
+            return page;
+        }
+
+        /// <summary>
+        /// Encodes many labels onto one SVG, PDF or EPS page.
+        /// </summary>
+        /// <param name="labels">The labels; X and Y are the top-left corner
+        /// of the quiet zone in output units (points for PDF and EPS).</param>
+        /// <param name="width">The page width in output units.</param>
+        /// <param name="height">The page height in output units.</param>
+        /// <param name="format">The document format.</param>
+        /// <param name="moduleSize">The module size in output units.</param>
+        /// <param name="margin">The quiet zone in modules.</param>
+        /// <param name="options">The scheme and symbol size of every label.</param>
+        /// <param name="threads">The number of encoding threads (1 to 64).</param>
+        /// <returns>The document.</returns>
+        /// <example>
+        /// <code>
+        ///   SheetLabel[] labels = new SheetLabel[serials.Length];
+        ///   for (int i = 0; i &lt; labels.Length; i++) {
+        ///       labels[i] = new SheetLabel(serials[i], 20 + (i % 4) * 140, 20 + (i / 4) * 140);
+        ///   }
+        ///   byte[] pdf = Dmtx.EncodeSheetVector(labels, 595, 842, VectorFormat.Pdf, 1.5, 2, new EncodeOptions(), 4);
+        /// </code>
+        /// </example>
+        public static byte[] EncodeSheetVector(SheetLabel[] labels, int width, int height, VectorFormat format,
+            double moduleSize, int margin, EncodeOptions options, int threads) {
+            return EncodeSheetDocument(labels, width, height, moduleSize, margin, options, threads,
+                format.ToString().ToLowerInvariant());
+        }
+
+        private static byte[] EncodeSheetDocument(SheetLabel[] labels, int width, int height, double moduleSize,
+            int margin, EncodeOptions options, int threads, string format) {
+            int total = 0;
+            foreach (SheetLabel label in labels) {
+                total += label.Data.Length;
+            }
+
+            byte[] data = new byte[total];
+            UInt32[] dataSizes = new UInt32[labels.Length];
+            Int32[] positions = new Int32[2 * labels.Length];
+            total = 0;
+            for (int i = 0; i < labels.Length; i++) {
+                Array.Copy(labels[i].Data, 0, data, total, labels[i].Data.Length);
+                total += labels[i].Data.Length;
+                dataSizes[i] = (UInt32)labels[i].Data.Length;
+                positions[2 * i] = labels[i].X;
+                positions[2 * i + 1] = labels[i].Y;
+            }
+
+            IntPtr document = IntPtr.Zero;
+            try {
+                UInt32 length;
+                byte status = DmtxEncodeSheet(data, dataSizes, positions, (UInt32)labels.Length,
+                    (UInt32)width, (UInt32)height, moduleSize, (Int16)margin, (Int16)options.Scheme,
+                    (Int16)options.SizeIdx, (UInt16)threads, format, out document, out length);
+                if (status == RETURN_NO_MEMORY) {
+                    throw new DmtxOutOfMemoryException("Not enough memory.");
+                } else if (status > 0) {
+                    throw new DmtxInvalidArgumentException("Invalid page size, module size, margin or threads.");
+                }
+                byte[] ret = new byte[length];
+                Marshal.Copy(document, ret, 0, (int)length);
+                return ret;
+            } finally {
+                if (document != IntPtr.Zero) {
+                    DmtxFreeVector(document);
+                }
+            }
+        }
+
+        private delegate byte DocumentWriter(IntPtr enc, out IntPtr document, out UInt32 length);
+
+        private static byte[] EncodeDocument(byte[] data, EncodeOptions options, DocumentWriter writer) {
+            if (options.CodeType != CodeType.DataMatrix) {
+                throw new DmtxInvalidArgumentException("Document output needs a DataMatrix symbol.");
+            }
+
+            IntPtr result;
+            byte status;
+            try {
+                status = DmtxEncode(data, (UInt16)data.Length, out result, options);
+            } catch (Exception ex) {
+                throw new DmtxException("Encoding error.", ex);
+            }
+            if (status == RETURN_NO_MEMORY) {
+                throw new DmtxOutOfMemoryException("Not enough memory.");
+            } else if (status == RETURN_INVALID_ARGUMENT) {
+                throw new DmtxInvalidArgumentException("Invalid options configuration.");
+            } else if (status == RETURN_ENCODE_ERROR) {
+                throw new DmtxException("Error while encoding.");
+            } else if ((status > 0) || (result == IntPtr.Zero)) {
+                throw new DmtxException("Unknown error.");
+            }
+
+            EncodedInternal intResult = null;
+            IntPtr document = IntPtr.Zero;
+            try {
+                intResult = (EncodedInternal)Marshal.PtrToStructure(result, typeof(EncodedInternal));
+                UInt32 length;
+                status = writer(intResult.Data, out document, out length);
+                if (status > 0) {
+                    throw new DmtxInvalidArgumentException("Invalid size or margin.");
+                }
+                byte[] ret = new byte[length];
+                Marshal.Copy(document, ret, 0, (int)length);
+                return ret;
+            } finally {
+                if (document != IntPtr.Zero) {
+                    DmtxFreeVector(document);
+                }
+                if (intResult != null) {
+                    DmtxFreeEncodeResult(intResult.Data);
+                }
+            }
+        }
+
         public static Bitmap PnmToBitmap(Stream pnmInputStream) {
             // read header
             if (ReadLine(pnmInputStream) != "P6") {
@@ -310,10 +676,107 @@ namespace Libdmtx {
             [In] UInt32 stride,
             [In] IntPtr bitmap);
 
+        [DllImport("libdmtx.dll", EntryPoint = "dmtx_expand_encode_result")]
+        private static extern byte
+        DmtxExpandEncodeResult(
+            [In] IntPtr data,
+            [In] UInt16 format,
+            [In] UInt32 stride,
+            [In] IntPtr bitmap);
+
         [DllImport("libdmtx.dll", EntryPoint = "dmtx_free_encode_result")]
         private static extern void
         DmtxFreeEncodeResult([In] IntPtr data);
 
+        [DllImport("libdmtx.dll", EntryPoint = "dmtx_estimate_size")]
+        private static extern byte
+        DmtxEstimateSize(
+            [In] byte[] plain_text,
+            [In] UInt16 text_size,
+            [In] EncodeOptions options,
+            [In, Out] SymbolInfo result);
+
+        [DllImport("libdmtx.dll", EntryPoint = "dmtx_encode_vector")]
+        private static extern byte
+        DmtxEncodeVector(
+            [In] IntPtr data,
+            [In] UInt16 format,
+            [In] double moduleSize,
+            [In] Int16 margin,
+            [Out] out IntPtr document,
+            [Out] out UInt32 length);
+
+        [DllImport("libdmtx.dll", EntryPoint = "dmtx_encode_label")]
+        private static extern byte
+        DmtxEncodeLabel(
+            [In] IntPtr data,
+            [In] byte[] message,
+            [In] UInt16 messageSize,
+            [In] UInt16 mode,
+            [In] UInt16 dots,
+            [In] Int16 margin,
+            [Out] out IntPtr document,
+            [Out] out UInt32 length);
+
+        [DllImport("libdmtx.dll", EntryPoint = "dmtx_encode_sheet")]
+        private static extern byte
+        DmtxEncodeSheet(
+            [In] byte[] data,
+            [In] UInt32[] dataSizes,
+            [In] Int32[] positions,
+            [In] UInt32 count,
+            [In] UInt32 width,
+            [In] UInt32 height,
+            [In] double moduleSize,
+            [In] Int16 margin,
+            [In] Int16 scheme,
+            [In] Int16 sizeRequest,
+            [In] UInt16 threads,
+            [In, MarshalAs(UnmanagedType.LPStr)] string format,
+            [Out] out IntPtr document,
+            [Out] out UInt32 length);
+
+        [DllImport("libdmtx.dll", EntryPoint = "dmtx_free_vector")]
+        private static extern void
+        DmtxFreeVector([In] IntPtr document);
+
+        [DllImport("libdmtx.dll", EntryPoint = "dmtx_cache_enable")]
+        private static extern byte
+        DmtxCacheEnable(
+            [In] Int32 entries,
+            [In] Int32 ttl);
+
+        [DllImport("libdmtx.dll", EntryPoint = "dmtx_cache_stats")]
+        private static extern void
+        DmtxCacheStats(
+            [Out] out Int32 hits,
+            [Out] out Int32 misses);
+
+        [DllImport("libdmtx.dll", EntryPoint = "dmtx_stats_enabled")]
+        private static extern byte
+        DmtxStatsEnabled();
+
+        [DllImport("libdmtx.dll", EntryPoint = "dmtx_stats_get")]
+        private static extern Int32
+        DmtxStatsGet(
+            [Out] double[] values,
+            [In] Int32 count);
+
+        // Static string: returned as IntPtr so the marshaller leaves it alone
+        [DllImport("libdmtx.dll", EntryPoint = "dmtx_stats_name")]
+        private static extern IntPtr
+        DmtxStatsName([In] Int32 index);
+
+        [DllImport("libdmtx.dll", EntryPoint = "dmtx_stats_reset")]
+        private static extern void
+        DmtxStatsReset();
+
+        [DllImport("libdmtx.dll", EntryPoint = "dmtx_stats_add_convert")]
+        private static extern void
+        DmtxStatsAddConvert(
+            [In] double msec,
+            [In] double bytes);
+
         [DllImport("libdmtx.dll", EntryPoint = "dmtx_version", CharSet = CharSet.Ansi)]
         private static extern string
         DmtxVersion();
@@ -323,6 +786,47 @@ namespace Libdmtx {
         Default = 0
     }
 
+    /// <summary>
+    /// Documents written by <see cref="Dmtx.EncodeVector"/>; values must
+    /// be consistent with enum DmtxwVectorFormat.
+    /// </summary>
+    public enum VectorFormat {
+        Svg = 0,
+        Pdf = 1,
+        Eps = 2
+    }
+
+    /// <summary>
+    /// Labels written by <see cref="Dmtx.EncodeLabel"/>; values must be
+    /// consistent with enum DmtxwPrinterMode.
+    /// </summary>
+    public enum LabelMode {
+        Zpl = 0,
+        ZplGraphic = 1,
+        EplGraphic = 2
+    }
+
+    /// <summary>
+    /// Why a decode stopped.
+    /// </summary>
+    public enum DecodeStatus {
+        /// <summary>
+        /// The whole bitmap was searched.
+        /// </summary>
+        Complete,
+
+        /// <summary>
+        /// <see cref="DecodeOptions.MaxCodes"/> symbols were found.
+        /// </summary>
+        MaxCount,
+
+        /// <summary>
+        /// <see cref="DecodeOptions.TimeoutMS"/> expired; the symbols found
+        /// before are partial results.
+        /// </summary>
+        Timeout
+    }
+
     /// <summary>
     /// Enumeration of symbol sizes.
     /// </summary>
@@ -432,6 +936,32 @@ namespace Libdmtx {
         public Int16 CorrectionsMax = Dmtx.DmtxUndefined;
         public CodeType CodeType = CodeType.DataMatrix;
         public Int16 Shrink = 1;
+
+        /// <summary>
+        /// Convert the bitmap to luminance natively before searching,
+        /// downscaled by 1, 2 or 4 (0 searches the color bitmap as is).
+        /// </summary>
+        public Int16 LumaScale = 0;
+
+        /// <summary>
+        /// Skip bitmaps whose sharpness (variance of the Laplacian, see
+        /// <see cref="DmtxDecoded.Sharpness"/>) is lower, throwing
+        /// <see cref="DmtxImageQualityException"/> instead of searching.
+        /// </summary>
+        public Int32 MinSharpness = Dmtx.DmtxUndefined;
+
+        /// <summary>
+        /// Skip bitmaps with fewer strong edges (per mille of sampled pixels,
+        /// see <see cref="DmtxDecoded.EdgeDensity"/>), throwing
+        /// <see cref="DmtxImageQualityException"/> instead of searching.
+        /// </summary>
+        public Int16 MinEdgeDensity = Dmtx.DmtxUndefined;
+
+        /// <summary>
+        /// Percent of <see cref="TimeoutMS"/> spent searching for symbols;
+        /// the rest is kept for decoding those found near its end.
+        /// </summary>
+        public Int16 SearchShare = Dmtx.DmtxUndefined;
     }
 
     /// <summary>
@@ -530,6 +1060,16 @@ namespace Libdmtx {
         /// </code>
         /// </summary>
         public byte[] Data;
+
+        /// <summary>
+        /// Variance of the Laplacian of the bitmap the symbol was found in.
+        /// </summary>
+        public Int32 Sharpness;
+
+        /// <summary>
+        /// Sampled pixels of that bitmap lying on a strong edge, per mille.
+        /// </summary>
+        public UInt16 EdgeDensity;
     }
 
     [StructLayout(LayoutKind.Sequential)]
@@ -538,6 +1078,35 @@ namespace Libdmtx {
         public Corners Corners;
         public IntPtr Data;
         public UInt32 DataSize;
+        public Int32 Sharpness;
+        public UInt16 EdgeDensity;
+    }
+
+    /// <summary>
+    /// One label of <see cref="Dmtx.EncodeSheet"/> and
+    /// <see cref="Dmtx.EncodeSheetVector"/>.
+    /// </summary>
+    public class SheetLabel {
+        /// <summary>
+        /// The data to encode.
+        /// </summary>
+        public byte[] Data;
+
+        /// <summary>
+        /// Left edge of the quiet zone.
+        /// </summary>
+        public int X;
+
+        /// <summary>
+        /// Top edge of the quiet zone.
+        /// </summary>
+        public int Y;
+
+        public SheetLabel(byte[] data, int x, int y) {
+            Data = data;
+            X = x;
+            Y = y;
+        }
     }
 
     /// <summary>
@@ -590,4 +1159,15 @@ namespace Libdmtx {
         public DmtxInvalidArgumentException(string message, Exception innerException)
             : base(message, innerException) { }
     }
+
+    /// <summary>
+    /// Bitmap rejected by <see cref="DecodeOptions.MinSharpness"/> or
+    /// <see cref="DecodeOptions.MinEdgeDensity"/> before it was searched.
+    /// </summary>
+    public class DmtxImageQualityException : DmtxException {
+        public DmtxImageQualityException() { }
+        public DmtxImageQualityException(string message) : base(message) { }
+        public DmtxImageQualityException(string message, Exception innerException)
+            : base(message, innerException) { }
+    }
 }
\ No newline at end of file
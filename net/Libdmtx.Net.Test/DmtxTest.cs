@@ -97,6 +97,53 @@ namespace Libdmtx {
             AssertAreEqual(expectedBitmap, encodeResults.Bitmap);
         }
 
+        [Test]
+        public void TestEncodeMono() {
+            byte[] data = Encoding.ASCII.GetBytes("Test");
+            EncodeOptions opt = new EncodeOptions();
+            Bitmap rgb = Dmtx.Encode(data, opt).Bitmap;
+            Bitmap mono = Dmtx.Encode(data, opt, PixelFormat.Format1bppIndexed).Bitmap;
+            Assert.AreEqual(rgb.Width, mono.Width, "Bitmap Width");
+            Assert.AreEqual(rgb.Height, mono.Height, "Bitmap Height");
+            for (int y = 0; y < rgb.Height; y++) {
+                for (int x = 0; x < rgb.Width; x++) {
+                    Assert.AreEqual(rgb.GetPixel(x, y).ToArgb(), mono.GetPixel(x, y).ToArgb(),
+                        string.Format("Pixel mismatch at location ({0},{1})", x, y));
+                }
+            }
+        }
+
+        [Test]
+        public void TestEstimateSize() {
+            byte[] data = Encoding.ASCII.GetBytes("Test");
+            EncodeOptions opt = new EncodeOptions();
+            SymbolInfo estimate = Dmtx.EstimateSize(data, opt);
+            DmtxEncoded encodeResults = Dmtx.Encode(data, opt);
+            Assert.IsNotNull(estimate);
+            Assert.AreEqual(encodeResults.SymbolInfo.Rows, estimate.Rows);
+            Assert.AreEqual(encodeResults.SymbolInfo.Cols, estimate.Cols);
+            Assert.AreEqual(encodeResults.SymbolInfo.Capacity, estimate.Capacity);
+            Assert.AreEqual(encodeResults.SymbolInfo.ErrorWords, estimate.ErrorWords);
+        }
+
+        [Test]
+        public void TestEstimateSizeRect() {
+            byte[] data = Encoding.ASCII.GetBytes("Rectangle 16");
+            EncodeOptions opt = new EncodeOptions();
+            opt.SizeIdx = CodeSize.SymbolRectAuto;
+            SymbolInfo estimate = Dmtx.EstimateSize(data, opt);
+            DmtxEncoded encodeResults = Dmtx.Encode(data, opt);
+            Assert.IsNotNull(estimate);
+            Assert.Less(estimate.Rows, estimate.Cols);
+            Assert.AreEqual(encodeResults.SymbolInfo.Rows, estimate.Rows);
+            Assert.AreEqual(encodeResults.SymbolInfo.Cols, estimate.Cols);
+            Assert.AreEqual(encodeResults.SymbolInfo.Capacity, estimate.Capacity);
+
+            // libdmtx only searches for SquareAuto and RectAuto
+            opt.SizeIdx = CodeSize.SymbolShapeAuto;
+            Assert.IsNull(Dmtx.EstimateSize(data, opt));
+        }
+
         [Test]
         public void TestVersion() {
             string version = Dmtx.Version;
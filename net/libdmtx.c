@@ -24,11 +24,103 @@ Contact: libdmtx@fernsroth.com
 
 #include "libdmtx.h"
 #include "dmtx.h"
+#include "dmtxw.h"
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
 #include <stdio.h>
 
+/* Result cache shared by every dmtx_decode() call, NULL while disabled */
+static DmtxwCache *decode_cache = NULL;
+
+/* Hand the decode options over to a libdmtxw session */
+static DmtxPassFail
+dmtx_apply_options(DmtxwSession *session, const dmtx_decode_options_t *options)
+{
+	DmtxPassFail err = DmtxPass;
+
+	err &= dmtxwSessionSetProp(session, DmtxPropEdgeMin, options->edgeMin);
+	err &= dmtxwSessionSetProp(session, DmtxPropEdgeMax, options->edgeMax);
+	err &= dmtxwSessionSetProp(session, DmtxPropScanGap, options->scanGap);
+	err &= dmtxwSessionSetProp(session, DmtxPropSquareDevn, options->squareDevn);
+	err &= dmtxwSessionSetProp(session, DmtxPropSymbolSize, options->sizeIdxExpected);
+	err &= dmtxwSessionSetProp(session, DmtxPropEdgeThresh, options->edgeThresh);
+	err &= dmtxwSessionSetProp(session, DmtxPropXmin, options->xMin);
+	err &= dmtxwSessionSetProp(session, DmtxPropXmax, options->xMax);
+	err &= dmtxwSessionSetProp(session, DmtxPropYmin, options->yMin);
+	err &= dmtxwSessionSetProp(session, DmtxPropYmax, options->yMax);
+	err &= dmtxwSessionSetProp(session, DmtxwPropTimeout, options->timeoutMS);
+	err &= dmtxwSessionSetProp(session, DmtxwPropMaxCount, options->maxCodes);
+	err &= dmtxwSessionSetProp(session, DmtxwPropCorrections, options->correctionsMax);
+	err &= dmtxwSessionSetProp(session, DmtxwPropMosaic, options->mosaic);
+	err &= dmtxwSessionSetProp(session, DmtxwPropShrink, options->shrink);
+	err &= dmtxwSessionSetProp(session, DmtxwPropLuma, options->lumaScale);
+	err &= dmtxwSessionSetProp(session, DmtxwPropMinSharpness, options->minSharpness);
+	err &= dmtxwSessionSetProp(session, DmtxwPropMinEdgeDensity, options->minEdgeDensity);
+	err &= dmtxwSessionSetProp(session, DmtxwPropSearchShare, options->searchShare);
+
+	return err;
+}
+
+/* Describe a symbol size from the libdmtxw table; padWords and dataWords
+ * depend on the message and are left to the caller */
+static void
+dmtx_fill_symbol_info(dmtx_symbolinfo_t *symbolInfo, int sizeIdx)
+{
+	const DmtxwSymbolInfo *info = dmtxwSymbolInfo(sizeIdx);
+
+	if (info == NULL) {
+		memset(symbolInfo, 0, sizeof(dmtx_symbolinfo_t));
+		return;
+	}
+
+	symbolInfo->cols = (dmtx_uint16_t) info->cols;
+	symbolInfo->rows = (dmtx_uint16_t) info->rows;
+	symbolInfo->horizDataRegions = (dmtx_uint16_t) info->horizDataRegions;
+	symbolInfo->vertDataRegions = (dmtx_uint16_t) info->vertDataRegions;
+	symbolInfo->interleavedBlocks = (dmtx_uint16_t) info->interleavedBlocks;
+	symbolInfo->capacity = (dmtx_uint16_t) info->dataWords;
+	symbolInfo->errorWords = (dmtx_uint16_t) info->errorWords;
+}
+
+/* Write the diagnostic image of the undecoded input */
+static unsigned char
+dmtx_diagnose(const unsigned char *rgb_image,
+			const dmtx_uint32_t width,
+			const dmtx_uint32_t height,
+			const dmtx_uint32_t bitmapStride,
+			const dmtx_decode_options_t *options,
+			void(*diagnoseFunc)(unsigned char *data, int totalBytes, int headerBytes),
+			const dmtx_uint32_t diagnosticStyle)
+{
+	DmtxImage *img;
+	DmtxDecode *decode;
+	unsigned char *diagnosticData;
+	int totalBytes, headerBytes;
+
+	img = dmtxwImageCreate((unsigned char *)rgb_image, (int) width, (int) height,
+		(int) bitmapStride, DmtxwFormatBGR24);
+	if (img == NULL) return DMTX_RETURN_INVALID_ARGUMENT;
+
+	decode = dmtxDecodeCreate(img, (options->shrink > 0) ? options->shrink : 1);
+	if (decode == NULL) {
+		dmtxImageDestroy(&img);
+		return DMTX_RETURN_NO_MEMORY;
+	}
+
+	diagnosticData = dmtxDecodeCreateDiagnostic(
+		decode, &totalBytes, &headerBytes, diagnosticStyle);
+	if (diagnosticData != NULL) {
+		diagnoseFunc(diagnosticData, totalBytes, headerBytes);
+		free(diagnosticData);
+	}
+
+	dmtxDecodeDestroy(&decode);
+	dmtxImageDestroy(&img);
+
+	return DMTX_RETURN_OK;
+}
+
 DMTX_EXTERN unsigned char
 dmtx_decode(const unsigned char *rgb_image,
 			const dmtx_uint32_t width,
@@ -39,139 +131,98 @@ dmtx_decode(const unsigned char *rgb_image,
 			const dmtx_uint32_t diagnosticStyle,
 			int(*callbackFunc)(dmtx_decoded_t *decode_result))
 {
-	DmtxImage *img = NULL;
-	DmtxDecode *decode = NULL;
-	DmtxRegion *region = NULL;
-	DmtxMessage *msg = NULL;
-	unsigned char returncode = DMTX_RETURN_OK;
-	dmtx_uint16_t max_results = options->maxCodes;
-	DmtxPassFail err = DmtxPass;
-	DmtxTime msec, *timeout = NULL;
-	DmtxVector2 p00, p10, p11, p01;
-	double rotate;
-	int result_count;
-
-	// Create libdmtx's image structure
-	img = dmtxImageCreate((unsigned char *)rgb_image, (int) width, (int) height, DmtxPack24bppBGR);
-	if (img == NULL) return DMTX_RETURN_NO_MEMORY;
-
-	dmtxImageSetProp(img, DmtxPropRowPadBytes, bitmapStride % 3);
-
-	// Apply options
-	decode = dmtxDecodeCreate(img, options->shrink);
-	timeout = (options->timeoutMS != DmtxUndefined) ? &msec : NULL;
-	if (timeout != NULL)
-		msec = dmtxTimeAdd(dmtxTimeNow(), options->timeoutMS);
-	while (1) {
-		if ((options->edgeMax != DmtxUndefined) &&
-			((err = dmtxDecodeSetProp(decode, DmtxPropEdgeMax, options->edgeMax)
-			) != DmtxPass)) break;
-		if ((options->edgeMin != DmtxUndefined) &&
-			((err = dmtxDecodeSetProp(decode, DmtxPropEdgeMin, options->edgeMin)
-			) != DmtxPass)) break;
-		if ((options->scanGap != DmtxUndefined) &&
-			((err = dmtxDecodeSetProp(decode, DmtxPropScanGap, options->scanGap)
-			) != DmtxPass)) break;
-		if ((options->squareDevn != DmtxUndefined) &&
-			((err = dmtxDecodeSetProp(decode, DmtxPropSquareDevn, options->squareDevn)
-			) != DmtxPass)) break;
-		if ((err = dmtxDecodeSetProp(decode, DmtxPropSymbolSize, options->sizeIdxExpected)
-			) != DmtxPass) break;
-		if ((options->edgeThresh != DmtxUndefined) &&
-			((err = dmtxDecodeSetProp(decode, DmtxPropEdgeThresh, options->edgeThresh)
-			) != DmtxPass)) break;
-		if ((options->xMax != DmtxUndefined) &&
-			((err = dmtxDecodeSetProp(decode, DmtxPropXmax, options->xMax)
-			) != DmtxPass)) break;
-		if ((options->xMin != DmtxUndefined) &&
-			((err = dmtxDecodeSetProp(decode, DmtxPropXmin, options->xMin)
-			) != DmtxPass)) break;
-		if ((options->yMax != DmtxUndefined) &&
-			((err = dmtxDecodeSetProp(decode, DmtxPropYmax, options->yMax)
-			) != DmtxPass)) break;
-		if ((options->yMin != DmtxUndefined) &&
-			((err = dmtxDecodeSetProp(decode, DmtxPropYmin, options->yMin)
-			) != DmtxPass)) break;
-		break;
+	DmtxwSession *session;
+	const DmtxwResult *found;
+	const unsigned char *payload;
+	size_t payloadLength;
+	unsigned char returncode;
+	double timer;
+	int i;
+
+	if (diagnoseFunc) {
+		returncode = dmtx_diagnose(rgb_image, width, height, bitmapStride,
+			options, diagnoseFunc, diagnosticStyle);
+		if (returncode != DMTX_RETURN_OK) return returncode;
 	}
-	if (err != DmtxPass) {
-		dmtxDecodeDestroy(&decode);
-		dmtxImageDestroy(&img);
+
+	DMTXW_STATS_START(timer);
+
+	session = dmtxwSessionCreate();
+	if (session == NULL) return DMTX_RETURN_NO_MEMORY;
+
+	if (dmtx_apply_options(session, options) != DmtxPass) {
+		dmtxwSessionDestroy(&session);
 		return DMTX_RETURN_INVALID_ARGUMENT;
 	}
 
-	if (diagnoseFunc) {
-		int totalBytes, headerBytes;
-		unsigned char *diagnosticData;
-		diagnosticData = dmtxDecodeCreateDiagnostic(
-			decode, &totalBytes, &headerBytes, diagnosticStyle);
-		diagnoseFunc(diagnosticData, totalBytes, headerBytes);
-		free(diagnosticData);
+	dmtxwSessionSetCache(session, decode_cache);
+
+	DMTXW_STATS_STOP(timer, DmtxwPhaseSetup);
+	DMTXW_STATS_COUNT(DmtxwCounterAllocations, 1);
+
+	// Bitmap rows are bitmapStride bytes apart, including any padding
+	if (dmtxwSessionDecode(session, (unsigned char *)rgb_image, (int) width,
+		(int) height, (int) bitmapStride, DmtxwFormatBGR24) != DmtxPass) {
+		dmtxwSessionDestroy(&session);
+		return DMTX_RETURN_INVALID_ARGUMENT;
 	}
 
-	// Find and decode matrices in the image
-	region = dmtxRegionFindNext(decode, timeout);
-	result_count = 0;
-	while ((region != NULL) && (result_count < max_results)) {
+	// Includes the managed callback, which copies each payload
+	DMTXW_STATS_START(timer);
+
+	for (i = 0; i < dmtxwSessionGetResultCount(session); i++) {
 		dmtx_decoded_t result;
 
-		p00.X = p00.Y = p10.Y = p01.X = 0.0;
-		p10.X = p01.Y = p11.X = p11.Y = 1.0;
-		dmtxMatrix3VMultiplyBy(&p00, region->fit2raw);
-		dmtxMatrix3VMultiplyBy(&p10, region->fit2raw);
-		dmtxMatrix3VMultiplyBy(&p11, region->fit2raw);
-		dmtxMatrix3VMultiplyBy(&p01, region->fit2raw);
-		result.corners.corner0.x = (dmtx_uint16_t)(p00.X + 0.5);
-		result.corners.corner0.y = (dmtx_uint16_t)(height - 1 - (int)(p00.Y + 0.5));
-		result.corners.corner1.x = (dmtx_uint16_t)(p01.X + 0.5);
-		result.corners.corner1.y = (dmtx_uint16_t)(height - 1 - (int)(p01.Y + 0.5));
-		result.corners.corner2.x = (dmtx_uint16_t)(p10.X + 0.5);
-		result.corners.corner2.y = (dmtx_uint16_t)(height - 1 - (int)(p10.Y + 0.5));
-		result.corners.corner3.x = (dmtx_uint16_t)(p11.X + 0.5);
-		result.corners.corner3.y = (dmtx_uint16_t)(height - 1 - (int)(p11.Y + 0.5));
-
-		rotate = (2 * M_PI) + (atan2(region->fit2raw[0][1], region->fit2raw[1][1]) -
-			atan2(region->fit2raw[1][0], region->fit2raw[0][0])) / 2.0;
-		rotate = (rotate * 180/M_PI);  // degrees
-		if (rotate >= 360) rotate -= 360;
-		result.symbolInfo.angle = (dmtx_uint16_t) (rotate + 0.5);
-		result.symbolInfo.cols = (dmtx_uint16_t) dmtxGetSymbolAttribute(DmtxSymAttribSymbolCols, region->sizeIdx);
-		result.symbolInfo.rows = (dmtx_uint16_t) dmtxGetSymbolAttribute(DmtxSymAttribSymbolRows, region->sizeIdx);
-		result.symbolInfo.horizDataRegions = (dmtx_uint16_t) dmtxGetSymbolAttribute(DmtxSymAttribHorizDataRegions, region->sizeIdx);
-		result.symbolInfo.vertDataRegions = (dmtx_uint16_t) dmtxGetSymbolAttribute(DmtxSymAttribVertDataRegions, region->sizeIdx);
-		result.symbolInfo.interleavedBlocks = (dmtx_uint16_t) dmtxGetSymbolAttribute(DmtxSymAttribInterleavedBlocks, region->sizeIdx);
-		result.symbolInfo.capacity = (dmtx_uint16_t) dmtxGetSymbolAttribute(DmtxSymAttribSymbolDataWords, region->sizeIdx);
-		result.symbolInfo.errorWords = (dmtx_uint16_t) dmtxGetSymbolAttribute(DmtxSymAttribSymbolErrorWords, region->sizeIdx);
-
-		if (options->mosaic)
-			msg = dmtxDecodeMosaicRegion(decode, region, options->correctionsMax);
-		else
-			msg = dmtxDecodeMatrixRegion(decode, region, options->correctionsMax);
-		if (msg != NULL) {
-			result.data = malloc(msg->outputSize);
-			if (result.data != NULL) {
-				memcpy(result.data, msg->output, msg->outputSize);
-				result.dataSize = msg->outputSize;
-			}
-			result.symbolInfo.padWords = (dmtx_uint16_t) msg->padCount;
-			result.symbolInfo.dataWords = (dmtx_uint16_t) (
-				result.symbolInfo.capacity -
-				result.symbolInfo.padWords);
-			dmtxMessageDestroy(&msg);
-		}
+		found = dmtxwSessionGetResult(session, i);
+		payload = dmtxwSessionGetPayload(session, i, &payloadLength);
+
+		// Corner order expected by LibDmtx.cs: p00, p01, p10, p11
+		result.corners.corner0.x = (dmtx_uint16_t) found->corner[0].X;
+		result.corners.corner0.y = (dmtx_uint16_t) found->corner[0].Y;
+		result.corners.corner1.x = (dmtx_uint16_t) found->corner[3].X;
+		result.corners.corner1.y = (dmtx_uint16_t) found->corner[3].Y;
+		result.corners.corner2.x = (dmtx_uint16_t) found->corner[1].X;
+		result.corners.corner2.y = (dmtx_uint16_t) found->corner[1].Y;
+		result.corners.corner3.x = (dmtx_uint16_t) found->corner[2].X;
+		result.corners.corner3.y = (dmtx_uint16_t) found->corner[2].Y;
+
+		result.symbolInfo.angle = (dmtx_uint16_t) found->angle;
+		dmtx_fill_symbol_info(&result.symbolInfo, found->sizeIdx);
+		result.symbolInfo.padWords = (dmtx_uint16_t) found->padCount;
+		result.symbolInfo.dataWords = (dmtx_uint16_t) (
+			result.symbolInfo.capacity -
+			result.symbolInfo.padWords);
+
+		// Payload stays in the session arena; the callback copies it
+		result.data = (char *) payload;
+		result.dataSize = (dmtx_uint32_t) payloadLength;
+
+		result.sharpness = (dmtx_int32_t) found->sharpness;
+		result.edgeDensity = (dmtx_uint16_t) found->edgeDensity;
+
+		DMTXW_STATS_COUNT(DmtxwCounterAllocations, 2);
 
 		if(callbackFunc(&result)==0) {
 			break;
 		}
-
-		result_count++;
-		region = dmtxRegionFindNext(decode, timeout);
 	}
 
-	// Clean-up
-	dmtxRegionDestroy(&region);
-	dmtxDecodeDestroy(&decode);
-	dmtxImageDestroy(&img);
+	DMTXW_STATS_STOP(timer, DmtxwPhaseMarshal);
+
+	// Frames rejected by the quality gate were never searched; an early
+	// stop still delivered what was found up to then
+	if (session->status == DmtxwStatusBlurred)
+		returncode = DMTX_RETURN_BLURRED;
+	else if (session->status == DmtxwStatusEmpty)
+		returncode = DMTX_RETURN_EMPTY;
+	else if (session->status == DmtxwStatusTimeout)
+		returncode = DMTX_RETURN_TIMEOUT;
+	else if (session->status == DmtxwStatusMaxCount)
+		returncode = DMTX_RETURN_MAX_COUNT;
+	else
+		returncode = DMTX_RETURN_OK;
+
+	dmtxwSessionDestroy(&session);
 
 	return returncode;
 }
@@ -186,6 +237,7 @@ dmtx_encode(const void *plain_text,
 	DmtxPassFail err = DmtxPass;
 	DmtxRegion *region = NULL;
 	dmtx_encoded_t *res = NULL;
+	int width, height;
 	*result = NULL;
 
 	enc = dmtxEncodeCreate();
@@ -208,10 +260,17 @@ dmtx_encode(const void *plain_text,
 		return DMTX_RETURN_INVALID_ARGUMENT;
 	}
 
-	if (options->mosaic)
+	// Plain symbols are rendered at module size 1 and expanded into the
+	// Bitmap by dmtx_expand_encode_result(); mosaics keep libdmtx's image
+	if (options->mosaic) {
 		err = dmtxEncodeDataMosaic(enc, (int) text_size, (void *) plain_text);
-	else
-		err = dmtxEncodeDataMatrix(enc, (int) text_size, (void *) plain_text);
+		width = dmtxImageGetProp(enc->image, DmtxPropWidth);
+		height = dmtxImageGetProp(enc->image, DmtxPropHeight);
+	} else {
+		err = dmtxwEncodeDataMatrix(enc, (int) text_size, (const unsigned char *) plain_text);
+		if (err == DmtxPass)
+			err = dmtxwEncodeGetSize(enc, &width, &height);
+	}
 	if (err != DmtxPass) {
 		dmtxEncodeDestroy(&enc);
 		return DMTX_RETURN_ENCODE_ERROR;
@@ -225,26 +284,13 @@ dmtx_encode(const void *plain_text,
 
 	res->symbolInfo.angle = options->rotate;
 	region = &enc->region;
-	res->symbolInfo.cols = (dmtx_uint16_t)
-		dmtxGetSymbolAttribute(DmtxSymAttribSymbolCols, region->sizeIdx);
-	res->symbolInfo.rows = (dmtx_uint16_t)
-		dmtxGetSymbolAttribute(DmtxSymAttribSymbolRows, region->sizeIdx);
-	res->symbolInfo.horizDataRegions = (dmtx_uint16_t)
-		dmtxGetSymbolAttribute(DmtxSymAttribHorizDataRegions, region->sizeIdx);
-	res->symbolInfo.vertDataRegions = (dmtx_uint16_t)
-		dmtxGetSymbolAttribute(DmtxSymAttribVertDataRegions, region->sizeIdx);
-	res->symbolInfo.interleavedBlocks = (dmtx_uint16_t)
-		dmtxGetSymbolAttribute(DmtxSymAttribInterleavedBlocks, region->sizeIdx);
-	res->symbolInfo.capacity = (dmtx_uint16_t)
-		dmtxGetSymbolAttribute(DmtxSymAttribSymbolDataWords, region->sizeIdx);
-	res->symbolInfo.errorWords = (dmtx_uint16_t)
-		dmtxGetSymbolAttribute(DmtxSymAttribSymbolErrorWords, region->sizeIdx);
+	dmtx_fill_symbol_info(&res->symbolInfo, region->sizeIdx);
 	res->symbolInfo.padWords = (dmtx_uint16_t) enc->message->padCount;
 	res->symbolInfo.dataWords = (dmtx_uint16_t) (
 		res->symbolInfo.capacity -
 		res->symbolInfo.padWords);
-	res->width = (dmtx_uint16_t) dmtxImageGetProp(enc->image, DmtxPropWidth);
-	res->height = (dmtx_uint16_t) dmtxImageGetProp(enc->image, DmtxPropHeight);
+	res->width = (dmtx_uint32_t) width;
+	res->height = (dmtx_uint32_t) height;
 	res->data = enc;
 	return DMTX_RETURN_OK;
 }
@@ -264,6 +310,24 @@ dmtx_copy_encode_result(const DmtxEncode *enc,
 		3 * width);
 }
 
+// Writes a plain (not mosaic) encode result into a top-down bitmap of the
+// result's size; format is a DmtxwFormat value, e.g. DmtxwFormatBGR24 for
+// Format24bppRgb or DmtxwFormatMono1 for Format1bppIndexed
+DMTX_EXTERN unsigned char
+dmtx_expand_encode_result(const DmtxEncode *enc,
+						const dmtx_uint16_t format,
+						const dmtx_uint32_t stride,
+						unsigned char *bitmap)
+{
+	if (enc == NULL || bitmap == NULL)
+		return DMTX_RETURN_INVALID_ARGUMENT;
+
+	if (dmtxwEncodeExpand((DmtxEncode *) enc, bitmap, (int) stride, (int) format) != DmtxPass)
+		return DMTX_RETURN_INVALID_ARGUMENT;
+
+	return DMTX_RETURN_OK;
+}
+
 DMTX_EXTERN void
 dmtx_free_encode_result(const DmtxEncode *enc)
 {
@@ -271,6 +335,247 @@ dmtx_free_encode_result(const DmtxEncode *enc)
 	dmtxEncodeDestroy(pEnc);
 }
 
+// Predicts the symbol dmtx_encode() would create from the capacity table,
+// without encoding. dataWords is the predicted codeword count and padWords
+// what is left of the capacity; for mosaic options the largest of the
+// three layers counts.
+DMTX_EXTERN unsigned char
+dmtx_estimate_size(const void *plain_text,
+			const dmtx_uint16_t text_size,
+			const dmtx_encode_options_t *options,
+			dmtx_symbolinfo_t *result)
+{
+	const unsigned char *text = (const unsigned char *) plain_text;
+	int layers, layer, offset, size, sizeIdx, words, maxWords;
+
+	if (text == NULL || options == NULL || result == NULL)
+		return DMTX_RETURN_INVALID_ARGUMENT;
+
+	layers = options->mosaic ? 3 : 1;
+	maxWords = 0;
+	for (layer = 0, offset = 0; layer < layers; layer++, offset += size) {
+		size = ((int) text_size + layers - 1 - layer) / layers;
+		words = dmtxwSymbolCountWords(text + offset, size, options->scheme);
+		if (words == DmtxUndefined)
+			return DMTX_RETURN_ENCODE_ERROR;
+		if (words > maxWords)
+			maxWords = words;
+	}
+
+	sizeIdx = dmtxwSymbolFit(maxWords, options->sizeIdx);
+	if (sizeIdx == DmtxUndefined)
+		return DMTX_RETURN_ENCODE_ERROR;
+
+	dmtx_fill_symbol_info(result, sizeIdx);
+	result->angle = options->rotate;
+	result->dataWords = (dmtx_uint16_t) maxWords;
+	result->padWords = (dmtx_uint16_t) (result->capacity - maxWords);
+	return DMTX_RETURN_OK;
+}
+
+// Describes an encode result as an SVG, PDF or EPS document (format is a
+// DmtxwVectorFormat); margin in modules, -1 for the encode margin. The
+// document is released with dmtx_free_vector().
+DMTX_EXTERN unsigned char
+dmtx_encode_vector(const DmtxEncode *enc,
+			const dmtx_uint16_t format,
+			const double moduleSize,
+			const dmtx_int16_t margin,
+			unsigned char **document,
+			dmtx_uint32_t *length)
+{
+	DmtxwBuffer buffer;
+
+	*document = NULL;
+	*length = 0;
+
+	memset(&buffer, 0x00, sizeof(DmtxwBuffer));
+	if (dmtxwEncodeVector((DmtxEncode *) enc, (int) format, moduleSize,
+			(int) margin, &buffer) != DmtxPass) {
+		dmtxwBufferFree(&buffer);
+		return DMTX_RETURN_INVALID_ARGUMENT;
+	}
+
+	*document = buffer.data;
+	*length = (dmtx_uint32_t) buffer.length;
+	return DMTX_RETURN_OK;
+}
+
+// Describes an encode result as a ZPL or EPL label (mode is a
+// DmtxwPrinterMode); message is the encoded data, sent as such in ZPL
+// mode. The label is released with dmtx_free_vector().
+DMTX_EXTERN unsigned char
+dmtx_encode_label(const DmtxEncode *enc,
+			const unsigned char *message,
+			const dmtx_uint16_t messageSize,
+			const dmtx_uint16_t mode,
+			const dmtx_uint16_t dots,
+			const dmtx_int16_t margin,
+			unsigned char **document,
+			dmtx_uint32_t *length)
+{
+	DmtxwBuffer buffer;
+
+	*document = NULL;
+	*length = 0;
+
+	memset(&buffer, 0x00, sizeof(DmtxwBuffer));
+	if (dmtxwEncodePrinter((DmtxEncode *) enc, message, (int) messageSize,
+			(int) mode, (int) dots, (int) margin, &buffer) != DmtxPass) {
+		dmtxwBufferFree(&buffer);
+		return DMTX_RETURN_INVALID_ARGUMENT;
+	}
+
+	*document = buffer.data;
+	*length = (dmtx_uint32_t) buffer.length;
+	return DMTX_RETURN_OK;
+}
+
+// Draws many symbols onto one page: data holds the payloads back to back,
+// positions an x, y pair per label. format is "pgm", "pbm", "svg", "pdf"
+// or "eps"; the page is released with dmtx_free_vector().
+DMTX_EXTERN unsigned char
+dmtx_encode_sheet(const unsigned char *data,
+			const dmtx_uint32_t *dataSizes,
+			const dmtx_int32_t *positions,
+			const dmtx_uint32_t count,
+			const dmtx_uint32_t width,
+			const dmtx_uint32_t height,
+			const double moduleSize,
+			const dmtx_int16_t margin,
+			const dmtx_int16_t scheme,
+			const dmtx_int16_t sizeRequest,
+			const dmtx_uint16_t threads,
+			const char *format,
+			unsigned char **document,
+			dmtx_uint32_t *length)
+{
+	DmtxwSheetSpec spec;
+	DmtxwSheetLabel *labels;
+	DmtxwBuffer buffer;
+	dmtx_uint32_t i;
+	size_t offset = 0;
+	int drawn;
+
+	*document = NULL;
+	*length = 0;
+
+	labels = (DmtxwSheetLabel *) calloc(count + 1, sizeof(DmtxwSheetLabel));
+	if (labels == NULL) {
+		return DMTX_RETURN_NO_MEMORY;
+	}
+	for (i = 0; i < count; i++) {
+		labels[i].data = data + offset;
+		labels[i].dataSize = (int) dataSizes[i];
+		labels[i].x = (int) positions[2 * i];
+		labels[i].y = (int) positions[2 * i + 1];
+		offset += dataSizes[i];
+	}
+
+	dmtxwSheetSpecInit(&spec);
+	spec.width = (int) width;
+	spec.height = (int) height;
+	spec.moduleSize = moduleSize;
+	spec.margin = margin;
+	spec.scheme = scheme;
+	spec.sizeRequest = sizeRequest;
+	spec.threads = threads;
+
+	memset(&buffer, 0x00, sizeof(DmtxwBuffer));
+	drawn = dmtxwSheetWrite(&spec, labels, (int) count, format, &buffer);
+	free(labels);
+	if (drawn < 0) {
+		dmtxwBufferFree(&buffer);
+		return DMTX_RETURN_INVALID_ARGUMENT;
+	}
+
+	*document = buffer.data;
+	*length = (dmtx_uint32_t) buffer.length;
+	return DMTX_RETURN_OK;
+}
+
+DMTX_EXTERN void
+dmtx_free_vector(unsigned char *document)
+{
+	free(document);
+}
+
+// Must not be called while another thread is inside dmtx_decode()
+DMTX_EXTERN unsigned char
+dmtx_cache_enable(const dmtx_int32_t entries,
+			const dmtx_int32_t ttl)
+{
+	DmtxwCache *cache = NULL;
+
+	if (entries > 0) {
+		cache = dmtxwCacheCreate((int) entries, (int) ttl, DmtxUndefined);
+		if (cache == NULL) return DMTX_RETURN_INVALID_ARGUMENT;
+	}
+
+	if (decode_cache != NULL)
+		dmtxwCacheDestroy(&decode_cache);
+	decode_cache = cache;
+
+	return DMTX_RETURN_OK;
+}
+
+DMTX_EXTERN void
+dmtx_cache_stats(dmtx_int32_t *hits,
+			dmtx_int32_t *misses)
+{
+	long cacheHits = 0, cacheMisses = 0;
+
+	dmtxwCacheGetStats(decode_cache, &cacheHits, &cacheMisses);
+	*hits = (dmtx_int32_t) cacheHits;
+	*misses = (dmtx_int32_t) cacheMisses;
+}
+
+DMTX_EXTERN unsigned char
+dmtx_stats_enabled(void)
+{
+	return (dmtxwStatsEnabled() == DmtxTrue) ? 1 : 0;
+}
+
+/* Copy up to count instrumentation values of the calling thread, in the
+ * order of dmtx_stats_name(); -1 when libdmtxw was built without them */
+DMTX_EXTERN dmtx_int32_t
+dmtx_stats_get(double *values,
+			const dmtx_int32_t count)
+{
+	DmtxwStats stats;
+	dmtx_int32_t i;
+
+	if (dmtxwStatsGet(&stats) == DmtxFail)
+		return -1;
+
+	for (i = 0; i < count && dmtxwStatsName(i) != NULL; i++)
+		values[i] = dmtxwStatsValue(&stats, i);
+
+	return i;
+}
+
+DMTX_EXTERN const char *
+dmtx_stats_name(const dmtx_int32_t index)
+{
+	return dmtxwStatsName(index);
+}
+
+DMTX_EXTERN void
+dmtx_stats_reset(void)
+{
+	dmtxwStatsReset();
+}
+
+/* Bitmap conversion done by the managed caller */
+DMTX_EXTERN void
+dmtx_stats_add_convert(const double msec,
+			const double bytes)
+{
+	dmtxwStatsAddPhase(DmtxwPhaseConvert, msec);
+	dmtxwStatsCount(DmtxwCounterBytesConverted, bytes);
+	dmtxwStatsCount(DmtxwCounterAllocations, 1.0);
+}
+
 DMTX_EXTERN char *
 dmtx_version(void)
 {
@@ -29,6 +29,10 @@ Contact: libdmtx@fernsroth.com
 #define DMTX_RETURN_NO_MEMORY         1
 #define DMTX_RETURN_INVALID_ARGUMENT  2
 #define DMTX_RETURN_ENCODE_ERROR      3
+#define DMTX_RETURN_BLURRED           4
+#define DMTX_RETURN_EMPTY             5
+#define DMTX_RETURN_TIMEOUT           6 /* Time ran out, results are partial */
+#define DMTX_RETURN_MAX_COUNT         7 /* Stopped after maxCodes results */
 
 #include "dmtx.h"
 
@@ -64,6 +68,10 @@ typedef struct dmtx_decode_options_t {
 	dmtx_int16_t correctionsMax;
 	dmtx_uint16_t mosaic;
 	dmtx_int16_t shrink;
+	dmtx_int16_t lumaScale;
+	dmtx_int32_t minSharpness;
+	dmtx_int16_t minEdgeDensity;
+	dmtx_int16_t searchShare;
 } dmtx_decode_options_t;
 
 typedef struct dmtx_encode_options_t {
@@ -109,6 +117,8 @@ typedef struct dmtx_decoded_t
 	dmtx_corners_t corners;
 	char *data;
 	dmtx_uint32_t dataSize;
+	dmtx_int32_t sharpness;
+	dmtx_uint16_t edgeDensity;
 } dmtx_decoded_t;
 
 typedef struct dmtx_encoded_t
@@ -140,9 +150,83 @@ dmtx_copy_encode_result(const DmtxEncode *enc,
 						const dmtx_uint32_t stride,
 						const unsigned char *bitmap);
 
+DMTX_EXTERN unsigned char
+dmtx_expand_encode_result(const DmtxEncode *enc,
+						const dmtx_uint16_t format,
+						const dmtx_uint32_t stride,
+						unsigned char *bitmap);
+
 DMTX_EXTERN void
 dmtx_free_encode_result(const DmtxEncode *enc);
 
+DMTX_EXTERN unsigned char
+dmtx_estimate_size(const void *plain_text,
+			const dmtx_uint16_t text_size,
+			const dmtx_encode_options_t *options,
+			dmtx_symbolinfo_t *result);
+
+DMTX_EXTERN unsigned char
+dmtx_encode_vector(const DmtxEncode *enc,
+			const dmtx_uint16_t format,
+			const double moduleSize,
+			const dmtx_int16_t margin,
+			unsigned char **document,
+			dmtx_uint32_t *length);
+
+DMTX_EXTERN unsigned char
+dmtx_encode_label(const DmtxEncode *enc,
+			const unsigned char *message,
+			const dmtx_uint16_t messageSize,
+			const dmtx_uint16_t mode,
+			const dmtx_uint16_t dots,
+			const dmtx_int16_t margin,
+			unsigned char **document,
+			dmtx_uint32_t *length);
+
+DMTX_EXTERN unsigned char
+dmtx_encode_sheet(const unsigned char *data,
+			const dmtx_uint32_t *dataSizes,
+			const dmtx_int32_t *positions,
+			const dmtx_uint32_t count,
+			const dmtx_uint32_t width,
+			const dmtx_uint32_t height,
+			const double moduleSize,
+			const dmtx_int16_t margin,
+			const dmtx_int16_t scheme,
+			const dmtx_int16_t sizeRequest,
+			const dmtx_uint16_t threads,
+			const char *format,
+			unsigned char **document,
+			dmtx_uint32_t *length);
+
+DMTX_EXTERN void
+dmtx_free_vector(unsigned char *document);
+
+DMTX_EXTERN unsigned char
+dmtx_cache_enable(const dmtx_int32_t entries,
+			const dmtx_int32_t ttl);
+
+DMTX_EXTERN void
+dmtx_cache_stats(dmtx_int32_t *hits,
+			dmtx_int32_t *misses);
+
+DMTX_EXTERN unsigned char
+dmtx_stats_enabled(void);
+
+DMTX_EXTERN dmtx_int32_t
+dmtx_stats_get(double *values,
+			const dmtx_int32_t count);
+
+DMTX_EXTERN const char *
+dmtx_stats_name(const dmtx_int32_t index);
+
+DMTX_EXTERN void
+dmtx_stats_reset(void);
+
+DMTX_EXTERN void
+dmtx_stats_add_convert(const double msec,
+			const double bytes);
+
 DMTX_EXTERN char *
 dmtx_version(void);
 
@@ -1,6 +1,23 @@
 <?php
 	$dmtx = dmtx_write($_GET["d"]);
 
+	// Vector output for printing: ?d=...&vector=svg|pdf|eps
+	$types = array("svg" => "image/svg+xml", "pdf" => "application/pdf",
+		"eps" => "application/postscript");
+	if (isset($_GET["vector"]) && isset($types[$_GET["vector"]])) {
+		header("Content-type: " . $types[$_GET["vector"]]);
+		echo dmtx_getVector($dmtx, $_GET["vector"], 2.0);
+		exit;
+	}
+
+	// Thermal printer label: ?d=...&label=zpl|zpl-graphic|epl-graphic
+	$labels = array("zpl" => 1, "zpl-graphic" => 1, "epl-graphic" => 1);
+	if (isset($_GET["label"]) && isset($labels[$_GET["label"]])) {
+		header("Content-type: application/octet-stream");
+		echo dmtx_getLabel($dmtx, $_GET["label"], 4, -1, $_GET["d"]);
+		exit;
+	}
+
 	$size = dmtx_getSize($dmtx);
 	$gd = imagecreatetruecolor($size['width'], $size['height']);
 
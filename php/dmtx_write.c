@@ -27,6 +27,7 @@
 
 #include <php.h>
 #include <dmtx.h>
+#include <dmtxw.h>
 #include "php_dmtx.h"
 
 #define PHP_DMTX_IMAGE_RES_NAME "Datamatrix Image"
@@ -40,6 +41,9 @@ static zend_function_entry dmtx_functions[] = {
    PHP_FE(dmtx_write, NULL)
    PHP_FE(dmtx_getRow, NULL)
    PHP_FE(dmtx_getSize, NULL)
+   PHP_FE(dmtx_getVector, NULL)
+   PHP_FE(dmtx_getLabel, NULL)
+   PHP_FE(dmtx_sheet, NULL)
    {NULL, NULL, NULL}
 };
 
@@ -113,7 +117,8 @@ PHP_FUNCTION(dmtx_write)
 
    dmtxEncodeSetProp(enc, DmtxPropSizeRequest, DmtxSymbolSquareAuto);
 
-   dmtxEncodeDataMatrix(enc, data_len, data);
+   /* Rendered at module size 1; dmtx_getRow() expands rows on demand */
+   dmtxwEncodeDataMatrix(enc, data_len, data);
 
    printf("ddd");
    fflush(stdout);
@@ -125,49 +130,225 @@ PHP_FUNCTION(dmtx_getSize)
 {
    DmtxEncode *enc;
    zval *zImage;
+   int width, height;
 
    if(zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "r", &zImage) == FAILURE)
       RETURN_NULL();
 
    ZEND_FETCH_RESOURCE(enc, DmtxEncode *, &zImage, -1, PHP_DMTX_IMAGE_RES_NAME, le_dmtx_image);
 
+   if(dmtxwEncodeGetSize(enc, &width, &height) == DmtxFail)
+      RETURN_NULL();
+
    array_init(return_value);
-   add_assoc_long(return_value, "width", enc->image->width);
-   add_assoc_long(return_value, "height", enc->image->height);
+   add_assoc_long(return_value, "width", width);
+   add_assoc_long(return_value, "height", height);
 }
 
 PHP_FUNCTION(dmtx_getRow)
 {
    int i;
+   int width, height;
    zval *zImage;
    DmtxEncode *enc;
-   DmtxImage *img;
+   unsigned char *rgb;
 
    if(zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "r", &zImage) == FAILURE)
       RETURN_NULL();
 
    ZEND_FETCH_RESOURCE(enc, DmtxEncode *, &zImage, -1, PHP_DMTX_IMAGE_RES_NAME, le_dmtx_image);
-   img = enc->image;
 
-   if(DMTX_G(row_index) >= img->height)
+   if(dmtxwEncodeGetSize(enc, &width, &height) == DmtxFail ||
+         DMTX_G(row_index) >= height)
       RETURN_NULL();
 
+   rgb = (unsigned char *)emalloc((size_t)width * 3);
+   dmtxwEncodeExpandRows(enc, DMTX_G(row_index), 1, rgb, 0, DmtxwFormatRGB24);
+
    array_init(return_value);
 
-   for(i = 0; i < img->width; i++) {
+   for(i = 0; i < width; i++) {
 
-      int pos = (DMTX_G(row_index) * img->width) + i;
       zval *arr;
 
       ALLOC_INIT_ZVAL(arr);
       array_init(arr);
 
-      add_assoc_long(arr, "R", img->pxl[pos * 3 + 0]);
-      add_assoc_long(arr, "G", img->pxl[pos * 3 + 1]);
-      add_assoc_long(arr, "B", img->pxl[pos * 3 + 2]);
+      add_assoc_long(arr, "R", rgb[i * 3 + 0]);
+      add_assoc_long(arr, "G", rgb[i * 3 + 1]);
+      add_assoc_long(arr, "B", rgb[i * 3 + 2]);
 
       add_next_index_zval(return_value, arr);
    }
 
+   efree(rgb);
+
    DMTX_G(row_index)++;
 }
+
+/* The symbol as an SVG, PDF or EPS document drawn with rectangles, so it
+ * prints sharp at any size: module_size in output units (points for PDF
+ * and EPS), margin in modules (-1 for libdmtx's margin) */
+PHP_FUNCTION(dmtx_getVector)
+{
+   zval *zImage;
+   DmtxEncode *enc;
+   DmtxwBuffer buffer;
+   char *format_name = "svg";
+   int format_len = 3;
+   double module_size = 1.0;
+   long margin = DmtxUndefined;
+   int format;
+
+   if(zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "r|sdl", &zImage,
+         &format_name, &format_len, &module_size, &margin) == FAILURE)
+      RETURN_NULL();
+
+   ZEND_FETCH_RESOURCE(enc, DmtxEncode *, &zImage, -1, PHP_DMTX_IMAGE_RES_NAME, le_dmtx_image);
+
+   format = dmtxwVectorByName(format_name);
+   if(format == DmtxUndefined)
+      RETURN_FALSE;
+
+   memset(&buffer, 0x00, sizeof(DmtxwBuffer));
+   if(dmtxwEncodeVector(enc, format, module_size, (int)margin, &buffer) == DmtxFail) {
+      dmtxwBufferFree(&buffer);
+      RETURN_FALSE;
+   }
+
+   RETVAL_STRINGL((char *)buffer.data, (int)buffer.length, 1);
+   dmtxwBufferFree(&buffer);
+}
+
+/* The symbol as a label for a thermal printer: mode "zpl" (the printer
+ * encodes data itself, which must then be passed again), "zpl-graphic" or
+ * "epl-graphic"; dots per module edge, margin in modules (-1 for
+ * libdmtx's margin) */
+PHP_FUNCTION(dmtx_getLabel)
+{
+   zval *zImage;
+   DmtxEncode *enc;
+   DmtxwBuffer buffer;
+   char *mode_name = "zpl-graphic";
+   int mode_len = 11;
+   long dots = 4;
+   long margin = DmtxUndefined;
+   unsigned char *data = NULL;
+   int data_len = 0;
+   int mode;
+
+   if(zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "r|slls", &zImage,
+         &mode_name, &mode_len, &dots, &margin, &data, &data_len) == FAILURE)
+      RETURN_NULL();
+
+   ZEND_FETCH_RESOURCE(enc, DmtxEncode *, &zImage, -1, PHP_DMTX_IMAGE_RES_NAME, le_dmtx_image);
+
+   mode = dmtxwPrinterByName(mode_name);
+   if(mode == DmtxUndefined)
+      RETURN_FALSE;
+
+   memset(&buffer, 0x00, sizeof(DmtxwBuffer));
+   if(dmtxwEncodePrinter(enc, data, data_len, mode, (int)dots, (int)margin,
+         &buffer) == DmtxFail) {
+      dmtxwBufferFree(&buffer);
+      RETURN_FALSE;
+   }
+
+   RETVAL_STRINGL((char *)buffer.data, (int)buffer.length, 1);
+   dmtxwBufferFree(&buffer);
+}
+
+/* Numeric entry of an options array, or def when missing */
+static double php_dmtx_option(zval *zOptions, char *name, double def)
+{
+   zval **zValue, copy;
+
+   if(zOptions == NULL || zend_hash_find(Z_ARRVAL_P(zOptions), name,
+         strlen(name) + 1, (void **)&zValue) == FAILURE)
+      return def;
+
+   copy = **zValue;
+   zval_copy_ctor(&copy);
+   convert_to_double(&copy);
+
+   return Z_DVAL(copy);
+}
+
+/* Many symbols on one page, encoded in parallel: labels are arrays of
+ * (data, x, y), or strings laid out "columns" to a row from "x", "y"
+ * every "pitch_x" and "pitch_y". Returns a "pgm" or "pbm" image, or an
+ * "svg", "pdf" or "eps" document */
+PHP_FUNCTION(dmtx_sheet)
+{
+   zval *zLabels, *zOptions = NULL, **zItem, **zField;
+   HashPosition pos;
+   DmtxwSheetSpec spec;
+   DmtxwSheetLabel *labels;
+   DmtxwBuffer buffer;
+   char *format = "pgm";
+   int format_len = 3;
+   long width, height;
+   int i, count, columns, drawn;
+
+   if(zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "all|sa", &zLabels,
+         &width, &height, &format, &format_len, &zOptions) == FAILURE)
+      RETURN_NULL();
+
+   dmtxwSheetSpecInit(&spec);
+   spec.width = (int)width;
+   spec.height = (int)height;
+   spec.moduleSize = php_dmtx_option(zOptions, "module_size", spec.moduleSize);
+   spec.margin = (int)php_dmtx_option(zOptions, "margin", spec.margin);
+   spec.threads = (int)php_dmtx_option(zOptions, "threads", spec.threads);
+   columns = (int)php_dmtx_option(zOptions, "columns", 0);
+
+   count = zend_hash_num_elements(Z_ARRVAL_P(zLabels));
+   labels = (DmtxwSheetLabel *)ecalloc(count + 1, sizeof(DmtxwSheetLabel));
+
+   i = 0;
+   for(zend_hash_internal_pointer_reset_ex(Z_ARRVAL_P(zLabels), &pos);
+         zend_hash_get_current_data_ex(Z_ARRVAL_P(zLabels), (void **)&zItem, &pos) == SUCCESS;
+         zend_hash_move_forward_ex(Z_ARRVAL_P(zLabels), &pos), i++) {
+      if(columns > 0 && Z_TYPE_PP(zItem) == IS_STRING) {
+         labels[i].data = (unsigned char *)Z_STRVAL_PP(zItem);
+         labels[i].dataSize = Z_STRLEN_PP(zItem);
+         continue;
+      }
+      if(columns == 0 && Z_TYPE_PP(zItem) == IS_ARRAY &&
+            zend_hash_index_find(Z_ARRVAL_PP(zItem), 0, (void **)&zField) == SUCCESS &&
+            Z_TYPE_PP(zField) == IS_STRING) {
+         labels[i].data = (unsigned char *)Z_STRVAL_PP(zField);
+         labels[i].dataSize = Z_STRLEN_PP(zField);
+         if(zend_hash_index_find(Z_ARRVAL_PP(zItem), 1, (void **)&zField) == SUCCESS &&
+               Z_TYPE_PP(zField) == IS_LONG)
+            labels[i].x = (int)Z_LVAL_PP(zField);
+         if(zend_hash_index_find(Z_ARRVAL_PP(zItem), 2, (void **)&zField) == SUCCESS &&
+               Z_TYPE_PP(zField) == IS_LONG)
+            labels[i].y = (int)Z_LVAL_PP(zField);
+         continue;
+      }
+      php_error_docref(NULL TSRMLS_CC, E_WARNING,
+            "labels must be strings with columns, arrays (data, x, y) without");
+      efree(labels);
+      RETURN_FALSE;
+   }
+
+   if(columns > 0)
+      dmtxwSheetGrid(labels, count, columns,
+            (int)php_dmtx_option(zOptions, "x", 0),
+            (int)php_dmtx_option(zOptions, "y", 0),
+            (int)php_dmtx_option(zOptions, "pitch_x", 0),
+            (int)php_dmtx_option(zOptions, "pitch_y", 0));
+
+   memset(&buffer, 0x00, sizeof(DmtxwBuffer));
+   drawn = dmtxwSheetWrite(&spec, labels, count, format, &buffer);
+   efree(labels);
+
+   if(drawn < 0) {
+      dmtxwBufferFree(&buffer);
+      RETURN_FALSE;
+   }
+
+   RETVAL_STRINGL((char *)buffer.data, (int)buffer.length, 1);
+   dmtxwBufferFree(&buffer);
+}
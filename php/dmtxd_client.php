@@ -0,0 +1,174 @@
+<?php
+/*
+ * Thin client for dmtxd, the libdmtx decode daemon (see daemon/dmtxd.h).
+ *
+ * Lets PHP-FPM workers hand decode and encode jobs to a long-running pool
+ * of decoders instead of loading libdmtx on every request:
+ *
+ *	require 'dmtxd_client.php';
+ *	$dmtxd = new DmtxdClient();
+ *	$img = imagecreatefrompng('label.png');
+ *	$result = $dmtxd->decode(DmtxdClient::gdToGray($img), imagesx($img),
+ *		imagesy($img), 'gray8', array('timeout' => 200, 'max_count' => 1));
+ *	foreach ($result['symbols'] as $symbol)
+ *		echo $symbol['data'], "\n";
+ *
+ * $result['status'] is 'complete', 'max_count' or 'timeout'; with
+ * 'timeout' the symbols listed are those found in time.
+ */
+
+class DmtxdClient
+{
+	private $sock;
+
+	public function __construct($path = '/tmp/dmtxd.sock', $connectTimeout = 1.0)
+	{
+		$this->sock = @stream_socket_client('unix://' . $path, $errno, $errstr,
+			$connectTimeout);
+		if ($this->sock === false)
+			throw new Exception("dmtxd: cannot connect to $path: $errstr");
+	}
+
+	public function __destruct()
+	{
+		if ($this->sock !== false)
+			fclose($this->sock);
+	}
+
+	/* Decode raw pixel rows; $format is one of gray8, rgb24, bgr24, ... and
+	 * $options holds libdmtxw option names (timeout, max_count, luma, ...) */
+	public function decode($pixels, $width, $height, $format = 'rgb24', $options = array())
+	{
+		$this->send(sprintf("DECODE %d %d %s 0 inline %d%s\n", $width, $height,
+			$format, strlen($pixels), $this->optionWords($options)) . $pixels);
+
+		$head = explode(' ', $this->readStatusLine());
+		$result = array('status' => $head[1], 'msec' => (float)$head[3],
+			'symbols' => array());
+
+		for ($i = 0; $i < (int)$head[2]; $i++) {
+			$f = explode(' ', $this->readLine());
+			$result['symbols'][] = array(
+				'data' => $this->readBytes((int)$f[1]),
+				'corners' => array(
+					array((int)$f[2], (int)$f[3]), array((int)$f[4], (int)$f[5]),
+					array((int)$f[6], (int)$f[7]), array((int)$f[8], (int)$f[9])),
+				'angle' => (int)$f[10],
+				'size_idx' => (int)$f[11]);
+			$this->readBytes(1);
+		}
+
+		return $result;
+	}
+
+	/* Encode a message; returns width, height and top-down RGB rows */
+	public function encode($message, $options = array())
+	{
+		$this->send(sprintf("ENCODE %d%s\n", strlen($message),
+			$this->optionWords($options)) . $message);
+
+		$head = explode(' ', $this->readStatusLine());
+
+		return array('width' => (int)$head[1], 'height' => (int)$head[2],
+			'rgb' => $this->readBytes((int)$head[3]));
+	}
+
+	/* Pool counters: workers, connections, queued, served, failed. When
+	 * libdmtxw was built with DMTXW_STATS, the decode phase timers and
+	 * counters of all workers follow (convert_calls, convert_ms, ...,
+	 * search_ms, decode_ms, marshal_ms, regions_tried, regions_decoded,
+	 * bytes_converted, allocations). */
+	public function stats()
+	{
+		$this->send("STATS\n");
+		$head = explode(' ', $this->readStatusLine());
+
+		$stats = array('workers' => (int)$head[1], 'connections' => (int)$head[2],
+			'queued' => (int)$head[3], 'served' => (int)$head[4],
+			'failed' => (int)$head[5]);
+
+		return array_merge($stats, $this->counters("COUNTERS\n"));
+	}
+
+	/* Clear the decode phase timers and counters of the daemon */
+	public function resetStats()
+	{
+		$this->counters("COUNTERS reset\n");
+	}
+
+	/* 8 bit gray rows of a GD image, for decode(..., 'gray8') */
+	public static function gdToGray($img)
+	{
+		$pixels = '';
+		for ($y = 0; $y < imagesy($img); $y++) {
+			for ($x = 0; $x < imagesx($img); $x++) {
+				$c = imagecolorat($img, $x, $y);
+				$pixels .= chr((77 * (($c >> 16) & 0xff) + 150 * (($c >> 8) & 0xff) +
+					29 * ($c & 0xff)) >> 8);
+			}
+		}
+		return $pixels;
+	}
+
+	/* Instrumentation totals, empty if the daemon has none */
+	private function counters($request)
+	{
+		$this->send($request);
+		$line = $this->readLine();
+		if (strncmp($line, 'OK', 2) != 0)
+			return array();
+
+		$counters = array();
+		foreach (array_slice(explode(' ', $line), 1) as $word) {
+			list($name, $value) = explode('=', $word, 2);
+			$counters[$name] = (float)$value;
+		}
+		return $counters;
+	}
+
+	private function optionWords($options)
+	{
+		$words = '';
+		foreach ($options as $name => $value)
+			$words .= sprintf(' %s=%d', $name, $value);
+		return $words;
+	}
+
+	private function send($data)
+	{
+		for ($done = 0; $done < strlen($data); $done += $n) {
+			$n = fwrite($this->sock, substr($data, $done));
+			if ($n === false || $n === 0)
+				throw new Exception('dmtxd: connection lost');
+		}
+	}
+
+	private function readLine()
+	{
+		$line = fgets($this->sock);
+		if ($line === false)
+			throw new Exception('dmtxd: connection lost');
+		return rtrim($line, "\n");
+	}
+
+	private function readStatusLine()
+	{
+		$line = $this->readLine();
+		if (strncmp($line, 'OK ', 3) != 0)
+			throw new Exception('dmtxd: ' . $line);
+		return $line;
+	}
+
+	private function readBytes($length)
+	{
+		$data = '';
+		while (strlen($data) < $length) {
+			$chunk = fread($this->sock, $length - strlen($data));
+			if ($chunk === false || $chunk === '')
+				throw new Exception('dmtxd: connection lost');
+			$data .= $chunk;
+		}
+		return $data;
+	}
+}
+?>
@@ -27,6 +27,9 @@ PHP_RINIT_FUNCTION(dmtx);
 PHP_FUNCTION(dmtx_write);
 PHP_FUNCTION(dmtx_getRow);
 PHP_FUNCTION(dmtx_getSize);
+PHP_FUNCTION(dmtx_getVector);
+PHP_FUNCTION(dmtx_getLabel);
+PHP_FUNCTION(dmtx_sheet);
 
 extern zend_module_entry dmtx_module_entry;
 #define phpext_libdmtx_ptr &dmtx_module_entry
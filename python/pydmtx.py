@@ -22,13 +22,25 @@
 # $Id$
 
 import _pydmtx
+import time
 try:
-	from PIL import Image, ImageDraw
+	from PIL import Image
 	_hasPIL = True
 except ImportError:
 	_hasPIL = False
 
 
+# decode phase timers and counters of the calling thread since the last
+# reset_stats(): convert/setup/search/decode/marshal _calls and _ms,
+# regions_tried, regions_decoded, bytes_converted and allocations. None
+# unless libdmtxw was built with --enable-stats.
+def stats():
+	return _pydmtx.stats()
+
+def reset_stats():
+	_pydmtx.reset_stats()
+
+
 class DataMatrix (object):
 	DmtxUndefined = -1
 
@@ -77,10 +89,21 @@ class DataMatrix (object):
 	DmtxSymbol16x36      =  28
 	DmtxSymbol16x48      =  29
 
+	# Decode status: values must be consistent with enum DmtxwStatus
+	DmtxwStatusComplete  =  0
+	DmtxwStatusMaxCount  =  1
+	DmtxwStatusTimeout   =  2
+	DmtxwStatusCancelled =  3
+	DmtxwStatusError     =  4
+	DmtxwStatusBlurred   =  5
+	DmtxwStatusEmpty     =  6
+
 	def __init__( self, **kwargs ):
 		self._data = None
 		self._image = None
-		self._draw = None
+		self._session = _pydmtx.session()
+		self._cache = None
+		self._trace = None
 
 		self.width, self.height = 0, 0
 
@@ -106,31 +129,69 @@ class DataMatrix (object):
 		all_kwargs = self.options
 		all_kwargs.update(kwargs)
 
+		# drawn natively at the final size and handed over as one string
+		self._data = str(data)
+		self.width, self.height, pixels = _pydmtx.encode_image( self._data,
+			all_kwargs['module_size'], all_kwargs['margin_size'],
+			all_kwargs['scheme'], all_kwargs['shape'] )
+		self._image = Image.frombuffer( 'RGB', (self.width, self.height),
+			pixels, 'raw', 'RGB', 0, 1 )
+
+	# the symbol as an 'svg', 'pdf' or 'eps' document, drawn natively as
+	# rectangles: module_size is in output units (points for pdf and
+	# eps), margin the quiet zone in modules (libdmtx's default is 2)
+	def encode_vector( self, data, format='svg', module_size=1.0, margin=None ):
 		self._data = str(data)
-		_pydmtx.encode( self._data, plotter=self._plot,
-			start=self._start, finish=self._finish, **all_kwargs );
+		if margin is None:
+			margin = self.DmtxUndefined
+		return _pydmtx.encode_vector( self._data, format, float(module_size),
+			margin, self.options['scheme'], self.options['shape'] )
+
+	# the symbol as a thermal printer label: 'zpl' sends the data for the
+	# printer to encode, 'zpl-graphic' and 'epl-graphic' the modules as a
+	# graphic; dots is the module edge in printer dots (e.g. 4 at 203 dpi
+	# for 0.5 mm modules), margin the quiet zone in modules
+	def encode_label( self, data, mode='zpl', dots=4, margin=None ):
+		self._data = str(data)
+		if margin is None:
+			margin = self.DmtxUndefined
+		return _pydmtx.encode_label( self._data, mode, int(dots),
+			margin, self.options['scheme'], self.options['shape'] )
+
+	# many symbols on one page, encoded in parallel natively: labels are
+	# (data, x, y) tuples, or plain strings laid out columns to a row from
+	# (x, y) every pitch_x and pitch_y. Positions are the top-left corner
+	# of the quiet zone, in pixels for 'pgm' and 'pbm' (returned as PIL
+	# images) and output units for 'svg', 'pdf' and 'eps' (returned as
+	# documents). Labels that do not fit on the page are left out.
+	def encode_sheet( self, labels, width, height, format='pgm', **kwargs ):
+		kwargs.setdefault( 'scheme', self.options['scheme'] )
+		kwargs.setdefault( 'shape', self.options['shape'] )
+		page = _pydmtx.encode_sheet( labels, width, height, format, **kwargs )
+		if format in ( 'pgm', 'pbm' ) and _hasPIL:
+			from StringIO import StringIO
+			return Image.open( StringIO( page ) )
+		return page
 
 	def save( self, path, fmt ):
 		if self._image is not None:
 			self._image.save( path, fmt )
 
-	def _start( self, width, height, context ):
-		self.width, self.height = width, height
-		self._image = Image.new( 'RGB', (width,height), (255,255,255) )
-		self._draw = ImageDraw.Draw( self._image )
-
-	def _plot( self, x, y, color, context ):
-		self._draw.point( (x,self.height-y-1), fill=color )
-
-	def _finish( self, context ):
-		del self._draw
-		self._draw = None
-
-	def decode( self, width, height, data, **kwargs):
+	# deadline is an absolute time.time() value for this call only; what
+	# was found when it passed is returned and status() says so
+	def decode( self, width, height, data, deadline=None, **kwargs):
 		all_kwargs = self.options
 		all_kwargs.update(kwargs)
 
-		self.results =  _pydmtx.decode( width, height, data, **all_kwargs)
+		if deadline is not None:
+			left = max(0, int((deadline - time.time()) * 1000))
+			self.results =  _pydmtx.decode( width, height, data,
+				session=self._session, cache=self._cache, trace=self._trace,
+				deadline_ms=left, **all_kwargs)
+		else:
+			self.results =  _pydmtx.decode( width, height, data,
+				session=self._session, cache=self._cache, trace=self._trace,
+				**all_kwargs)
 
 		# return only the first message
 		return self.message(1)
@@ -150,3 +211,36 @@ class DataMatrix (object):
 			return self.results[ref-1]
 		else:
 			return
+
+	# why the last decode stopped (one of the DmtxwStatus values)
+	def status( self ):
+		return _pydmtx.quality( self._session )[0]
+
+	# (status, sharpness, edge density) of the last decoded frame
+	def quality( self ):
+		return _pydmtx.quality( self._session )
+
+	# answer frames matching one of the last 'entries' decoded frames from
+	# memory; entries expire after ttl milliseconds (at least 1)
+	def enable_cache( self, entries, ttl=1000, tolerance=DmtxUndefined ):
+		self._cache = _pydmtx.cache( entries, ttl, tolerance )
+
+	def disable_cache( self ):
+		self._cache = None
+
+	# write the spans of every decode to a Chrome trace file (open it in
+	# chrome://tracing or Perfetto); with min_ms, only decodes that took
+	# at least that long
+	def enable_trace( self, path, min_ms=0 ):
+		self._trace = _pydmtx.trace( path, min_ms )
+
+	# finishes the trace file
+	def disable_trace( self ):
+		self._trace = None
+
+	# (hits, misses) since the cache was enabled
+	def cache_stats( self ):
+		if self._cache is not None:
+			return _pydmtx.cache_stats( self._cache )
+		else:
+			return (0, 0)
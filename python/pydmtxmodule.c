@@ -30,6 +30,7 @@ Contact: mike@dragonflylogic.com
 #include <string.h>
 #include <Python.h>
 #include <dmtx.h>
+#include <dmtxw.h>
 
 /* Define Py_ssize_t for earlier Python versions */
 #if PY_VERSION_HEX < 0x02050000 && !defined(PY_SSIZE_T_MIN)
@@ -39,17 +40,72 @@ typedef int Py_ssize_t;
 #endif
 
 static PyObject *dmtx_encode(PyObject *self, PyObject *args, PyObject *kwargs);
+static PyObject *dmtx_encode_image(PyObject *self, PyObject *args, PyObject *kwargs);
+static PyObject *dmtx_encode_vector(PyObject *self, PyObject *args, PyObject *kwargs);
+static PyObject *dmtx_encode_label(PyObject *self, PyObject *args, PyObject *kwargs);
+static PyObject *dmtx_encode_sheet(PyObject *self, PyObject *args, PyObject *kwargs);
 static PyObject *dmtx_decode(PyObject *self, PyObject *args, PyObject *kwargs);
+static PyObject *dmtx_session(PyObject *self, PyObject *args);
+static PyObject *dmtx_quality(PyObject *self, PyObject *args);
+static PyObject *dmtx_cache(PyObject *self, PyObject *args);
+static PyObject *dmtx_cache_stats(PyObject *self, PyObject *args);
+static PyObject *dmtx_stats(PyObject *self, PyObject *args);
+static PyObject *dmtx_reset_stats(PyObject *self, PyObject *args);
+static PyObject *dmtx_trace(PyObject *self, PyObject *args);
 
 static PyMethodDef dmtxMethods[] = {
    { "encode",
      (PyCFunction)dmtx_encode,
      METH_VARARGS | METH_KEYWORDS,
      "Encodes data into a matrix and calls back to plot." },
+   { "encode_image",
+     (PyCFunction)dmtx_encode_image,
+     METH_VARARGS | METH_KEYWORDS,
+     "Encodes data and returns (width, height, pixels) in 'RGB', 'L' or '1' mode." },
+   { "encode_vector",
+     (PyCFunction)dmtx_encode_vector,
+     METH_VARARGS | METH_KEYWORDS,
+     "Encodes data and returns it as an SVG, PDF or EPS document." },
+   { "encode_label",
+     (PyCFunction)dmtx_encode_label,
+     METH_VARARGS | METH_KEYWORDS,
+     "Encodes data and returns it as a ZPL or EPL printer label." },
+   { "encode_sheet",
+     (PyCFunction)dmtx_encode_sheet,
+     METH_VARARGS | METH_KEYWORDS,
+     "Encodes many payloads onto one PGM, PBM, SVG, PDF or EPS page." },
    { "decode",
      (PyCFunction)dmtx_decode,
      METH_VARARGS | METH_KEYWORDS,
      "Decodes data from a bitmap stored in a buffer and returns the encoded data." },
+   { "session",
+     (PyCFunction)dmtx_session,
+     METH_NOARGS,
+     "Creates a decoder session that keeps its buffers between decode calls." },
+   { "quality",
+     (PyCFunction)dmtx_quality,
+     METH_VARARGS,
+     "Returns (status, sharpness, edge density) of the last decode in a session." },
+   { "cache",
+     (PyCFunction)dmtx_cache,
+     METH_VARARGS,
+     "Creates a result cache that answers repeated frames without decoding." },
+   { "cache_stats",
+     (PyCFunction)dmtx_cache_stats,
+     METH_VARARGS,
+     "Returns (hits, misses) of a result cache." },
+   { "stats",
+     (PyCFunction)dmtx_stats,
+     METH_NOARGS,
+     "Returns the decode phase timers and counters of this thread, or None if not built in." },
+   { "reset_stats",
+     (PyCFunction)dmtx_reset_stats,
+     METH_NOARGS,
+     "Clears the decode phase timers and counters of this thread." },
+   { "trace",
+     (PyCFunction)dmtx_trace,
+     METH_VARARGS,
+     "Creates a Chrome trace file receiving the spans of every decode given it." },
    { NULL,
      NULL,
      0,
@@ -74,8 +130,8 @@ dmtx_encode(PyObject *self, PyObject *arglist, PyObject *kwargs)
    PyObject *args;
 
    DmtxEncode *enc;
-   int row, col;
-   int rgb[3];
+   int row, col, width, height;
+   unsigned char *rgb;
    static char *kwlist[] = { "data", "module_size", "margin_size",
                              "scheme", "shape", "plotter", "start",
                              "finish", "context", NULL };
@@ -109,9 +165,6 @@ dmtx_encode(PyObject *self, PyObject *arglist, PyObject *kwargs)
    if(enc == NULL)
       return NULL;
 
-   dmtxEncodeSetProp(enc, DmtxPropPixelPacking, DmtxPack24bppRGB);
-   dmtxEncodeSetProp(enc, DmtxPropImageFlip, DmtxFlipNone);
-
    if(scheme != DmtxUndefined)
       dmtxEncodeSetProp(enc, DmtxPropScheme, scheme);
 
@@ -124,20 +177,34 @@ dmtx_encode(PyObject *self, PyObject *arglist, PyObject *kwargs)
    if(module_size != DmtxUndefined)
       dmtxEncodeSetProp(enc, DmtxPropModuleSize, module_size);
 
-   dmtxEncodeDataMatrix(enc, data_size, (unsigned char *)data);
+   /* Encoded at module size 1; each row is expanded just before plotting */
+   if(dmtxwEncodeDataMatrix(enc, data_size, data) == DmtxFail ||
+         dmtxwEncodeGetSize(enc, &width, &height) == DmtxFail) {
+      dmtxEncodeDestroy(&enc);
+      Py_DECREF(context);
+      PyErr_SetString(PyExc_ValueError, "unable to encode data with these options");
+      return NULL;
+   }
+
+   rgb = (unsigned char *)malloc((size_t)width * 3);
+   if(rgb == NULL) {
+      dmtxEncodeDestroy(&enc);
+      Py_DECREF(context);
+      return PyErr_NoMemory();
+   }
 
    if((start_cb != NULL) && PyCallable_Check(start_cb)) {
-      args = Py_BuildValue("(iiO)", enc->image->width, enc->image->height, context);
+      args = Py_BuildValue("(iiO)", width, height, context);
       (void)PyEval_CallObject(start_cb, args);
       Py_DECREF(args);
    }
 
-   for(row = 0; row < enc->image->height; row++) {
-      for(col = 0; col < enc->image->width; col++) {
-         dmtxImageGetPixelValue(enc->image, col, row, 0, &rgb[0]);
-         dmtxImageGetPixelValue(enc->image, col, row, 1, &rgb[1]);
-         dmtxImageGetPixelValue(enc->image, col, row, 2, &rgb[2]);
-         args = Py_BuildValue("(ii(iii)O)", col, row, rgb[0], rgb[1], rgb[2], context);
+   /* Plotter rows count from the bottom, as libdmtx's image did */
+   for(row = 0; row < height; row++) {
+      dmtxwEncodeExpandRows(enc, height - 1 - row, 1, rgb, 0, DmtxwFormatRGB24);
+      for(col = 0; col < width; col++) {
+         args = Py_BuildValue("(ii(iii)O)", col, row, rgb[col * 3],
+               rgb[col * 3 + 1], rgb[col * 3 + 2], context);
          (void)PyEval_CallObject(plotter, args);
          Py_DECREF(args);
       }
@@ -149,157 +216,580 @@ dmtx_encode(PyObject *self, PyObject *arglist, PyObject *kwargs)
       Py_DECREF(args);
    }
 
+   free(rgb);
    dmtxEncodeDestroy(&enc);
    Py_DECREF(context);
 
    return Py_None;
 }
 
+/* Same symbol as encode(), drawn natively into one string of raw pixels
+ * in PIL's 'RGB', 'L' or '1' (rawmode '1;I') layout, top row first */
 static PyObject *
-dmtx_decode(PyObject *self, PyObject *arglist, PyObject *kwargs)
+dmtx_encode_image(PyObject *self, PyObject *arglist, PyObject *kwargs)
 {
-   int count=0;
-   int found=0;
-   int width;
-   int height;
-   int gap_size = DmtxUndefined;
-   int max_count = DmtxUndefined;
-   int timeout = DmtxUndefined;
+   const unsigned char *data;
+   int data_size = 0;
+   int module_size = DmtxUndefined;
+   int margin_size = DmtxUndefined;
+   int scheme = DmtxUndefined;
    int shape = DmtxUndefined;
-   int deviation = DmtxUndefined;
-   int threshold = DmtxUndefined;
-   int shrink = 1;
-   int corrections = DmtxUndefined;
-   int min_edge = DmtxUndefined;
-   int max_edge = DmtxUndefined;
+   const char *mode = "RGB";
+   int format, width, height, rowBytes;
 
-   PyObject *dataBuf = NULL;
-   Py_ssize_t dataLen;
-   PyObject *context = Py_None;
-   PyObject *output = PyList_New(0);
-
-   DmtxTime dmtx_timeout;
-   DmtxImage *img;
-   DmtxDecode *dec;
-   DmtxRegion *reg;
-   DmtxMessage *msg;
-   DmtxVector2 p00, p10, p11, p01;
-   const char *pxl; /* Input image buffer */
+   DmtxEncode *enc;
+   PyObject *pixels;
+   PyObject *output;
+   static char *kwlist[] = { "data", "module_size", "margin_size",
+                             "scheme", "shape", "mode", NULL };
 
-   static char *kwlist[] = { "width", "height", "data", "gap_size",
-                             "max_count", "context", "timeout", "shape",
-                             "deviation", "threshold", "shrink", "corrections",
-                             "min_edge", "max_edge", NULL };
+   if(!PyArg_ParseTupleAndKeywords(arglist, kwargs, "s#|iiiis", kwlist, &data,
+         &data_size, &module_size, &margin_size, &scheme, &shape, &mode))
+      return NULL;
 
-   /* Parse out the options which are applicable */
-   PyObject *filtered_kwargs;
-   filtered_kwargs = PyDict_New();
-   count = 3; /* Skip the first 3 keywords as they are sent in arglist */
-   while(kwlist[count]){
-      if(PyDict_GetItemString(kwargs, kwlist[count])) {
-         PyDict_SetItemString(filtered_kwargs, kwlist[count],
-               PyDict_GetItemString(kwargs, kwlist[count]));
-      }
-      count++;
+   if(strcmp(mode, "RGB") == 0)
+      format = DmtxwFormatRGB24;
+   else if(strcmp(mode, "L") == 0)
+      format = DmtxwFormatGray8;
+   else if(strcmp(mode, "1") == 0)
+      format = DmtxwFormatMono1;
+   else {
+      PyErr_SetString(PyExc_ValueError, "mode must be 'RGB', 'L' or '1'");
+      return NULL;
    }
 
-   /* Get parameters from Python for libdmtx */
-   if(!PyArg_ParseTupleAndKeywords(arglist, filtered_kwargs, "iiOi|iOiiiiiiii",
-         kwlist, &width, &height, &dataBuf, &gap_size, &max_count, &context,
-         &timeout, &shape, &deviation, &threshold, &shrink, &corrections,
-         &min_edge, &max_edge)) {
-      PyErr_SetString(PyExc_TypeError, "decode takes at least 3 arguments");
+   enc = dmtxEncodeCreate();
+   if(enc == NULL)
+      return PyErr_NoMemory();
+
+   if(scheme != DmtxUndefined)
+      dmtxEncodeSetProp(enc, DmtxPropScheme, scheme);
+
+   if(shape != DmtxUndefined)
+      dmtxEncodeSetProp(enc, DmtxPropSizeRequest, shape);
+
+   if(margin_size != DmtxUndefined)
+      dmtxEncodeSetProp(enc, DmtxPropMarginSize, margin_size);
+
+   if(module_size != DmtxUndefined)
+      dmtxEncodeSetProp(enc, DmtxPropModuleSize, module_size);
+
+   if(dmtxwEncodeDataMatrix(enc, data_size, data) == DmtxFail ||
+         dmtxwEncodeGetSize(enc, &width, &height) == DmtxFail) {
+      dmtxEncodeDestroy(&enc);
+      PyErr_SetString(PyExc_ValueError, "unable to encode data with these options");
       return NULL;
    }
 
-   Py_INCREF(context);
+   rowBytes = (format == DmtxwFormatMono1) ? (width + 7) / 8 :
+         width * dmtxwFormatGetBytesPerPixel(format);
 
-   /* Reset timeout for each new page */
-   if(timeout != DmtxUndefined)
-      dmtx_timeout = dmtxTimeAdd(dmtxTimeNow(), timeout);
+   /* The pixels are expanded straight into the new string */
+   pixels = PyString_FromStringAndSize(NULL, (Py_ssize_t)rowBytes * height);
+   if(pixels == NULL) {
+      dmtxEncodeDestroy(&enc);
+      return NULL;
+   }
 
-   if(dataBuf == NULL) {
-      PyErr_SetString(PyExc_TypeError, "Interleaved bitmapped data in buffer missing");
+   dmtxwEncodeExpand(enc, (unsigned char *)PyString_AS_STRING(pixels), rowBytes, format);
+   dmtxEncodeDestroy(&enc);
+
+   output = Py_BuildValue("(iiO)", width, height, pixels);
+   Py_DECREF(pixels);
+
+   return output;
+}
+
+/* Same symbol as encode(), described as rectangles instead of pixels */
+static PyObject *
+dmtx_encode_vector(PyObject *self, PyObject *arglist, PyObject *kwargs)
+{
+   const unsigned char *data;
+   int data_size = 0;
+   const char *format_name = "svg";
+   double module_size = 1.0;
+   int margin = DmtxUndefined;
+   int scheme = DmtxUndefined;
+   int shape = DmtxUndefined;
+   int format;
+
+   DmtxEncode *enc;
+   DmtxwBuffer buffer;
+   PyObject *output;
+   static char *kwlist[] = { "data", "format", "module_size", "margin",
+                             "scheme", "shape", NULL };
+
+   if(!PyArg_ParseTupleAndKeywords(arglist, kwargs, "s#|sdiii", kwlist, &data,
+         &data_size, &format_name, &module_size, &margin, &scheme, &shape))
+      return NULL;
+
+   format = dmtxwVectorByName(format_name);
+   if(format == DmtxUndefined) {
+      PyErr_SetString(PyExc_ValueError, "format must be 'svg', 'pdf' or 'eps'");
+      return NULL;
+   }
+
+   enc = dmtxEncodeCreate();
+   if(enc == NULL)
+      return PyErr_NoMemory();
+
+   if(scheme != DmtxUndefined)
+      dmtxEncodeSetProp(enc, DmtxPropScheme, scheme);
+
+   if(shape != DmtxUndefined)
+      dmtxEncodeSetProp(enc, DmtxPropSizeRequest, shape);
+
+   memset(&buffer, 0x00, sizeof(DmtxwBuffer));
+   if(dmtxwEncodeDataMatrix(enc, data_size, data) == DmtxFail ||
+         dmtxwEncodeVector(enc, format, module_size, margin, &buffer) == DmtxFail) {
+      dmtxEncodeDestroy(&enc);
+      dmtxwBufferFree(&buffer);
+      PyErr_SetString(PyExc_ValueError, "unable to encode data with these options");
       return NULL;
    }
 
-   PyObject_AsCharBuffer(dataBuf, &pxl, &dataLen);
+   output = PyString_FromStringAndSize((const char *)buffer.data, (Py_ssize_t)buffer.length);
+
+   dmtxEncodeDestroy(&enc);
+   dmtxwBufferFree(&buffer);
+
+   return output;
+}
+
+/* Same symbol as encode(), as a label to send to a thermal printer */
+static PyObject *
+dmtx_encode_label(PyObject *self, PyObject *arglist, PyObject *kwargs)
+{
+   const unsigned char *data;
+   int data_size = 0;
+   const char *mode_name = "zpl";
+   int dots = 4;
+   int margin = DmtxUndefined;
+   int scheme = DmtxUndefined;
+   int shape = DmtxUndefined;
+   int mode;
+
+   DmtxEncode *enc;
+   DmtxwBuffer buffer;
+   PyObject *output;
+   static char *kwlist[] = { "data", "mode", "dots", "margin",
+                             "scheme", "shape", NULL };
 
-   img = dmtxImageCreate((unsigned char *)pxl, width, height, DmtxPack24bppRGB);
-   if(img == NULL)
+   if(!PyArg_ParseTupleAndKeywords(arglist, kwargs, "s#|siiii", kwlist, &data,
+         &data_size, &mode_name, &dots, &margin, &scheme, &shape))
       return NULL;
 
-   dec = dmtxDecodeCreate(img, shrink);
-   if(dec == NULL) {
-      dmtxImageDestroy(&img);
+   mode = dmtxwPrinterByName(mode_name);
+   if(mode == DmtxUndefined) {
+      PyErr_SetString(PyExc_ValueError, "mode must be 'zpl', 'zpl-graphic' or 'epl-graphic'");
       return NULL;
    }
 
-   if(gap_size != DmtxUndefined)
-      dmtxDecodeSetProp(dec, DmtxPropScanGap, gap_size);
+   enc = dmtxEncodeCreate();
+   if(enc == NULL)
+      return PyErr_NoMemory();
+
+   if(scheme != DmtxUndefined)
+      dmtxEncodeSetProp(enc, DmtxPropScheme, scheme);
 
    if(shape != DmtxUndefined)
-      dmtxDecodeSetProp(dec, DmtxPropSymbolSize, shape);
+      dmtxEncodeSetProp(enc, DmtxPropSizeRequest, shape);
+
+   memset(&buffer, 0x00, sizeof(DmtxwBuffer));
+   if(dmtxwEncodeDataMatrix(enc, data_size, data) == DmtxFail ||
+         dmtxwEncodePrinter(enc, data, data_size, mode, dots, margin, &buffer) == DmtxFail) {
+      dmtxEncodeDestroy(&enc);
+      dmtxwBufferFree(&buffer);
+      PyErr_SetString(PyExc_ValueError, "unable to encode data with these options");
+      return NULL;
+   }
 
-   if(deviation != DmtxUndefined)
-      dmtxDecodeSetProp(dec, DmtxPropSquareDevn, deviation);
+   output = PyString_FromStringAndSize((const char *)buffer.data, (Py_ssize_t)buffer.length);
 
-   if(threshold != DmtxUndefined)
-      dmtxDecodeSetProp(dec, DmtxPropEdgeThresh, threshold);
+   dmtxEncodeDestroy(&enc);
+   dmtxwBufferFree(&buffer);
 
-   if(min_edge != DmtxUndefined)
-      dmtxDecodeSetProp(dec, DmtxPropEdgeMin, min_edge);
+   return output;
+}
 
-   if(max_edge != DmtxUndefined)
-      dmtxDecodeSetProp(dec, DmtxPropEdgeMax, max_edge);
+/* Many symbols on one page: labels is a sequence of (data, x, y) tuples,
+ * or of plain strings placed columns to a row when columns is given */
+static PyObject *
+dmtx_encode_sheet(PyObject *self, PyObject *arglist, PyObject *kwargs)
+{
+   PyObject *labelList, *sequence, *item;
+   const char *format = "pgm";
+   int columns = 0, x = 0, y = 0, pitch_x = 0, pitch_y = 0;
+   int i, count, drawn, data_size;
+   char *data;
+   Py_ssize_t string_size;
+
+   DmtxwSheetSpec spec;
+   DmtxwSheetLabel *labels;
+   DmtxwBuffer buffer;
+   PyObject *output = NULL;
+   static char *kwlist[] = { "labels", "width", "height", "format", "module_size",
+                             "margin", "columns", "x", "y", "pitch_x", "pitch_y",
+                             "threads", "scheme", "shape", NULL };
+
+   dmtxwSheetSpecInit(&spec);
+
+   if(!PyArg_ParseTupleAndKeywords(arglist, kwargs, "Oii|sdiiiiiiiii", kwlist,
+         &labelList, &spec.width, &spec.height, &format, &spec.moduleSize,
+         &spec.margin, &columns, &x, &y, &pitch_x, &pitch_y, &spec.threads,
+         &spec.scheme, &spec.sizeRequest))
+      return NULL;
 
-   for(count=1; ;count++) {
-      Py_BEGIN_ALLOW_THREADS
-      if(timeout == DmtxUndefined)
-         reg = dmtxRegionFindNext(dec, NULL);
-      else
-         reg = dmtxRegionFindNext(dec, &dmtx_timeout);
-      Py_END_ALLOW_THREADS
+   sequence = PySequence_Fast(labelList, "labels must be a sequence");
+   if(sequence == NULL)
+      return NULL;
 
-      /* Finished file or ran out of time before finding another region */
-      if(reg == NULL)
-         break;
+   count = (int)PySequence_Fast_GET_SIZE(sequence);
+   labels = (DmtxwSheetLabel *)calloc((size_t)count + 1, sizeof(DmtxwSheetLabel));
+   if(labels == NULL) {
+      Py_DECREF(sequence);
+      return PyErr_NoMemory();
+   }
 
-      msg = dmtxDecodeMatrixRegion(dec, reg, corrections);
-      if(msg != NULL) {
-         p00.X = p00.Y = p10.Y = p01.X = 0.0;
-         p10.X = p01.Y = p11.X = p11.Y = 1.0;
-         dmtxMatrix3VMultiplyBy(&p00, reg->fit2raw);
-         dmtxMatrix3VMultiplyBy(&p10, reg->fit2raw);
-         dmtxMatrix3VMultiplyBy(&p11, reg->fit2raw);
-         dmtxMatrix3VMultiplyBy(&p01, reg->fit2raw);
-
-         PyList_Append(output, Py_BuildValue("s#((ii)(ii)(ii)(ii))", msg->output, msg->outputIdx,
-               (int)((shrink * p00.X) + 0.5), height - 1 - (int)((shrink * p00.Y) + 0.5),
-               (int)((shrink * p10.X) + 0.5), height - 1 - (int)((shrink * p10.Y) + 0.5),
-               (int)((shrink * p11.X) + 0.5), height - 1 - (int)((shrink * p11.Y) + 0.5),
-               (int)((shrink * p01.X) + 0.5), height - 1 - (int)((shrink * p01.Y) + 0.5)));
-
-         Py_INCREF(output);
-         dmtxMessageDestroy(&msg);
-         found++;
+   for(i = 0; i < count; i++) {
+      item = PySequence_Fast_GET_ITEM(sequence, i);
+      if(columns > 0) {
+         if(PyString_AsStringAndSize(item, &data, &string_size) == -1)
+            break;
+         data_size = (int)string_size;
       }
+      else if(!PyArg_ParseTuple(item, "s#ii", &data, &data_size, &labels[i].x,
+            &labels[i].y)) {
+         break;
+      }
+      labels[i].data = (unsigned char *)data;
+      labels[i].dataSize = data_size;
+   }
+
+   if(i == count) {
+      if(columns > 0)
+         dmtxwSheetGrid(labels, count, columns, x, y, pitch_x, pitch_y);
 
-      dmtxRegionDestroy(&reg);
+      memset(&buffer, 0x00, sizeof(DmtxwBuffer));
+      drawn = dmtxwSheetWrite(&spec, labels, count, format, &buffer);
+      if(drawn < 0)
+         PyErr_SetString(PyExc_ValueError, "invalid sheet options or format");
+      else
+         output = PyString_FromStringAndSize((const char *)buffer.data,
+               (Py_ssize_t)buffer.length);
+      dmtxwBufferFree(&buffer);
+   }
+
+   free(labels);
+   Py_DECREF(sequence);
+
+   return output;
+}
+
+/* Release the libdmtxw session owned by a DataMatrix object */
+static void
+dmtx_session_free(void *ptr)
+{
+   DmtxwSession *session = (DmtxwSession *)ptr;
+
+   dmtxwSessionDestroy(&session);
+}
+
+static PyObject *
+dmtx_session(PyObject *self, PyObject *arglist)
+{
+   DmtxwSession *session;
+
+   session = dmtxwSessionCreate();
+   if(session == NULL)
+      return PyErr_NoMemory();
+
+   return PyCObject_FromVoidPtr(session, dmtx_session_free);
+}
+
+/* Why the last decode of a session stopped, and the quality metrics of its
+ * frame, so callers can tune min_sharpness and min_edge_density */
+static PyObject *
+dmtx_quality(PyObject *self, PyObject *arglist)
+{
+   PyObject *sessionObj;
+   DmtxwSession *session;
 
-      /* Stop if we've reached maximium count */
-      if(max_count != DmtxUndefined)
-         if(found >= max_count) break;
+   if(!PyArg_ParseTuple(arglist, "O", &sessionObj))
+      return NULL;
+
+   if(!PyCObject_Check(sessionObj)) {
+      PyErr_SetString(PyExc_TypeError, "quality takes a decoder session");
+      return NULL;
    }
 
-   dmtxDecodeDestroy(&dec);
-   dmtxImageDestroy(&img);
-   Py_DECREF(context);
-   if(output == NULL) {
+   session = (DmtxwSession *)PyCObject_AsVoidPtr(sessionObj);
+
+   return Py_BuildValue("(iii)", (int)session->status, session->sharpness,
+         session->edgeDensity);
+}
+
+/* Release a result cache owned by a DataMatrix object */
+static void
+dmtx_cache_free(void *ptr)
+{
+   DmtxwCache *cache = (DmtxwCache *)ptr;
+
+   dmtxwCacheDestroy(&cache);
+}
+
+static PyObject *
+dmtx_cache(PyObject *self, PyObject *arglist)
+{
+   int entries;
+   int ttl = 1000;
+   int tolerance = DmtxUndefined;
+   DmtxwCache *cache;
+
+   if(!PyArg_ParseTuple(arglist, "i|ii", &entries, &ttl, &tolerance))
+      return NULL;
+
+   cache = dmtxwCacheCreate(entries, ttl, tolerance);
+   if(cache == NULL) {
+      PyErr_SetString(PyExc_ValueError, "invalid cache size, ttl or tolerance");
+      return NULL;
+   }
+
+   return PyCObject_FromVoidPtr(cache, dmtx_cache_free);
+}
+
+static PyObject *
+dmtx_cache_stats(PyObject *self, PyObject *arglist)
+{
+   PyObject *cacheObj;
+   long hits, misses;
+
+   if(!PyArg_ParseTuple(arglist, "O", &cacheObj))
+      return NULL;
+
+   if(!PyCObject_Check(cacheObj)) {
+      PyErr_SetString(PyExc_TypeError, "cache_stats takes a result cache");
+      return NULL;
+   }
+
+   dmtxwCacheGetStats((DmtxwCache *)PyCObject_AsVoidPtr(cacheObj), &hits, &misses);
+
+   return Py_BuildValue("(ll)", hits, misses);
+}
+
+/* Decode phase timers and counters of the calling thread as a dict */
+static PyObject *
+dmtx_stats(PyObject *self, PyObject *args)
+{
+   DmtxwStats stats;
+   PyObject *output;
+   PyObject *value;
+   const char *name;
+   int i;
+
+   if(dmtxwStatsGet(&stats) == DmtxFail) {
       Py_INCREF(Py_None);
       return Py_None;
    }
 
+   output = PyDict_New();
+
+   for(i = 0; output != NULL && (name = dmtxwStatsName(i)) != NULL; i++) {
+      value = (strstr(name, "_ms") != NULL) ?
+            PyFloat_FromDouble(dmtxwStatsValue(&stats, i)) :
+            PyLong_FromDouble(dmtxwStatsValue(&stats, i));
+      if(value == NULL || PyDict_SetItemString(output, name, value) != 0) {
+         Py_XDECREF(value);
+         Py_DECREF(output);
+         return NULL;
+      }
+      Py_DECREF(value);
+   }
+
+   return output;
+}
+
+static PyObject *
+dmtx_reset_stats(PyObject *self, PyObject *args)
+{
+   dmtxwStatsReset();
+
+   Py_INCREF(Py_None);
+   return Py_None;
+}
+
+/* Finish the trace file owned by a DataMatrix object */
+static void
+dmtx_trace_free(void *ptr)
+{
+   DmtxwTraceJson *writer = (DmtxwTraceJson *)ptr;
+
+   dmtxwTraceJsonClose(&writer);
+}
+
+static PyObject *
+dmtx_trace(PyObject *self, PyObject *arglist)
+{
+   const char *path;
+   double minMsec = 0.0;
+   DmtxwTraceJson *writer;
+
+   if(!PyArg_ParseTuple(arglist, "s|d", &path, &minMsec))
+      return NULL;
+
+   writer = dmtxwTraceJsonOpen(path, minMsec);
+   if(writer == NULL)
+      return PyErr_SetFromErrnoWithFilename(PyExc_IOError, (char *)path);
+
+   return PyCObject_FromVoidPtr(writer, dmtx_trace_free);
+}
+
+static PyObject *
+dmtx_decode(PyObject *self, PyObject *arglist, PyObject *kwargs)
+{
+   int i;
+   int prop;
+   int width;
+   int height;
+   size_t length;
+   Py_ssize_t pos = 0;
+   Py_ssize_t dataLen;
+   DmtxPassFail decoded;
+   DmtxTime deadline;
+   double timer;
+
+   PyObject *dataBuf = NULL;
+   PyObject *key, *value;
+   PyObject *sessionObj = NULL;
+   PyObject *cacheObj = NULL;
+   PyObject *traceObj = NULL;
+   PyObject *deadlineObj = NULL;
+   PyObject *output;
+   PyObject *item;
+
+   DmtxwSession *session;
+   const DmtxwResult *result;
+   const unsigned char *payload;
+   const char *pxl; /* Input image buffer */
+
+   if(!PyArg_ParseTuple(arglist, "iiO", &width, &height, &dataBuf)) {
+      PyErr_SetString(PyExc_TypeError, "decode takes at least 3 arguments");
+      return NULL;
+   }
+
+   if(PyObject_AsCharBuffer(dataBuf, &pxl, &dataLen) != 0) {
+      PyErr_SetString(PyExc_TypeError, "Interleaved bitmapped data in buffer missing");
+      return NULL;
+   }
+
+   if(dataLen < (Py_ssize_t)width * height * 3) {
+      PyErr_SetString(PyExc_ValueError, "buffer is smaller than width * height * 3");
+      return NULL;
+   }
+
+   if(kwargs != NULL) {
+      sessionObj = PyDict_GetItemString(kwargs, "session");
+      cacheObj = PyDict_GetItemString(kwargs, "cache");
+      traceObj = PyDict_GetItemString(kwargs, "trace");
+      deadlineObj = PyDict_GetItemString(kwargs, "deadline_ms");
+   }
+
+   /* The budget counts from the call, before any conversion work */
+   if(deadlineObj != NULL && PyInt_Check(deadlineObj))
+      deadline = dmtxTimeAdd(dmtxTimeNow(), PyInt_AsLong(deadlineObj));
+   else
+      deadlineObj = NULL;
+
+   /* Reuse the caller's session when given one, so its result and payload
+    * storage survive from page to page */
+   DMTXW_STATS_START(timer);
+   if(sessionObj != NULL && PyCObject_Check(sessionObj)) {
+      session = (DmtxwSession *)PyCObject_AsVoidPtr(sessionObj);
+      dmtxwSessionResetProps(session);
+   }
+   else {
+      sessionObj = NULL;
+      session = dmtxwSessionCreate();
+      if(session == NULL)
+         return PyErr_NoMemory();
+      DMTXW_STATS_COUNT(DmtxwCounterAllocations, 1);
+   }
+
+   /* Every option libdmtxw knows by name is applied, and a bad value for
+    * one is an error; others (module_size, scheme, context, ...) belong to
+    * encode and are ignored here */
+   while(kwargs != NULL && PyDict_Next(kwargs, &pos, &key, &value)) {
+      if(!PyString_Check(key))
+         continue;
+      prop = dmtxwPropByName(PyString_AsString(key));
+      if(prop == DmtxUndefined)
+         continue;
+      if(!PyInt_Check(value) ||
+            dmtxwSessionSetProp(session, prop, (int)PyInt_AsLong(value)) == DmtxFail) {
+         if(sessionObj == NULL)
+            dmtxwSessionDestroy(&session);
+         PyErr_Format(PyExc_ValueError, "invalid value for decode option '%s'",
+               PyString_AsString(key));
+         return NULL;
+      }
+   }
+
+   /* The cache object is kept alive by the caller for the whole call */
+   dmtxwSessionSetCache(session, (cacheObj != NULL && PyCObject_Check(cacheObj)) ?
+         (DmtxwCache *)PyCObject_AsVoidPtr(cacheObj) : NULL);
+
+   /* So is the trace file */
+   if(traceObj != NULL && PyCObject_Check(traceObj))
+      dmtxwSessionSetTrace(session, dmtxwTraceJsonWrite, PyCObject_AsVoidPtr(traceObj));
+   else
+      dmtxwSessionSetTrace(session, NULL, NULL);
+   DMTXW_STATS_STOP(timer, DmtxwPhaseSetup);
+
+   Py_BEGIN_ALLOW_THREADS
+   decoded = dmtxwSessionDecodeBefore(session, (unsigned char *)pxl, width, height,
+         0, DmtxwFormatRGB24, (deadlineObj != NULL) ? &deadline : NULL);
+   Py_END_ALLOW_THREADS
+
+   if(decoded == DmtxFail) {
+      if(sessionObj == NULL)
+         dmtxwSessionDestroy(&session);
+      PyErr_SetString(PyExc_RuntimeError, "unable to decode image");
+      return NULL;
+   }
+
+   dmtxwSessionTrace(session, DmtxwSpanMarshal, 1, DmtxwOutcomeNone);
+   DMTXW_STATS_START(timer);
+   output = PyList_New(0);
+
+   for(i = 0; output != NULL && i < dmtxwSessionGetResultCount(session); i++) {
+      result = dmtxwSessionGetResult(session, i);
+      payload = dmtxwSessionGetPayload(session, i, &length);
+
+      item = Py_BuildValue("s#((ii)(ii)(ii)(ii))", payload, (int)length,
+            result->corner[0].X, result->corner[0].Y,
+            result->corner[1].X, result->corner[1].Y,
+            result->corner[2].X, result->corner[2].Y,
+            result->corner[3].X, result->corner[3].Y);
+
+      if(item == NULL || PyList_Append(output, item) != 0) {
+         Py_XDECREF(item);
+         Py_DECREF(output);
+         output = NULL;
+         break;
+      }
+      Py_DECREF(item);
+   }
+
+   DMTXW_STATS_STOP(timer, DmtxwPhaseMarshal);
+   DMTXW_STATS_COUNT(DmtxwCounterAllocations, (output != NULL) ?
+         PyList_GET_SIZE(output) + 1 : 0);
+   dmtxwSessionTrace(session, DmtxwSpanMarshal, 0,
+         (output != NULL) ? DmtxwOutcomeFound : DmtxwOutcomeError);
+   dmtxwSessionSetTrace(session, NULL, NULL);
+
+   if(sessionObj == NULL)
+      dmtxwSessionDestroy(&session);
+
    return output;
 }
 
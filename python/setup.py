@@ -19,12 +19,20 @@
 
 # $Id$
 
+import os
 from distutils.core import setup, Extension
 
+# DMTXW_STATS=1 times the wrapper's own decode phases as well; build
+# libdmtxw with ./configure --enable-stats to match
+macros = []
+if os.environ.get( 'DMTXW_STATS' ):
+	macros.append( ('DMTXW_STATS', None) )
+
 mod = Extension( '_pydmtx',
-                 include_dirs = ['/usr/local/include'],
-                 library_dirs = ['/usr/local/lib'],
-                 libraries = ['dmtx'],
+                 include_dirs = ['/usr/local/include', '../dmtxw'],
+                 library_dirs = ['/usr/local/lib', '../.libs'],
+                 libraries = ['dmtxw', 'dmtx'],
+                 define_macros = macros,
                  sources = ['pydmtxmodule.c'] )
 
 setup( name = 'pydmtx',
@@ -24,59 +24,173 @@ Contact: r.goyet@gmail.com
 
 #include <ruby.h>
 #include <dmtx.h>
+#include <dmtxw.h>
+
+static void rdmtx_free(void *session) {
+    DmtxwCache *cache = ((DmtxwSession *)session)->cache;
+
+    dmtxwSessionDestroy((DmtxwSession **)&session);
+    if (cache != NULL)
+        dmtxwCacheDestroy(&cache);
+}
+
+/* Every Rdmtx object owns one decoder session, so result and payload
+ * storage is reused from one decode call to the next */
+static VALUE rdmtx_alloc(VALUE klass) {
+    DmtxwSession *session = dmtxwSessionCreate();
+
+    if (session == NULL)
+        rb_raise(rb_eNoMemError, "unable to create decoder session");
+
+    return Data_Wrap_Struct(klass, NULL, rdmtx_free, session);
+}
 
 static VALUE rdmtx_init(VALUE self) {
     return self;
 }
 
-static VALUE rdmtx_decode(VALUE self, VALUE image /* Image from RMagick (Magick::Image) */, VALUE timeout /* Timeout in msec */) {
+static VALUE rdmtx_decode(int argc, VALUE *argv, VALUE self) {
+
+    VALUE image;   /* Image from RMagick (Magick::Image) */
+    VALUE timeout; /* Timeout in msec, or a Time to be done by */
+    VALUE luma;    /* Optional: decode luminance at 1/1, 1/2 or 1/4 size */
+    rb_scan_args(argc, argv, "21", &image, &timeout, &luma);
+
+    DmtxwSession *session;
+    Data_Get_Struct(self, DmtxwSession, session);
+
+    double timer;
+    DMTXW_STATS_START(timer);
+
+    /* A deadline also covers exporting the pixels below */
+    DmtxTime deadline;
+    int hasDeadline = RTEST(rb_obj_is_kind_of(timeout, rb_cTime));
+    if (hasDeadline) {
+        double left = NUM2DBL(rb_funcall(timeout, rb_intern("-"), 1,
+                rb_funcall(rb_cTime, rb_intern("now"), 0)));
+        deadline = dmtxTimeAdd(dmtxTimeNow(), (left > 0.0) ? (long)(left * 1000.0) : 0);
+    }
+
+    if (dmtxwSessionSetProp(session, DmtxwPropLuma, NIL_P(luma) ? 0 : NUM2INT(luma)) == DmtxFail)
+        rb_raise(rb_eArgError, "luma must be 0, 1, 2 or 4");
+
+    DMTXW_STATS_STOP(timer, DmtxwPhaseSetup);
+    DMTXW_STATS_START(timer);
 
     VALUE rawImageString = rb_funcall(image, rb_intern("export_pixels_to_str"), 0);
 
     VALUE safeImageString = StringValue(rawImageString);
 
+    DMTXW_STATS_STOP(timer, DmtxwPhaseConvert);
+    DMTXW_STATS_COUNT(DmtxwCounterBytesConverted, RSTRING_LEN(safeImageString));
+    DMTXW_STATS_COUNT(DmtxwCounterAllocations, 1);
+
     char * imageBuffer = RSTRING_PTR(safeImageString);
 
     int width = NUM2INT(rb_funcall(image, rb_intern("columns"), 0));
     int height = NUM2INT(rb_funcall(image, rb_intern("rows"), 0));
 
-    DmtxImage *dmtxImage = dmtxImageCreate((unsigned char *)imageBuffer, width,
-          height, DmtxPack24bppRGB);
+    if (RSTRING_LEN(safeImageString) < (long)width * height * 3)
+        rb_raise(rb_eArgError, "image must export 8 bit RGB pixels");
 
     VALUE results = rb_ary_new();
 
-    /* Initialize decode struct for newly loaded image */
-    DmtxDecode * decode = dmtxDecodeCreate(dmtxImage, 1);
+    /* A timeout of 0 means search the whole image */
+    int intTimeout = hasDeadline ? 0 : NUM2INT(timeout);
+    dmtxwSessionSetProp(session, DmtxwPropTimeout, (intTimeout == 0) ? DmtxUndefined : intTimeout);
 
-    DmtxRegion * region;
+    if (dmtxwSessionDecodeBefore(session, (unsigned char *)imageBuffer, width, height,
+            0, DmtxwFormatRGB24, hasDeadline ? &deadline : NULL) == DmtxFail)
+        return results;
 
-    int intTimeout = NUM2INT(timeout);
-    DmtxTime dmtxTimeout = dmtxTimeAdd(dmtxTimeNow(), intTimeout);
+    DMTXW_STATS_START(timer);
 
-    for(;;) {
-        if (intTimeout == 0) {
-            region = dmtxRegionFindNext(decode, NULL);
-        } else {
-            region = dmtxRegionFindNext(decode, &dmtxTimeout);
-        }
+    int i;
+    size_t length;
+    for (i = 0; i < dmtxwSessionGetResultCount(session); i++) {
+        const unsigned char *payload = dmtxwSessionGetPayload(session, i, &length);
+        rb_ary_push(results, rb_str_new((const char *)payload, (long)length));
+    }
 
-        if (region == NULL )
-            break;
+    DMTXW_STATS_STOP(timer, DmtxwPhaseMarshal);
+    DMTXW_STATS_COUNT(DmtxwCounterAllocations, dmtxwSessionGetResultCount(session) + 1);
 
-        DmtxMessage * message = dmtxDecodeMatrixRegion(decode, region, DmtxUndefined);
-        if (message != NULL) {
-            VALUE outputString = rb_str_new2((char *)message->output);
-            rb_ary_push(results, outputString);
-            dmtxMessageDestroy(&message);
-        }
+    return results;
+}
+
+/* Why the last decode stopped: :complete, :max_count, :timeout, ... */
+static VALUE rdmtx_status(VALUE self) {
+
+    static const char *names[] = { "complete", "max_count", "timeout",
+            "cancelled", "error", "blurred", "empty" };
+
+    DmtxwSession *session;
+    Data_Get_Struct(self, DmtxwSession, session);
+
+    if ((int)session->status < 0 || (int)session->status >= (int)(sizeof(names) / sizeof(names[0])))
+        return Qnil;
+
+    return ID2SYM(rb_intern(names[session->status]));
+}
+
+/* Answer frames matching one of the last decoded ones from memory */
+static VALUE rdmtx_enable_cache(int argc, VALUE *argv, VALUE self) {
+
+    VALUE entries; /* Number of frames remembered */
+    VALUE ttl;     /* Optional: msec an entry stays valid (default 1000, at least 1) */
+    rb_scan_args(argc, argv, "11", &entries, &ttl);
+
+    DmtxwSession *session;
+    Data_Get_Struct(self, DmtxwSession, session);
+
+    DmtxwCache *cache = dmtxwCacheCreate(NUM2INT(entries),
+            NIL_P(ttl) ? 1000 : NUM2INT(ttl), DmtxUndefined);
+    if (cache == NULL)
+        rb_raise(rb_eArgError, "invalid cache size or ttl");
+
+    DmtxwCache *previous = session->cache;
+    dmtxwSessionSetCache(session, cache);
+    if (previous != NULL)
+        dmtxwCacheDestroy(&previous);
+
+    return self;
+}
+
+/* [hits, misses] of the result cache */
+static VALUE rdmtx_cache_stats(VALUE self) {
+
+    DmtxwSession *session;
+    Data_Get_Struct(self, DmtxwSession, session);
+
+    long hits = 0, misses = 0;
+    dmtxwCacheGetStats(session->cache, &hits, &misses);
+
+    return rb_ary_new3(2, LONG2NUM(hits), LONG2NUM(misses));
+}
+
+/* Decode phase timers and counters of the calling thread since the last
+ * Rdmtx.reset_stats, as a Hash; nil unless built with DMTXW_STATS */
+static VALUE rdmtx_stats(VALUE klass) {
+
+    DmtxwStats stats;
+    if (dmtxwStatsGet(&stats) == DmtxFail)
+        return Qnil;
 
-        dmtxRegionDestroy(&region);
+    VALUE hash = rb_hash_new();
+    const char *name;
+    int i;
+    for (i = 0; (name = dmtxwStatsName(i)) != NULL; i++) {
+        double value = dmtxwStatsValue(&stats, i);
+        rb_hash_aset(hash, ID2SYM(rb_intern(name)),
+                (strstr(name, "_ms") != NULL) ? rb_float_new(value) : rb_dbl2big(value));
     }
 
-    dmtxDecodeDestroy(&decode);
-    dmtxImageDestroy(&dmtxImage);
+    return hash;
+}
 
-    return results;
+static VALUE rdmtx_reset_stats(VALUE klass) {
+    dmtxwStatsReset();
+    return Qnil;
 }
 
 static VALUE rdmtx_encode(VALUE self, VALUE string) {
@@ -86,19 +200,25 @@ static VALUE rdmtx_encode(VALUE self, VALUE string) {
 
     VALUE safeString = StringValue(string);
 
-    dmtxEncodeSetProp(enc, DmtxPropPixelPacking, DmtxPack24bppRGB);
     dmtxEncodeSetProp(enc, DmtxPropSizeRequest, DmtxSymbolSquareAuto);
 
-    /* Create barcode image */
-    if (dmtxEncodeDataMatrix(enc, RSTRING_LEN(safeString),
+    /* Create barcode at module size 1 */
+    if (dmtxwEncodeDataMatrix(enc, RSTRING_LEN(safeString),
             (unsigned char *)RSTRING_PTR(safeString)) == DmtxFail) {
 //        printf("Fatal error !\n");
         dmtxEncodeDestroy(&enc);
         return Qnil;
     }
 
-    int width = dmtxImageGetProp(enc->image, DmtxPropWidth);
-    int height = dmtxImageGetProp(enc->image, DmtxPropHeight);
+    int width, height;
+    dmtxwEncodeGetSize(enc, &width, &height);
+
+    /* Expand the modules straight into the string handed to RMagick */
+    VALUE pixels = rb_str_new(NULL, 3*width*height);
+    dmtxwEncodeExpand(enc, (unsigned char *)RSTRING_PTR(pixels), 0, DmtxwFormatRGB24);
+
+    /* Clean up */
+    dmtxEncodeDestroy(&enc);
 
     VALUE magickImageClass = rb_path2class("Magick::Image");
     VALUE outputImage = rb_funcall(magickImageClass, rb_intern("new"), 2, INT2NUM(width), INT2NUM(height));
@@ -109,20 +229,160 @@ static VALUE rdmtx_encode(VALUE self, VALUE string) {
                INT2NUM(width),
                INT2NUM(height),
                rb_str_new("RGB", 3),
-               rb_str_new((char *)enc->image->pxl, 3*width*height),
+               pixels,
 //               rb_const_get("Magick" ,rb_intern("CharPixel"))
                rb_eval_string("Magick::CharPixel"));
 
-    /* Clean up */
+    return outputImage;
+}
+
+/* Same symbol as encode, as an SVG, PDF or EPS document drawn with
+ * rectangles: module_size in output units (points for PDF and EPS),
+ * margin in modules */
+static VALUE rdmtx_encode_vector(int argc, VALUE *argv, VALUE self) {
+
+    VALUE string, format, moduleSize, margin;
+    rb_scan_args(argc, argv, "13", &string, &format, &moduleSize, &margin);
+
+    VALUE safeString = StringValue(string);
+    int vectorFormat = dmtxwVectorByName(NIL_P(format) ? "svg" : StringValueCStr(format));
+    if (vectorFormat == DmtxUndefined)
+        rb_raise(rb_eArgError, "format must be \"svg\", \"pdf\" or \"eps\"");
+
+    DmtxEncode * enc = dmtxEncodeCreate();
+    if (enc == NULL)
+        rb_raise(rb_eNoMemError, "unable to create encoder");
+
+    dmtxEncodeSetProp(enc, DmtxPropSizeRequest, DmtxSymbolSquareAuto);
+
+    DmtxwBuffer buffer;
+    memset(&buffer, 0x00, sizeof(DmtxwBuffer));
+    if (dmtxwEncodeDataMatrix(enc, RSTRING_LEN(safeString),
+            (unsigned char *)RSTRING_PTR(safeString)) == DmtxFail ||
+            dmtxwEncodeVector(enc, vectorFormat,
+                NIL_P(moduleSize) ? 1.0 : NUM2DBL(moduleSize),
+                NIL_P(margin) ? DmtxUndefined : NUM2INT(margin), &buffer) == DmtxFail) {
+        dmtxEncodeDestroy(&enc);
+        dmtxwBufferFree(&buffer);
+        return Qnil;
+    }
+
+    VALUE output = rb_str_new((char *)buffer.data, buffer.length);
+
     dmtxEncodeDestroy(&enc);
+    dmtxwBufferFree(&buffer);
 
-    return outputImage;
+    return output;
+}
+
+/* Option of encode_sheet, or nil */
+static VALUE rdmtx_option(VALUE options, const char *name) {
+    return NIL_P(options) ? Qnil : rb_hash_aref(options, ID2SYM(rb_intern(name)));
+}
+
+/* Many symbols on one page, encoded in parallel: labels is an array of
+ * [string, x, y], or of strings laid out :columns to a row. Returns a
+ * PGM or PBM image (:format "pgm" or "pbm") or an SVG, PDF or EPS
+ * document as a String */
+static VALUE rdmtx_encode_sheet(int argc, VALUE *argv, VALUE self) {
+
+    VALUE labelList, width, height, options, value, item, output;
+    rb_scan_args(argc, argv, "31", &labelList, &width, &height, &options);
+
+    Check_Type(labelList, T_ARRAY);
+    if (!NIL_P(options))
+        Check_Type(options, T_HASH);
+
+    DmtxwSheetSpec spec;
+    dmtxwSheetSpecInit(&spec);
+    spec.width = NUM2INT(width);
+    spec.height = NUM2INT(height);
+    spec.sizeRequest = DmtxSymbolSquareAuto;
+    if (!NIL_P(value = rdmtx_option(options, "module_size")))
+        spec.moduleSize = NUM2DBL(value);
+    if (!NIL_P(value = rdmtx_option(options, "margin")))
+        spec.margin = NUM2INT(value);
+    if (!NIL_P(value = rdmtx_option(options, "threads")))
+        spec.threads = NUM2INT(value);
+
+    value = rdmtx_option(options, "format");
+    const char *format = NIL_P(value) ? "pgm" : StringValueCStr(value);
+
+    value = rdmtx_option(options, "columns");
+    int columns = NIL_P(value) ? 0 : NUM2INT(value);
+
+    /* Convert everything before allocating, Ruby may raise */
+    int i, count = (int)RARRAY_LEN(labelList);
+    for (i = 0; i < count; i++) {
+        item = rb_ary_entry(labelList, i);
+        if (columns > 0) {
+            StringValue(item);
+        } else {
+            Check_Type(item, T_ARRAY);
+            if (RARRAY_LEN(item) != 3)
+                rb_raise(rb_eArgError, "labels must be [string, x, y]");
+            StringValue(RARRAY_PTR(item)[0]);
+            NUM2INT(rb_ary_entry(item, 1));
+            NUM2INT(rb_ary_entry(item, 2));
+        }
+    }
+
+    int x = 0, y = 0, pitchX = 0, pitchY = 0;
+    if (columns > 0) {
+        if (!NIL_P(value = rdmtx_option(options, "origin"))) {
+            x = NUM2INT(rb_ary_entry(value, 0));
+            y = NUM2INT(rb_ary_entry(value, 1));
+        }
+        if (!NIL_P(value = rdmtx_option(options, "pitch"))) {
+            pitchX = NUM2INT(rb_ary_entry(value, 0));
+            pitchY = NUM2INT(rb_ary_entry(value, 1));
+        }
+    }
+
+    DmtxwSheetLabel *labels = ALLOC_N(DmtxwSheetLabel, count + 1);
+    memset(labels, 0x00, sizeof(DmtxwSheetLabel) * (count + 1));
+    for (i = 0; i < count; i++) {
+        item = rb_ary_entry(labelList, i);
+        if (columns == 0) {
+            labels[i].x = NUM2INT(rb_ary_entry(item, 1));
+            labels[i].y = NUM2INT(rb_ary_entry(item, 2));
+            item = rb_ary_entry(item, 0);
+        }
+        StringValue(item);
+        labels[i].data = (unsigned char *)RSTRING_PTR(item);
+        labels[i].dataSize = (int)RSTRING_LEN(item);
+    }
+    if (columns > 0)
+        dmtxwSheetGrid(labels, count, columns, x, y, pitchX, pitchY);
+
+    DmtxwBuffer buffer;
+    memset(&buffer, 0x00, sizeof(DmtxwBuffer));
+    int drawn = dmtxwSheetWrite(&spec, labels, count, format, &buffer);
+    xfree(labels);
+
+    if (drawn < 0) {
+        dmtxwBufferFree(&buffer);
+        rb_raise(rb_eArgError, "invalid sheet options or format");
+    }
+
+    output = rb_str_new((char *)buffer.data, buffer.length);
+    dmtxwBufferFree(&buffer);
+
+    return output;
 }
 
 VALUE cRdmtx;
 void Init_Rdmtx() {
     cRdmtx = rb_define_class("Rdmtx", rb_cObject);
+    rb_define_alloc_func(cRdmtx, rdmtx_alloc);
     rb_define_method(cRdmtx, "initialize", rdmtx_init, 0);
-    rb_define_method(cRdmtx, "decode", rdmtx_decode, 2);
+    rb_define_method(cRdmtx, "decode", rdmtx_decode, -1);
+    rb_define_method(cRdmtx, "status", rdmtx_status, 0);
+    rb_define_method(cRdmtx, "enable_cache", rdmtx_enable_cache, -1);
+    rb_define_method(cRdmtx, "cache_stats", rdmtx_cache_stats, 0);
+    rb_define_singleton_method(cRdmtx, "stats", rdmtx_stats, 0);
+    rb_define_singleton_method(cRdmtx, "reset_stats", rdmtx_reset_stats, 0);
     rb_define_method(cRdmtx, "encode", rdmtx_encode, 1);
+    rb_define_method(cRdmtx, "encode_vector", rdmtx_encode_vector, -1);
+    rb_define_method(cRdmtx, "encode_sheet", rdmtx_encode_sheet, -1);
 }
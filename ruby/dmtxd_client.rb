@@ -0,0 +1,104 @@
+# Thin client for dmtxd, the libdmtx decode daemon (see daemon/dmtxd.h).
+#
+# Short-lived scripts hand their decode and encode jobs to a long-running
+# pool of decoders instead of loading libdmtx themselves:
+#
+#   require 'dmtxd_client'
+#   dmtxd = DmtxdClient.new
+#   result = dmtxd.decode_image(Magick::Image.read('label.png').first,
+#                               'timeout' => 200)
+#   result[:symbols].each { |symbol| puts symbol[:data] }
+#
+# result[:status] is :complete, :max_count or :timeout; with :timeout the
+# symbols listed are those found in time. Large images can be passed as an
+# open file (e.g. in /dev/shm) with decode_io, so that the daemon reads the
+# pixels from the file instead of through the socket.
+
+require 'socket'
+
+class DmtxdClient
+  def initialize(path = '/tmp/dmtxd.sock')
+    @sock = UNIXSocket.new(path)
+  end
+
+  def close
+    @sock.close
+  end
+
+  # Decode raw pixel rows; format is one of gray8, rgb24, bgr24, ... and
+  # options holds libdmtxw option names (timeout, max_count, luma, ...)
+  def decode(pixels, width, height, format = 'rgb24', options = {})
+    @sock.write("DECODE #{width} #{height} #{format} 0 inline #{pixels.bytesize}" +
+                option_words(options) + "\n")
+    @sock.write(pixels)
+    read_decode
+  end
+
+  # Like decode, but the pixels are the first length bytes of an open file
+  def decode_io(io, length, width, height, format = 'rgb24', options = {})
+    @sock.write("DECODE #{width} #{height} #{format} 0 fd #{length}" +
+                option_words(options) + "\n")
+    @sock.send_io(io.fileno)
+    read_decode
+  end
+
+  # Decode an RMagick image as 8 bit RGB
+  def decode_image(image, options = {})
+    decode(image.export_pixels_to_str, image.columns, image.rows, 'rgb24', options)
+  end
+
+  # Encode a message; returns width, height and top-down RGB rows
+  def encode(message, options = {})
+    @sock.write("ENCODE #{message.bytesize}" + option_words(options) + "\n")
+    @sock.write(message)
+    head = read_status_line
+    { :width => head[1].to_i, :height => head[2].to_i,
+      :rgb => read_bytes(head[3].to_i) }
+  end
+
+  # Pool counters of the daemon
+  def stats
+    @sock.write("STATS\n")
+    head = read_status_line
+    { :workers => head[1].to_i, :connections => head[2].to_i,
+      :queued => head[3].to_i, :served => head[4].to_i, :failed => head[5].to_i }
+  end
+
+  private
+
+  def option_words(options)
+    options.map { |name, value| " #{name}=#{value.to_i}" }.join
+  end
+
+  def read_decode
+    head = read_status_line
+    symbols = (1..head[2].to_i).map do
+      f = read_line.split(' ')
+      data = read_bytes(f[1].to_i)
+      read_bytes(1)
+      { :data => data,
+        :corners => [[f[2].to_i, f[3].to_i], [f[4].to_i, f[5].to_i],
+                     [f[6].to_i, f[7].to_i], [f[8].to_i, f[9].to_i]],
+        :angle => f[10].to_i, :size_idx => f[11].to_i }
+    end
+    { :status => head[1].to_sym, :msec => head[3].to_f, :symbols => symbols }
+  end
+
+  def read_line
+    line = @sock.gets
+    raise IOError, 'dmtxd: connection lost' if line.nil?
+    line.chomp
+  end
+
+  def read_status_line
+    line = read_line
+    raise IOError, "dmtxd: #{line}" unless line.start_with?('OK ')
+    line.split(' ')
+  end
+
+  def read_bytes(length)
+    data = @sock.read(length)
+    raise IOError, 'dmtxd: connection lost' if data.nil? || data.bytesize < length
+    data
+  end
+end
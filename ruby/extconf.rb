@@ -1,4 +1,8 @@
 require 'mkmf'
 dir_config('dmtx')
+dir_config('dmtxw', '../dmtxw', '../.libs')
 have_library('dmtx')
+have_library('dmtxw', 'dmtxwSessionCreate', 'dmtxw.h')
+# --enable-stats also times the wrapper's own decode phases
+$defs << '-DDMTXW_STATS' if enable_config('stats', false)
 create_makefile('Rdmtx')
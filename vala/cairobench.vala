@@ -0,0 +1,100 @@
+/* cairobench.vala
+ * Compare the DmtxCairo rendering modes on a 144x144 symbol.
+ *
+ * For every mode and output format this reports the number of path
+ * rectangles emitted, the size of the written file and the average time
+ * spent rendering one symbol (including surface creation and teardown).
+ *
+ *   $ valac -o cairobench --pkg libdmtx --pkg cairo cairobench.vala dmtxcairo.vala
+ *   $ ./cairobench [iterations] [output directory]
+ */
+
+/* render_once
+ * Render one symbol to a new surface of the requested format and return the
+ * number of path rectangles emitted.
+ */
+int render_once (Dmtx.Encode enc, DmtxCairo.Mode mode, string format, string path) {
+  /* 60 mm x 60 mm page for vector output, 1 pixel per point for PNG */
+  double size = 170.07874;
+  Cairo.Surface surface;
+  int rects;
+
+  switch ( format ) {
+    case "pdf":
+      surface = new Cairo.PdfSurface(path, size, size);
+      break;
+    case "svg":
+      surface = new Cairo.SvgSurface(path, size, size);
+      break;
+    default:
+      surface = new Cairo.ImageSurface(Cairo.Format.RGB24, (int)size, (int)size);
+      break;
+  }
+
+  var cr = new Cairo.Context(surface);
+  cr.set_source_rgb(1, 1, 1);
+  cr.paint();
+  cr.set_source_rgb(0, 0, 0);
+
+  rects = DmtxCairo.write(enc, cr, size * 0.1, size * 0.1, size * 0.8, size * 0.8, mode);
+
+  if ( format == "png" )
+    ((Cairo.ImageSurface)surface).write_to_png(path);
+
+  surface.finish();
+
+  return rects;
+}
+
+public int main (string[] args) {
+  int iterations = (args.length > 1) ? int.parse(args[1]) : 50;
+  string outdir = (args.length > 2) ? args[2] : ".";
+  string[] formats = { "pdf", "svg", "png" };
+  DmtxCairo.Mode[] modes = { DmtxCairo.Mode.MODULES, DmtxCairo.Mode.RUNS, DmtxCairo.Mode.MASK };
+  string[] modeNames = { "modules", "runs", "mask" };
+
+  /* 3000 digits fill a 144x144 symbol in ASCII (two digits per codeword) */
+  var payload = new StringBuilder();
+  var rand = new GLib.Rand.with_seed(144);
+  for ( int i = 0 ; i < 3000 ; i++ )
+    payload.append_c((char)('0' + rand.int_range(0, 10)));
+
+  var enc = new Dmtx.Encode();
+  enc.set_property(Dmtx.Property.SCHEME, Dmtx.Scheme.ASCII);
+  enc.set_property(Dmtx.Property.SIZE_REQUEST, Dmtx.SymbolSize.SQUARE_AUTO);
+
+  unowned uchar[] data = (uchar[])payload.str;
+  data.length = (int)payload.len;
+
+  if ( !enc.data_matrix(data) )
+    GLib.error("Unable to encode benchmark payload.");
+
+  stdout.printf("symbol: %dx%d, %d iterations\n",
+      enc.region.symbol_rows, enc.region.symbol_columns, iterations);
+  stdout.printf("%-8s %-4s %8s %10s %12s\n", "mode", "fmt", "rects", "bytes", "usec/render");
+
+  for ( int m = 0 ; m < modes.length ; m++ ) {
+    foreach ( string format in formats ) {
+      string path = Path.build_filename(outdir, "cairobench-%s.%s".printf(modeNames[m], format));
+      int rects = 0;
+      string contents;
+      size_t length = 0;
+
+      var timer = new GLib.Timer();
+      for ( int i = 0 ; i < iterations ; i++ )
+        rects = render_once(enc, modes[m], format, path);
+      timer.stop();
+
+      try {
+        FileUtils.get_contents(path, out contents, out length);
+      } catch ( FileError e ) {
+        GLib.warning("%s", e.message);
+      }
+
+      stdout.printf("%-8s %-4s %8d %10lu %12.1f\n", modeNames[m], format, rects,
+          (ulong)length, timer.elapsed() * 1000000.0 / iterations);
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,74 @@
+/* dmtxdetect-test.vala
+ * Run the dmtxdetect element in a pipeline and report sustained throughput.
+ *
+ * Without arguments a 720p GRAY8 videotestsrc stream is used. Pass a video
+ * file to decode real footage instead:
+ *
+ *   $ valac -o dmtxdetect-test --pkg libdmtx --pkg gstreamer-1.0 \
+ *       --pkg gstreamer-video-1.0 dmtxdetect-test.vala dmtxdetect.vala
+ *   $ ./dmtxdetect-test [/path/to/video]
+ */
+public int main (string[] args) {
+  string description;
+  int results = 0;
+
+  Gst.init(ref args);
+
+  /* The element is compiled into this program, so register it statically */
+  Gst.Element.register(null, "dmtxdetect", Gst.Rank.NONE, typeof(DmtxDetect));
+
+  if ( args.length > 1 ) {
+    description = ("filesrc location=\"%s\" ! decodebin ! videoconvert ! " +
+        "dmtxdetect name=detect ! fakesink sync=false").printf(args[1]);
+  } else {
+    description = "videotestsrc num-buffers=600 ! " +
+        "video/x-raw,format=GRAY8,width=1280,height=720,framerate=30/1 ! " +
+        "dmtxdetect name=detect ! fakesink sync=false";
+  }
+
+  Gst.Element pipeline;
+  try {
+    pipeline = Gst.parse_launch(description);
+  } catch ( Error e ) {
+    GLib.stderr.printf("Unable to build pipeline: %s\n", e.message);
+    return -1;
+  }
+
+  var detect = (DmtxDetect)((Gst.Bin)pipeline).get_by_name("detect");
+  var bus = pipeline.get_bus();
+  var timer = new GLib.Timer();
+
+  pipeline.set_state(Gst.State.PLAYING);
+
+  for ( ;; ) {
+    var msg = bus.timed_pop_filtered(Gst.CLOCK_TIME_NONE,
+        Gst.MessageType.ERROR | Gst.MessageType.EOS | Gst.MessageType.ELEMENT);
+
+    if ( msg.type == Gst.MessageType.ELEMENT ) {
+      unowned Gst.Structure s = msg.get_structure();
+      if ( s.has_name("dmtxdetect") ) {
+        stdout.printf("%s\n", s.get_string("message"));
+        results++;
+      }
+      continue;
+    }
+
+    if ( msg.type == Gst.MessageType.ERROR ) {
+      Error err;
+      msg.parse_error(out err, null);
+      GLib.stderr.printf("Pipeline error: %s\n", err.message);
+    }
+    break;
+  }
+
+  timer.stop();
+  pipeline.set_state(Gst.State.NULL);
+
+  uint64 frames = detect.frames_processed + detect.frames_skipped;
+  stdout.printf("frames: %llu (decoded %llu, skipped %llu)\n",
+      frames, detect.frames_processed, detect.frames_skipped);
+  stdout.printf("symbols: %d\n", results);
+  stdout.printf("sustained: %.1f fps over %.2f s\n", frames / timer.elapsed(), timer.elapsed());
+
+  return 0;
+}
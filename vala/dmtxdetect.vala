@@ -0,0 +1,217 @@
+/* dmtxdetect.vala
+ * GStreamer video filter that decodes Data Matrix symbols in-stream.
+ *
+ * The element maps each GRAY8, RGB or BGRx buffer read-only (passthrough,
+ * no pixel copy), points its DmtxImage straight at the mapped memory and
+ * decodes it within a per-frame time budget. The image wrapper and decoder
+ * are built once per caps negotiation; per frame the image is repointed and
+ * the decoder's scan state reset, so nothing is allocated. Decoded symbols
+ * are posted on the bus as "dmtxdetect" element messages.
+ *
+ * When decoding a frame takes longer than the frame period, the overrun is
+ * carried forward as a debt and following frames are passed through
+ * untouched until it is paid off, so the element never stalls the pipeline.
+ *
+ *   $ valac --library=dmtxdetect -X -shared -X -fPIC -o libgstdmtxdetect.so \
+ *       --pkg libdmtx --pkg gstreamer-1.0 --pkg gstreamer-video-1.0 dmtxdetect.vala
+ */
+public class DmtxDetect : Gst.Video.Filter {
+
+  /* Time budget for decoding a single frame, in milliseconds (0 = none) */
+  public int budget { get; set; default = 30; }
+
+  /* Stop looking after this many symbols have been found in a frame */
+  public int max_count { get; set; default = 1; }
+
+  /* Pixel skipping factor handed to dmtxDecodeCreate() */
+  public int shrink { get; set; default = 1; }
+
+  /* Frames decoded and frames passed through to catch up */
+  public uint64 frames_processed { get; private set; default = 0; }
+  public uint64 frames_skipped { get; private set; default = 0; }
+
+  /* Processing time (usec) still owed from earlier overruns */
+  private int64 debt = 0;
+
+  /* Image wrapper and decoder reused for every frame of the negotiated
+   * format (the decoder is also rebuilt when shrink changes) */
+  private Dmtx.Image? image = null;
+  private Dmtx.Decode? dec = null;
+
+  class construct {
+    set_static_metadata("Data Matrix detector", "Filter/Analyzer/Video",
+        "Decodes Data Matrix symbols in video frames using libdmtx",
+        "libdmtx-wrappers");
+
+    var caps = Gst.Caps.from_string("video/x-raw, format = (string) { GRAY8, RGB, BGRx }");
+    add_pad_template(new Gst.PadTemplate("sink", Gst.PadDirection.SINK, Gst.PadPresence.ALWAYS, caps));
+    add_pad_template(new Gst.PadTemplate("src", Gst.PadDirection.SRC, Gst.PadPresence.ALWAYS, caps));
+  }
+
+  construct {
+    /* Frames are only inspected, so map them read-only and never copy */
+    set_passthrough(true);
+  }
+
+  public override bool set_info (Gst.Caps incaps, Gst.Video.Info in_info,
+      Gst.Caps outcaps, Gst.Video.Info out_info) {
+    /* Geometry or format changed; rebuild both on the next frame */
+    dec = null;
+    image = null;
+    return true;
+  }
+
+  public override bool start () {
+    debt = 0;
+    frames_processed = 0;
+    frames_skipped = 0;
+    return true;
+  }
+
+  public override Gst.FlowReturn transform_frame_ip (Gst.Video.Frame frame) {
+    int64 period = frame_period(frame);
+
+    if ( debt > 0 ) {
+      debt -= period;
+      frames_skipped++;
+      return Gst.FlowReturn.OK;
+    }
+
+    int64 start = GLib.get_monotonic_time();
+    decode_frame(frame);
+    int64 elapsed = GLib.get_monotonic_time() - start;
+    frames_processed++;
+
+    if ( elapsed > period )
+      debt += elapsed - period;
+
+    return Gst.FlowReturn.OK;
+  }
+
+  /* frame_period
+   * Returns the nominal frame duration in microseconds, falling back to the
+   * decode budget for variable-rate streams.
+   */
+  private int64 frame_period (Gst.Video.Frame frame) {
+    if ( frame.info.fps_n > 0 && frame.info.fps_d > 0 )
+      return (int64)1000000 * frame.info.fps_d / frame.info.fps_n;
+
+    return (int64)budget * 1000;
+  }
+
+  /* decode_frame
+   * Decode up to max_count symbols from the mapped frame, posting one bus
+   * message per symbol.
+   */
+  private void decode_frame (Gst.Video.Frame frame) {
+    Dmtx.PackOrder pack;
+    int bytesPerPixel;
+
+    switch ( frame.info.finfo.format ) {
+      case Gst.Video.Format.GRAY8:
+        pack = Dmtx.PackOrder.8BPP_K;
+        bytesPerPixel = 1;
+        break;
+      case Gst.Video.Format.RGB:
+        pack = Dmtx.PackOrder.24BPP_RGB;
+        bytesPerPixel = 3;
+        break;
+      case Gst.Video.Format.BGRx:
+        pack = Dmtx.PackOrder.32BPP_BGRX;
+        bytesPerPixel = 4;
+        break;
+      default:
+        return;
+    }
+
+    int width = frame.info.width;
+    int height = frame.info.height;
+
+    if ( image == null ) {
+      dec = null;
+      image = new Dmtx.Image((uint8*)frame.data[0], width, height, pack);
+      if ( image == null )
+        return;
+      image.set_property(Dmtx.Property.ROW_PAD_BYTES, frame.info.stride[0] - width * bytesPerPixel);
+    } else {
+      image.pxl = (uint8*)frame.data[0];
+    }
+
+    if ( dec == null || dec.scale != shrink ) {
+      dec = new Dmtx.Decode(image, shrink);
+      if ( dec == null )
+        return;
+    } else {
+      /* Forget the previous frame: clear the cache of visited pixels
+       * (sized by dmtxDecodeCreate() for the shrunken image) and set a
+       * property, which restarts the scan grid */
+      Memory.set(dec.cache, 0, (width / dec.scale) * (height / dec.scale));
+      dec.set_property(Dmtx.Property.SCAN_GAP, dec.scan_gap);
+    }
+
+    Dmtx.Time? deadline = null;
+    if ( budget > 0 )
+      deadline = Dmtx.Time().add(budget);
+
+    Dmtx.Region* reg;
+
+    for ( int found = 0 ; found < max_count ; ) {
+      reg = Dmtx.Region.find_next(dec, deadline);
+      if ( reg == null )
+        break;
+
+      var msg = dec.matrix_region(reg, Dmtx.UNDEFINED);
+      if ( msg != null ) {
+        post_result(frame, reg, msg, height);
+        found++;
+      }
+
+      Dmtx.Region.destroy(ref reg);
+    }
+  }
+
+  /* post_result
+   * Post one decoded symbol, including its four corners in top-down frame
+   * coordinates (bottom-left, bottom-right, top-right, top-left).
+   */
+  private void post_result (Gst.Video.Frame frame, Dmtx.Region* reg, Dmtx.Message msg, int height) {
+    Dmtx.Vector2 corner[4] = {
+      Dmtx.Vector2() { X = 0.0, Y = 0.0 }, Dmtx.Vector2() { X = 1.0, Y = 0.0 },
+      Dmtx.Vector2() { X = 1.0, Y = 1.0 }, Dmtx.Vector2() { X = 0.0, Y = 1.0 }
+    };
+    var points = GLib.Value(typeof(Gst.ValueArray));
+
+    for ( int i = 0 ; i < 4 ; i++ ) {
+      reg->fit_2_raw.vmultiply_by(ref corner[i]);
+      var point = GLib.Value(typeof(Gst.ValueArray));
+      Gst.ValueArray.append_value(point, (int)(shrink * corner[i].X + 0.5));
+      Gst.ValueArray.append_value(point, height - 1 - (int)(shrink * corner[i].Y + 0.5));
+      Gst.ValueArray.append_value(points, point);
+    }
+
+    var s = new Gst.Structure("dmtxdetect",
+        "message", typeof(string), ((string)msg.output).ndup(msg.output.length),
+        "timestamp", typeof(uint64), frame.buffer.pts,
+        "rows", typeof(int), reg->symbol_rows,
+        "columns", typeof(int), reg->symbol_columns);
+    s.set_value("corners", points);
+
+    post_message(new Gst.Message.element(this, (owned)s));
+  }
+}
+
+private static bool plugin_init (Gst.Plugin plugin) {
+  return Gst.Element.register(plugin, "dmtxdetect", Gst.Rank.NONE, typeof(DmtxDetect));
+}
+
+public const Gst.PluginDesc gst_plugin_desc = {
+  Gst.VERSION_MAJOR, Gst.VERSION_MINOR,
+  "dmtxdetect",
+  "Data Matrix detection using libdmtx",
+  plugin_init,
+  "0.7.3",
+  "LGPL",
+  "libdmtx-wrappers",
+  "libdmtx",
+  "http://www.libdmtx.org/"
+};
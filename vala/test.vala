@@ -1,41 +1,3 @@
-/* dmtxCairoWrite
- * Write a libdmtx barcode to a Cairo context.
- *
- * enc: dmtx data to write
- * cr: Cairo context to write to
- * x: horizontal margin
- * y: vertical margin
- * width: width of barcode
- * height: height of barcode
- */
-public void dmtxCairoWrite (Dmtx.Encode enc, Cairo.Context cr, double x, double y, double width, double height) {
-  Cairo.Matrix old_matrix;
-  cr.get_matrix(out old_matrix);
-
-  /* Save a copy of the old matrix so we can restore the setting when we're done. */
-  var matrix = old_matrix;
-
-  /* Account for the margin. */
-  matrix.translate(x, y);
-  /* Allows us to work within the specified area more easily. */
-  matrix.scale(width / enc.region.symbol_columns, height / enc.region.symbol_rows);
-  cr.set_matrix(matrix);
-
-  for ( int row = 0 ; row < enc.region.symbol_rows ; row++ ) {
-    int rowInv = enc.region.symbol_rows - row - 1;
-    for ( int col = 0 ; col < enc.region.symbol_columns ; col++ ) {
-      var module = enc.message.status(enc.region.size_idx, row, col);
-      if ( (module & Dmtx.Module.ON) == Dmtx.Module.ON ) {
-        cr.rectangle(col, rowInv, 1, 1);
-      }
-    }
-  }
-  cr.fill();
-
-  /* Restore the old settings. */
-  cr.set_matrix(old_matrix);
-}
-
 public int main (string[] args) {
   /* Create and initialize libdmtx encoding struct */
   var enc = new Dmtx.Encode();
@@ -70,7 +32,8 @@ public int main (string[] args) {
   var cr = new Cairo.Context(surface);
 
   /* Encode */
-  dmtxCairoWrite(enc, cr, surface_size[0] * 0.25, surface_size[1] * 0.25, surface_size[0] * 0.5, surface_size[0] * 0.5);
+  DmtxCairo.write(enc, cr, surface_size[0] * 0.25, surface_size[1] * 0.25, surface_size[0] * 0.5, surface_size[0] * 0.5,
+      DmtxCairo.Mode.RUNS);
 
   return 0;
 }
\ No newline at end of file